@@ -2,37 +2,328 @@
 
 
 
+#include "backend/cpu/GemmAutotuner.h"
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 
 
-void CpuOps::matmul(const Tensor &a, const Tensor &b, Tensor &c)
+namespace
 {
-    if ((a.getCols() != b.getRows()))
+    // Widest pool job since CpuOps::resetThreadsUsed
+    std::atomic<size_t> threads_used{1};
+
+
+
+    // Runs fn(0..tasks-1) on the calling thread plus persistent helpers, so
+    // threaded GEMMs do not pay for thread creation on every call. The pool
+    // serves one caller at a time; a caller that finds it busy (another
+    // Hogwild worker or search trial) runs its tasks inline instead of
+    // waiting, so concurrent callers never do worse than single-threaded.
+    class WorkerPool
     {
-        throw std::invalid_argument("Matrix dimensions do not match for multiplication.");
+    public:
+        static WorkerPool &instance()
+        {
+            static WorkerPool pool;
+            return pool;
+        }
+
+        void run(size_t tasks, const std::function<void(size_t)> &fn)
+        {
+            if (tasks <= 1)
+            {
+                fn(0);
+                return;
+            }
+            std::unique_lock<std::mutex> serial(run_mutex, std::try_to_lock);
+            if (!serial.owns_lock())
+            {
+                for (size_t t = 0; t < tasks; t++) { fn(t); }
+                return;
+            }
+            for (size_t seen = threads_used.load(); (seen < tasks) && !threads_used.compare_exchange_weak(seen, tasks);) {}
+            auto job = std::make_shared<Job>();
+            job->fn = &fn;
+            job->total = tasks;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (workers.size() + 1 < tasks)
+                {
+                    workers.emplace_back([this] { workerLoop(); });
+                }
+                current = job;
+            }
+            cv.notify_all();
+            work(*job);
+            std::unique_lock<std::mutex> lock(mutex);
+            done_cv.wait(lock, [&] { return job->done.load() == job->total; });
+            current.reset();
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            for (auto &worker : workers) { worker.join(); }
+        }
+
+    private:
+        struct Job
+        {
+            const std::function<void(size_t)> *fn = nullptr;
+            size_t total = 0;
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+        };
+
+        void work(Job &job)
+        {
+            // A helper that wakes late finds next >= total and claims nothing
+            for (size_t t = job.next++; t < job.total; t = job.next++)
+            {
+                (*job.fn)(t);
+                if (++job.done == job.total)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done_cv.notify_all();
+                }
+            }
+        }
+
+        void workerLoop()
+        {
+            std::shared_ptr<Job> seen;
+            for (;;)
+            {
+                std::shared_ptr<Job> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return stopping || (current && (current != seen)); });
+                    if (stopping) { return; }
+                    job = current;
+                }
+                seen = job;
+                work(*job);
+            }
+        }
+
+        std::mutex run_mutex;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable done_cv;
+        std::vector<std::thread> workers;
+        std::shared_ptr<Job> current;
+        bool stopping = false;
+    };
+
+
+
+    std::atomic<size_t> gemm_threads{0};
+
+
+
+    // C[i0:i1, j0:j1] = alpha * op(A) op(B) + beta * C over that block
+    void gemmBlock(const GemmConfig &config, bool trans_a, bool trans_b, size_t i_begin, size_t i_end, size_t j_begin, size_t j_end, size_t k,
+                   float alpha, const float *a, size_t lda, const float *b, size_t ldb, float beta, float *c, size_t ldc)
+    {
+        // Apply beta up front; beta == 0 must overwrite so uninitialised output is safe
+        for (size_t i = i_begin; i < i_end; i++)
+        {
+            float *c_row = c + i * ldc;
+            if (beta == 0.0f)
+            {
+                std::fill(c_row + j_begin, c_row + j_end, 0.0f);
+            }
+            else if (beta != 1.0f)
+            {
+                for (size_t j = j_begin; j < j_end; j++) { c_row[j] *= beta; }
+            }
+        }
+        if ((i_end <= i_begin) || (j_end <= j_begin) || (k == 0) || (alpha == 0.0f))
+        {
+            return;
+        }
+
+        // Packed B panel (KC x NC) stays in L2 while one row of C plus the
+        // matching A row stay in L1
+        const size_t block_m = std::max<size_t>(1, config.block_m);
+        const size_t block_n = std::max<size_t>(1, config.block_n);
+        const size_t block_k = std::max<size_t>(1, config.block_k);
+        thread_local std::vector<float> packed_b;
+        packed_b.resize(block_k * block_n);
+
+        for (size_t j0 = j_begin; j0 < j_end; j0 += block_n)
+        {
+            const size_t nb = std::min(block_n, j_end - j0);
+            for (size_t p0 = 0; p0 < k; p0 += block_k)
+            {
+                const size_t kb = std::min(block_k, k - p0);
+
+                // Pack op(B)[p0:p0+kb, j0:j0+nb] into a contiguous kb x nb panel
+                for (size_t p = 0; p < kb; p++)
+                {
+                    float *dst = packed_b.data() + p * nb;
+                    if (!trans_b)
+                    {
+                        const float *src = b + (p0 + p) * ldb + j0;
+                        std::copy(src, src + nb, dst);
+                    }
+                    else
+                    {
+                        for (size_t j = 0; j < nb; j++) { dst[j] = b[(j0 + j) * ldb + (p0 + p)]; }
+                    }
+                }
+
+                for (size_t i0 = i_begin; i0 < i_end; i0 += block_m)
+                {
+                    const size_t mb = std::min(block_m, i_end - i0);
+                    for (size_t i = i0; i < i0 + mb; i++)
+                    {
+                        float *c_row = c + i * ldc + j0;
+                        for (size_t p = 0; p < kb; p++)
+                        {
+                            const float a_ip = alpha * (trans_a ? a[(p0 + p) * lda + i] : a[i * lda + p0 + p]);
+                            if (a_ip == 0.0f) { continue; }
+                            const float *b_row = packed_b.data() + p * nb;
+                            for (size_t j = 0; j < nb; j++)
+                            {
+                                c_row[j] += a_ip * b_row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
     }
-    if ((c.getRows() != a.getRows()) || (c.getCols() != b.getCols()))
+
+
+
+    // Rows of A handled together by the sparse kernels: the transposed Csr
+    // panel and the C rows a tile is applied to stay in L2
+    constexpr size_t kSpmmPanel = 32;
+
+
+
+    // Csr: C[i0:i1] += A[i0:i1] * B. With the A panel transposed, output
+    // column j is a sum of contiguous panel rows scaled by column j's values.
+    void spmmCsrRows(size_t i_begin, size_t i_end, const float *a, size_t lda, const SparseMatrix &b, float *c, size_t ldc)
     {
-        throw std::invalid_argument("Output tensor C has incorrect dimensions.");
+        thread_local std::vector<float> panel;
+        float column[kSpmmPanel];
+        for (size_t i0 = i_begin; i0 < i_end; i0 += kSpmmPanel)
+        {
+            const size_t mb = std::min(kSpmmPanel, i_end - i0);
+            panel.resize(b.rows * mb);
+            for (size_t i = 0; i < mb; i++)
+            {
+                const float *a_row = a + (i0 + i) * lda;
+                for (size_t p = 0; p < b.rows; p++) { panel[p * mb + i] = a_row[p]; }
+            }
+            for (size_t j = 0; j < b.cols; j++)
+            {
+                std::fill_n(column, mb, 0.0f);
+                for (std::uint32_t e = b.offsets[j]; e < b.offsets[j + 1]; e++)
+                {
+                    const float value = b.values[e];
+                    const float *panel_row = panel.data() + static_cast<size_t>(b.indices[e]) * mb;
+                    for (size_t i = 0; i < mb; i++) { column[i] += value * panel_row[i]; }
+                }
+                for (size_t i = 0; i < mb; i++) { c[(i0 + i) * ldc + j] += column[i]; }
+            }
+        }
     }
 
-    for (size_t i = 0; i < a.getRows(); i++)
+
+
+    // Blocked: C[i0:i1] += A[i0:i1] * B, one tile at a time across a panel
+    // of rows. Block is the tile width as a compile-time constant (0 reads
+    // it from b), which lets the compiler keep a tile row in one vector.
+    template <size_t Block>
+    void spmmBlockedRows(size_t i_begin, size_t i_end, const float *a, size_t lda, const SparseMatrix &b, float *c, size_t ldc)
     {
-        for (size_t j = 0; j < b.getCols(); j++)
+        const size_t block = Block ? Block : b.block;
+        const size_t tile_size = block * block;
+        const size_t block_rows = b.offsets.size() - 1;
+        for (size_t i0 = i_begin; i0 < i_end; i0 += kSpmmPanel)
         {
-            float sum = 0.0f;
-            for (size_t k = 0; k < a.getCols(); k++)
+            const size_t i1 = std::min(i0 + kSpmmPanel, i_end);
+            for (size_t br = 0; br < block_rows; br++)
             {
-                sum += a.get(i, k) * b.get(k, j);
+                const size_t r0 = br * block;
+                const size_t height = std::min(block, b.rows - r0);
+                for (std::uint32_t e = b.offsets[br]; e < b.offsets[br + 1]; e++)
+                {
+                    const size_t c0 = static_cast<size_t>(b.indices[e]) * block;
+                    const float *tile = b.values.data() + e * tile_size;
+                    if (Block && (c0 + Block <= b.cols))
+                    {
+                        for (size_t i = i0; i < i1; i++)
+                        {
+                            const float *a_row = a + i * lda + r0;
+                            float acc[Block ? Block : 1] = {};
+                            for (size_t r = 0; r < height; r++)
+                            {
+                                const float x = a_row[r];
+                                for (size_t j = 0; j < Block; j++) { acc[j] += x * tile[r * Block + j]; }
+                            }
+                            float *c_row = c + i * ldc + c0;
+                            for (size_t j = 0; j < Block; j++) { c_row[j] += acc[j]; }
+                        }
+                        continue;
+                    }
+                    // Edge tile, or a block size without a fixed-width loop
+                    const size_t width = std::min(block, b.cols - c0);
+                    for (size_t i = i0; i < i1; i++)
+                    {
+                        const float *a_row = a + i * lda + r0;
+                        float *c_row = c + i * ldc + c0;
+                        for (size_t r = 0; r < height; r++)
+                        {
+                            const float x = a_row[r];
+                            for (size_t j = 0; j < width; j++) { c_row[j] += x * tile[r * block + j]; }
+                        }
+                    }
+                }
             }
-            c.set(i, j, sum);
         }
     }
 }
 
 
 
+void CpuOps::matmul(const Tensor &a, const Tensor &b, Tensor &c)
+{
+    if ((a.getCols() != b.getRows()))
+    {
+        throw std::invalid_argument("Matrix dimensions do not match for multiplication.");
+    }
+    if ((c.getRows() != a.getRows()) || (c.getCols() != b.getCols()))
+    {
+        throw std::invalid_argument("Output tensor C has incorrect dimensions.");
+    }
+
+    gemm(false, false, a.getRows(), b.getCols(), a.getCols(),
+         1.0f, a.getCpuData(), a.getCols(), b.getCpuData(), b.getCols(),
+         0.0f, c.getCpuData(), c.getCols());
+}
+
+
+
 void CpuOps::add(const Tensor &a, const Tensor &b, Tensor &c)
 {
     if ((a.getSize() != b.getSize()) || (a.getSize() != c.getSize()))
@@ -58,3 +349,263 @@ void CpuOps::relu(const Tensor &a, Tensor &b)
         b.getCpuData()[i] = std::max(0.0f, a.getCpuData()[i]);
     }
 }
+
+
+
+void CpuOps::gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                  float alpha, const float *a, size_t lda, const float *b, size_t ldb,
+                  float beta, float *c, size_t ldc)
+{
+    // Lookup only: unseen shapes run with defaults and are queued for tuning
+    bool tuned = false;
+    GemmConfig config = GemmAutotuner::lookup(trans_a, trans_b, m, n, k, &tuned);
+    if (const size_t threads = gemm_threads.load(std::memory_order_relaxed); threads > 0)
+    {
+        if (tuned)
+        {
+            config.threads = std::min(config.threads, threads);
+        }
+        else if (static_cast<std::uint64_t>(m) * n * k >= 32ull * 32ull * 32ull)
+        {
+            config.threads = threads;
+            config.split_n = n > m;
+        }
+    }
+    gemmWithConfig(config, trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+
+
+void CpuOps::gemmGrouped(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                         float alpha, const float *const *a, size_t lda, const float *const *b, size_t ldb,
+                         float beta, float *const *c, size_t ldc, size_t count)
+{
+    if ((count == 0) || (m == 0))
+    {
+        return;
+    }
+    GemmConfig config = GemmAutotuner::lookup(trans_a, trans_b, m, n, k);
+    config.threads = 1;
+    const size_t threads = std::max<size_t>(1, gemm_threads.load(std::memory_order_relaxed));
+    // Split each product into row ranges only when there are fewer products than threads
+    const size_t parts = std::min(m, (threads + count - 1) / count);
+    const size_t units = count * parts;
+    const size_t tasks = std::min(threads, units);
+    auto runUnits = [&](size_t begin, size_t end)
+    {
+        for (size_t unit = begin; unit < end; unit++)
+        {
+            const size_t g = unit / parts;
+            const size_t part = unit % parts;
+            gemmBlock(config, trans_a, trans_b, m * part / parts, m * (part + 1) / parts, 0, n, k,
+                      alpha, a[g], lda, b[g], ldb, beta, c[g], ldc);
+        }
+    };
+    if (tasks <= 1)
+    {
+        runUnits(0, units);
+        return;
+    }
+    WorkerPool::instance().run(tasks, [&](size_t t)
+    {
+        runUnits(units * t / tasks, units * (t + 1) / tasks);
+    });
+}
+
+
+
+void CpuOps::setThreads(size_t threads)
+{
+    gemm_threads = threads;
+}
+
+
+
+SparseMatrix CpuOps::compress(const float *dense, size_t rows, size_t cols, SparseFormat format, size_t block)
+{
+    if (static_cast<std::uint64_t>(rows) * cols > UINT32_MAX)
+    {
+        throw std::invalid_argument("CpuOps::compress: matrix too large for 32-bit indices");
+    }
+    SparseMatrix sparse;
+    sparse.format = format;
+    sparse.rows = rows;
+    sparse.cols = cols;
+    if (format == SparseFormat::Csr)
+    {
+        sparse.offsets.reserve(cols + 1);
+        sparse.offsets.push_back(0);
+        for (size_t j = 0; j < cols; j++)
+        {
+            for (size_t p = 0; p < rows; p++)
+            {
+                if (const float value = dense[p * cols + j]; value != 0.0f)
+                {
+                    sparse.indices.push_back(static_cast<std::uint32_t>(p));
+                    sparse.values.push_back(value);
+                }
+            }
+            sparse.offsets.push_back(static_cast<std::uint32_t>(sparse.values.size()));
+        }
+        return sparse;
+    }
+
+    sparse.block = std::max<size_t>(block, 1);
+    const size_t b = sparse.block;
+    const size_t block_rows = (rows + b - 1) / b;
+    const size_t block_cols = (cols + b - 1) / b;
+    sparse.offsets.reserve(block_rows + 1);
+    sparse.offsets.push_back(0);
+    for (size_t br = 0; br < block_rows; br++)
+    {
+        const size_t height = std::min(b, rows - br * b);
+        for (size_t bc = 0; bc < block_cols; bc++)
+        {
+            const size_t width = std::min(b, cols - bc * b);
+            const float *origin = dense + br * b * cols + bc * b;
+            bool nonzero = false;
+            for (size_t r = 0; (r < height) && !nonzero; r++)
+            {
+                nonzero = std::any_of(origin + r * cols, origin + r * cols + width, [](float v) { return v != 0.0f; });
+            }
+            if (!nonzero)
+            {
+                continue;
+            }
+            const size_t first = sparse.values.size();
+            sparse.values.resize(first + b * b, 0.0f);
+            for (size_t r = 0; r < height; r++)
+            {
+                std::copy(origin + r * cols, origin + r * cols + width, sparse.values.begin() + static_cast<std::ptrdiff_t>(first + r * b));
+            }
+            sparse.indices.push_back(static_cast<std::uint32_t>(bc));
+        }
+        sparse.offsets.push_back(static_cast<std::uint32_t>(sparse.indices.size()));
+    }
+    return sparse;
+}
+
+
+
+void CpuOps::spmm(size_t m, const float *a, size_t lda, const SparseMatrix &b, float *c, size_t ldc)
+{
+    if ((m == 0) || (b.cols == 0) || b.offsets.empty())
+    {
+        return;
+    }
+    auto runRows = [&](size_t begin, size_t end)
+    {
+        if (b.format == SparseFormat::Csr)
+        {
+            spmmCsrRows(begin, end, a, lda, b, c, ldc);
+            return;
+        }
+        switch (b.block)
+        {
+            case 4: spmmBlockedRows<4>(begin, end, a, lda, b, c, ldc); break;
+            case 8: spmmBlockedRows<8>(begin, end, a, lda, b, c, ldc); break;
+            default: spmmBlockedRows<0>(begin, end, a, lda, b, c, ldc); break;
+        }
+    };
+    const size_t panels = (m + kSpmmPanel - 1) / kSpmmPanel;
+    const size_t tasks = std::min(std::max<size_t>(1, gemm_threads.load(std::memory_order_relaxed)), panels);
+    if (tasks <= 1)
+    {
+        runRows(0, m);
+        return;
+    }
+    WorkerPool::instance().run(tasks, [&](size_t t)
+    {
+        runRows(std::min(m, panels * t / tasks * kSpmmPanel), std::min(m, panels * (t + 1) / tasks * kSpmmPanel));
+    });
+}
+
+
+
+size_t CpuOps::getThreads()
+{
+    return gemm_threads;
+}
+
+
+
+void CpuOps::resetThreadsUsed()
+{
+    threads_used = 1;
+}
+
+
+
+size_t CpuOps::getThreadsUsed()
+{
+    return threads_used;
+}
+
+
+
+OpCost CpuOps::gemmCost(size_t m, size_t n, size_t k, bool reads_c)
+{
+    const double md = static_cast<double>(m), nd = static_cast<double>(n), kd = static_cast<double>(k);
+    return {2.0 * md * nd * kd, (md * kd + kd * nd + (reads_c ? 2.0 : 1.0) * md * nd) * sizeof(float)};
+}
+
+
+
+OpCost CpuOps::matmulCost(const Tensor &a, const Tensor &b)
+{
+    return gemmCost(a.getRows(), b.getCols(), a.getCols());
+}
+
+
+
+OpCost CpuOps::spmmCost(size_t m, const SparseMatrix &b)
+{
+    const double md = static_cast<double>(m);
+    const double stored = static_cast<double>(b.storedValues());
+    return {2.0 * md * stored, md * static_cast<double>(b.rows) * sizeof(float) + static_cast<double>(b.storageBytes()) +
+                               2.0 * md * static_cast<double>(b.cols) * sizeof(float)};
+}
+
+
+
+OpCost CpuOps::addCost(const Tensor &a)
+{
+    const double n = static_cast<double>(a.getSize());
+    return {n, 3.0 * n * sizeof(float)};
+}
+
+
+
+OpCost CpuOps::reluCost(const Tensor &a)
+{
+    const double n = static_cast<double>(a.getSize());
+    return {n, 2.0 * n * sizeof(float)};
+}
+
+
+
+void CpuOps::gemmWithConfig(const GemmConfig &config, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                            float alpha, const float *a, size_t lda, const float *b, size_t ldb,
+                            float beta, float *c, size_t ldc)
+{
+    const size_t extent = config.split_n ? n : m;
+    const size_t tasks = std::max<size_t>(1, std::min(config.threads, extent));
+    if (tasks == 1)
+    {
+        gemmBlock(config, trans_a, trans_b, 0, m, 0, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+    WorkerPool::instance().run(tasks, [&](size_t t)
+    {
+        const size_t begin = extent * t / tasks;
+        const size_t end = extent * (t + 1) / tasks;
+        if (config.split_n)
+        {
+            gemmBlock(config, trans_a, trans_b, 0, m, begin, end, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        }
+        else
+        {
+            gemmBlock(config, trans_a, trans_b, begin, end, 0, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        }
+    });
+}
@@ -3,6 +3,59 @@
 
 
 #include "nn/Tensor.h"
+#include "nn/nn_types.h"
+
+
+
+#include <cstdint>
+#include <vector>
+
+
+
+// Tunable parameters of the blocked GEMM kernel; see GemmAutotuner
+struct GemmConfig
+{
+    size_t block_m = 64;
+    size_t block_n = 256;
+    size_t block_k = 256;
+    size_t threads = 1;   // row (or column) ranges computed in parallel
+    bool split_n = false; // split columns instead of rows across threads
+
+    [[nodiscard]] bool operator==(const GemmConfig &) const = default;
+};
+
+
+
+enum class SparseFormat : std::uint8_t
+{
+    Csr,     // individual non-zeros
+    Blocked, // block x block tiles that contain a non-zero
+};
+
+
+
+// Sparse rows x cols right-hand operand of CpuOps::spmm, built by
+// CpuOps::compress. Csr stores it column by column (CSR of its transpose),
+// so each output column is a sparse dot product. Blocked stores a row of
+// tiles per block row (BSR), each tile row-major with zero padding at the
+// edges. Indices are 32-bit to halve their share of the footprint.
+struct SparseMatrix
+{
+    SparseFormat format = SparseFormat::Csr;
+    size_t rows = 0;
+    size_t cols = 0;
+    size_t block = 1;
+    std::vector<std::uint32_t> offsets; // per column (Csr) or block row (Blocked), plus one
+    std::vector<std::uint32_t> indices; // row (Csr) or block column (Blocked) of each entry
+    std::vector<float> values;
+
+    // Stored values, including the explicit zeros inside kept tiles
+    [[nodiscard]] size_t storedValues() const noexcept { return values.size(); }
+    [[nodiscard]] size_t storageBytes() const noexcept
+    {
+        return values.size() * sizeof(float) + (offsets.size() + indices.size()) * sizeof(std::uint32_t);
+    }
+};
 
 
 
@@ -12,4 +65,60 @@ public:
     static void matmul(const Tensor &a, const Tensor &b, Tensor &c);
     static void add(const Tensor &a, const Tensor &b, Tensor &c);
     static void relu(const Tensor &a, Tensor &b);
+
+    // Row-major GEMM on raw buffers: C = alpha * op(A) * op(B) + beta * C,
+    // where op(A) is m x k and op(B) is k x n. Cache-blocked, with B panels
+    // packed so the inner loop is unit-stride regardless of transposition.
+    // Tile sizes and thread split come from the autotuning cache when the
+    // shape has been tuned, otherwise from the GemmConfig defaults.
+    static void gemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                     float alpha, const float *a, size_t lda, const float *b, size_t ldb,
+                     float beta, float *c, size_t ldc);
+
+    // Grouped GEMM: count independent products of one shape, C[g] =
+    // alpha * op(A[g]) * op(B[g]) + beta * C[g]. Each product runs
+    // single-threaded on its tuned tiles, and (group, row range) units are
+    // spread over the GEMM threads (one when none are set, as for untuned
+    // gemm), so many products too small to thread on their own still fill
+    // the cores.
+    static void gemmGrouped(bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                            float alpha, const float *const *a, size_t lda, const float *const *b, size_t ldb,
+                            float beta, float *const *c, size_t ldc, size_t count);
+
+    // Dense row-major rows x cols matrix to SparseMatrix, dropping exact
+    // zeros (Csr) or all-zero tiles (Blocked)
+    [[nodiscard]] static SparseMatrix compress(const float *dense, size_t rows, size_t cols, SparseFormat format, size_t block = 4);
+
+    // C += A * B for dense row-major A (m x b.rows) and sparse B, so callers
+    // seed C (with biases, say) or zero it first. Csr transposes panels of A
+    // so each stored value scales one contiguous row of the panel; Blocked
+    // walks A row by row with the tile width as a fixed-size inner loop for
+    // 4 and 8. Both vectorize without intrinsics. Row panels are spread over
+    // the GEMM threads when setThreads has set any.
+    static void spmm(size_t m, const float *a, size_t lda, const SparseMatrix &b, float *c, size_t ldc);
+
+    // GEMM thread count: untuned shapes run with this many threads and tuned
+    // shapes are capped at it. 0 (the default) keeps untuned shapes
+    // single-threaded and tuned shapes as tuned.
+    static void setThreads(size_t threads);
+    [[nodiscard]] static size_t getThreads();
+
+    // Most threads any kernel has run on since the last reset (at least 1),
+    // tuned configurations included, so a report can compare measured rates
+    // with a machine peak of the same width
+    static void resetThreadsUsed();
+    [[nodiscard]] static size_t getThreadsUsed();
+
+    // Analytic work of each kernel for the roofline report; pass reads_c
+    // when the GEMM accumulates into C (beta != 0)
+    [[nodiscard]] static OpCost gemmCost(size_t m, size_t n, size_t k, bool reads_c = false);
+    [[nodiscard]] static OpCost matmulCost(const Tensor &a, const Tensor &b);
+    [[nodiscard]] static OpCost spmmCost(size_t m, const SparseMatrix &b);
+    [[nodiscard]] static OpCost addCost(const Tensor &a);
+    [[nodiscard]] static OpCost reluCost(const Tensor &a);
+
+    // Same GEMM with an explicit configuration (used by the autotuner)
+    static void gemmWithConfig(const GemmConfig &config, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                               float alpha, const float *a, size_t lda, const float *b, size_t ldb,
+                               float beta, float *c, size_t ldc);
 };
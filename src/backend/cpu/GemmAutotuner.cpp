@@ -0,0 +1,386 @@
+// =============================================================================
+// File: src/backend/cpu/GemmAutotuner.cpp
+// =============================================================================
+//
+// Description: Implements the GEMM autotuner. Tuning runs in two stages: tile
+//              sizes are searched single-threaded, then thread counts and the
+//              split dimension are searched with the best tile, which keeps
+//              the candidate count linear rather than multiplicative.
+//
+// =============================================================================
+
+#include "backend/cpu/GemmAutotuner.h"
+
+
+
+#include "nlohmann/json.hpp"
+
+
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+
+namespace
+{
+    // Shapes below this many multiply-adds run too briefly to be worth a
+    // lookup, let alone tuning
+    constexpr std::uint64_t kMinTunedWork = 32ull * 32ull * 32ull;
+    constexpr size_t kMaxPending = 64;
+
+
+
+    struct Entry
+    {
+        GemmConfig config;
+        double gflops = 0.0;
+    };
+
+    std::shared_mutex table_mutex;
+    std::unordered_map<std::uint64_t, Entry> table;
+    std::mutex pending_mutex;
+    std::unordered_set<std::uint64_t> pending;
+    std::atomic<bool> recording{true};
+
+
+
+    // 20 bits per dimension plus the transpose flags
+    std::uint64_t makeKey(bool trans_a, bool trans_b, size_t m, size_t n, size_t k)
+    {
+        constexpr std::uint64_t kMask = (1ull << 20) - 1;
+        return (static_cast<std::uint64_t>(trans_a) << 62) | (static_cast<std::uint64_t>(trans_b) << 61) |
+               ((m & kMask) << 40) | ((n & kMask) << 20) | (k & kMask);
+    }
+
+    void splitKey(std::uint64_t key, bool &trans_a, bool &trans_b, size_t &m, size_t &n, size_t &k)
+    {
+        constexpr std::uint64_t kMask = (1ull << 20) - 1;
+        trans_a = (key >> 62) & 1;
+        trans_b = (key >> 61) & 1;
+        m = (key >> 40) & kMask;
+        n = (key >> 20) & kMask;
+        k = key & kMask;
+    }
+
+    std::string keyName(std::uint64_t key)
+    {
+        bool ta = false, tb = false;
+        size_t m = 0, n = 0, k = 0;
+        splitKey(key, ta, tb, m, n, k);
+        return std::string(ta ? "T" : "N") + (tb ? "T" : "N") + ":" + std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k);
+    }
+
+    bool parseKeyName(const std::string &name, std::uint64_t &key)
+    {
+        size_t m = 0, n = 0, k = 0;
+        char ta = 0, tb = 0;
+        if (std::sscanf(name.c_str(), "%c%c:%zux%zux%zu", &ta, &tb, &m, &n, &k) != 5) { return false; }
+        key = makeKey(ta == 'T', tb == 'T', m, n, k);
+        return true;
+    }
+
+
+
+    // Mean seconds per call, measured for at least ~20 ms after one warm-up
+    double timeConfig(const GemmConfig &config, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                      const std::vector<float> &a, const std::vector<float> &b, std::vector<float> &c)
+    {
+        using clock = std::chrono::steady_clock;
+        const size_t lda = trans_a ? m : k;
+        const size_t ldb = trans_b ? k : n;
+        CpuOps::gemmWithConfig(config, trans_a, trans_b, m, n, k, 1.0f, a.data(), lda, b.data(), ldb, 0.0f, c.data(), n);
+        size_t calls = 0;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+        do
+        {
+            CpuOps::gemmWithConfig(config, trans_a, trans_b, m, n, k, 1.0f, a.data(), lda, b.data(), ldb, 0.0f, c.data(), n);
+            calls++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while ((elapsed < 0.02) && (calls < 200));
+        return elapsed / static_cast<double>(calls);
+    }
+}
+
+
+
+namespace GemmAutotuner
+{
+
+GemmConfig lookup(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, bool *tuned)
+{
+    if (tuned) { *tuned = false; }
+    if (static_cast<std::uint64_t>(m) * n * k < kMinTunedWork)
+    {
+        return GemmConfig{};
+    }
+    const std::uint64_t key = makeKey(trans_a, trans_b, m, n, k);
+    {
+        std::shared_lock<std::shared_mutex> lock(table_mutex);
+        const auto it = table.find(key);
+        if (it != table.end())
+        {
+            if (tuned) { *tuned = true; }
+            return it->second.config;
+        }
+    }
+    if (recording)
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (pending.size() < kMaxPending)
+        {
+            pending.insert(key);
+        }
+    }
+    return GemmConfig{};
+}
+
+
+
+GemmConfig tune(bool trans_a, bool trans_b, size_t m, size_t n, size_t k)
+{
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> a(m * k), b(k * n), c(m * n);
+    for (float &v : a) { v = dist(rng); }
+    for (float &v : b) { v = dist(rng); }
+
+    // Stage 1: tile sizes, single-threaded. Tiles larger than the matrix
+    // behave identically, so they are clipped and deduplicated.
+    GemmConfig best;
+    double best_seconds = timeConfig(best, trans_a, trans_b, m, n, k, a, b, c);
+    std::vector<GemmConfig> tried = {best};
+    for (size_t bm : {32, 64, 128})
+    {
+        for (size_t bn : {128, 256, 512})
+        {
+            for (size_t bk : {128, 256, 512})
+            {
+                GemmConfig candidate;
+                candidate.block_m = std::min(bm, std::max<size_t>(m, 1));
+                candidate.block_n = std::min(bn, std::max<size_t>(n, 1));
+                candidate.block_k = std::min(bk, std::max<size_t>(k, 1));
+                if (std::find(tried.begin(), tried.end(), candidate) != tried.end()) { continue; }
+                tried.push_back(candidate);
+                const double seconds = timeConfig(candidate, trans_a, trans_b, m, n, k, a, b, c);
+                if (seconds < best_seconds)
+                {
+                    best_seconds = seconds;
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    // Stage 2: thread count and split dimension with the winning tile
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 2; threads <= hardware; threads *= 2)
+    {
+        for (bool split_n : {false, true})
+        {
+            GemmConfig candidate = best;
+            candidate.threads = threads;
+            candidate.split_n = split_n;
+            if ((split_n ? n : m) < threads) { continue; }
+            const double seconds = timeConfig(candidate, trans_a, trans_b, m, n, k, a, b, c);
+            if (seconds < best_seconds * 0.95) // threads must clearly pay off
+            {
+                best_seconds = seconds;
+                best = candidate;
+            }
+        }
+    }
+
+    Entry entry;
+    entry.config = best;
+    entry.gflops = 2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k) / best_seconds / 1e9;
+    {
+        std::unique_lock<std::shared_mutex> lock(table_mutex);
+        table[makeKey(trans_a, trans_b, m, n, k)] = entry;
+    }
+    return best;
+}
+
+
+
+size_t tunePending()
+{
+    std::vector<std::uint64_t> keys;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        keys.assign(pending.begin(), pending.end());
+        pending.clear();
+    }
+    size_t tuned = 0;
+    for (std::uint64_t key : keys)
+    {
+        bool ta = false, tb = false;
+        size_t m = 0, n = 0, k = 0;
+        splitKey(key, ta, tb, m, n, k);
+        {
+            std::shared_lock<std::shared_mutex> lock(table_mutex);
+            if (table.count(key)) { continue; }
+        }
+        (void)tune(ta, tb, m, n, k);
+        tuned++;
+    }
+    return tuned;
+}
+
+
+
+void setRecording(bool enabled)
+{
+    recording = enabled;
+}
+
+
+
+bool load(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    try
+    {
+        const nlohmann::json root = nlohmann::json::parse(file);
+        const auto cpus = root.find("cpus");
+        if ((cpus == root.end()) || !cpus->contains(cpuKey()))
+        {
+            return false;
+        }
+        std::unique_lock<std::shared_mutex> lock(table_mutex);
+        for (const auto &[name, value] : (*cpus)[cpuKey()].items())
+        {
+            std::uint64_t key = 0;
+            if (!parseKeyName(name, key)) { continue; }
+            Entry entry;
+            entry.config.block_m = value.value("block_m", entry.config.block_m);
+            entry.config.block_n = value.value("block_n", entry.config.block_n);
+            entry.config.block_k = value.value("block_k", entry.config.block_k);
+            entry.config.threads = value.value("threads", entry.config.threads);
+            entry.config.split_n = value.value("split_n", entry.config.split_n);
+            entry.gflops = value.value("gflops", 0.0);
+            table[key] = entry;
+        }
+        return true;
+    }
+    catch (const nlohmann::json::exception &)
+    {
+        return false;
+    }
+}
+
+
+
+bool save(const std::string &path)
+{
+    nlohmann::json root;
+    {
+        std::ifstream existing(path);
+        if (existing)
+        {
+            try { root = nlohmann::json::parse(existing); }
+            catch (const nlohmann::json::exception &) { root = nlohmann::json::object(); }
+        }
+    }
+    root["version"] = 1;
+    nlohmann::json entries = nlohmann::json::object();
+    {
+        std::shared_lock<std::shared_mutex> lock(table_mutex);
+        for (const auto &[key, entry] : table)
+        {
+            entries[keyName(key)] = {
+                {"block_m", entry.config.block_m},
+                {"block_n", entry.config.block_n},
+                {"block_k", entry.config.block_k},
+                {"threads", entry.config.threads},
+                {"split_n", entry.config.split_n},
+                {"gflops", entry.gflops},
+            };
+        }
+    }
+    root["cpus"][cpuKey()] = entries;
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    file << root.dump(2) << '\n';
+    return static_cast<bool>(file);
+}
+
+
+
+std::string cpuKey()
+{
+    static const std::string key = []
+    {
+        std::string model;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int regs[4] = {};
+        char brand[49] = {};
+        for (int i = 0; i < 3; i++)
+        {
+            __cpuid(regs, static_cast<int>(0x80000002u + i));
+            std::memcpy(brand + 16 * i, regs, sizeof(regs));
+        }
+        model = brand;
+#else
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        for (std::string line; std::getline(cpuinfo, line);)
+        {
+            if (line.rfind("model name", 0) == 0)
+            {
+                model = line.substr(line.find(':') + 1);
+                break;
+            }
+        }
+#endif
+        model.erase(0, model.find_first_not_of(' '));
+        if (model.empty()) { model = "unknown-cpu"; }
+        return model + " x" + std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+    }();
+    return key;
+}
+
+
+
+std::string describe()
+{
+    std::ostringstream out;
+    std::shared_lock<std::shared_mutex> lock(table_mutex);
+    out << "GEMM tuning cache for " << cpuKey() << ": " << table.size() << " shapes";
+    for (const auto &[key, entry] : table)
+    {
+        out << "\n  " << keyName(key) << " -> tile " << entry.config.block_m << "x" << entry.config.block_n << "x" << entry.config.block_k
+            << ", " << entry.config.threads << (entry.config.split_n ? " threads over N" : " threads over M")
+            << ", " << static_cast<int>(entry.gflops * 100.0) / 100.0 << " GFLOP/s";
+    }
+    return out.str();
+}
+
+} // namespace GemmAutotuner
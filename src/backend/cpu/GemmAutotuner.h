@@ -0,0 +1,54 @@
+// =============================================================================
+// File: src/backend/cpu/GemmAutotuner.h
+// =============================================================================
+//
+// Description: Per-machine autotuning of CpuOps::gemm. The hot path only ever
+//              looks configurations up: a shape that has not been tuned runs
+//              with the default GemmConfig and is queued. tunePending(),
+//              called at a warm-up point such as after the first training
+//              batch, benchmarks candidate tile sizes and thread splits for
+//              the queued shapes. The winners are kept in a JSON cache keyed
+//              by CPU model and shape, so each machine tunes a shape once.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "backend/cpu/CpuOps.h"
+
+
+
+#include <cstddef>
+#include <string>
+
+
+
+namespace GemmAutotuner
+{
+    inline constexpr const char *kDefaultCachePath = "gemm_tuning.json";
+
+    // Tuned configuration for the shape, or the defaults. Never tunes.
+    // tuned, when given, reports which of the two was returned.
+    [[nodiscard]] GemmConfig lookup(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, bool *tuned = nullptr);
+
+    // Benchmarks candidates for one shape now and stores the winner
+    GemmConfig tune(bool trans_a, bool trans_b, size_t m, size_t n, size_t k);
+
+    // Tunes every shape queued by lookup(); returns how many were tuned
+    size_t tunePending();
+
+    // Stop or resume queueing unseen shapes (on by default)
+    void setRecording(bool enabled);
+
+    // The cache file holds entries for several CPUs; only this machine's are
+    // loaded, and saving preserves the others
+    bool load(const std::string &path = kDefaultCachePath);
+    bool save(const std::string &path = kDefaultCachePath);
+
+    // CPU model string plus hardware thread count
+    [[nodiscard]] std::string cpuKey();
+
+    [[nodiscard]] std::string describe();
+}
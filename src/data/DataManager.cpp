@@ -13,6 +13,8 @@
 
 
 #include "nlp/Parser.h"
+#include "nn/AllocationTracker.h"
+#include "perf/PerfCounters.h"
 #include "utils/Http.h"
 #include "utils/Zip.h"
 
@@ -22,6 +24,7 @@
 #include <ctime>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <numeric>
 #include <random>
@@ -164,14 +167,16 @@ void DataManager::downloadMnist()
         "t10k-labels-idx1-ubyte.gz"
     };
 
-    for (size_t i = 0; i < files.size(); i++)
+    // Each file falls back independently; the four run concurrently and share
+    // pooled connections to each host
+    auto fetch = [&](size_t i)
     {
         // Try primary URL
         try
         {
             std::cout << "[Data] Downloading " << files[i] << " from primary source..." << '\n';
             Http::downloadFileFromUrl(primary_urls[i], "./data/mnist/" + files[i]);
-            continue; // If successful, continue to next file
+            return; // If successful, this file is done
         }
         catch (const std::exception &)
         {
@@ -183,7 +188,7 @@ void DataManager::downloadMnist()
         {
             std::cout << "[Data] Trying fallback source for " << files[i] << "..." << '\n';
             Http::downloadFileFromUrl(fallback_urls[i], "./data/mnist/" + files[i]);
-            continue; // If successful, continue to next file
+            return; // If successful, this file is done
         }
         catch (const std::exception &)
         {
@@ -225,6 +230,16 @@ void DataManager::downloadMnist()
             std::filesystem::remove("./data/mnist/" + files[i]);
             throw std::runtime_error("All download attempts failed for " + files[i] + ": " + e.what());
         }
+    };
+
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        pending.push_back(std::async(std::launch::async, fetch, i));
+    }
+    for (auto &download : pending)
+    {
+        download.get();
     }
 }
 
@@ -234,10 +249,14 @@ void DataManager::loadMnist()
 {
     try
     {
-        X_train = loadMnistImages("./data/mnist/train-images-idx3-ubyte.gz");
-        y_train = loadMnistLabels("./data/mnist/train-labels-idx1-ubyte.gz");
-        X_test = loadMnistImages("./data/mnist/t10k-images-idx3-ubyte.gz");
+        // The four files are independent; decompress and parse them concurrently
+        auto train_images = std::async(std::launch::async, [this] { return loadMnistImages("./data/mnist/train-images-idx3-ubyte.gz"); });
+        auto train_labels = std::async(std::launch::async, [this] { return loadMnistLabels("./data/mnist/train-labels-idx1-ubyte.gz"); });
+        auto test_images = std::async(std::launch::async, [this] { return loadMnistImages("./data/mnist/t10k-images-idx3-ubyte.gz"); });
         y_test = loadMnistLabels("./data/mnist/t10k-labels-idx1-ubyte.gz");
+        X_train = train_images.get();
+        y_train = train_labels.get();
+        X_test = test_images.get();
         std::cout << "[Data] MNIST loaded. Training samples: " << X_train.getRows() << ", Test samples: " << X_test.getRows() << '\n';
     }
     catch (const std::exception &e)
@@ -555,17 +574,15 @@ void DataManager::loadMnistDirect()
 
     try
     {
-        std::cout << "[Data] Downloading and decompressing train images..." << '\n';
-        auto train_images_data = Http::downloadAndDecompress(train_images_url);
-
-        std::cout << "[Data] Downloading and decompressing train labels..." << '\n';
-        auto train_labels_data = Http::downloadAndDecompress(train_labels_url);
-
-        std::cout << "[Data] Downloading and decompressing test images..." << '\n';
-        auto test_images_data = Http::downloadAndDecompress(test_images_url);
-
-        std::cout << "[Data] Downloading and decompressing test labels..." << '\n';
+        // The four downloads are independent, so they run concurrently
+        std::cout << "[Data] Downloading and decompressing train/test images and labels..." << '\n';
+        auto train_images = std::async(std::launch::async, [&] { return Http::downloadAndDecompress(train_images_url); });
+        auto train_labels = std::async(std::launch::async, [&] { return Http::downloadAndDecompress(train_labels_url); });
+        auto test_images = std::async(std::launch::async, [&] { return Http::downloadAndDecompress(test_images_url); });
         auto test_labels_data = Http::downloadAndDecompress(test_labels_url);
+        auto train_images_data = train_images.get();
+        auto train_labels_data = train_labels.get();
+        auto test_images_data = test_images.get();
 
         // Parse the downloaded data
         X_train = parseMnistImages(train_images_data);
@@ -697,6 +714,8 @@ std::pair<Tensor, Tensor> DataManager::getTrainBatch(size_t batch_size)
     }
 
     // Create batch tensors by copying data
+    PerfCounters::Region region("batch gather");
+    AllocationTracker::Scope tag("batch gather");
     Tensor X_batch{{batch_size, X_train.getCols()}};
     Tensor y_batch{{batch_size, y_train.getCols()}};
 
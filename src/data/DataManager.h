@@ -55,6 +55,13 @@ public:
     // Get all test labels for evaluation
     [[nodiscard]] Tensor getTestLabels() const;
 
+    // Read-only views of the loaded tensors, shared without copying (e.g. by
+    // concurrent tuning trials). Valid until the next dataset load.
+    [[nodiscard]] const Tensor &getTrainInputs() const noexcept { return X_train; }
+    [[nodiscard]] const Tensor &getTrainTargets() const noexcept { return y_train; }
+    [[nodiscard]] const Tensor &getTestInputs() const noexcept { return X_test; }
+    [[nodiscard]] const Tensor &getTestTargets() const noexcept { return y_test; }
+
     // Get dataset statistics for architecture inference
     struct DatasetStats
     {
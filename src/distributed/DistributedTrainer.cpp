@@ -0,0 +1,679 @@
+// =============================================================================
+// File: src/distributed/DistributedTrainer.cpp
+// =============================================================================
+//
+// Description: Implements the ring all-reduce, the bucketed data-parallel
+//              trainer and the local multi-process scaling benchmark.
+//
+// =============================================================================
+
+#include "distributed/DistributedTrainer.h"
+
+
+
+#include "data/DataManager.h"
+#include "nn/Loss.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Softmax.h"
+#include "nn/optimizers/SGD.h"
+
+
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+
+
+    std::vector<Dense *> denseLayers(const Model &model)
+    {
+        std::vector<Dense *> result;
+        for(const auto &layer : model.getLayers())
+        {
+            if(auto *dense = dynamic_cast<Dense *>(layer.get()))
+            {
+                result.push_back(dense);
+            }
+        }
+        return result;
+    }
+
+
+
+    void gatherRows(const Tensor &src, const size_t *rows, size_t count, Tensor &dst)
+    {
+        const size_t cols = src.getCols();
+        if((dst.getRows() != count) || (dst.getCols() != cols))
+        {
+            dst = Tensor{{count, cols}};
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            std::copy_n(src.getCpuData() + rows[i] * cols, cols, dst.getCpuData() + i * cols);
+        }
+    }
+}
+
+
+
+// --- Ring all-reduce ---
+
+void ringAllReduce(Transport &transport, float *data, size_t count, std::vector<float> &scratch)
+{
+    const size_t world = transport.getWorldSize();
+    const size_t rank = transport.getRank();
+    if((world <= 1) || (count == 0)) { return; }
+
+    const auto offset = [count, world](size_t chunk) { return count * chunk / world; };
+    const auto length = [&offset](size_t chunk) { return offset(chunk + 1) - offset(chunk); };
+    scratch.resize(count / world + 1);
+
+    // Reduce-scatter: after N - 1 steps rank r holds the full sum of chunk r + 1
+    for(size_t step = 0; step + 1 < world; step++)
+    {
+        const size_t send_chunk = (rank + world - step) % world;
+        const size_t recv_chunk = (rank + world - step - 1) % world;
+        transport.sendRecv(data + offset(send_chunk), length(send_chunk) * sizeof(float),
+                           scratch.data(), length(recv_chunk) * sizeof(float));
+        float *target = data + offset(recv_chunk);
+        const size_t n = length(recv_chunk);
+        for(size_t i = 0; i < n; i++)
+        {
+            target[i] += scratch[i];
+        }
+    }
+
+    // All-gather: circulate the reduced chunks until every rank has all of them
+    for(size_t step = 0; step + 1 < world; step++)
+    {
+        const size_t send_chunk = (rank + 1 + world - step) % world;
+        const size_t recv_chunk = (rank + world - step) % world;
+        transport.sendRecv(data + offset(send_chunk), length(send_chunk) * sizeof(float),
+                           data + offset(recv_chunk), length(recv_chunk) * sizeof(float));
+    }
+}
+
+
+
+// --- ShardSampler ---
+
+ShardSampler::ShardSampler(size_t dataset_size, size_t rank, size_t world_size, std::uint64_t seed)
+    : dataset_size{dataset_size}, rank{rank}, world_size{world_size}, seed{seed}
+{
+    if((world_size == 0) || (rank >= world_size))
+    {
+        throw std::invalid_argument("ShardSampler: rank must be smaller than world size.");
+    }
+    setEpoch(0);
+}
+
+
+
+void ShardSampler::setEpoch(size_t epoch)
+{
+    // Fisher-Yates with mt19937_64, whose output the standard pins down, so
+    // ranks on different hosts and standard libraries agree on the permutation
+    std::vector<size_t> order(dataset_size);
+    for(size_t i = 0; i < dataset_size; i++) { order[i] = i; }
+    std::mt19937_64 rng(seed + 0x9E3779B97F4A7C15ull * (epoch + 1));
+    for(size_t i = dataset_size; i > 1; i--)
+    {
+        std::swap(order[i - 1], order[rng() % i]);
+    }
+
+    const size_t per_rank = dataset_size / world_size;
+    indices.resize(per_rank);
+    for(size_t i = 0; i < per_rank; i++)
+    {
+        indices[i] = order[i * world_size + rank];
+    }
+}
+
+
+
+// --- DistributedTrainer ---
+
+DistributedTrainer::DistributedTrainer(Model &model, Transport &transport, const DistributedOptions &options)
+    : model{model}, transport{transport}, options{options}
+{
+    if(!model.getLoss() || !model.getOptimizer())
+    {
+        throw std::invalid_argument("DistributedTrainer: the model must be compiled first.");
+    }
+    if(options.overlap && (transport.getWorldSize() > 1))
+    {
+        comm_thread = std::thread(&DistributedTrainer::commLoop, this);
+    }
+}
+
+
+
+DistributedTrainer::~DistributedTrainer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    if(comm_thread.joinable())
+    {
+        comm_thread.join();
+    }
+}
+
+
+
+void DistributedTrainer::broadcastParameters()
+{
+    // A sum in which only rank 0 contributes is a broadcast
+    const auto layers = denseLayers(model);
+    size_t total = 0;
+    for(Dense *dense : layers)
+    {
+        total += dense->weights.getSize() + dense->biases.getSize();
+    }
+    flat.assign(total, 0.0f);
+    if(transport.getRank() == 0)
+    {
+        size_t pos = 0;
+        for(Dense *dense : layers)
+        {
+            pos = std::copy_n(dense->weights.getCpuData(), dense->weights.getSize(), flat.begin() + pos) - flat.begin();
+            pos = std::copy_n(dense->biases.getCpuData(), dense->biases.getSize(), flat.begin() + pos) - flat.begin();
+        }
+    }
+    ringAllReduce(transport, flat.data(), flat.size(), scratch);
+    size_t pos = 0;
+    for(Dense *dense : layers)
+    {
+        std::copy_n(flat.data() + pos, dense->weights.getSize(), dense->weights.getCpuData());
+        pos += dense->weights.getSize();
+        std::copy_n(flat.data() + pos, dense->biases.getSize(), dense->biases.getCpuData());
+        pos += dense->biases.getSize();
+    }
+}
+
+
+
+float DistributedTrainer::trainStep(const Tensor &X_batch, const Tensor &y_batch)
+{
+    const auto start = Clock::now();
+    Tensor y_pred = model.forward(X_batch);
+    const float loss = model.getLoss()->forward(y_pred, y_batch);
+    Tensor grad = model.getLoss()->backward(y_pred, y_batch);
+
+    // Walk backward and hand each full bucket to the communication thread, so
+    // the last layers' gradients are in flight while earlier layers compute
+    const auto &layers = model.getLayers();
+    const size_t bucket_floats = std::max<size_t>(1, options.bucket_bytes / sizeof(float));
+    Bucket pending;
+    for(auto it = layers.rbegin(); it != layers.rend(); it++)
+    {
+        if((*it)->isIdentity()) { continue; }
+        grad = (*it)->backward(grad);
+        if(auto *dense = dynamic_cast<Dense *>(it->get()))
+        {
+            pending.layers.push_back(dense);
+            pending.floats += dense->getGradWeights().getSize() + dense->getGradBiases().getSize();
+            if(pending.floats >= bucket_floats)
+            {
+                enqueue(std::move(pending));
+                pending = Bucket{};
+            }
+        }
+    }
+    if(!pending.layers.empty())
+    {
+        enqueue(std::move(pending));
+    }
+
+    const auto wait_start = Clock::now();
+    waitForBuckets();
+    stats.exposed_seconds += secondsSince(wait_start);
+
+    for(auto &layer : layers)
+    {
+        layer->update(*model.getOptimizer());
+    }
+    stats.steps++;
+    stats.step_seconds += secondsSince(start);
+    stats.bytes_sent = transport.getBytesSent();
+    return loss;
+}
+
+
+
+float DistributedTrainer::averageScalar(float value)
+{
+    ringAllReduce(transport, &value, 1, scratch);
+    return value / static_cast<float>(transport.getWorldSize());
+}
+
+
+
+void DistributedTrainer::enqueue(Bucket bucket)
+{
+    if(transport.getWorldSize() <= 1) { return; }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(bucket));
+        submitted++;
+    }
+    if(comm_thread.joinable())
+    {
+        cv.notify_all();
+    }
+}
+
+
+
+void DistributedTrainer::reduceBucket(const Bucket &bucket)
+{
+    const auto start = Clock::now();
+    flat.resize(bucket.floats);
+    size_t pos = 0;
+    for(Dense *dense : bucket.layers)
+    {
+        const Tensor &gw = dense->getGradWeights();
+        const Tensor &gb = dense->getGradBiases();
+        std::copy_n(gw.getCpuData(), gw.getSize(), flat.data() + pos);
+        pos += gw.getSize();
+        std::copy_n(gb.getCpuData(), gb.getSize(), flat.data() + pos);
+        pos += gb.getSize();
+    }
+
+    ringAllReduce(transport, flat.data(), flat.size(), scratch);
+
+    const float scale = 1.0f / static_cast<float>(transport.getWorldSize());
+    pos = 0;
+    for(Dense *dense : bucket.layers)
+    {
+        for(Tensor *g : {&dense->getGradWeights(), &dense->getGradBiases()})
+        {
+            float *out = g->getCpuData();
+            for(size_t i = 0; i < g->getSize(); i++)
+            {
+                out[i] = flat[pos + i] * scale;
+            }
+            pos += g->getSize();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.comm_seconds += secondsSince(start);
+    stats.buckets++;
+}
+
+
+
+void DistributedTrainer::commLoop()
+{
+    for(;;)
+    {
+        Bucket bucket;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if(queue.empty()) { return; }
+            bucket = std::move(queue.front());
+            queue.pop_front();
+        }
+        try
+        {
+            if(!comm_error) { reduceBucket(bucket); }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            comm_error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed++;
+        }
+        cv.notify_all();
+    }
+}
+
+
+
+void DistributedTrainer::waitForBuckets()
+{
+    if(!comm_thread.joinable())
+    {
+        // Non-overlapped mode: reduce everything after backward has finished
+        while(!queue.empty())
+        {
+            reduceBucket(queue.front());
+            queue.pop_front();
+            completed++;
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return completed == submitted; });
+    if(comm_error)
+    {
+        std::rethrow_exception(std::exchange(comm_error, nullptr));
+    }
+}
+
+
+
+// --- DistributedBenchmark ---
+
+namespace
+{
+    constexpr size_t kBenchInputs = 784;
+    constexpr size_t kBenchClasses = 10;
+    constexpr size_t kBenchSamples = 4096;
+    constexpr size_t kBenchWarmup = 5;
+
+
+
+    std::unique_ptr<Model> buildMlp(size_t inputs, size_t classes, float learning_rate)
+    {
+        auto model = std::make_unique<Model>();
+        model->add(std::make_unique<Dense>(inputs, 256));
+        model->add(std::make_unique<Activation>(ActivationType::ReLU));
+        model->add(std::make_unique<Dense>(256, 128));
+        model->add(std::make_unique<Activation>(ActivationType::ReLU));
+        model->add(std::make_unique<Dense>(128, classes));
+        model->add(std::make_unique<Softmax>());
+        model->compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>(learning_rate));
+        return model;
+    }
+
+
+
+    std::unique_ptr<Transport> makeTransport(const std::string &kind, const std::string &tag, std::uint16_t port, size_t rank, size_t world)
+    {
+        if(kind == "shm")
+        {
+            return std::make_unique<ShmTransport>("/ddp_" + tag, rank, world);
+        }
+        if(kind == "tcp")
+        {
+            return std::make_unique<TcpTransport>(std::vector<std::string>(world, "127.0.0.1"), port, rank);
+        }
+        throw std::invalid_argument("Unknown transport '" + kind + "', expected shm or tcp.");
+    }
+
+
+
+#ifdef __linux__
+    struct RankReport
+    {
+        double seconds;
+        double step_seconds;
+        double exposed_seconds;
+        double checksum;
+        int ok;
+    };
+
+
+
+    void benchRank(const std::string &kind, const std::string &tag, std::uint16_t port, size_t rank, size_t world,
+                   size_t steps, size_t batch, RankReport &report)
+    {
+        auto transport = makeTransport(kind, tag, port, rank, world);
+
+        // Every rank generates the same synthetic dataset and trains on its shard
+        Tensor X{{kBenchSamples, kBenchInputs}};
+        Tensor y{{kBenchSamples, kBenchClasses}};
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> pixel(0.0f, 1.0f);
+        for(size_t i = 0; i < X.getSize(); i++) { X.getCpuData()[i] = pixel(rng); }
+        std::fill_n(y.getCpuData(), y.getSize(), 0.0f);
+        for(size_t i = 0; i < kBenchSamples; i++) { y.getCpuData()[i * kBenchClasses + rng() % kBenchClasses] = 1.0f; }
+
+        auto model = buildMlp(kBenchInputs, kBenchClasses, 0.01f);
+        DistributedTrainer trainer(*model, *transport);
+        trainer.broadcastParameters();
+
+        ShardSampler sampler(kBenchSamples, rank, world);
+        size_t epoch = 0;
+        size_t pos = 0;
+        Tensor xb, yb;
+        const auto run = [&](size_t count)
+        {
+            for(size_t s = 0; s < count; s++)
+            {
+                if(pos + batch > sampler.getIndices().size())
+                {
+                    sampler.setEpoch(++epoch);
+                    pos = 0;
+                }
+                gatherRows(X, sampler.getIndices().data() + pos, batch, xb);
+                gatherRows(y, sampler.getIndices().data() + pos, batch, yb);
+                pos += batch;
+                (void)trainer.trainStep(xb, yb);
+            }
+        };
+
+        run(kBenchWarmup);
+        transport->barrier();
+        const DistributedStats before = trainer.getStats();
+        const auto start = Clock::now();
+        run(steps);
+        transport->barrier();
+        report.seconds = secondsSince(start);
+        report.step_seconds = trainer.getStats().step_seconds - before.step_seconds;
+        report.exposed_seconds = trainer.getStats().exposed_seconds - before.exposed_seconds;
+
+        double checksum = 0.0;
+        for(Dense *dense : denseLayers(*model))
+        {
+            for(size_t i = 0; i < dense->weights.getSize(); i++) { checksum += dense->weights.getCpuData()[i] * static_cast<double>(i % 7 + 1); }
+            for(size_t i = 0; i < dense->biases.getSize(); i++) { checksum += dense->biases.getCpuData()[i]; }
+        }
+        report.checksum = checksum;
+        report.ok = 1;
+    }
+
+
+
+    // Runs one measurement with `world` forked processes; returns rank reports
+    std::vector<RankReport> runProcesses(const std::string &kind, size_t world, size_t steps, size_t batch)
+    {
+        const size_t bytes = world * sizeof(RankReport);
+        void *shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if(shared == MAP_FAILED)
+        {
+            throw std::runtime_error("DistributedBenchmark: cannot map the report area.");
+        }
+        auto *reports = static_cast<RankReport *>(shared);
+        std::memset(reports, 0, bytes);
+
+        const std::string tag = std::to_string(getpid()) + "_" + std::to_string(world);
+        const auto port = static_cast<std::uint16_t>(20000 + (getpid() % 2000) * 16);
+        std::cout << std::flush;
+        std::vector<pid_t> children;
+        for(size_t rank = 0; rank < world; rank++)
+        {
+            const pid_t pid = fork();
+            if(pid == 0)
+            {
+                int code = 0;
+                try
+                {
+                    benchRank(kind, tag, port, rank, world, steps, batch, reports[rank]);
+                }
+                catch(const std::exception &e)
+                {
+                    std::cerr << "[APP_LOG] DDP rank " << rank << " failed: " << e.what() << '\n';
+                    code = 1;
+                }
+                _exit(code);
+            }
+            if(pid > 0) { children.push_back(pid); }
+        }
+        for(pid_t child : children)
+        {
+            int status = 0;
+            waitpid(child, &status, 0);
+        }
+
+        std::vector<RankReport> result(reports, reports + world);
+        munmap(shared, bytes);
+        if(children.size() != world)
+        {
+            throw std::runtime_error("DistributedBenchmark: fork failed.");
+        }
+        for(const auto &report : result)
+        {
+            if(!report.ok)
+            {
+                throw std::runtime_error("DistributedBenchmark: a worker process failed.");
+            }
+        }
+        return result;
+    }
+#endif
+}
+
+
+
+namespace DistributedBenchmark
+{
+    ScalingResult runScaling(size_t world_size, const std::string &transport, size_t steps, size_t batch_per_worker)
+    {
+#ifdef __linux__
+        if((world_size == 0) || (steps == 0) || (batch_per_worker == 0))
+        {
+            throw std::invalid_argument("DistributedBenchmark: world size, steps and batch must be positive.");
+        }
+        ScalingResult result;
+        result.transport = transport;
+        result.world_size = world_size;
+        result.steps = steps;
+        result.batch_per_worker = batch_per_worker;
+
+        const auto throughput = [&](const std::vector<RankReport> &reports)
+        {
+            double slowest = 0.0;
+            for(const auto &r : reports) { slowest = std::max(slowest, r.seconds); }
+            return static_cast<double>(reports.size() * steps * batch_per_worker) / slowest;
+        };
+
+        const auto single = runProcesses(transport, 1, steps, batch_per_worker);
+        const auto multi = runProcesses(transport, world_size, steps, batch_per_worker);
+        result.single_samples_per_second = throughput(single);
+        result.samples_per_second = throughput(multi);
+        result.efficiency = result.samples_per_second / (static_cast<double>(world_size) * result.single_samples_per_second);
+        result.comm_fraction = (multi[0].step_seconds > 0.0) ? multi[0].exposed_seconds / multi[0].step_seconds : 0.0;
+        result.replicas_consistent = std::all_of(multi.begin(), multi.end(),
+                                                 [&](const RankReport &r) { return r.checksum == multi[0].checksum; });
+        return result;
+#else
+        (void)world_size; (void)transport; (void)steps; (void)batch_per_worker;
+        throw std::runtime_error("The local scaling benchmark forks worker processes and is only available on Linux.");
+#endif
+    }
+
+
+
+    std::string formatResult(const ScalingResult &result)
+    {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1)
+            << "DDP " << result.transport << " x" << result.world_size
+            << " | batch/worker " << result.batch_per_worker << ", " << result.steps << " steps"
+            << " | 1 proc " << result.single_samples_per_second << " samples/s"
+            << " | " << result.world_size << " procs " << result.samples_per_second << " samples/s"
+            << " | efficiency " << (100.0 * result.efficiency) << "%"
+            << " | exposed comm " << (100.0 * result.comm_fraction) << "%"
+            << " | replicas " << (result.replicas_consistent ? "identical" : "DIVERGED");
+        return out.str();
+    }
+
+
+
+    int runWorker(const WorkerOptions &options)
+    {
+        try
+        {
+            const size_t world = options.hosts.size();
+            TcpTransport transport(options.hosts, options.port, options.rank);
+            std::cout << "[APP_LOG] DDP rank " << options.rank << "/" << world << " connected." << '\n';
+
+            DataManager data;
+            if(!data.loadDataset(Dataset::MNIST))
+            {
+                std::cerr << "[APP_LOG] DDP rank " << options.rank << ": failed to load MNIST." << '\n';
+                return 1;
+            }
+            const Tensor &X = data.getTrainInputs();
+            const Tensor &y = data.getTrainTargets();
+            const auto dataset_stats = data.getDatasetStats();
+
+            auto model = buildMlp(X.getCols(), dataset_stats.num_classes, options.learning_rate);
+            DistributedTrainer trainer(*model, transport);
+            trainer.broadcastParameters();
+
+            ShardSampler sampler(X.getRows(), options.rank, world);
+            Tensor xb, yb;
+            for(size_t epoch = 0; epoch < options.epochs; epoch++)
+            {
+                sampler.setEpoch(epoch);
+                const auto &indices = sampler.getIndices();
+                double loss_sum = 0.0;
+                size_t batches = 0;
+                for(size_t pos = 0; pos + options.batch_size <= indices.size(); pos += options.batch_size)
+                {
+                    gatherRows(X, indices.data() + pos, options.batch_size, xb);
+                    gatherRows(y, indices.data() + pos, options.batch_size, yb);
+                    loss_sum += trainer.trainStep(xb, yb);
+                    batches++;
+                }
+                const float loss = trainer.averageScalar(batches ? static_cast<float>(loss_sum / batches) : 0.0f);
+                if(options.rank == 0)
+                {
+                    std::cout << "[APP_LOG] DDP epoch " << (epoch + 1) << " mean loss " << loss << '\n';
+                }
+            }
+
+            if(options.rank == 0)
+            {
+                const auto [loss, accuracy] = model->evaluate(data.getTestInputs(), data.getTestTargets());
+                const auto &s = trainer.getStats();
+                std::cout << "[APP_LOG] DDP done: test loss " << loss << ", accuracy " << accuracy
+                          << ", exposed comm " << s.exposed_seconds << "s of " << s.step_seconds << "s" << '\n';
+            }
+            transport.barrier();
+            return 0;
+        }
+        catch(const std::exception &e)
+        {
+            std::cerr << "[APP_LOG] DDP rank " << options.rank << " failed: " << e.what() << '\n';
+            return 1;
+        }
+    }
+}
@@ -0,0 +1,176 @@
+// =============================================================================
+// File: src/distributed/DistributedTrainer.h
+// =============================================================================
+//
+// Description: Declares multi-process data-parallel training. Every worker
+//              process holds a full replica of the model and trains on its own
+//              shard of the sample indices; after each backward the Dense
+//              gradients are summed with a ring all-reduce and averaged, so the
+//              replicas apply identical updates. Gradients are grouped into
+//              buckets in backward order and reduced on a communication thread
+//              while backward continues through earlier layers.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "distributed/Transport.h"
+#include "nn/Model.h"
+#include "nn/Tensor.h"
+
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+class Dense;
+
+
+
+// Sums count floats across all ranks in place. Bandwidth-optimal: each rank
+// sends 2 * (N - 1) / N of the buffer. scratch is resized as needed.
+void ringAllReduce(Transport &transport, float *data, size_t count, std::vector<float> &scratch);
+
+
+
+// Deterministic per-epoch partition of [0, dataset_size). All ranks draw the
+// same global permutation from (seed, epoch) and rank r keeps every
+// world_size-th entry starting at r; the tail is dropped so every rank runs
+// the same number of steps.
+class ShardSampler
+{
+public:
+    ShardSampler(size_t dataset_size, size_t rank, size_t world_size, std::uint64_t seed = 42);
+
+    void setEpoch(size_t epoch);
+    [[nodiscard]] const std::vector<size_t> &getIndices() const noexcept { return indices; }
+
+private:
+    size_t dataset_size;
+    size_t rank;
+    size_t world_size;
+    std::uint64_t seed;
+    std::vector<size_t> indices;
+};
+
+
+
+struct DistributedOptions
+{
+    size_t bucket_bytes = 1u << 20; // gradient bytes per all-reduce
+    bool overlap = true;            // reduce buckets while backward continues
+};
+
+
+
+struct DistributedStats
+{
+    size_t steps = 0;
+    size_t buckets = 0;
+    double step_seconds = 0.0;    // wall time inside trainStep
+    double comm_seconds = 0.0;    // time spent inside all-reduce
+    double exposed_seconds = 0.0; // time trainStep waited for communication
+    std::uint64_t bytes_sent = 0;
+};
+
+
+
+class DistributedTrainer
+{
+public:
+    // The model must be compiled; the transport must outlive the trainer
+    DistributedTrainer(Model &model, Transport &transport, const DistributedOptions &options = {});
+    ~DistributedTrainer();
+
+    DistributedTrainer(const DistributedTrainer &) = delete;
+    DistributedTrainer &operator=(const DistributedTrainer &) = delete;
+
+    // Makes every replica start from rank 0's parameters
+    void broadcastParameters();
+
+    // One synchronous data-parallel step on this rank's batch; returns the
+    // local loss
+    [[nodiscard]] float trainStep(const Tensor &X_batch, const Tensor &y_batch);
+
+    // Mean of a scalar across ranks (e.g. loss or accuracy)
+    [[nodiscard]] float averageScalar(float value);
+
+    [[nodiscard]] const DistributedStats &getStats() const noexcept { return stats; }
+
+private:
+    struct Bucket
+    {
+        std::vector<Dense *> layers;
+        size_t floats = 0;
+    };
+
+    void enqueue(Bucket bucket);
+    void reduceBucket(const Bucket &bucket);
+    void commLoop();
+    void waitForBuckets();
+
+    Model &model;
+    Transport &transport;
+    DistributedOptions options;
+    DistributedStats stats;
+    std::vector<float> flat;
+    std::vector<float> scratch;
+
+    std::thread comm_thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Bucket> queue;
+    size_t submitted = 0;
+    size_t completed = 0;
+    bool stopping = false;
+    std::exception_ptr comm_error;
+};
+
+
+
+namespace DistributedBenchmark
+{
+    struct ScalingResult
+    {
+        std::string transport;
+        size_t world_size = 0;
+        size_t steps = 0;
+        size_t batch_per_worker = 0;
+        double single_samples_per_second = 0.0;
+        double samples_per_second = 0.0;
+        double efficiency = 0.0;       // throughput_N / (N * throughput_1)
+        double comm_fraction = 0.0;    // exposed communication / step time on rank 0
+        bool replicas_consistent = false;
+    };
+
+    // Forks world_size local worker processes that train an MNIST-sized MLP on
+    // synthetic data over "shm" or "tcp", after a single-process baseline.
+    // Linux only.
+    [[nodiscard]] ScalingResult runScaling(size_t world_size, const std::string &transport = "shm", size_t steps = 100, size_t batch_per_worker = 64);
+
+    [[nodiscard]] std::string formatResult(const ScalingResult &result);
+
+    struct WorkerOptions
+    {
+        size_t rank = 0;
+        std::vector<std::string> hosts;  // one per rank
+        std::uint16_t port = 29500;
+        size_t epochs = 1;
+        size_t batch_size = 64;
+        float learning_rate = 0.01f;
+    };
+
+    // Trains an MLP on MNIST as one rank of a TCP ring; returns the process
+    // exit code
+    int runWorker(const WorkerOptions &options);
+}
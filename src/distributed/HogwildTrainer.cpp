@@ -0,0 +1,332 @@
+// =============================================================================
+// File: src/distributed/HogwildTrainer.cpp
+// =============================================================================
+//
+// Description: Implements the Hogwild and synchronous multi-threaded SGD
+//              trainers. Shared parameters are only touched through
+//              std::atomic_ref with relaxed ordering, so concurrent updates
+//              are well defined without any locking.
+//
+// =============================================================================
+
+#include "distributed/HogwildTrainer.h"
+
+
+
+#include "distributed/DistributedTrainer.h"
+#include "nn/Loss.h"
+#include "nn/layers/Dense.h"
+
+
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+
+namespace
+{
+    // Per-thread counters, padded so that threads do not false-share them
+    struct alignas(64) ThreadState
+    {
+        double loss_sum = 0.0;
+        size_t batches = 0;
+        size_t samples = 0;
+        size_t applied = 0;
+        size_t dropped = 0;
+        size_t staleness_sum = 0;
+        size_t staleness_max = 0;
+    };
+
+
+
+    // Weights and biases of every Dense layer, in layer order
+    std::vector<Tensor *> parameterTensors(Model &model)
+    {
+        std::vector<Tensor *> result;
+        for(const auto &layer : model.getLayers())
+        {
+            if(auto *dense = dynamic_cast<Dense *>(layer.get()))
+            {
+                result.push_back(&dense->weights);
+                result.push_back(&dense->biases);
+            }
+        }
+        return result;
+    }
+
+
+
+    std::vector<Tensor *> gradientTensors(Model &model)
+    {
+        std::vector<Tensor *> result;
+        for(const auto &layer : model.getLayers())
+        {
+            if(auto *dense = dynamic_cast<Dense *>(layer.get()))
+            {
+                result.push_back(&dense->getGradWeights());
+                result.push_back(&dense->getGradBiases());
+            }
+        }
+        return result;
+    }
+
+
+
+    void gatherRows(const Tensor &src, const size_t *rows, size_t count, Tensor &dst)
+    {
+        const size_t cols = src.getCols();
+        if((dst.getRows() != count) || (dst.getCols() != cols))
+        {
+            dst = Tensor{{count, cols}};
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            std::copy_n(src.getCpuData() + rows[i] * cols, cols, dst.getCpuData() + i * cols);
+        }
+    }
+
+
+
+    void readShared(const std::vector<Tensor *> &shared, const std::vector<Tensor *> &local)
+    {
+        for(size_t k = 0; k < shared.size(); k++)
+        {
+            float *src = shared[k]->getCpuData();
+            float *dst = local[k]->getCpuData();
+            for(size_t i = 0; i < shared[k]->getSize(); i++)
+            {
+                dst[i] = std::atomic_ref<float>(src[i]).load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+
+
+HogwildTrainer::HogwildTrainer(ModelFactory factory, const HogwildOptions &options)
+    : factory{std::move(factory)}, options{options}
+{
+    if(!this->factory)
+    {
+        throw std::invalid_argument("HogwildTrainer: a model factory is required.");
+    }
+    if((options.batch_size == 0) || (options.refresh_interval == 0))
+    {
+        throw std::invalid_argument("HogwildTrainer: batch size and refresh interval must be positive.");
+    }
+    shared = this->factory();
+    if(!shared || !shared->getLoss())
+    {
+        throw std::invalid_argument("HogwildTrainer: the factory must return a compiled model.");
+    }
+}
+
+
+
+HogwildStats HogwildTrainer::train(const Tensor &X, const Tensor &y, size_t epochs)
+{
+    const size_t threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const auto shared_params = parameterTensors(*shared);
+
+    std::vector<std::unique_ptr<Model>> replicas;
+    for(size_t t = 0; t < threads; t++)
+    {
+        replicas.push_back(factory());
+        const auto params = parameterTensors(*replicas.back());
+        const bool same = (params.size() == shared_params.size()) &&
+                          std::equal(params.begin(), params.end(), shared_params.begin(),
+                                     [](const Tensor *a, const Tensor *b) { return a->getShape() == b->getShape(); });
+        if(!same)
+        {
+            throw std::invalid_argument("HogwildTrainer: the factory returned models of different architectures.");
+        }
+        readShared(shared_params, params);
+    }
+
+    std::vector<std::vector<Tensor *>> replica_grads;
+    for(const auto &r : replicas) { replica_grads.push_back(gradientTensors(*r)); }
+
+    size_t total_params = 0;
+    for(const Tensor *p : shared_params) { total_params += p->getSize(); }
+
+    // Dataset placement: spread pages over all nodes, or give every node its
+    // own copy so workers never read the training set across the socket link
+    std::unique_ptr<Numa::ReplicatedTensor> X_copies;
+    std::unique_ptr<Numa::ReplicatedTensor> y_copies;
+    if(options.data_placement == Numa::DataPlacement::Interleave)
+    {
+        (void)Numa::interleave(const_cast<float *>(X.getCpuData()), X.getSize() * sizeof(float));
+        (void)Numa::interleave(const_cast<float *>(y.getCpuData()), y.getSize() * sizeof(float));
+    }
+    else if(options.data_placement == Numa::DataPlacement::Replicate)
+    {
+        X_copies = std::make_unique<Numa::ReplicatedTensor>(X);
+        y_copies = std::make_unique<Numa::ReplicatedTensor>(y);
+    }
+
+    cancelled = false;
+    alignas(64) std::atomic<std::uint64_t> version{0};
+    std::vector<ThreadState> state(threads);
+    bool stop_sync = false;
+    std::barrier sync_point(static_cast<std::ptrdiff_t>(threads), [this, &stop_sync]() noexcept { stop_sync = cancelled.load(); });
+
+    const auto worker = [&](size_t t)
+    {
+        // Pin first: everything the worker allocates from here on (activations,
+        // gradients, batches) is first-touched on its node, and the replica's
+        // parameters, built on the calling thread, are migrated there
+        const size_t node = Numa::pinCurrentThread(t, options.pin_policy);
+        if(options.pin_policy != Numa::PinPolicy::None)
+        {
+            for(Tensor *p : parameterTensors(*replicas[t]))
+            {
+                (void)Numa::bindToNode(p->getCpuData(), p->getSize() * sizeof(float), node);
+            }
+        }
+        const Tensor &X_local = X_copies ? X_copies->local(node) : X;
+        const Tensor &y_local = y_copies ? y_copies->local(node) : y;
+
+        Model &replica = *replicas[t];
+        ThreadState &st = state[t];
+        const auto local = parameterTensors(replica);
+        const auto &grads = replica_grads[t];
+        const float lr = options.learning_rate;
+        ShardSampler sampler(X.getRows(), t, threads, options.seed);
+        Tensor xb, yb;
+        std::uint64_t snapshot = 0;
+        size_t step = 0;
+
+        const auto pull = [&]
+        {
+            snapshot = version.load(std::memory_order_acquire);
+            readShared(shared_params, local);
+        };
+
+        for(size_t epoch = 0; epoch < epochs; epoch++)
+        {
+            sampler.setEpoch(epoch);
+            st.loss_sum = 0.0;
+            st.batches = 0;
+            const auto &indices = sampler.getIndices();
+            for(size_t pos = 0; pos + options.batch_size <= indices.size(); pos += options.batch_size, step++)
+            {
+                if((options.mode == ParallelSgdMode::Hogwild) && cancelled) { return; }
+                gatherRows(X_local, indices.data() + pos, options.batch_size, xb);
+                gatherRows(y_local, indices.data() + pos, options.batch_size, yb);
+                if((options.mode == ParallelSgdMode::Hogwild) && (step % options.refresh_interval == 0))
+                {
+                    pull();
+                }
+
+                Tensor pred = replica.forward(xb);
+                st.loss_sum += replica.getLoss()->forward(pred, yb);
+                st.batches++;
+                st.samples += options.batch_size;
+                replica.backward(replica.getLoss()->backward(pred, yb));
+
+                if(options.mode == ParallelSgdMode::Hogwild)
+                {
+                    const auto staleness = static_cast<size_t>(version.load(std::memory_order_relaxed) - snapshot);
+                    if((options.max_staleness > 0) && (staleness > options.max_staleness))
+                    {
+                        st.dropped++;
+                        pull();
+                        continue;
+                    }
+                    for(size_t k = 0; k < grads.size(); k++)
+                    {
+                        const float *g = grads[k]->getCpuData();
+                        float *target = shared_params[k]->getCpuData();
+                        float *mine = local[k]->getCpuData();
+                        for(size_t i = 0; i < grads[k]->getSize(); i++)
+                        {
+                            const float delta = lr * g[i];
+                            if(options.skip_zero_gradients && (delta == 0.0f)) { continue; }
+                            // Read-modify-write without CAS: a racing update may be
+                            // lost, which Hogwild accepts in exchange for no contention
+                            std::atomic_ref<float> shared_value(target[i]);
+                            shared_value.store(shared_value.load(std::memory_order_relaxed) - delta, std::memory_order_relaxed);
+                            mine[i] -= delta;
+                        }
+                    }
+                    version.fetch_add(1, std::memory_order_release);
+                    st.applied++;
+                    st.staleness_sum += staleness;
+                    st.staleness_max = std::max(st.staleness_max, staleness);
+                    continue;
+                }
+
+                // Synchronous: all gradients ready -> each thread averages and
+                // applies its slice of the parameters -> all threads re-read
+                sync_point.arrive_and_wait();
+                if(stop_sync) { return; }
+                const size_t begin = total_params * t / threads;
+                const size_t end = total_params * (t + 1) / threads;
+                const float scale = lr / static_cast<float>(threads);
+                size_t offset = 0;
+                for(size_t k = 0; k < shared_params.size(); k++)
+                {
+                    const size_t n = shared_params[k]->getSize();
+                    const size_t lo = std::max(begin, offset);
+                    const size_t hi = std::min(end, offset + n);
+                    float *target = shared_params[k]->getCpuData();
+                    for(size_t i = lo; i < hi; i++)
+                    {
+                        float sum = 0.0f;
+                        for(const auto &g : replica_grads)
+                        {
+                            sum += g[k]->getCpuData()[i - offset];
+                        }
+                        target[i - offset] -= scale * sum;
+                    }
+                    offset += n;
+                }
+                sync_point.arrive_and_wait();
+                readShared(shared_params, local);
+                st.applied++;
+            }
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; t++)
+    {
+        pool.emplace_back(worker, t);
+    }
+    for(auto &thread : pool)
+    {
+        thread.join();
+    }
+
+    HogwildStats stats;
+    stats.threads = threads;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double loss_sum = 0.0;
+    size_t batches = 0;
+    size_t staleness_sum = 0;
+    for(const auto &st : state)
+    {
+        stats.samples += st.samples;
+        stats.updates_applied += st.applied;
+        stats.updates_dropped += st.dropped;
+        stats.max_staleness = std::max(stats.max_staleness, st.staleness_max);
+        staleness_sum += st.staleness_sum;
+        loss_sum += st.loss_sum;
+        batches += st.batches;
+    }
+    if(options.mode == ParallelSgdMode::Synchronous)
+    {
+        stats.updates_applied /= threads; // one shared update per lockstep step
+    }
+    stats.mean_staleness = (options.mode == ParallelSgdMode::Hogwild) && (stats.updates_applied > 0)
+                               ? static_cast<double>(staleness_sum) / static_cast<double>(stats.updates_applied) : 0.0;
+    stats.final_loss = batches ? static_cast<float>(loss_sum / static_cast<double>(batches)) : 0.0f;
+    return stats;
+}
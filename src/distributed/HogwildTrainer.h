@@ -0,0 +1,101 @@
+// =============================================================================
+// File: src/distributed/HogwildTrainer.h
+// =============================================================================
+//
+// Description: Declares HogwildTrainer, a multi-threaded SGD trainer for one
+//              process. In Hogwild mode every thread trains a private replica
+//              on its own shard of the samples and writes its SGD step straight
+//              into the shared Dense parameters with relaxed atomic stores, with
+//              no lock and no barrier (Niu et al., "Hogwild!"). Updates may
+//              overwrite each other, which sparse and wide models tolerate well.
+//              A staleness bound drops gradients computed from parameters that
+//              too many other updates have since changed. Synchronous mode runs
+//              the same threads in lockstep with averaged gradients, as the
+//              baseline the asynchronous mode is compared against. Workers can
+//              be pinned per NUMA node; each then keeps its replica and its
+//              activation and gradient buffers on its own node.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Model.h"
+#include "nn/Tensor.h"
+#include "utils/Numa.h"
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+
+
+enum class ParallelSgdMode : std::uint8_t
+{
+    Hogwild,     // lock-free asynchronous updates
+    Synchronous, // lockstep data-parallel with averaged gradients
+};
+
+
+
+struct HogwildOptions
+{
+    ParallelSgdMode mode = ParallelSgdMode::Hogwild;
+    size_t threads = 0;           // 0 = hardware concurrency
+    size_t batch_size = 32;       // per thread
+    float learning_rate = 0.05f;
+    size_t max_staleness = 0;     // Hogwild: drop gradients older than this many updates, 0 = unbounded
+    size_t refresh_interval = 1;  // Hogwild: steps between re-reading the shared parameters
+    bool skip_zero_gradients = true; // Hogwild: do not write parameters whose gradient is exactly zero
+    Numa::PinPolicy pin_policy = Numa::PinPolicy::None;
+    Numa::DataPlacement data_placement = Numa::DataPlacement::FirstTouch;
+    std::uint64_t seed = 42;
+};
+
+
+
+struct HogwildStats
+{
+    size_t threads = 0;
+    size_t samples = 0;
+    size_t updates_applied = 0;
+    size_t updates_dropped = 0;   // rejected by the staleness bound
+    double mean_staleness = 0.0;  // updates by other threads between read and write
+    size_t max_staleness = 0;
+    double seconds = 0.0;
+    float final_loss = 0.0f;      // mean training loss of the last epoch
+};
+
+
+
+class HogwildTrainer
+{
+public:
+    // The factory must return compiled models of identical architecture; one
+    // becomes the shared model, the others are per-thread replicas. Only Dense
+    // parameters are shared and only plain SGD is applied, since optimizer
+    // state such as Adam moments cannot be updated lock-free.
+    using ModelFactory = std::function<std::unique_ptr<Model>()>;
+
+    HogwildTrainer(ModelFactory factory, const HogwildOptions &options = {});
+
+    // Trains the shared model; X and y are read concurrently and must not
+    // change during the call. DataPlacement::Interleave changes the page
+    // placement of X and y themselves.
+    HogwildStats train(const Tensor &X, const Tensor &y, size_t epochs);
+
+    // Asks running threads to stop after their current batch
+    void cancel() { cancelled = true; }
+
+    [[nodiscard]] Model &getModel() noexcept { return *shared; }
+
+private:
+    ModelFactory factory;
+    HogwildOptions options;
+    std::unique_ptr<Model> shared;
+    std::atomic<bool> cancelled{false};
+};
@@ -0,0 +1,480 @@
+// =============================================================================
+// File: src/distributed/Transport.cpp
+// =============================================================================
+//
+// Description: Implements the shared-memory and TCP ring transports.
+//
+// =============================================================================
+
+#include "distributed/Transport.h"
+
+
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+
+
+// --- Transport ---
+
+void Transport::barrier()
+{
+    // Two trips around the ring: the first proves every rank has arrived,
+    // the second releases them
+    for(int trip = 0; trip < 2; trip++)
+    {
+        std::uint8_t token = 1;
+        std::uint8_t received = 0;
+        for(size_t hop = 1; hop < getWorldSize(); hop++)
+        {
+            sendRecv(&token, 1, &received, 1);
+        }
+    }
+}
+
+
+
+// --- ShmTransport ---
+
+namespace
+{
+    constexpr std::uint32_t kShmMagic = 0x44445031u; // "DDP1"
+
+    struct ShmHeader
+    {
+        std::atomic<std::uint32_t> ready;
+        std::atomic<std::uint32_t> attached;
+    };
+
+    // One per rank: the channel from that rank to its successor. The counters
+    // sit on separate cache lines so writer and reader do not false-share.
+    struct alignas(64) Mailbox
+    {
+        alignas(64) std::atomic<std::uint64_t> written;
+        alignas(64) std::atomic<std::uint64_t> read;
+        alignas(64) std::uint64_t piece_bytes;
+    };
+
+    constexpr size_t kHeaderBytes = 64;
+
+    size_t mailboxStride(size_t mailbox_bytes)
+    {
+        return sizeof(Mailbox) + ((mailbox_bytes + 63) / 64) * 64;
+    }
+}
+
+
+
+#ifdef __linux__
+
+ShmTransport::ShmTransport(const std::string &name, size_t rank, size_t world_size, size_t mailbox_bytes)
+    : name{(name.empty() || name[0] != '/') ? "/" + name : name}, rank{rank}, world_size{world_size}, mailbox_bytes{mailbox_bytes}
+{
+    if((world_size == 0) || (rank >= world_size) || (mailbox_bytes == 0))
+    {
+        throw std::invalid_argument("ShmTransport: invalid rank, world size or mailbox size.");
+    }
+    segment_bytes = kHeaderBytes + world_size * mailboxStride(mailbox_bytes);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+
+    int fd = -1;
+    if(rank == 0)
+    {
+        shm_unlink(this->name.c_str()); // stale segment from a crashed run
+        fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if((fd < 0) || (ftruncate(fd, static_cast<off_t>(segment_bytes)) != 0))
+        {
+            if(fd >= 0) { close(fd); }
+            throw std::runtime_error("ShmTransport: cannot create shared memory segment " + this->name);
+        }
+    }
+    else
+    {
+        for(;;)
+        {
+            fd = shm_open(this->name.c_str(), O_RDWR, 0600);
+            struct stat st{};
+            if((fd >= 0) && (fstat(fd, &st) == 0) && (static_cast<size_t>(st.st_size) == segment_bytes)) { break; }
+            if(fd >= 0) { close(fd); fd = -1; }
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                throw std::runtime_error("ShmTransport: timed out waiting for rank 0 to create " + this->name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void *mapped = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("ShmTransport: mmap failed for " + this->name);
+    }
+    segment = static_cast<unsigned char *>(mapped);
+    auto *header = reinterpret_cast<ShmHeader *>(segment);
+
+    if(rank == 0)
+    {
+        new(&header->attached) std::atomic<std::uint32_t>(0);
+        for(size_t r = 0; r < world_size; r++)
+        {
+            auto *box = new(segment + kHeaderBytes + r * mailboxStride(mailbox_bytes)) Mailbox;
+            box->written.store(0, std::memory_order_relaxed);
+            box->read.store(0, std::memory_order_relaxed);
+            box->piece_bytes = 0;
+        }
+        header->ready.store(kShmMagic, std::memory_order_release);
+    }
+    else
+    {
+        while(header->ready.load(std::memory_order_acquire) != kShmMagic)
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                munmap(segment, segment_bytes);
+                throw std::runtime_error("ShmTransport: segment " + this->name + " was never initialized.");
+            }
+            std::this_thread::yield();
+        }
+    }
+    header->attached.fetch_add(1, std::memory_order_acq_rel);
+
+    // Once everyone is mapped the name is no longer needed, so a crash later
+    // cannot leak the segment
+    if(rank == 0)
+    {
+        while(header->attached.load(std::memory_order_acquire) < world_size)
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                shm_unlink(this->name.c_str());
+                munmap(segment, segment_bytes);
+                throw std::runtime_error("ShmTransport: not every rank attached to " + this->name);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        shm_unlink(this->name.c_str());
+    }
+}
+
+
+
+ShmTransport::~ShmTransport()
+{
+    if(segment)
+    {
+        munmap(segment, segment_bytes);
+    }
+}
+
+
+
+void ShmTransport::sendRecv(const void *send, size_t send_bytes, void *recv, size_t recv_bytes)
+{
+    const size_t stride = mailboxStride(mailbox_bytes);
+    auto *out = reinterpret_cast<Mailbox *>(segment + kHeaderBytes + rank * stride);
+    auto *in = reinterpret_cast<Mailbox *>(segment + kHeaderBytes + ((rank + world_size - 1) % world_size) * stride);
+    unsigned char *out_data = reinterpret_cast<unsigned char *>(out) + sizeof(Mailbox);
+    const unsigned char *in_data = reinterpret_cast<const unsigned char *>(in) + sizeof(Mailbox);
+    const auto *src = static_cast<const unsigned char *>(send);
+    auto *dst = static_cast<unsigned char *>(recv);
+
+    size_t sent = 0;
+    size_t received = 0;
+    size_t idle = 0;
+    while((sent < send_bytes) || (received < recv_bytes))
+    {
+        bool progress = false;
+        // The successor has consumed everything we wrote: post the next piece
+        if((sent < send_bytes) &&
+           (out->read.load(std::memory_order_acquire) == out->written.load(std::memory_order_relaxed)))
+        {
+            const size_t piece = std::min(mailbox_bytes, send_bytes - sent);
+            std::memcpy(out_data, src + sent, piece);
+            out->piece_bytes = piece;
+            out->written.fetch_add(1, std::memory_order_release);
+            sent += piece;
+            progress = true;
+        }
+        // The predecessor posted a piece we have not read yet
+        if((received < recv_bytes) &&
+           (in->written.load(std::memory_order_acquire) != in->read.load(std::memory_order_relaxed)))
+        {
+            const size_t piece = in->piece_bytes;
+            if((piece == 0) || ((received + piece) > recv_bytes))
+            {
+                throw std::runtime_error("ShmTransport: message size mismatch between neighbouring ranks.");
+            }
+            std::memcpy(dst + received, in_data, piece);
+            in->read.fetch_add(1, std::memory_order_release);
+            received += piece;
+            progress = true;
+        }
+        if(progress)
+        {
+            idle = 0;
+        }
+        else if(++idle > 64)
+        {
+            std::this_thread::yield();
+        }
+    }
+    bytes_sent += send_bytes;
+}
+
+#else
+
+ShmTransport::ShmTransport(const std::string &name, size_t rank, size_t world_size, size_t mailbox_bytes)
+    : name{name}, rank{rank}, world_size{world_size}, mailbox_bytes{mailbox_bytes}
+{
+    throw std::runtime_error("ShmTransport is only available on Linux; use TcpTransport.");
+}
+
+
+
+ShmTransport::~ShmTransport() = default;
+
+
+
+void ShmTransport::sendRecv(const void *, size_t, void *, size_t)
+{
+    throw std::runtime_error("ShmTransport is only available on Linux; use TcpTransport.");
+}
+
+#endif
+
+
+
+// --- TcpTransport ---
+
+namespace
+{
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+    void closeSocket(SocketHandle s) { closesocket(s); }
+    bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+    int pollSockets(WSAPOLLFD *fds, size_t count, int timeout_ms) { return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms); }
+    using PollFd = WSAPOLLFD;
+    constexpr int kSendFlags = 0;
+
+    void setNonBlocking(SocketHandle s)
+    {
+        u_long mode = 1;
+        ioctlsocket(s, FIONBIO, &mode);
+    }
+
+    void initSockets()
+    {
+        static const bool initialized = []
+        {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        if(!initialized)
+        {
+            throw std::runtime_error("TcpTransport: WSAStartup failed.");
+        }
+    }
+#else
+    using SocketHandle = int;
+    constexpr SocketHandle kInvalidSocket = -1;
+    void closeSocket(SocketHandle s) { close(s); }
+    bool wouldBlock() { return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR); }
+    int pollSockets(pollfd *fds, size_t count, int timeout_ms) { return poll(fds, static_cast<nfds_t>(count), timeout_ms); }
+    using PollFd = pollfd;
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0;
+#endif
+
+    void setNonBlocking(SocketHandle s)
+    {
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    void initSockets()
+    {
+    }
+#endif
+
+    void setNoDelay(SocketHandle s)
+    {
+        int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+    }
+
+
+
+    addrinfo *resolve(const std::string &host, std::uint16_t port, bool passive)
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        addrinfo *result = nullptr;
+        const std::string service = std::to_string(port);
+        if(getaddrinfo(passive ? nullptr : host.c_str(), service.c_str(), &hints, &result) != 0)
+        {
+            throw std::runtime_error("TcpTransport: cannot resolve " + host + ":" + service);
+        }
+        return result;
+    }
+}
+
+
+
+TcpTransport::TcpTransport(const std::vector<std::string> &hosts, std::uint16_t base_port, size_t rank, double connect_timeout_seconds)
+    : rank{rank}, world_size{hosts.size()}
+{
+    if((world_size == 0) || (rank >= world_size))
+    {
+        throw std::invalid_argument("TcpTransport: rank must index into the host list.");
+    }
+    if(world_size == 1) { return; }
+    initSockets();
+
+    // Listen first so the predecessor can connect while we dial the successor
+    addrinfo *local = resolve(hosts[rank], static_cast<std::uint16_t>(base_port + rank), true);
+    SocketHandle listener = socket(local->ai_family, local->ai_socktype, local->ai_protocol);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one));
+    const bool listening = (listener != kInvalidSocket) &&
+                           (bind(listener, local->ai_addr, static_cast<int>(local->ai_addrlen)) == 0) && (listen(listener, 1) == 0);
+    freeaddrinfo(local);
+    if(!listening)
+    {
+        if(listener != kInvalidSocket) { closeSocket(listener); }
+        throw std::runtime_error("TcpTransport: cannot listen on port " + std::to_string(base_port + rank));
+    }
+
+    const size_t next = (rank + 1) % world_size;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(connect_timeout_seconds);
+    SocketHandle out = kInvalidSocket;
+    while(out == kInvalidSocket)
+    {
+        addrinfo *remote = resolve(hosts[next], static_cast<std::uint16_t>(base_port + next), false);
+        SocketHandle s = socket(remote->ai_family, remote->ai_socktype, remote->ai_protocol);
+        if((s != kInvalidSocket) && (connect(s, remote->ai_addr, static_cast<int>(remote->ai_addrlen)) == 0))
+        {
+            out = s;
+        }
+        else if(s != kInvalidSocket)
+        {
+            closeSocket(s);
+        }
+        freeaddrinfo(remote);
+        if(out == kInvalidSocket)
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                closeSocket(listener);
+                throw std::runtime_error("TcpTransport: timed out connecting to rank " + std::to_string(next));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    SocketHandle in = accept(listener, nullptr, nullptr);
+    closeSocket(listener);
+    if(in == kInvalidSocket)
+    {
+        closeSocket(out);
+        throw std::runtime_error("TcpTransport: accept from the previous rank failed.");
+    }
+    setNoDelay(out);
+    setNoDelay(in);
+    setNonBlocking(out);
+    setNonBlocking(in);
+    next_socket = static_cast<std::intptr_t>(out);
+    prev_socket = static_cast<std::intptr_t>(in);
+}
+
+
+
+TcpTransport::~TcpTransport()
+{
+    if(next_socket != -1) { closeSocket(static_cast<SocketHandle>(next_socket)); }
+    if(prev_socket != -1) { closeSocket(static_cast<SocketHandle>(prev_socket)); }
+}
+
+
+
+void TcpTransport::sendRecv(const void *send, size_t send_bytes, void *recv, size_t recv_bytes)
+{
+    if(world_size == 1)
+    {
+        std::memcpy(recv, send, std::min(send_bytes, recv_bytes));
+        return;
+    }
+    const auto out = static_cast<SocketHandle>(next_socket);
+    const auto in = static_cast<SocketHandle>(prev_socket);
+    const auto *src = static_cast<const char *>(send);
+    auto *dst = static_cast<char *>(recv);
+    constexpr size_t kMaxIo = 1u << 20;
+
+    size_t sent = 0;
+    size_t received = 0;
+    while((sent < send_bytes) || (received < recv_bytes))
+    {
+        PollFd fds[2]{};
+        size_t count = 0;
+        if(sent < send_bytes) { fds[count].fd = out; fds[count].events = POLLOUT; count++; }
+        if(received < recv_bytes) { fds[count].fd = in; fds[count].events = POLLIN; count++; }
+        if(pollSockets(fds, count, 1000) < 0)
+        {
+            throw std::runtime_error("TcpTransport: poll failed.");
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            if(fds[i].revents & (POLLERR | POLLNVAL))
+            {
+                throw std::runtime_error("TcpTransport: socket error on ring connection.");
+            }
+            if((fds[i].fd == out) && (fds[i].revents & POLLOUT))
+            {
+                const auto n = ::send(out, src + sent, static_cast<int>(std::min(kMaxIo, send_bytes - sent)), kSendFlags);
+                if(n > 0) { sent += static_cast<size_t>(n); }
+                else if(!wouldBlock()) { throw std::runtime_error("TcpTransport: send to the next rank failed."); }
+            }
+            if((fds[i].fd == in) && (fds[i].revents & (POLLIN | POLLHUP)))
+            {
+                const auto n = ::recv(in, dst + received, static_cast<int>(std::min(kMaxIo, recv_bytes - received)), 0);
+                if(n > 0) { received += static_cast<size_t>(n); }
+                else if(n == 0) { throw std::runtime_error("TcpTransport: previous rank closed the connection."); }
+                else if(!wouldBlock()) { throw std::runtime_error("TcpTransport: receive from the previous rank failed."); }
+            }
+        }
+    }
+    bytes_sent += send_bytes;
+}
@@ -0,0 +1,96 @@
+// =============================================================================
+// File: src/distributed/Transport.h
+// =============================================================================
+//
+// Description: Declares the point-to-point transports used by data-parallel
+//              training. Workers form a ring, so a transport only needs a
+//              channel to the next rank and one from the previous rank.
+//              ShmTransport uses a POSIX shared-memory segment with one
+//              mailbox per rank (single host, Linux). TcpTransport uses one
+//              socket per neighbour and works across hosts. Both implement
+//              sendRecv with non-blocking progress on the two directions, so
+//              ring exchanges cannot deadlock on full buffers.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    [[nodiscard]] virtual size_t getRank() const noexcept = 0;
+    [[nodiscard]] virtual size_t getWorldSize() const noexcept = 0;
+
+    // Sends send_bytes to the next rank while receiving recv_bytes from the
+    // previous one; returns when both have completed.
+    virtual void sendRecv(const void *send, size_t send_bytes, void *recv, size_t recv_bytes) = 0;
+
+    // Returns once every rank has entered the barrier
+    void barrier();
+
+    [[nodiscard]] std::uint64_t getBytesSent() const noexcept { return bytes_sent; }
+
+protected:
+    std::uint64_t bytes_sent = 0;
+};
+
+
+
+// Single-host transport over a named shared-memory segment. Rank 0 creates
+// the segment, the others attach to it; it is unlinked when rank 0 closes.
+class ShmTransport final : public Transport
+{
+public:
+    ShmTransport(const std::string &name, size_t rank, size_t world_size, size_t mailbox_bytes = 4u << 20);
+    ~ShmTransport() override;
+
+    ShmTransport(const ShmTransport &) = delete;
+    ShmTransport &operator=(const ShmTransport &) = delete;
+
+    [[nodiscard]] size_t getRank() const noexcept override { return rank; }
+    [[nodiscard]] size_t getWorldSize() const noexcept override { return world_size; }
+    void sendRecv(const void *send, size_t send_bytes, void *recv, size_t recv_bytes) override;
+
+private:
+    std::string name;
+    size_t rank;
+    size_t world_size;
+    size_t mailbox_bytes;
+    size_t segment_bytes = 0;
+    unsigned char *segment = nullptr;
+};
+
+
+
+// Ring over TCP: rank r listens on hosts[r]:base_port + r, connects to rank
+// r + 1 and accepts rank r - 1.
+class TcpTransport final : public Transport
+{
+public:
+    TcpTransport(const std::vector<std::string> &hosts, std::uint16_t base_port, size_t rank, double connect_timeout_seconds = 60.0);
+    ~TcpTransport() override;
+
+    TcpTransport(const TcpTransport &) = delete;
+    TcpTransport &operator=(const TcpTransport &) = delete;
+
+    [[nodiscard]] size_t getRank() const noexcept override { return rank; }
+    [[nodiscard]] size_t getWorldSize() const noexcept override { return world_size; }
+    void sendRecv(const void *send, size_t send_bytes, void *recv, size_t recv_bytes) override;
+
+private:
+    size_t rank;
+    size_t world_size;
+    std::intptr_t next_socket = -1; // to rank + 1
+    std::intptr_t prev_socket = -1; // from rank - 1
+};
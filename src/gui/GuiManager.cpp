@@ -13,16 +13,24 @@
 
 
 
+#include "backend/cpu/GemmAutotuner.h"
 #include "data/DataManager.h"
 #include "gui/Visualizer.h"
-#include "nn/Loss.h"
+#include "nn/AllocationTracker.h"
+#include "nn/HostMemory.h"
 #include "nn/Model.h"
-#include "nn/layers/Activation.h"
+#include "nn/NumericHealth.h"
+#include "nn/Pruning.h"
+#include "nn/autograd/GradCheck.h"
 #include "nn/layers/Dense.h"
-#include "nn/layers/Softmax.h"
-#include "nn/optimizers/Adam.h"
 #include "nn/optimizers/SGD.h"
+#include "nlp/CommandPipeline.h"
 #include "nlp/Parser.h"
+#include "perf/Benchmark.h"
+#include "perf/PerfCounters.h"
+#include "tuning/AutoConfig.h"
+#include "tuning/HyperparameterSearch.h"
+#include "utils/EventLog.h"
 
 
 
@@ -33,9 +41,10 @@
 
 
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <future>
+#include <cstdio>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -52,6 +61,36 @@
 // --- Global state for training thread ---
 std::atomic<bool> isTraining(false);
 std::thread trainingThread;
+// Set until the (detached) training thread has stopped touching the model and
+// data; after Stop it stays set while the current batch finishes
+std::atomic<bool> trainingThreadRunning(false);
+std::atomic<bool> isBenchmarking(false);
+std::atomic<bool> isTuning(false);
+std::atomic<bool> isCalibrating(false);
+
+
+
+// Blocks until the training thread has let go of the model and data
+static void waitForTrainingThread()
+{
+    while (trainingThreadRunning)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+
+
+// Rows [begin, end) of a tensor whose first dimension is the sample index
+static Tensor copyRows(const Tensor &source, size_t begin, size_t end)
+{
+    std::vector<size_t> shape = source.getShape();
+    const size_t row_size = source.getSize() / std::max<size_t>(source.getRows(), 1);
+    shape[0] = end - begin;
+    Tensor rows{shape};
+    std::copy(source.getCpuData() + begin * row_size, source.getCpuData() + end * row_size, rows.getCpuData());
+    return rows;
+}
 
 
 
@@ -82,18 +121,22 @@ GuiManager::GuiManager()
 {
     memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
     memset(assistantInputBuffer, 0, sizeof(assistantInputBuffer));
+    EventLog::start({});
     addLog("Welcome to TensorFlow from Scratch!");
+    if (GemmAutotuner::load())
+    {
+        addLog("Loaded GEMM tuning cache for " + GemmAutotuner::cpuKey());
+    }
 }
 
 
 
 GuiManager::~GuiManager()
 {
+    commandPipeline.reset();
     isTraining = false;
-    if (trainingThread.joinable())
-    {
-        trainingThread.join();
-    }
+    waitForTrainingThread();
+    EventLog::stop();
 }
 
 
@@ -147,6 +190,7 @@ void GuiManager::init()
     model = std::make_unique<Model>();
     dataManager = std::make_unique<DataManager>();
     nlpParser = std::make_unique<Parser>();
+    commandPipeline = std::make_unique<CommandPipeline>(*nlpParser);
     visualizer = std::make_unique<Visualizer>();
 
     // Detect CUDA availability
@@ -171,10 +215,7 @@ void GuiManager::init()
 void GuiManager::shutdown()
 {
     isTraining = false;
-    if (trainingThread.joinable())
-    {
-        trainingThread.join();
-    }
+    waitForTrainingThread();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -211,6 +252,8 @@ void GuiManager::mainLoop()
 void GuiManager::renderUI()
 {
     ImGui::GetIO().FontGlobalScale = uiScale;
+    pollCommandPipeline();
+    pollCalibration();
 
     renderMenuBar();
     renderControlPanel();
@@ -257,7 +300,17 @@ void GuiManager::renderControlPanel()
         processNlpInput();
     }
     ImGui::SameLine();
-    if (ImGui::Button("Parse & Build"))
+    if (commandPipeline->busy())
+    {
+        if (ImGui::Button("Cancel"))
+        {
+            commandPipeline->cancel();
+            addLog("Cancelling command after the current stage...");
+        }
+        const CommandPipeline::Event &event = commandPipeline->current();
+        ImGui::ProgressBar(event.progress, ImVec2(-1.0f, 0.0f), CommandPipeline::stageName(event.stage));
+    }
+    else if (ImGui::Button("Parse & Build"))
     {
         processNlpInput();
     }
@@ -328,8 +381,41 @@ void GuiManager::renderControlPanel()
     // Debug toggle
     ImGui::SameLine();
     ImGui::Checkbox("Debug", &debugVerbose);
+    ImGui::SameLine();
+    if (ImGui::Checkbox("HW counters", &perfCounters))
+    {
+        PerfCounters::setEnabled(perfCounters);
+        PerfCounters::reset();
+        addLog(perfCounters ? PerfCounters::status() : "Hardware counter regions disabled.");
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    ImGui::InputInt("Health every", &healthInterval);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    ImGui::InputFloat("Clip norm", &gradClipNorm, 0.0f, 0.0f, "%.2f");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    ImGui::InputFloat("Prune to", &pruneSparsity, 0.0f, 0.0f, "%.2f");
+
+    // Structured step/epoch/eval records for dashboards
+    bool restart_log = ImGui::Checkbox("Export metrics", &exportMetrics);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    restart_log |= ImGui::Combo("##metricsFormat", &metricsFormat, "JSONL\0CSV\0");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    restart_log |= ImGui::InputInt("Log every", &metricsSampleInterval);
+    if (metricsSampleInterval < 1) metricsSampleInterval = 1;
+    if (restart_log)
+    {
+        restartEventLog();
+    }
 
     // Clamp to reasonable values
+    if (healthInterval < 0) healthInterval = 0;
+    if (gradClipNorm < 0.0f) gradClipNorm = 0.0f;
+    pruneSparsity = std::clamp(pruneSparsity, 0.0f, 0.99f);
     if (numEpochs < 1) numEpochs = 1;
     if (numEpochs > 100) numEpochs = 100;
 
@@ -340,7 +426,23 @@ void GuiManager::renderControlPanel()
 
     if (ImGui::Button("Start Training", ImVec2(buttonWidth, 30)))
     {
-        if (!isTraining)
+        if (commandPipeline->busy())
+        {
+            addLog("Wait for the current command to finish building the model.");
+        }
+        else if (isCalibrating)
+        {
+            addLog("Wait for Auto-configure to finish before training.");
+        }
+        else if (isTuning)
+        {
+            addLog("Wait for the hyperparameter search to finish before training.");
+        }
+        else if (!isTraining && trainingThreadRunning)
+        {
+            addLog("Wait for the stopped run to finish its current batch.");
+        }
+        else if (!isTraining)
         {
             // Reset training metrics for new session
             currentLoss = 0.0f;
@@ -348,6 +450,7 @@ void GuiManager::renderControlPanel()
             currentEpoch = 0;
             currentBatchIndex = 0;
             isTraining = true;
+            AllocationTracker::reset();
 
             // Set the selected backend before starting training
             try
@@ -363,6 +466,30 @@ void GuiManager::renderControlPanel()
                     model->setBackend(Backend::CPU);
                 }
 
+                model->setHealthInterval(static_cast<size_t>(healthInterval));
+                model->setGradientClipping(gradClipNorm);
+
+                // Ramp the sparsity over the first two thirds of training and
+                // fine-tune the surviving weights for the rest
+                PruningSchedule pruning;
+                pruning.target_sparsity = pruneSparsity;
+                const size_t total_steps = static_cast<size_t>(numEpochs) * (dataManager->getTrainSamplesCount() / std::max<size_t>(batchSize, 1));
+                pruning.end_step = std::max<size_t>(total_steps * 2 / 3, 1);
+                pruning.interval = std::max<size_t>(pruning.end_step / 20, 1);
+                const size_t masked = model->setPruning(pruning);
+                if (pruning.enabled())
+                {
+                    addLog("Pruning wide Dense layers to " + std::to_string(static_cast<int>(pruneSparsity * 100.0f + 0.5f)) + "% sparsity by step " + std::to_string(pruning.end_step) + ".");
+                    if (masked > 0)
+                    {
+                        addLog(std::to_string(masked) + " layer(s) keep the pruning masks of the previous run; pruning continues from them.");
+                    }
+                }
+                else if (masked > 0)
+                {
+                    addLog("Cleared the pruning masks of " + std::to_string(masked) + " layer(s); pruned weights start at zero but can grow back.");
+                }
+
                 // Create stable shared copies of data for the thread
                 auto *model_ptr = model.get();
                 auto *data_ptr = dataManager.get();
@@ -382,20 +509,23 @@ void GuiManager::renderControlPanel()
 
                 // Create new thread with captured pointers rather than 'this'
                 bool dbg = debugVerbose;
+                trainingThreadRunning = true;
                 trainingThread = std::thread([model_ptr, data_ptr, log_ptr, epochs_to_use, current_loss_ptr, current_epoch_ptr, current_batch_index_ptr, num_batches_per_epoch_ptr, batch_size_ptr, dbg]()
                 {
                     try
                     {
                         log_ptr->push_back("Training started...");
-                        std::cout << "[APP_LOG] Training started..." << std::endl;
+                        EventLog::message("Training started...");
                         size_t batch_size = *batch_size_ptr;
                         size_t num_batches = data_ptr->getTrainSamplesCount() / batch_size;
                         *num_batches_per_epoch_ptr = num_batches;
+                        size_t health_reports = NumericHealth::published(model_ptr);
 
                         for (size_t i = 0; i < epochs_to_use && isTraining; i++)
                         {
                             *current_epoch_ptr = static_cast<int>(i) + 1;
                             float epoch_loss = 0;
+                            const auto epoch_start = std::chrono::steady_clock::now();
                             for (size_t j = 0; j < num_batches && isTraining; j++)
                             {
                                 *current_batch_index_ptr = j + 1;
@@ -406,14 +536,56 @@ void GuiManager::renderControlPanel()
                                     {
                                         std::cout << "[APP_LOG][DBG] Batch " << (j + 1) << "/" << num_batches
                                                   << ", X:(" << batch.first.getRows() << "," << batch.first.getCols() << ")"
-                                                  << ", y:(" << batch.second.getRows() << "," << batch.second.getCols() << ")" << std::endl;
+                                                  << ", y:(" << batch.second.getRows() << "," << batch.second.getCols() << ")" << '\n';
+                                    }
+                                    const auto step_start = std::chrono::steady_clock::now();
+                                    const float step_loss = model_ptr->train_step(batch.first, batch.second);
+                                    const double step_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - step_start).count();
+                                    epoch_loss += step_loss;
+                                    EventLog::step(i + 1, i * num_batches + j + 1, step_loss,
+                                                   (step_ms > 0.0) ? batch_size * 1000.0 / step_ms : 0.0, step_ms);
+
+                                    // Stream sampled health reports; stop as soon as a
+                                    // non-finite value reaches the weights
+                                    // Only this model's reports: tuning trials and other
+                                    // models publish on their own channels
+                                    if (const size_t reports = NumericHealth::published(model_ptr); reports != health_reports)
+                                    {
+                                        health_reports = reports;
+                                        const NumericHealth::Report report = NumericHealth::latest(model_ptr);
+                                        const auto lines = NumericHealth::describe(report);
+                                        const size_t shown = report.healthy() ? 1 : lines.size();
+                                        for (size_t k = 0; k < shown; k++)
+                                        {
+                                            log_ptr->push_back(lines[k]);
+                                            EventLog::message(lines[k]);
+                                        }
+                                        if (!report.healthy() && !report.skipped)
+                                        {
+                                            log_ptr->push_back("Training diverged; stopping. Lower the learning rate or set a clip norm.");
+                                            EventLog::message("Training diverged at step " + std::to_string(report.step) + "; stopping.");
+                                            isTraining = false;
+                                        }
+                                    }
+
+                                    // The first batch is the warm-up: tune the GEMM shapes it
+                                    // used so the remaining batches only look them up
+                                    if ((i == 0) && (j == 0))
+                                    {
+                                        const auto tune_start = std::chrono::steady_clock::now();
+                                        if (const size_t tuned = GemmAutotuner::tunePending(); tuned > 0)
+                                        {
+                                            EventLog::timing("gemm autotune", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tune_start).count());
+                                            (void)GemmAutotuner::save();
+                                            log_ptr->push_back("Autotuned " + std::to_string(tuned) + " GEMM shapes.");
+                                            EventLog::message(GemmAutotuner::describe());
+                                        }
                                     }
-                                    epoch_loss += model_ptr->train_step(batch.first, batch.second);
                                 }
                                 catch (const std::exception &e)
                                 {
                                     log_ptr->push_back("Error in training batch: " + std::string(e.what()));
-                                    std::cout << "[APP_LOG] Error in training batch: " << e.what() << std::endl;
+                                    EventLog::message(std::string("Error in training batch: ") + e.what());
                                     // Continue with next batch
                                 }
                             }
@@ -422,19 +594,55 @@ void GuiManager::renderControlPanel()
                             *current_loss_ptr = avg_loss; // Update the loss for UI
                             std::string epoch_msg = "Epoch " + std::to_string(i + 1) + " Loss: " + std::to_string(avg_loss);
                             log_ptr->push_back(epoch_msg);
-                            std::cout << "[APP_LOG] " << epoch_msg << std::endl;
+                            EventLog::message(epoch_msg);
+                            EventLog::epoch(i + 1, avg_loss, std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_start).count());
+
+                            // Per-region counters for this epoch
+                            if (PerfCounters::isEnabled())
+                            {
+                                for (const auto &line : PerfCounters::describe())
+                                {
+                                    log_ptr->push_back(line);
+                                    EventLog::message(line);
+                                }
+                                PerfCounters::reset();
+                            }
+
+                            // Tensor allocations so far, by call site
+                            for (const auto &line : AllocationTracker::describeSites(5))
+                            {
+                                log_ptr->push_back(line);
+                                EventLog::message(line);
+                            }
+                        }
+
+                        // Sparsity reached by each pruned layer
+                        const auto &layers = model_ptr->getLayers();
+                        for (size_t i = 0; i < layers.size(); i++)
+                        {
+                            const auto *dense = dynamic_cast<const Dense *>(layers[i].get());
+                            if (dense && dense->isPruned())
+                            {
+                                char line[96];
+                                std::snprintf(line, sizeof(line), "Layer %zu (Dense %zux%zu): %.1f%% of weights pruned", i,
+                                              dense->weights.getRows(), dense->weights.getCols(), 100.0f * Pruning::sparsity(dense->weights));
+                                log_ptr->push_back(line);
+                                EventLog::message(line);
+                            }
                         }
 
                         isTraining = false;
                         log_ptr->push_back("Training finished.");
-                        std::cout << "[APP_LOG] Training finished." << std::endl;
+                        EventLog::message("Training finished.");
                     }
                     catch (const std::exception &e)
                     {
                         log_ptr->push_back("Training error: " + std::string(e.what()));
-                        std::cout << "[APP_LOG] Training error: " << e.what() << std::endl;
+                        EventLog::message(std::string("Training error: ") + e.what());
                         isTraining = false;
                     }
+                    // Last action: from here on the model and data may be replaced
+                    trainingThreadRunning = false;
                 });
 
                 // Detach the thread to prevent crashes
@@ -444,6 +652,7 @@ void GuiManager::renderControlPanel()
             {
                 addLog("Error starting training: " + std::string(e.what()));
                 isTraining = false;
+                trainingThreadRunning = false;
             }
         }
     }
@@ -454,24 +663,10 @@ void GuiManager::renderControlPanel()
     {
         if (isTraining)
         {
+            // The thread notices at the end of its current batch and logs
+            // "Training finished." once it has let go of the model
             addLog("Stopping training...");
             isTraining = false;
-
-            // Wait for training thread to finish with a timeout
-            auto join_result = std::future<void>();
-            if (trainingThread.joinable())
-            {
-                // Use a separate thread to join with a timeout to avoid deadlock
-                std::thread([&trainingThread = trainingThread]()
-                {
-                    if (trainingThread.joinable())
-                    {
-                        trainingThread.join();
-                    }
-                }).detach();
-            }
-
-            addLog("Training stopped.");
         }
     }
 
@@ -479,7 +674,15 @@ void GuiManager::renderControlPanel()
 
     if (ImGui::Button("Test Model", ImVec2(buttonWidth, 30)))
     {
-        if (model && dataManager && (!isTraining))
+        if (isCalibrating)
+        {
+            addLog("Wait for Auto-configure to finish before testing the model.");
+        }
+        else if (!isTraining && trainingThreadRunning)
+        {
+            addLog("Wait for the stopped run to finish its current batch before testing.");
+        }
+        else if (model && dataManager && (!isTraining))
         {
             try
             {
@@ -492,7 +695,7 @@ void GuiManager::renderControlPanel()
                 if (debugVerbose)
                 {
                     std::cout << "[APP_LOG][DBG] Test shapes X:(" << X_test.getRows() << "," << X_test.getCols()
-                              << ") y:(" << y_test.getRows() << "," << y_test.getCols() << ")" << std::endl;
+                              << ") y:(" << y_test.getRows() << "," << y_test.getCols() << ")" << '\n';
                 }
 
                 auto t0 = std::chrono::steady_clock::now();
@@ -503,10 +706,12 @@ void GuiManager::renderControlPanel()
 
                 // Always log tested sample count; add perf when debug is on
                 addLog("Evaluated " + std::to_string(X_test.getRows()) + " samples.");
+                double samples_per_sec = (ms_total > 0) ? (static_cast<double>(X_test.getRows()) * 1000.0 / ms_total) : 0.0;
+                EventLog::eval(static_cast<size_t>(currentEpoch), loss, accuracy, samples_per_sec);
+                EventLog::timing("evaluate", static_cast<double>(ms_total));
                 if (debugVerbose)
                 {
-                    double samples_per_sec = (ms_total > 0) ? (static_cast<double>(X_test.getRows()) * 1000.0 / ms_total) : 0.0;
-                    std::cout << "[APP_LOG][DBG] Eval total ms:" << ms_total << ", samples/s:" << samples_per_sec << std::endl;
+                    std::cout << "[APP_LOG][DBG] Eval total ms:" << ms_total << ", samples/s:" << samples_per_sec << '\n';
                 }
 
                 // Update metrics
@@ -534,6 +739,229 @@ void GuiManager::renderControlPanel()
 
     ImGui::Spacing();
 
+    if (ImGui::Button("Run Benchmarks", ImVec2(buttonWidth, 30)))
+    {
+        if (isTraining)
+        {
+            addLog("Cannot benchmark while training is in progress. Stop training first.");
+        }
+        else if (!isBenchmarking)
+        {
+            isBenchmarking = true;
+            addLog("Running layer benchmarks (batch " + std::to_string(batchSize) + ")...");
+            auto *log_ptr = &logMessages;
+            size_t bench_batch = batchSize;
+            std::thread([log_ptr, bench_batch]()
+            {
+                try
+                {
+                    for (const auto &result : Benchmark::runLayerBenchmarks(bench_batch))
+                    {
+                        std::string line = Benchmark::formatResult(result);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    for (const auto &result : Benchmark::runHugePageBenchmarks(bench_batch))
+                    {
+                        std::string line = Benchmark::formatResult(result);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    log_ptr->push_back(HostMemory::describe());
+                    EventLog::message(HostMemory::describe());
+                    // Per-layer roofline against the measured machine peaks
+                    for (const auto &line : Benchmark::runRooflineReport(bench_batch))
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // Tensors allocated per training step once warmed up
+                    for (const auto &line : Benchmark::runAllocationCheck(bench_batch))
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // Same-shape models trained one by one vs as a grouped batch
+                    for (const auto &line : Benchmark::runModelBatchComparison(8, bench_batch))
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // Pruned Dense layers on the sparse kernels
+                    for (const auto &line : Benchmark::runSparseBenchmarks(bench_batch))
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // BatchNorm folded into the preceding Dense for inference
+                    for (const auto &line : Benchmark::runBatchNormFoldCheck(bench_batch))
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // Asynchronous vs synchronous multi-threaded SGD
+                    for (const auto &result : Benchmark::runParallelSgdComparison())
+                    {
+                        std::string line = Benchmark::formatResult(result);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    for (const auto &line : Benchmark::describeNuma())
+                    {
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    for (const auto &result : Benchmark::runNumaComparison())
+                    {
+                        std::string line = Benchmark::formatResult(result);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // Autograd rules are validated alongside the kernels they use
+                    for (const auto &result : GradCheck::runBuiltinChecks())
+                    {
+                        std::string line = GradCheck::formatResult(result);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    log_ptr->push_back("Benchmark error: " + std::string(e.what()));
+                    EventLog::message(std::string("Benchmark error: ") + e.what());
+                }
+                isBenchmarking = false;
+            }).detach();
+        }
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Tune Hyperparameters", ImVec2(buttonWidth, 30)))
+    {
+        if (isTraining || trainingThreadRunning || isTuning || isCalibrating)
+        {
+            addLog("Cannot tune while training, auto-configuring or another search is in progress.");
+        }
+        else if (dataManager->getTrainSamplesCount() < 2)
+        {
+            addLog("Load a dataset before tuning.");
+        }
+        else
+        {
+            isTuning = true;
+            addLog("Running ASHA search over learning rate, batch size and MLP width...");
+            auto *log_ptr = &logMessages;
+            auto *data_ptr = dataManager.get();
+            size_t max_epochs = static_cast<size_t>(std::max(1, std::min(numEpochs, 9)));
+            std::thread([log_ptr, data_ptr, max_epochs]()
+            {
+                try
+                {
+                    // Trials are scored on the last 15% of the training set;
+                    // the test set stays untouched until "Test Model"
+                    const size_t samples = data_ptr->getTrainInputs().getRows();
+                    const size_t split = samples - std::max<size_t>(samples * 15 / 100, 1);
+                    const Tensor X_fit = copyRows(data_ptr->getTrainInputs(), 0, split);
+                    const Tensor y_fit = copyRows(data_ptr->getTrainTargets(), 0, split);
+                    const Tensor X_val = copyRows(data_ptr->getTrainInputs(), split, samples);
+                    const Tensor y_val = copyRows(data_ptr->getTrainTargets(), split, samples);
+                    HyperparameterSearch search(X_fit, y_fit, X_val, y_val);
+                    SearchSpace space;
+                    SearchOptions options;
+                    options.strategy = SearchStrategy::ASHA;
+                    options.max_epochs = max_epochs;
+                    options.samples_per_epoch = 10000;
+                    auto results = search.run(space, options, [log_ptr](const TrialResult &r)
+                    {
+                        std::string line = "Trial " + std::to_string(r.config.id) + " [" + HyperparameterSearch::statusName(r.status) +
+                                           "] epochs " + std::to_string(r.epochs_run) + ", val loss " + std::to_string(r.val_loss) +
+                                           ", acc " + std::to_string(r.val_accuracy);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    });
+                    if (!results.empty())
+                    {
+                        const auto &best = results.front();
+                        std::string line = "Best trial " + std::to_string(best.config.id) + ": " + best.config.optimizer +
+                                           ", lr " + std::to_string(best.config.learning_rate) + ", batch " + std::to_string(best.config.batch_size) +
+                                           ", val acc " + std::to_string(best.val_accuracy);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    if (HyperparameterSearch::writeReport("tuning_report.json", results, options, search.getLastWallSeconds()))
+                    {
+                        log_ptr->push_back("Tuning report written to tuning_report.json");
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    log_ptr->push_back("Tuning error: " + std::string(e.what()));
+                    EventLog::message(std::string("Tuning error: ") + e.what());
+                }
+                isTuning = false;
+            }).detach();
+        }
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Auto-configure", ImVec2(buttonWidth, 30)))
+    {
+        if (isTraining || trainingThreadRunning || isTuning || isCalibrating)
+        {
+            addLog("Cannot auto-configure while training or tuning is in progress.");
+        }
+        else if (!model || !model->getOptimizer() || (dataManager->getTrainSamplesCount() == 0))
+        {
+            addLog("Build a model and load a dataset before auto-configuring.");
+        }
+        else
+        {
+            isCalibrating = true;
+            addLog("Calibrating batch size and GEMM threads on this machine...");
+            model->setBackend(Backend::CPU);
+            auto *model_ptr = model.get();
+            auto *data_ptr = dataManager.get();
+            auto *log_ptr = &logMessages;
+            auto *outcome_ptr = &calibrationOutcome;
+            AutoConfigOptions options;
+            options.reference_batch_size = batchSize;
+            // Linear scaling suits SGD; Adam's normalized steps want the gentler rule
+            options.scaling = dynamic_cast<SGD *>(model->getOptimizer()) ? LearningRateScaling::Linear : LearningRateScaling::Sqrt;
+            std::thread([model_ptr, data_ptr, log_ptr, outcome_ptr, options]()
+            {
+                try
+                {
+                    const AutoConfigResult result = AutoConfig::calibrate(*model_ptr, data_ptr->getTrainInputs(), data_ptr->getTrainTargets(), options);
+                    for (const auto &point : result.points)
+                    {
+                        std::string line = AutoConfig::formatPoint(point);
+                        log_ptr->push_back(line);
+                        EventLog::message(line);
+                    }
+                    // The model is this thread's until isCalibrating clears
+                    model_ptr->getOptimizer()->setLearningRate(result.learning_rate);
+                    {
+                        std::lock_guard<std::mutex> lock(outcome_ptr->mutex);
+                        outcome_ptr->batch_size = result.batch_size;
+                        outcome_ptr->learning_rate = result.learning_rate;
+                        outcome_ptr->ready = true;
+                    }
+                    std::string line = AutoConfig::describe(result);
+                    log_ptr->push_back(line);
+                    EventLog::message(line);
+                }
+                catch (const std::exception &e)
+                {
+                    log_ptr->push_back("Auto-configure error: " + std::string(e.what()));
+                    EventLog::message(std::string("Auto-configure error: ") + e.what());
+                }
+                isCalibrating = false;
+            }).detach();
+        }
+    }
+
+    ImGui::Spacing();
+
     ImGui::Separator();
     ImGui::Text("Metrics");
 
@@ -550,6 +978,25 @@ void GuiManager::renderControlPanel()
         ImGui::Text("Test Accuracy: %.2f%%", testAccuracy * 100.0f);
     }
 
+    if (model && (NumericHealth::published(model.get()) > 0))
+    {
+        const NumericHealth::Report health = NumericHealth::latest(model.get());
+        ImGui::Text("Health (step %zu): grad norm %.4g, clip scale %.3f%s", health.step, health.grad_norm, health.clip_scale,
+                    health.healthy() ? "" : ", NON-FINITE VALUES");
+        if (model->getSkippedSteps() > 0)
+        {
+            ImGui::Text("Updates skipped for non-finite gradients: %zu", model->getSkippedSteps());
+        }
+    }
+
+    if (AllocationTracker::isEnabled())
+    {
+        const AllocationTracker::Totals memory = AllocationTracker::totals();
+        ImGui::Text("Tensor memory: %.1f MB live, %.1f MB peak, %llu allocations",
+                    memory.live_bytes / 1048576.0, memory.peak_bytes / 1048576.0,
+                    static_cast<unsigned long long>(memory.allocations));
+    }
+
     if (isTraining)
     {
         ImGui::Spacing();
@@ -678,234 +1125,51 @@ void GuiManager::renderDragHandle(const char *id)
 void GuiManager::processNlpInput()
 {
     if (strlen(nlpInputBuffer) == 0) return;
-
-    std::string command(nlpInputBuffer);
-    addLog("AI-parsing command: " + command);
-
-    ModelConfig config = nlpParser->parse(command);
-
-    if (config.valid)
+    if (commandPipeline->busy())
     {
-        // Step 1: Load dataset using AI-resolved dataset info
-        addLog("Loading AI-resolved dataset: " + config.dataset_info.name);
-
-        bool dataset_loaded = false;
-        if ((!config.dataset_info.name.empty()) && (config.dataset_info.name != "custom_needed"))
-        {
-            // Use new AI-driven dataset loading
-            dataset_loaded = dataManager->loadDatasetFromInfo(config.dataset_info);
-        }
-        else
-        {
-            // Fallback to legacy datasets only if explicitly requested
-            if (config.dataset == "mnist")
-            {
-                dataset_loaded = dataManager->loadDataset(Dataset::MNIST);
-                addLog("Loaded legacy MNIST dataset.");
-            }
-            else if (config.dataset == "cifar10")
-            {
-                dataset_loaded = dataManager->loadDataset(Dataset::CIFAR10);
-                addLog("Loaded legacy CIFAR-10 dataset.");
-            }
-            else
-            {
-                addLog("Error: No suitable dataset found for this task.");
-                memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
-                return;
-            }
-        }
-
-        if (!dataset_loaded)
-        {
-            // If AI-resolved loading failed, try legacy MNIST when applicable
-            std::string ds_name_lower = config.dataset_info.name;
-            std::transform(ds_name_lower.begin(), ds_name_lower.end(), ds_name_lower.begin(), ::tolower);
-            std::string legacy_lower = config.dataset;
-            std::transform(legacy_lower.begin(), legacy_lower.end(), legacy_lower.begin(), ::tolower);
-            if ((ds_name_lower.find("mnist") != std::string::npos) || (legacy_lower == "mnist"))
-            {
-                addLog("AI dataset load failed; falling back to built-in MNIST loader.");
-                if (!dataManager->loadDataset(Dataset::MNIST))
-                {
-                    addLog("Error: Failed to load MNIST dataset.");
-                    memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
-                    return;
-                }
-                dataset_loaded = true;
-            }
-            else
-            {
-                addLog("Error: Failed to load dataset.");
-                memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
-                return;
-            }
-        }
-
-        // Step 2: Build model architecture
-        addLog("Building neural network architecture...");
-        model = std::make_unique<Model>(); // Reset the model
-
-        // Get dataset stats for shaping
-        auto stats = dataManager->getDatasetStats();
-        size_t dataset_input_size = stats.input_size;
-        size_t dataset_num_classes = stats.num_classes;
-
-        if (config.use_ai_architecture || config.layers.empty())
-        {
-            // AI-infer architecture from dataset characteristics
-            addLog("Using AI-inferred architecture based on dataset characteristics.");
-
-            // Infer architecture based on data characteristics
-            std::vector<LayerConfig> inferred_layers;
-
-            if (stats.modality == "image")
-            {
-                // Image classification architecture
-                size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 784;
-                size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 10;
-
-                // Create a reasonable CNN-like dense architecture for images
-                inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
-
-                if (input_size > 1000) // Large images (like 32x32x3 = 3072)
-                {
-                    inferred_layers.push_back({512, ActivationType::ReLU, false});
-                    inferred_layers.push_back({256, ActivationType::ReLU, false});
-                    inferred_layers.push_back({128, ActivationType::ReLU, false});
-                }
-                else // Smaller images (like 28x28 = 784)
-                {
-                    inferred_layers.push_back({256, ActivationType::ReLU, false});
-                    inferred_layers.push_back({128, ActivationType::ReLU, false});
-                }
-
-                inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true}); // Output with softmax
-
-                addLog("Inferred image classification architecture: " + std::to_string(input_size) + " -> ... -> " + std::to_string(num_classes) + " classes");
-            }
-            else if (stats.modality == "tabular")
-            {
-                // Tabular data architecture
-                size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 32;
-                size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 2;
-
-                inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
-
-                if (input_size > 100)
-                {
-                    inferred_layers.push_back({static_cast<int>(input_size / 2), ActivationType::ReLU, false});
-                    inferred_layers.push_back({static_cast<int>(input_size / 4), ActivationType::ReLU, false});
-                }
-                else
-                {
-                    inferred_layers.push_back({64, ActivationType::ReLU, false});
-                    inferred_layers.push_back({32, ActivationType::ReLU, false});
-                }
-
-                inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true}); // Output with softmax
-
-                addLog("Inferred tabular classification architecture: " + std::to_string(input_size) + " -> ... -> " + std::to_string(num_classes) + " classes");
-            }
-            else
-            {
-                // Generic fallback architecture
-                size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 128;
-                size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 2;
-
-                inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
-                inferred_layers.push_back({128, ActivationType::ReLU, false});
-                inferred_layers.push_back({64, ActivationType::ReLU, false});
-                inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true});
-
-                addLog("Inferred generic architecture: " + std::to_string(input_size) + " -> 128 -> 64 -> " + std::to_string(num_classes));
-            }
-
-            config.layers = inferred_layers;
-            config.is_classification = true; // Most AI tasks are classification
-        }
-        else
-        {
-            // Correct user-specified layers to match dataset
-            addLog("Using user-specified architecture (aligning to dataset).");
-            if (config.layers.size() >= 2)
-            {
-                // First layer must match input size
-                config.layers.front().nodes = static_cast<int>(dataset_input_size);
-                // Last layer must match number of classes
-                config.layers.back().nodes = static_cast<int>(dataset_num_classes);
-                config.layers.back().is_softmax = true;
-                config.is_classification = true;
-            }
-        }
+        addLog("A command is already being processed; cancel it or wait for it to finish.");
+        return;
+    }
 
-        // Build the model layers
-        if (config.layers.size() < 2)
-        {
-            addLog("Error: Model must have at least an input and an output layer.");
-            memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
-            return;
-        }
+    commandPipeline->submit(std::string(nlpInputBuffer), learningRate);
+    memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
+}
 
-        for (size_t i = 0; i < config.layers.size() - 1; i++)
-        {
-            const auto &current_layer_config = config.layers[i];
-            const auto &next_layer_config = config.layers[i + 1];
 
-            // Add the Dense layer connecting the current layer to the next
-            addLog("Adding Dense layer: " + std::to_string(current_layer_config.nodes) + " -> " + std::to_string(next_layer_config.nodes));
-            model->add(std::make_unique<Dense>(current_layer_config.nodes, next_layer_config.nodes));
 
-            // Add the activation function for the new layer (defined by the next layer's config)
-            if (next_layer_config.is_softmax)
-            {
-                addLog("Adding Softmax activation.");
-                model->add(std::make_unique<Softmax>());
-            }
-            else
-            {
-                std::string activation_name = (next_layer_config.activation == ActivationType::ReLU) ? "ReLU" : "Sigmoid";
-                addLog("Adding " + activation_name + " activation.");
-                model->add(std::make_unique<Activation>(next_layer_config.activation));
-            }
-        }
+void GuiManager::pollCommandPipeline()
+{
+    for (const CommandPipeline::Event &event : commandPipeline->poll())
+    {
+        addLog(event.text);
+    }
+    // Training, tuning and calibration threads hold raw pointers to the
+    // current model and data until they clear their running flags; the new
+    // ones are installed only after that. isTraining alone is not enough:
+    // after Stop it is false while the thread finishes its batch.
+    if (commandPipeline->busy() || isTraining || trainingThreadRunning || isTuning || isCalibrating)
+    {
+        return;
+    }
+    if (auto result = commandPipeline->takeResult())
+    {
+        dataManager = std::move(result->data);
+        model = std::move(result->model);
+    }
+}
 
-        // Step 3: Configure optimizer and loss
-        std::unique_ptr<Optimizer> opt;
-        if (config.optimizer == "adam")
-        {
-            addLog("Using Adam optimizer.");
-            auto a = std::make_unique<Adam>();
-            a->setLearningRate(learningRate);
-            opt = std::move(a);
-        }
-        else
-        {
-            addLog("Using SGD optimizer.");
-            auto s = std::make_unique<SGD>();
-            s->setLearningRate(learningRate);
-            opt = std::move(s);
-        }
 
-        if (config.is_classification)
-        {
-            addLog("Using CrossEntropyLoss for classification.");
-            model->compile(std::make_unique<CrossEntropyLoss>(), std::move(opt));
-        }
-        else
-        {
-            addLog("Using MeanSquaredError.");
-            model->compile(std::make_unique<MeanSquaredError>(), std::move(opt));
-        }
 
-        addLog("AI-driven model pipeline completed successfully. Ready to train!");
-    }
-    else
+void GuiManager::pollCalibration()
+{
+    std::lock_guard<std::mutex> lock(calibrationOutcome.mutex);
+    if (!calibrationOutcome.ready)
     {
-        addLog("Failed to parse command. Please try again with a valid format.");
+        return;
     }
-
-    memset(nlpInputBuffer, 0, sizeof(nlpInputBuffer));
+    batchSize = calibrationOutcome.batch_size;
+    learningRate = calibrationOutcome.learning_rate;
+    calibrationOutcome.ready = false;
 }
 
 
@@ -913,5 +1177,30 @@ void GuiManager::processNlpInput()
 void GuiManager::addLog(const std::string &message)
 {
     logMessages.push_back(message);
-    std::cout << "[APP_LOG] " << message << std::endl;
+    EventLog::message(message);
+}
+
+
+
+void GuiManager::restartEventLog()
+{
+    EventLog::Options options;
+    if (exportMetrics)
+    {
+        options.format = (metricsFormat == 1) ? EventLog::Format::Csv : EventLog::Format::JsonLines;
+        options.path = (metricsFormat == 1) ? "metrics.csv" : "metrics.jsonl";
+    }
+    options.step_sample_interval = static_cast<size_t>(std::max(metricsSampleInterval, 1));
+    try
+    {
+        EventLog::start(options);
+    }
+    catch (const std::exception &e)
+    {
+        exportMetrics = false;
+        EventLog::start({});
+        addLog(std::string("Metrics export failed: ") + e.what());
+        return;
+    }
+    addLog(EventLog::describe());
 }
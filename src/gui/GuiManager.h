@@ -23,11 +23,13 @@ struct GLFWwindow;
 class Model;
 class DataManager;
 class Parser;
+class CommandPipeline;
 class Visualizer;
 
 
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -60,11 +62,19 @@ private:
     void renderLogPanel();
     void renderVisualizationWindow();
 
-    // Add a log entry to both the on-screen log and stdout
+    // Add a log entry to both the on-screen log and the EventLog (stdout)
     void addLog(const std::string &message);
+    // Apply the metrics export settings to the EventLog
+    void restartEventLog();
 
     // --- Helper Methods ---
     void processNlpInput();
+    // Drain command pipeline progress into the log and install a finished
+    // model and dataset once nothing else is using the current ones
+    void pollCommandPipeline();
+    // Copy a finished Auto-configure result into the batch size and
+    // learning rate fields
+    void pollCalibration();
     void renderDragHandle(const char *id);
 
     // --- Member Variables ---
@@ -95,13 +105,32 @@ private:
     size_t currentBatchIndex = 0;
     float learningRate = 0.001f;
     bool debugVerbose = false;
+    bool perfCounters = false;
+    int healthInterval = 100;        // training steps between numerical health reports, 0 = off
+    float gradClipNorm = 0.0f;       // global gradient-norm clipping threshold, 0 = off
+    float pruneSparsity = 0.0f;      // final sparsity of gradual magnitude pruning of wide Dense layers, 0 = off
+    bool exportMetrics = false;      // write EventLog records to metrics.jsonl / metrics.csv
+    int metricsFormat = 0;           // 0 = JSON Lines, 1 = CSV
+    int metricsSampleInterval = 10;  // keep one training-step record in N
 
     // Core Application Components (using smart pointers for automatic memory management)
     std::unique_ptr<Model> model;
     std::unique_ptr<DataManager> dataManager;
     std::unique_ptr<Parser> nlpParser;
+    std::unique_ptr<CommandPipeline> commandPipeline; // runs commands off the render thread
     std::unique_ptr<Visualizer> visualizer;
 
+    // Posted by the Auto-configure thread, applied by pollCalibration on the
+    // render thread, which owns the fields ImGui edits
+    struct CalibrationOutcome
+    {
+        std::mutex mutex;
+        bool ready = false;
+        size_t batch_size = 0;
+        float learning_rate = 0.0f;
+    };
+    CalibrationOutcome calibrationOutcome;
+
     // System capabilities
     bool hasCuda = false;
 };
@@ -5,23 +5,150 @@
 // Description: The main entry point for the "TensorFlow from Scratch"
 //              application. Its sole responsibility is to create and run the
 //              main GUI manager, which handles the entire application lifecycle.
+//              A few headless modes are selected on the command line:
+//                --ddp-bench N [shm|tcp] [steps]   local data-parallel scaling run
+//                --ddp-worker --rank R --hosts h0,h1,... [--port P] [--epochs E]
+//                --alloc-check [batch]             steady-state Tensor allocation check
+//                --parse "command" [endpoint] [n]  resolve a command n times, e.g.
+//                                                  against a local Gemini stand-in
+//                --http-bench URL [n]              fresh vs pooled vs concurrent GET latency
+//                --sparse-bench [batch]            pruned Dense on the CSR/blocked kernels
+//                --fold-check [batch]              folded BatchNorm1d matches the unfolded model
 //
 // =============================================================================
 
+#include "distributed/DistributedTrainer.h"
 #include "gui/GuiManager.h"
+#include "nlp/Parser.h"
+#include "perf/Benchmark.h"
+#include "utils/Http.h"
 
 
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 
 
 
+namespace
+{
+    // Returns -1 when argv does not select a headless mode
+    int runHeadless(int argc, char **argv)
+    {
+        if((argc >= 3) && (std::strcmp(argv[1], "--ddp-bench") == 0))
+        {
+            const size_t world = std::stoul(argv[2]);
+            const std::string transport = (argc >= 4) ? argv[3] : "shm";
+            const size_t steps = (argc >= 5) ? std::stoul(argv[4]) : 100;
+            const auto result = DistributedBenchmark::runScaling(world, transport, steps);
+            std::cout << DistributedBenchmark::formatResult(result) << '\n';
+            return result.replicas_consistent ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if((argc >= 2) && (std::strcmp(argv[1], "--ddp-worker") == 0))
+        {
+            DistributedBenchmark::WorkerOptions options;
+            for(int i = 2; i + 1 < argc; i += 2)
+            {
+                const std::string key = argv[i];
+                const std::string value = argv[i + 1];
+                if(key == "--rank") { options.rank = std::stoul(value); }
+                else if(key == "--port") { options.port = static_cast<std::uint16_t>(std::stoul(value)); }
+                else if(key == "--epochs") { options.epochs = std::stoul(value); }
+                else if(key == "--batch") { options.batch_size = std::stoul(value); }
+                else if(key == "--lr") { options.learning_rate = std::stof(value); }
+                else if(key == "--hosts")
+                {
+                    std::stringstream hosts(value);
+                    for(std::string host; std::getline(hosts, host, ',');) { options.hosts.push_back(host); }
+                }
+                else { throw std::invalid_argument("Unknown --ddp-worker option " + key); }
+            }
+            return DistributedBenchmark::runWorker(options);
+        }
+
+        if((argc >= 2) && (std::strcmp(argv[1], "--alloc-check") == 0))
+        {
+            const size_t batch = (argc >= 3) ? std::stoul(argv[2]) : 64;
+            bool passed = false;
+            for(const auto &line : Benchmark::runAllocationCheck(batch, &passed))
+            {
+                std::cout << line << '\n';
+            }
+            return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if((argc >= 3) && (std::strcmp(argv[1], "--parse") == 0))
+        {
+            Parser parser((argc >= 4) ? argv[3] : Gemini::kDefaultEndpoint);
+            const size_t repeats = (argc >= 5) ? std::stoul(argv[4]) : 2;
+            bool valid = true;
+            for(size_t i = 0; i < repeats; i++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const ModelConfig config = parser.parse(argv[2]);
+                const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::printf("[%zu] %s via %s in %.3f ms: dataset '%s', %zu layers\n", i, config.valid ? "resolved" : "FAILED",
+                            config.source.empty() ? "-" : config.source.c_str(), ms,
+                            config.dataset_info.name.empty() ? config.dataset.c_str() : config.dataset_info.name.c_str(), config.layers.size());
+                valid = valid && config.valid;
+            }
+            std::cout << parser.getCache().describe() << '\n';
+            return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if((argc >= 3) && (std::strcmp(argv[1], "--http-bench") == 0))
+        {
+            const size_t requests = (argc >= 4) ? std::stoul(argv[3]) : 20;
+            for(const auto &line : Http::runLatencyBenchmark(argv[2], requests))
+            {
+                std::cout << line << '\n';
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if((argc >= 2) && (std::strcmp(argv[1], "--sparse-bench") == 0))
+        {
+            const size_t batch = (argc >= 3) ? std::stoul(argv[2]) : 64;
+            for(const auto &line : Benchmark::runSparseBenchmarks(batch))
+            {
+                std::cout << line << '\n';
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if((argc >= 2) && (std::strcmp(argv[1], "--fold-check") == 0))
+        {
+            const size_t batch = (argc >= 3) ? std::stoul(argv[2]) : 64;
+            bool passed = false;
+            for(const auto &line : Benchmark::runBatchNormFoldCheck(batch, 20, &passed))
+            {
+                std::cout << line << '\n';
+            }
+            return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
 
-int main()
+        return -1;
+    }
+}
+
+
+
+
+int main(int argc, char **argv)
 {
     try
     {
+        if(const int code = runHeadless(argc, argv); code >= 0)
+        {
+            return code;
+        }
+
         GuiManager app;
         app.run();
     }
@@ -0,0 +1,450 @@
+// =============================================================================
+// File: src/nlp/CommandPipeline.cpp
+// =============================================================================
+//
+// Description: Implements the command pipeline. The stages are the steps the
+//              GUI used to run inline: Gemini parsing, dataset resolution with
+//              the legacy MNIST/CIFAR-10 fallbacks, loading into a private
+//              DataManager, and building the model from the dataset shape.
+//
+// =============================================================================
+
+#include "nlp/CommandPipeline.h"
+
+
+
+#include "nn/Loss.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Conv2D.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Pooling.h"
+#include "nn/layers/Softmax.h"
+#include "nn/optimizers/Adam.h"
+#include "nn/optimizers/SGD.h"
+
+
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace
+{
+    // Job progress at the start of each stage
+    constexpr float kParseProgress = 0.0f;
+    constexpr float kResolveProgress = 0.35f;
+    constexpr float kLoadProgress = 0.4f;
+    constexpr float kBuildProgress = 0.9f;
+
+    using LogFn = std::function<void(std::string)>;
+
+
+
+    std::string toLower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+
+
+    // Replaces config.layers with an architecture inferred from the dataset,
+    // or aligns the user's layers to it. Returns the convolutional stem
+    // geometry {channels, height, width}; channels == 0 means no stem.
+    std::array<size_t, 3> shapeLayers(ModelConfig &config, const DataManager::DatasetStats &stats, const LogFn &log)
+    {
+        std::array<size_t, 3> stem{0, 0, 0};
+        const size_t dataset_input_size = stats.input_size;
+        const size_t dataset_num_classes = stats.num_classes;
+
+        if (!config.use_ai_architecture && !config.layers.empty())
+        {
+            // Correct user-specified layers to match dataset
+            log("Using user-specified architecture (aligning to dataset).");
+            if (config.layers.size() >= 2)
+            {
+                // First layer must match input size
+                config.layers.front().nodes = static_cast<int>(dataset_input_size);
+                // Last layer must match number of classes
+                config.layers.back().nodes = static_cast<int>(dataset_num_classes);
+                config.layers.back().is_softmax = true;
+                config.is_classification = true;
+            }
+            return stem;
+        }
+
+        // AI-infer architecture from dataset characteristics
+        log("Using AI-inferred architecture based on dataset characteristics.");
+        std::vector<LayerConfig> inferred_layers;
+
+        if (stats.modality == "image")
+        {
+            // Image classification architecture
+            size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 784;
+            size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 10;
+
+            // When the image geometry is known, two conv/pool stages feed a much
+            // smaller fully connected head than the flattened pixels would
+            const bool large_image = (input_size > 1000);
+            const auto &shape = stats.input_shape;
+            if ((shape.size() == 3) && (shape[0] >= 4) && (shape[1] >= 4) && (shape[2] > 0) &&
+                (static_cast<size_t>(shape[0]) * shape[1] * shape[2] == input_size))
+            {
+                // input_shape is [width, height, channels]
+                stem = {static_cast<size_t>(shape[2]), static_cast<size_t>(shape[1]), static_cast<size_t>(shape[0])};
+                input_size = 32 * (stem[1] / 4) * (stem[2] / 4);
+                log("Using convolutional stem: " + std::to_string(stem[0]) + "x" + std::to_string(stem[1]) + "x" + std::to_string(stem[2]) + " -> " + std::to_string(input_size) + " features");
+            }
+
+            // Create a reasonable dense head for images
+            inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
+
+            if (large_image) // Large images (like 32x32x3 = 3072)
+            {
+                inferred_layers.push_back({512, ActivationType::ReLU, false});
+                inferred_layers.push_back({256, ActivationType::ReLU, false});
+                inferred_layers.push_back({128, ActivationType::ReLU, false});
+            }
+            else // Smaller images (like 28x28 = 784)
+            {
+                inferred_layers.push_back({256, ActivationType::ReLU, false});
+                inferred_layers.push_back({128, ActivationType::ReLU, false});
+            }
+
+            inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true}); // Output with softmax
+
+            log("Inferred image classification architecture: " + std::to_string(input_size) + " -> ... -> " + std::to_string(num_classes) + " classes");
+        }
+        else if (stats.modality == "tabular")
+        {
+            // Tabular data architecture
+            size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 32;
+            size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 2;
+
+            inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
+
+            if (input_size > 100)
+            {
+                inferred_layers.push_back({static_cast<int>(input_size / 2), ActivationType::ReLU, false});
+                inferred_layers.push_back({static_cast<int>(input_size / 4), ActivationType::ReLU, false});
+            }
+            else
+            {
+                inferred_layers.push_back({64, ActivationType::ReLU, false});
+                inferred_layers.push_back({32, ActivationType::ReLU, false});
+            }
+
+            inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true}); // Output with softmax
+
+            log("Inferred tabular classification architecture: " + std::to_string(input_size) + " -> ... -> " + std::to_string(num_classes) + " classes");
+        }
+        else
+        {
+            // Generic fallback architecture
+            size_t input_size = (dataset_input_size > 0) ? dataset_input_size : 128;
+            size_t num_classes = (dataset_num_classes > 0) ? dataset_num_classes : 2;
+
+            inferred_layers.push_back({static_cast<int>(input_size), ActivationType::ReLU, false});
+            inferred_layers.push_back({128, ActivationType::ReLU, false});
+            inferred_layers.push_back({64, ActivationType::ReLU, false});
+            inferred_layers.push_back({static_cast<int>(num_classes), ActivationType::ReLU, true});
+
+            log("Inferred generic architecture: " + std::to_string(input_size) + " -> 128 -> 64 -> " + std::to_string(num_classes));
+        }
+
+        config.layers = inferred_layers;
+        config.is_classification = true; // Most AI tasks are classification
+        return stem;
+    }
+
+
+
+    std::unique_ptr<Model> buildModel(ModelConfig &config, const DataManager::DatasetStats &stats, float learning_rate, const LogFn &log)
+    {
+        const auto stem = shapeLayers(config, stats, log);
+        if (config.layers.size() < 2)
+        {
+            throw std::runtime_error("Model must have at least an input and an output layer.");
+        }
+
+        auto model = std::make_unique<Model>();
+        if (stem[0] > 0)
+        {
+            // Two stages of 3x3 conv (same padding) + ReLU + 2x2 max pooling
+            size_t channels = stem[0];
+            size_t height = stem[1];
+            size_t width = stem[2];
+            for (size_t out_channels : {static_cast<size_t>(16), static_cast<size_t>(32)})
+            {
+                log("Adding Conv2D layer: " + std::to_string(channels) + " -> " + std::to_string(out_channels) + " channels, 3x3.");
+                model->add(std::make_unique<Conv2D>(channels, height, width, out_channels, 3, 1, 1));
+                model->add(std::make_unique<Activation>(ActivationType::ReLU));
+                model->add(std::make_unique<MaxPool2D>(out_channels, height, width, 2));
+                channels = out_channels;
+                height /= 2;
+                width /= 2;
+            }
+        }
+
+        for (size_t i = 0; i < config.layers.size() - 1; i++)
+        {
+            const auto &current_layer_config = config.layers[i];
+            const auto &next_layer_config = config.layers[i + 1];
+
+            // Add the Dense layer connecting the current layer to the next
+            log("Adding Dense layer: " + std::to_string(current_layer_config.nodes) + " -> " + std::to_string(next_layer_config.nodes));
+            model->add(std::make_unique<Dense>(current_layer_config.nodes, next_layer_config.nodes));
+
+            // Add the activation function for the new layer (defined by the next layer's config)
+            if (next_layer_config.is_softmax)
+            {
+                log("Adding Softmax activation.");
+                model->add(std::make_unique<Softmax>());
+            }
+            else
+            {
+                std::string activation_name = (next_layer_config.activation == ActivationType::ReLU) ? "ReLU" : "Sigmoid";
+                log("Adding " + activation_name + " activation.");
+                model->add(std::make_unique<Activation>(next_layer_config.activation));
+            }
+        }
+
+        // Configure optimizer and loss
+        std::unique_ptr<Optimizer> opt;
+        if (config.optimizer == "adam")
+        {
+            log("Using Adam optimizer.");
+            auto a = std::make_unique<Adam>();
+            a->setLearningRate(learning_rate);
+            opt = std::move(a);
+        }
+        else
+        {
+            log("Using SGD optimizer.");
+            auto s = std::make_unique<SGD>();
+            s->setLearningRate(learning_rate);
+            opt = std::move(s);
+        }
+
+        if (config.is_classification)
+        {
+            log("Using CrossEntropyLoss for classification.");
+            model->compile(std::make_unique<CrossEntropyLoss>(), std::move(opt));
+        }
+        else
+        {
+            log("Using MeanSquaredError.");
+            model->compile(std::make_unique<MeanSquaredError>(), std::move(opt));
+        }
+        return model;
+    }
+}
+
+
+
+CommandPipeline::CommandPipeline(Parser &parser)
+    : parser{parser}
+{
+}
+
+
+
+CommandPipeline::~CommandPipeline()
+{
+    cancel();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+
+
+void CommandPipeline::submit(std::string command, float learning_rate)
+{
+    if (running)
+    {
+        throw std::logic_error("CommandPipeline: a command is already being processed");
+    }
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reset();
+    }
+    cancel_requested = false;
+    running = true;
+    worker = std::thread(&CommandPipeline::run, this, std::move(command), learning_rate);
+}
+
+
+
+void CommandPipeline::cancel() noexcept
+{
+    if (running)
+    {
+        cancel_requested = true;
+    }
+}
+
+
+
+std::vector<CommandPipeline::Event> CommandPipeline::poll()
+{
+    std::vector<Event> drained;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drained.swap(events);
+    }
+    if (!drained.empty())
+    {
+        last_event = drained.back();
+    }
+    return drained;
+}
+
+
+
+std::optional<CommandPipeline::Result> CommandPipeline::takeResult()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::optional<Result> taken = std::move(result);
+    result.reset();
+    return taken;
+}
+
+
+
+const char *CommandPipeline::stageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::Parse: return "Parsing";
+        case Stage::Resolve: return "Resolving dataset";
+        case Stage::Load: return "Loading dataset";
+        case Stage::Build: return "Building model";
+        case Stage::Done: return "Done";
+        case Stage::Failed: return "Failed";
+        case Stage::Cancelled: return "Cancelled";
+    }
+    return "Unknown";
+}
+
+
+
+void CommandPipeline::emit(Stage stage, float progress, std::string text)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back({stage, progress, std::move(text)});
+}
+
+
+
+bool CommandPipeline::cancelled(float progress)
+{
+    if (!cancel_requested)
+    {
+        return false;
+    }
+    emit(Stage::Cancelled, progress, "Command cancelled.");
+    running = false;
+    return true;
+}
+
+
+
+void CommandPipeline::run(std::string command, float learning_rate)
+{
+    try
+    {
+        // Stage 1: parse (may wait on Gemini for several seconds)
+        emit(Stage::Parse, kParseProgress, "AI-parsing command: " + command);
+        const auto parse_start = std::chrono::steady_clock::now();
+        ModelConfig config = parser.parse(command);
+        if (!config.valid)
+        {
+            emit(Stage::Failed, kResolveProgress, "Failed to parse command. Please try again with a valid format.");
+            running = false;
+            return;
+        }
+        const double parse_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parse_start).count();
+        char parse_line[96];
+        std::snprintf(parse_line, sizeof(parse_line), "Command resolved by %s in %.3f ms.", config.source.c_str(), parse_ms);
+        emit(Stage::Parse, kResolveProgress, parse_line);
+        if (cancelled(kResolveProgress)) { return; }
+
+        // Stage 2: resolve the dataset source
+        const bool use_info = !config.dataset_info.name.empty() && (config.dataset_info.name != "custom_needed");
+        std::optional<Dataset> legacy;
+        if (!use_info)
+        {
+            // Fallback to legacy datasets only if explicitly requested
+            if (config.dataset == "mnist") { legacy = Dataset::MNIST; }
+            else if (config.dataset == "cifar10") { legacy = Dataset::CIFAR10; }
+            else
+            {
+                emit(Stage::Failed, kResolveProgress, "Error: No suitable dataset found for this task.");
+                running = false;
+                return;
+            }
+        }
+        // If AI-resolved loading fails, retry with legacy MNIST when applicable
+        const bool mnist_fallback = (toLower(config.dataset_info.name).find("mnist") != std::string::npos) || (toLower(config.dataset) == "mnist");
+        emit(Stage::Resolve, kResolveProgress, "Loading AI-resolved dataset: " + config.dataset_info.name);
+        if (cancelled(kLoadProgress)) { return; }
+
+        // Stage 3: download and decode into a private DataManager
+        emit(Stage::Load, kLoadProgress, "Downloading and decoding dataset...");
+        auto data = std::make_unique<DataManager>();
+        bool dataset_loaded = use_info ? data->loadDatasetFromInfo(config.dataset_info) : data->loadDataset(*legacy);
+        if (legacy && dataset_loaded)
+        {
+            emit(Stage::Load, kBuildProgress, (*legacy == Dataset::MNIST) ? "Loaded legacy MNIST dataset." : "Loaded legacy CIFAR-10 dataset.");
+        }
+        if (!dataset_loaded && mnist_fallback && !cancel_requested)
+        {
+            emit(Stage::Load, kLoadProgress, "AI dataset load failed; falling back to built-in MNIST loader.");
+            dataset_loaded = data->loadDataset(Dataset::MNIST);
+            if (!dataset_loaded)
+            {
+                emit(Stage::Failed, kBuildProgress, "Error: Failed to load MNIST dataset.");
+                running = false;
+                return;
+            }
+        }
+        if (cancelled(kBuildProgress)) { return; }
+        if (!dataset_loaded)
+        {
+            emit(Stage::Failed, kBuildProgress, "Error: Failed to load dataset.");
+            running = false;
+            return;
+        }
+
+        // Stage 4: build the model for the loaded data
+        emit(Stage::Build, kBuildProgress, "Building neural network architecture...");
+        auto model = buildModel(config, data->getDatasetStats(), learning_rate,
+                                [this](std::string line) { emit(Stage::Build, kBuildProgress, std::move(line)); });
+        if (cancelled(1.0f)) { return; }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            result = Result{std::move(config), std::move(data), std::move(model)};
+            events.push_back({Stage::Done, 1.0f, "AI-driven model pipeline completed successfully. Ready to train!"});
+        }
+    }
+    catch (const std::exception &e)
+    {
+        emit(Stage::Failed, 1.0f, std::string("Error: ") + e.what());
+    }
+    running = false;
+}
@@ -0,0 +1,103 @@
+// =============================================================================
+// File: src/nlp/CommandPipeline.h
+// =============================================================================
+//
+// Description: Runs a natural-language command off the render thread. A job
+//              goes through parse -> resolve -> load (download and decode) ->
+//              build on a background worker and produces a fresh DataManager
+//              and a compiled Model, so the ones in use are untouched until
+//              the caller takes the result. Progress is reported as events
+//              that the caller drains once per frame. Cancellation is checked
+//              between stages; a cancelled job finishes the stage it is in
+//              and its partial result is discarded.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "data/DataManager.h"
+#include "nlp/Parser.h"
+#include "nn/Model.h"
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+class CommandPipeline
+{
+public:
+    enum class Stage : std::uint8_t
+    {
+        Parse,
+        Resolve,
+        Load,
+        Build,
+        Done,
+        Failed,
+        Cancelled,
+    };
+
+    struct Event
+    {
+        Stage stage;
+        float progress; // of the whole job, 0 to 1
+        std::string text;
+    };
+
+    struct Result
+    {
+        ModelConfig config;
+        std::unique_ptr<DataManager> data;
+        std::unique_ptr<Model> model;
+    };
+
+    // The parser is shared with the caller and only used by the worker
+    // while a job is running.
+    explicit CommandPipeline(Parser &parser);
+    // Cancels a running job and waits for its current stage to finish
+    ~CommandPipeline();
+
+    CommandPipeline(const CommandPipeline &) = delete;
+    CommandPipeline &operator=(const CommandPipeline &) = delete;
+
+    // Starts a job. Throws std::logic_error if one is already running.
+    void submit(std::string command, float learning_rate);
+    void cancel() noexcept;
+    [[nodiscard]] bool busy() const noexcept { return running; }
+
+    // Events since the last call, oldest first
+    [[nodiscard]] std::vector<Event> poll();
+    // The last event seen by poll(), for progress display
+    [[nodiscard]] const Event &current() const noexcept { return last_event; }
+    // The finished job's model and data, once; empty while running or
+    // after a failed or cancelled job
+    [[nodiscard]] std::optional<Result> takeResult();
+
+    [[nodiscard]] static const char *stageName(Stage stage) noexcept;
+
+private:
+    void run(std::string command, float learning_rate);
+    void emit(Stage stage, float progress, std::string text);
+    [[nodiscard]] bool cancelled(float progress);
+
+    Parser &parser;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> cancel_requested{false};
+
+    std::mutex mutex; // guards events and result
+    std::vector<Event> events;
+    std::optional<Result> result;
+    Event last_event{Stage::Done, 0.0f, {}};
+};
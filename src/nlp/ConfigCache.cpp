@@ -0,0 +1,252 @@
+// =============================================================================
+// File: src/nlp/ConfigCache.cpp
+// =============================================================================
+//
+// Description: Implements the command cache. The file is rewritten through a
+//              temporary file and a rename, so a crash mid-write leaves the
+//              previous contents intact.
+//
+// =============================================================================
+
+#include "nlp/ConfigCache.h"
+
+
+
+#include "nlohmann/json.hpp"
+
+
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+
+
+namespace
+{
+    constexpr std::array<std::string_view, 7> kFillerWords = {"a", "an", "the", "please", "me", "some", "to"};
+
+    std::int64_t nowSeconds()
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+
+
+ConfigCache::ConfigCache(ConfigCacheOptions options)
+    : options{std::move(options)}
+{
+    this->options.capacity = std::max<size_t>(this->options.capacity, 1);
+    load();
+}
+
+
+
+std::string ConfigCache::normalize(std::string_view command)
+{
+    std::string cleaned;
+    cleaned.reserve(command.size());
+    for (unsigned char c : command)
+    {
+        cleaned.push_back((std::isalnum(c) || (c == '-')) ? static_cast<char>(std::tolower(c)) : ' ');
+    }
+
+    std::istringstream words(cleaned);
+    std::string normalized;
+    for (std::string word; words >> word;)
+    {
+        if (std::find(kFillerWords.begin(), kFillerWords.end(), word) != kFillerWords.end())
+        {
+            continue;
+        }
+        if (!normalized.empty())
+        {
+            normalized.push_back(' ');
+        }
+        normalized += word;
+    }
+    return normalized;
+}
+
+
+
+std::optional<std::string> ConfigCache::lookup(std::string_view command)
+{
+    const std::string key = normalize(command);
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = index.find(key);
+    if (it == index.end())
+    {
+        miss_count++;
+        return std::nullopt;
+    }
+    if (expired(*it->second, nowSeconds()))
+    {
+        entries.erase(it->second);
+        index.erase(it);
+        miss_count++;
+        return std::nullopt;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    hit_count++;
+    return entries.front().response;
+}
+
+
+
+void ConfigCache::store(std::string_view command, std::string response)
+{
+    std::string key = normalize(command);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (const auto it = index.find(key); it != index.end())
+    {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    entries.push_front({key, std::move(response), nowSeconds()});
+    index[std::move(key)] = entries.begin();
+    while (entries.size() > options.capacity)
+    {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    (void)save();
+}
+
+
+
+void ConfigCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    (void)save();
+}
+
+
+
+size_t ConfigCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+
+
+std::uint64_t ConfigCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+
+
+std::uint64_t ConfigCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
+
+
+
+std::string ConfigCache::describe() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return "Command cache: " + std::to_string(entries.size()) + " entries, " + std::to_string(hit_count) + " hits, " +
+           std::to_string(miss_count) + " misses" + (options.path.empty() ? "" : " (" + options.path + ")");
+}
+
+
+
+void ConfigCache::load()
+{
+    if (options.path.empty())
+    {
+        return;
+    }
+    std::ifstream file(options.path);
+    if (!file)
+    {
+        return;
+    }
+    try
+    {
+        const nlohmann::json root = nlohmann::json::parse(file);
+        if (root.value("version", 0) != kVersion)
+        {
+            return;
+        }
+        const auto list = root.find("entries");
+        if ((list == root.end()) || !list->is_array())
+        {
+            return;
+        }
+        // The file is ordered most recently used first
+        const std::int64_t now = nowSeconds();
+        for (const auto &item : *list)
+        {
+            Entry entry{item.value("key", std::string{}), item.value("response", std::string{}), item.value("created", std::int64_t{0})};
+            if (entry.key.empty() || entry.response.empty() || expired(entry, now) || index.contains(entry.key))
+            {
+                continue;
+            }
+            entries.push_back(std::move(entry));
+            index[entries.back().key] = std::prev(entries.end());
+            if (entries.size() == options.capacity)
+            {
+                break;
+            }
+        }
+    }
+    catch (const nlohmann::json::exception &)
+    {
+        entries.clear();
+        index.clear();
+    }
+}
+
+
+
+bool ConfigCache::save() const
+{
+    if (options.path.empty())
+    {
+        return true;
+    }
+    nlohmann::json list = nlohmann::json::array();
+    for (const Entry &entry : entries)
+    {
+        list.push_back({{"key", entry.key}, {"response", entry.response}, {"created", entry.created}});
+    }
+    const nlohmann::json root = {{"version", kVersion}, {"entries", std::move(list)}};
+
+    const std::string temp_path = options.path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+        file << root.dump(2) << '\n';
+        if (!file)
+        {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, options.path, error);
+    return !error;
+}
+
+
+
+bool ConfigCache::expired(const Entry &entry, std::int64_t now) const
+{
+    return (now - entry.created) >= options.ttl.count();
+}
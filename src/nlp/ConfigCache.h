@@ -0,0 +1,81 @@
+// =============================================================================
+// File: src/nlp/ConfigCache.h
+// =============================================================================
+//
+// Description: Cache of resolved NLP commands. Commands are normalized (case,
+//              punctuation, filler words) and mapped to the JSON the model
+//              resolver returned for them, so a repeated command skips the
+//              network round-trip. Entries live in an in-memory LRU and are
+//              written through to a JSON file that is reloaded at startup.
+//              Entries expire after a TTL, and the whole file is ignored when
+//              its version differs from kVersion.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+
+struct ConfigCacheOptions
+{
+    std::string path = "nlp_cache.json";     // empty: memory only
+    size_t capacity = 256;                   // entries kept, least recently used dropped first
+    std::chrono::seconds ttl{7 * 24 * 3600}; // age at which an entry is no longer used
+};
+
+
+
+class ConfigCache
+{
+public:
+    // Bump when the resolver prompt or the response schema changes
+    static constexpr int kVersion = 1;
+
+    // Loads the cache file if present; a missing or stale file is not an error
+    explicit ConfigCache(ConfigCacheOptions options = {});
+
+    // Lower case, punctuation other than '-' dropped, filler words removed
+    // and whitespace collapsed
+    [[nodiscard]] static std::string normalize(std::string_view command);
+
+    [[nodiscard]] std::optional<std::string> lookup(std::string_view command);
+    // Inserts or refreshes the entry and rewrites the cache file
+    void store(std::string_view command, std::string response);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] std::uint64_t hits() const;
+    [[nodiscard]] std::uint64_t misses() const;
+    [[nodiscard]] std::string describe() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::string response;
+        std::int64_t created; // seconds since the epoch
+    };
+
+    void load();
+    [[nodiscard]] bool save() const;
+    [[nodiscard]] bool expired(const Entry &entry, std::int64_t now) const;
+
+    ConfigCacheOptions options;
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::uint64_t hit_count = 0;
+    std::uint64_t miss_count = 0;
+};
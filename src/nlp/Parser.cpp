@@ -12,6 +12,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -42,20 +43,38 @@ std::string cleanGeminiResponse(std::string response)
 
 
 
-Parser::Parser()
+Parser::Parser(std::string gemini_endpoint, ConfigCacheOptions cache_options)
+    : cache{std::move(cache_options)}
 {
-    gemini = std::make_unique<Gemini>();
+    gemini = std::make_unique<Gemini>(std::move(gemini_endpoint));
 }
 
 
 
 ModelConfig Parser::parse(const std::string &command)
 {
-    ModelConfig config = parseWithGemini(command);
+    // The rules only know the built-in datasets; anything else needs resolving
+    ModelConfig config = parseWithRules(command);
+    if (config.valid && ((config.dataset == "mnist") || (config.dataset == "cifar10")))
+    {
+        config.source = "rules";
+        return config;
+    }
+
+    if (const auto cached = cache.lookup(command))
+    {
+        config = parseResponse(*cached);
+        if (config.valid)
+        {
+            config.source = "cache";
+            return config;
+        }
+    }
+
+    config = parseWithGemini(command);
     if (config.valid)
     {
         std::cout << "[Parser] Successfully parsed command with Gemini." << std::endl;
-        return config;
     }
     return config; // invalid -> caller will surface error
 }
@@ -102,12 +121,26 @@ ModelConfig Parser::parseWithGemini(const std::string &command)
         return ModelConfig{};
     }
 
+    ModelConfig config = parseResponse(cleaned_response);
+    config.source = "gemini";
+    // "custom_needed" is not cached so that a retry asks again
+    if (config.valid && (config.dataset_info.name != "custom_needed"))
+    {
+        cache.store(command, cleaned_response);
+    }
+    return config;
+}
+
+
+
+ModelConfig Parser::parseResponse(const std::string &response)
+{
     ModelConfig config;
     config.valid = false;
 
     try
     {
-        auto json = nlohmann::json::parse(cleaned_response);
+        auto json = nlohmann::json::parse(response);
 
         // Parse dataset_info
         if (json.contains("dataset_info") && json["dataset_info"].is_object())
@@ -228,42 +261,9 @@ ModelConfig Parser::parseWithRules(const std::string &command)
 {
     ModelConfig config;
     config.valid = false;
-    std::string lower = command;
-    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
-
-    // Quick path: handle "train ... for <dataset>" without explicit architecture
-    if ((lower.find("train") != std::string::npos) && (lower.find("for") != std::string::npos))
-    {
-        if (lower.find("mnist") != std::string::npos)
-        {
-            config.dataset = "mnist";
-            config.optimizer = "adam";
-            config.is_classification = true;
-            config.layers = {
-                LayerConfig{784, ActivationType::ReLU, false},
-                LayerConfig{128, ActivationType::ReLU, false},
-                LayerConfig{64, ActivationType::ReLU, false},
-                LayerConfig{10, ActivationType::ReLU, true}
-            };
-            config.valid = true;
-            return config;
-        }
-        if ((lower.find("cifar10") != std::string::npos) || (lower.find("cifar-10") != std::string::npos))
-        {
-            config.dataset = "cifar10";
-            config.optimizer = "adam";
-            config.is_classification = true;
-            config.layers = {
-                LayerConfig{3072, ActivationType::ReLU, false},
-                LayerConfig{512, ActivationType::ReLU, false},
-                LayerConfig{256, ActivationType::ReLU, false},
-                LayerConfig{10, ActivationType::ReLU, true}
-            };
-            config.valid = true;
-            return config;
-        }
-    }
-
+    // Only the strict "build <layers> with <optimizer> for <dataset>"
+    // grammar is accepted; looser phrasings ("train a classifier for
+    // fashion-mnist") go to the resolver, which reads the whole command
     std::stringstream ss(command);
     std::string word;
 
@@ -308,7 +308,8 @@ ModelConfig Parser::parseWithRules(const std::string &command)
 
     if (ss >> word && (word == "with") && (ss >> config.optimizer) && (ss >> word) && (word == "for") && (ss >> config.dataset))
     {
-        if (config.layers.size() >= 2)
+        // Trailing words would be silently dropped, so they reject the match
+        if ((config.layers.size() >= 2) && !(ss >> word))
         {
             config.valid = true;
         }
@@ -2,6 +2,7 @@
 
 
 
+#include "nlp/ConfigCache.h"
 #include "nn/nn_types.h"
 #include "utils/Gemini.h"
 
@@ -44,6 +45,7 @@ struct ModelConfig
     DatasetInfo dataset_info;   // new AI-resolved dataset information
     bool is_classification = false;
     bool use_ai_architecture = false; // if true, ignore layers and infer from data
+    std::string source;         // "rules", "cache" or "gemini"
 };
 
 
@@ -51,12 +53,21 @@ struct ModelConfig
 class Parser
 {
 public:
-    Parser();
+    explicit Parser(std::string gemini_endpoint = Gemini::kDefaultEndpoint, ConfigCacheOptions cache_options = {});
+
+    // Tries the strict "build <layers> with <optimizer> for mnist|cifar10"
+    // grammar first, then the cache of earlier resolutions, and only then
+    // asks Gemini
     [[nodiscard]] ModelConfig parse(const std::string &command);
 
+    [[nodiscard]] ConfigCache &getCache() noexcept { return cache; }
+
 private:
     [[nodiscard]] ModelConfig parseWithGemini(const std::string &command);
     [[nodiscard]] ModelConfig parseWithRules(const std::string &command);
+    // Builds a config from the resolver's JSON; invalid on malformed input
+    [[nodiscard]] ModelConfig parseResponse(const std::string &response);
 
     std::unique_ptr<Gemini> gemini;
+    ConfigCache cache;
 };
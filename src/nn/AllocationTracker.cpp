@@ -0,0 +1,368 @@
+// =============================================================================
+// File: src/nn/AllocationTracker.cpp
+// =============================================================================
+//
+// Description: Implements the allocation tracker. Each thread owns a table of
+//              per-site counters, registered once in a global list so reports
+//              can sum them; the table's mutex is only contended while a
+//              report or reset runs. The last site used is cached, which
+//              makes the common repeated allocation a pointer compare and two
+//              relaxed adds.
+//
+// =============================================================================
+
+#include "nn/AllocationTracker.h"
+
+
+
+#include "nn/HostMemory.h"
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+
+
+namespace
+{
+    std::atomic<bool> enabled{true};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::uint64_t> bytes_allocated{0};
+    std::atomic<std::uint64_t> bytes_freed{0};
+
+    thread_local std::string_view current_tag;
+    thread_local int current_index = -1;
+
+
+
+    struct SiteKey
+    {
+        std::string_view tag;
+        int index = -1;
+
+        [[nodiscard]] bool operator==(const SiteKey &) const = default;
+        [[nodiscard]] bool operator<(const SiteKey &other) const
+        {
+            return (tag != other.tag) ? (tag < other.tag) : (index < other.index);
+        }
+    };
+
+    struct SiteKeyHash
+    {
+        size_t operator()(const SiteKey &key) const noexcept
+        {
+            return std::hash<std::string_view>{}(key.tag) ^ (static_cast<size_t>(key.index + 1) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    struct SiteCounters
+    {
+        std::atomic<std::uint64_t> allocations{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+
+    struct ThreadTable
+    {
+        std::mutex mutex; // guards the map; the counters themselves are atomic
+        std::unordered_map<SiteKey, std::unique_ptr<SiteCounters>, SiteKeyHash> sites;
+        SiteKey last_key;
+        SiteCounters *last = nullptr;
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<ThreadTable>> registry;
+
+
+
+    ThreadTable &threadTable()
+    {
+        thread_local const std::shared_ptr<ThreadTable> table = []
+        {
+            auto created = std::make_shared<ThreadTable>();
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            registry.push_back(created);
+            return created;
+        }();
+        return *table;
+    }
+
+
+
+    SiteCounters *siteFor(ThreadTable &table, const SiteKey &key)
+    {
+        if(table.last && (table.last_key == key))
+        {
+            return table.last;
+        }
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto &slot = table.sites[key];
+        if(!slot)
+        {
+            slot = std::make_unique<SiteCounters>();
+        }
+        table.last_key = key;
+        table.last = slot.get();
+        return table.last;
+    }
+
+
+
+    // Site counts of one thread's table, keyed for diffing
+    std::map<SiteKey, std::pair<std::uint64_t, std::uint64_t>> snapshot(ThreadTable &table)
+    {
+        std::map<SiteKey, std::pair<std::uint64_t, std::uint64_t>> counts;
+        std::lock_guard<std::mutex> lock(table.mutex);
+        for(const auto &[key, counters] : table.sites)
+        {
+            counts[key] = {counters->allocations.load(std::memory_order_relaxed), counters->bytes.load(std::memory_order_relaxed)};
+        }
+        return counts;
+    }
+
+
+
+    std::string siteName(const SiteKey &key)
+    {
+        std::string name = key.tag.empty() ? std::string("untagged") : std::string(key.tag);
+        if(key.index >= 0)
+        {
+            name += " [" + std::to_string(key.index) + "]";
+        }
+        return name;
+    }
+
+
+
+    void sortSites(std::vector<AllocationTracker::Site> &sites)
+    {
+        std::sort(sites.begin(), sites.end(), [](const auto &a, const auto &b) { return a.bytes > b.bytes; });
+    }
+}
+
+
+
+namespace AllocationTracker
+{
+
+void setEnabled(bool value)
+{
+    enabled = value;
+}
+
+
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+
+
+Scope::Scope(std::string_view tag, int index) noexcept : previous_tag{current_tag}, previous_index{current_index}
+{
+    current_tag = tag;
+    current_index = index;
+}
+
+
+
+Scope::~Scope()
+{
+    current_tag = previous_tag;
+    current_index = previous_index;
+}
+
+
+
+void recordAllocation(size_t bytes) noexcept
+{
+    if(!enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    try
+    {
+        SiteCounters *site = siteFor(threadTable(), SiteKey{current_tag, current_index});
+        site->allocations.fetch_add(1, std::memory_order_relaxed);
+        site->bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    catch(...)
+    {
+        // Attribution is best effort; the totals above are already counted
+    }
+}
+
+
+
+void recordFree(size_t bytes) noexcept
+{
+    if(!enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    frees.fetch_add(1, std::memory_order_relaxed);
+    bytes_freed.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+
+Totals totals()
+{
+    Totals result;
+    result.allocations = allocations;
+    result.frees = frees;
+    result.bytes_allocated = bytes_allocated;
+    result.bytes_freed = bytes_freed;
+    result.live_bytes = HostMemory::liveBytes();
+    result.peak_bytes = HostMemory::peakBytes();
+    return result;
+}
+
+
+
+std::vector<Site> sites()
+{
+    std::map<SiteKey, Site> merged;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for(const auto &table : registry)
+        {
+            for(const auto &[key, counts] : snapshot(*table))
+            {
+                Site &site = merged[key];
+                site.allocations += counts.first;
+                site.bytes += counts.second;
+            }
+        }
+    }
+    std::vector<Site> result;
+    for(auto &[key, site] : merged)
+    {
+        if(site.allocations == 0) { continue; }
+        site.name = siteName(key);
+        result.push_back(std::move(site));
+    }
+    sortSites(result);
+    return result;
+}
+
+
+
+void reset()
+{
+    allocations = 0;
+    frees = 0;
+    bytes_allocated = 0;
+    bytes_freed = 0;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    // Tables only the registry still holds belong to threads that have exited
+    std::erase_if(registry, [](const std::shared_ptr<ThreadTable> &table) { return table.use_count() == 1; });
+    for(const auto &table : registry)
+    {
+        std::lock_guard<std::mutex> table_lock(table->mutex);
+        for(auto &[key, counters] : table->sites)
+        {
+            counters->allocations = 0;
+            counters->bytes = 0;
+        }
+    }
+}
+
+
+
+SteadyState measureSteadyState(const std::function<void()> &step, size_t warmup, size_t steps)
+{
+    for(size_t i = 0; i < warmup; i++)
+    {
+        step();
+    }
+    ThreadTable &table = threadTable();
+    const auto before = snapshot(table);
+    for(size_t i = 0; i < steps; i++)
+    {
+        step();
+    }
+    const auto after = snapshot(table);
+
+    SteadyState result;
+    result.steps = steps;
+    std::uint64_t total_allocations = 0, total_bytes = 0;
+    for(const auto &[key, counts] : after)
+    {
+        const auto it = before.find(key);
+        const std::uint64_t count = counts.first - ((it != before.end()) ? it->second.first : 0);
+        const std::uint64_t bytes = counts.second - ((it != before.end()) ? it->second.second : 0);
+        if(count == 0) { continue; }
+        result.sites.push_back(Site{siteName(key), count, bytes});
+        total_allocations += count;
+        total_bytes += bytes;
+    }
+    sortSites(result.sites);
+    if(steps > 0)
+    {
+        result.allocations_per_step = static_cast<double>(total_allocations) / static_cast<double>(steps);
+        result.bytes_per_step = static_cast<double>(total_bytes) / static_cast<double>(steps);
+    }
+    return result;
+}
+
+
+
+void expectNoSteadyStateAllocations(const std::function<void()> &step, const std::string &what, size_t warmup, size_t steps)
+{
+    if(!isEnabled())
+    {
+        throw std::logic_error("AllocationTracker is disabled; cannot check " + what);
+    }
+    const SteadyState state = measureSteadyState(step, warmup, steps);
+    if(state.sites.empty())
+    {
+        return;
+    }
+    std::ostringstream out;
+    out << what << " allocates " << state.allocations_per_step << " tensors (" << state.bytes_per_step / 1024.0 << " KB) per step after warm-up:";
+    for(const Site &site : state.sites)
+    {
+        out << " " << site.name << " x" << site.allocations << ";";
+    }
+    throw std::runtime_error(out.str());
+}
+
+
+
+std::string describe()
+{
+    const Totals t = totals();
+    std::ostringstream out;
+    out << "Tensor allocations: " << t.allocations << " (" << (t.bytes_allocated >> 20) << " MB), frees " << t.frees
+        << " | live " << (t.live_bytes >> 20) << " MB, peak " << (t.peak_bytes >> 20) << " MB";
+    return out.str();
+}
+
+
+
+std::vector<std::string> describeSites(size_t limit)
+{
+    std::vector<std::string> lines = {describe()};
+    const std::vector<Site> all = sites();
+    for(size_t i = 0; i < std::min(limit, all.size()); i++)
+    {
+        std::ostringstream out;
+        out << "  " << all[i].name << ": " << all[i].allocations << " allocations, " << (all[i].bytes >> 10) << " KB";
+        lines.push_back(out.str());
+    }
+    return lines;
+}
+
+} // namespace AllocationTracker
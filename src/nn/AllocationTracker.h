@@ -0,0 +1,93 @@
+// =============================================================================
+// File: src/nn/AllocationTracker.h
+// =============================================================================
+//
+// Description: Counts Tensor CPU allocations and frees and attributes each
+//              allocation to the call site active on its thread. Call sites
+//              are tags pushed by AllocationTracker::Scope; Model tags every
+//              layer's forward and backward, and untagged allocations are
+//              reported as "untagged". Counting costs a few relaxed atomic
+//              adds and a lookup in a per-thread table, so it stays on by
+//              default. Resident and peak bytes come from HostMemory. The
+//              steady-state helpers run a step repeatedly and report or
+//              reject the allocations it still makes after warm-up.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+namespace AllocationTracker
+{
+    struct Totals
+    {
+        std::uint64_t allocations = 0;
+        std::uint64_t frees = 0;
+        std::uint64_t bytes_allocated = 0;
+        std::uint64_t bytes_freed = 0;
+        std::uint64_t live_bytes = 0;  // HostMemory::liveBytes
+        std::uint64_t peak_bytes = 0;  // HostMemory::peakBytes
+    };
+
+    struct Site
+    {
+        std::string name;
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    struct SteadyState
+    {
+        size_t steps = 0;
+        double allocations_per_step = 0.0;
+        double bytes_per_step = 0.0;
+        std::vector<Site> sites; // allocations during the measured steps, largest first
+    };
+
+    void setEnabled(bool enabled);
+    [[nodiscard]] bool isEnabled();
+
+    // Tags allocations made on this thread until destroyed; scopes nest.
+    // tag must outlive the report (a string literal or a layer type name).
+    class Scope
+    {
+    public:
+        explicit Scope(std::string_view tag, int index = -1) noexcept;
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        std::string_view previous_tag;
+        int previous_index;
+    };
+
+    // Called by Tensor whenever CPU storage is obtained or released
+    void recordAllocation(size_t bytes) noexcept;
+    void recordFree(size_t bytes) noexcept;
+
+    [[nodiscard]] Totals totals();
+    // Every thread's sites, largest byte count first
+    [[nodiscard]] std::vector<Site> sites();
+    // Zeroes the counters and sites; live and peak bytes are unaffected
+    void reset();
+
+    // Runs step warmup times, then measures steps more calls on this thread
+    [[nodiscard]] SteadyState measureSteadyState(const std::function<void()> &step, size_t warmup = 3, size_t steps = 10);
+    // Same, throwing std::runtime_error naming the sites if any allocation remains
+    void expectNoSteadyStateAllocations(const std::function<void()> &step, const std::string &what, size_t warmup = 3, size_t steps = 10);
+
+    [[nodiscard]] std::string describe();
+    [[nodiscard]] std::vector<std::string> describeSites(size_t limit = 10);
+}
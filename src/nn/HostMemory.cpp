@@ -0,0 +1,309 @@
+// =============================================================================
+// File: src/nn/HostMemory.cpp
+// =============================================================================
+//
+// Description: Implements the huge-page aware host allocator.
+//
+// =============================================================================
+
+#include "nn/HostMemory.h"
+
+
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+
+
+namespace
+{
+    constexpr size_t kHugePageBytes = size_t{2} << 20;
+
+    std::atomic<HostMemory::HugePageMode> mode{HostMemory::HugePageMode::Transparent};
+    std::atomic<size_t> threshold{kHugePageBytes};
+    std::atomic<size_t> cache_limit{size_t{512} << 20};
+
+    std::atomic<std::uint64_t> heap_allocations{0};
+    std::atomic<std::uint64_t> mapped_allocations{0};
+    std::atomic<std::uint64_t> explicit_allocations{0};
+    std::atomic<std::uint64_t> fallbacks{0};
+    std::atomic<std::uint64_t> cache_hits{0};
+    std::atomic<std::uint64_t> live_mapped_bytes{0};
+    std::atomic<std::uint64_t> live_bytes{0};
+    std::atomic<std::uint64_t> peak_bytes{0};
+
+    std::mutex cache_mutex;
+    std::multimap<size_t, void *> cache; // mapping length -> freed mapping
+    size_t cached_bytes = 0;
+
+
+
+    void trackAllocation(size_t count)
+    {
+        const std::uint64_t live = live_bytes.fetch_add(count * sizeof(float), std::memory_order_relaxed) + count * sizeof(float);
+        std::uint64_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while((live > peak) && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+
+
+    size_t mappingLength(size_t count)
+    {
+        return ((count * sizeof(float) + kHugePageBytes - 1) / kHugePageBytes) * kHugePageBytes;
+    }
+
+
+
+#ifdef __linux__
+    void *mapHuge(size_t length, HostMemory::HugePageMode requested)
+    {
+        if(requested == HostMemory::HugePageMode::Explicit)
+        {
+            void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p != MAP_FAILED)
+            {
+                explicit_allocations++;
+                return p;
+            }
+            fallbacks++; // hugetlb pool empty or not configured
+        }
+
+        // Over-map by one huge page and trim so the region is 2 MB aligned;
+        // otherwise the kernel cannot back its ends with huge pages
+        void *raw = mmap(nullptr, length + kHugePageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        const auto start = reinterpret_cast<std::uintptr_t>(raw);
+        const auto aligned = (start + kHugePageBytes - 1) & ~(std::uintptr_t{kHugePageBytes} - 1);
+        if(aligned > start)
+        {
+            munmap(raw, aligned - start);
+        }
+        const size_t tail = (start + length + kHugePageBytes) - (aligned + length);
+        if(tail > 0)
+        {
+            munmap(reinterpret_cast<void *>(aligned + length), tail);
+        }
+        void *p = reinterpret_cast<void *>(aligned);
+        if(madvise(p, length, MADV_HUGEPAGE) != 0)
+        {
+            fallbacks++; // THP disabled: the mapping still works with 4 KB pages
+        }
+        return p;
+    }
+
+
+
+    std::uint64_t readKeyedValue(const char *path, const std::string &key)
+    {
+        std::ifstream file(path);
+        for(std::string line; std::getline(file, line);)
+        {
+            if(line.rfind(key, 0) == 0)
+            {
+                return std::stoull(line.substr(key.size()));
+            }
+        }
+        return 0;
+    }
+#endif
+}
+
+
+
+namespace HostMemory
+{
+
+void setHugePageMode(HugePageMode new_mode)
+{
+    mode = new_mode;
+}
+
+
+
+HugePageMode getHugePageMode()
+{
+    return mode;
+}
+
+
+
+void setHugePageThreshold(size_t bytes)
+{
+    threshold = bytes;
+}
+
+
+
+void setCacheLimit(size_t bytes)
+{
+    cache_limit = bytes;
+    if(bytes == 0)
+    {
+        trimCache();
+    }
+}
+
+
+
+float *allocate(size_t count, Storage &storage)
+{
+    trackAllocation(count);
+#ifdef __linux__
+    const HugePageMode requested = mode;
+    if((requested != HugePageMode::Off) && (count * sizeof(float) >= threshold))
+    {
+        const size_t length = mappingLength(count);
+        void *p = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            const auto it = cache.find(length);
+            if(it != cache.end())
+            {
+                p = it->second;
+                cache.erase(it);
+                cached_bytes -= length;
+                cache_hits++;
+            }
+        }
+        if(!p)
+        {
+            p = mapHuge(length, requested);
+        }
+        if(p)
+        {
+            mapped_allocations++;
+            live_mapped_bytes += length;
+            storage = Storage::Mapped;
+            return static_cast<float *>(p);
+        }
+        fallbacks++;
+    }
+#endif
+    heap_allocations++;
+    storage = Storage::Heap;
+    return new float[count];
+}
+
+
+
+void release(float *data, size_t count, Storage storage) noexcept
+{
+    if(!data)
+    {
+        return;
+    }
+    live_bytes.fetch_sub(count * sizeof(float), std::memory_order_relaxed);
+    if(storage == Storage::Heap)
+    {
+        delete[] data;
+        return;
+    }
+#ifdef __linux__
+    const size_t length = mappingLength(count);
+    live_mapped_bytes -= length;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if(cached_bytes + length <= cache_limit)
+        {
+            cache.emplace(length, data);
+            cached_bytes += length;
+            return;
+        }
+    }
+    munmap(data, length);
+#endif
+}
+
+
+
+void trimCache()
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for(const auto &[length, p] : cache)
+    {
+        munmap(p, length);
+    }
+    cache.clear();
+    cached_bytes = 0;
+#endif
+}
+
+
+
+std::uint64_t liveBytes()
+{
+    return live_bytes.load(std::memory_order_relaxed);
+}
+
+
+
+std::uint64_t peakBytes()
+{
+    return peak_bytes.load(std::memory_order_relaxed);
+}
+
+
+
+void resetPeak()
+{
+    peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+
+
+Stats getStats()
+{
+    Stats stats;
+    stats.heap_allocations = heap_allocations;
+    stats.mapped_allocations = mapped_allocations;
+    stats.explicit_allocations = explicit_allocations;
+    stats.fallbacks = fallbacks;
+    stats.cache_hits = cache_hits;
+    stats.live_mapped_bytes = live_mapped_bytes;
+    stats.live_bytes = live_bytes;
+    stats.peak_bytes = peak_bytes;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        stats.cached_bytes = cached_bytes;
+    }
+#ifdef __linux__
+    stats.anon_huge_bytes = readKeyedValue("/proc/self/smaps_rollup", "AnonHugePages:") * 1024;
+    stats.hugetlb_total_pages = readKeyedValue("/proc/meminfo", "HugePages_Total:");
+    stats.hugetlb_free_pages = readKeyedValue("/proc/meminfo", "HugePages_Free:");
+#endif
+    return stats;
+}
+
+
+
+std::string describe()
+{
+    const Stats s = getStats();
+    const char *names[] = {"off", "transparent", "explicit"};
+    std::ostringstream out;
+    out << "Huge pages: " << names[static_cast<int>(getHugePageMode())]
+        << " | mapped " << s.mapped_allocations << " (" << s.explicit_allocations << " hugetlb, "
+        << s.cache_hits << " reused), heap " << s.heap_allocations << ", fallbacks " << s.fallbacks
+        << " | live " << (s.live_mapped_bytes >> 20) << " MB, cached " << (s.cached_bytes >> 20) << " MB"
+        << " | kernel THP " << (s.anon_huge_bytes >> 20) << " MB, hugetlb free " << s.hugetlb_free_pages
+        << "/" << s.hugetlb_total_pages;
+    return out.str();
+}
+
+} // namespace HostMemory
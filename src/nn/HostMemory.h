@@ -0,0 +1,86 @@
+// =============================================================================
+// File: src/nn/HostMemory.h
+// =============================================================================
+//
+// Description: Host allocator behind Tensor CPU storage. Small buffers come
+//              from the regular heap. Buffers at or above a threshold are
+//              mapped on 2 MB boundaries and backed by huge pages, explicit
+//              (MAP_HUGETLB, from the reserved pool) or transparent
+//              (madvise(MADV_HUGEPAGE)). Large tensors such as datasets and
+//              wide Dense weights then need far fewer TLB entries. Each mode
+//              falls back to the next weaker one when the kernel refuses, and
+//              to the heap on other platforms. Freed mappings are kept in a
+//              small size-keyed cache, because tensors of the same shape are
+//              reallocated every step and remapping would fault the pages in
+//              again.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+
+namespace HostMemory
+{
+    enum class HugePageMode : std::uint8_t
+    {
+        Off,         // heap only
+        Transparent, // 2 MB-aligned mapping + MADV_HUGEPAGE
+        Explicit,    // MAP_HUGETLB, falling back to Transparent
+    };
+
+    enum class Storage : std::uint8_t
+    {
+        Heap,
+        Mapped,
+    };
+
+    struct Stats
+    {
+        std::uint64_t heap_allocations = 0;
+        std::uint64_t mapped_allocations = 0;
+        std::uint64_t explicit_allocations = 0; // mapped from the hugetlb pool
+        std::uint64_t fallbacks = 0;            // huge pages requested but refused
+        std::uint64_t cache_hits = 0;
+        std::uint64_t live_mapped_bytes = 0;
+        std::uint64_t live_bytes = 0;           // all Tensor storage, heap and mapped
+        std::uint64_t peak_bytes = 0;           // high-water mark of live_bytes since resetPeak
+        std::uint64_t cached_bytes = 0;
+        // Reported by the kernel for the whole process (Linux only)
+        std::uint64_t anon_huge_bytes = 0;     // AnonHugePages in smaps_rollup
+        std::uint64_t hugetlb_total_pages = 0; // HugePages_Total in meminfo
+        std::uint64_t hugetlb_free_pages = 0;
+    };
+
+    void setHugePageMode(HugePageMode mode);
+    [[nodiscard]] HugePageMode getHugePageMode();
+
+    // Buffers smaller than this always use the heap (default 2 MB)
+    void setHugePageThreshold(size_t bytes);
+
+    // Cap on freed mappings kept for reuse (default 512 MB)
+    void setCacheLimit(size_t bytes);
+
+    // Returns uninitialized storage for count floats and how it was obtained;
+    // release must be given the same count and storage kind
+    [[nodiscard]] float *allocate(size_t count, Storage &storage);
+    void release(float *data, size_t count, Storage storage) noexcept;
+
+    // Unmaps every cached mapping
+    void trimCache();
+
+    // Tensor bytes currently allocated, and the high-water mark since the
+    // last resetPeak (which sets it to the current live size)
+    [[nodiscard]] std::uint64_t liveBytes();
+    [[nodiscard]] std::uint64_t peakBytes();
+    void resetPeak();
+
+    [[nodiscard]] Stats getStats();
+    [[nodiscard]] std::string describe();
+}
@@ -0,0 +1,199 @@
+// =============================================================================
+// File: src/nn/Initializer.cpp
+// =============================================================================
+//
+// Description: Implements the initializers. Uniform values take 24 bits of one
+//              Philox output; normal values come in Box-Muller pairs from
+//              outputs 2k and 2k + 1. Work is split into chunks of an even
+//              number of elements, so a pair never straddles two threads.
+//
+// =============================================================================
+
+#include "nn/Initializer.h"
+
+
+
+#include "nn/Philox.h"
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+    std::atomic<std::uint64_t> global_seed{Initializer::kDefaultSeed};
+    std::atomic<std::uint64_t> stream_counter{0};
+
+    constexpr size_t kBlock = 1024;                // Philox outputs generated per pass
+    constexpr size_t kParallelChunk = size_t{1} << 16;
+
+
+
+    // Elements [begin, end) of the stream; begin is even
+    void fillRange(float *out, size_t begin, size_t end, bool normal, float a, float b, std::uint64_t stream, std::uint64_t seed)
+    {
+        std::uint32_t bits[kBlock];
+        for(size_t start = begin; start < end; start += kBlock)
+        {
+            const size_t count = std::min(kBlock, end - start);
+            const size_t generated = count + (count & 1); // whole Box-Muller pairs
+            Philox::fill(bits, generated, start, stream, seed);
+            float *dst = out + start;
+            if(normal)
+            {
+                constexpr float kTwoPi = 2.0f * std::numbers::pi_v<float>;
+                for(size_t k = 0; k + 1 < count; k += 2)
+                {
+                    // u1 in (0, 1] keeps the logarithm finite
+                    const float u1 = 1.0f - Philox::toUniform(bits[k]);
+                    const float u2 = Philox::toUniform(bits[k + 1]);
+                    const float r = b * std::sqrt(-2.0f * std::log(u1));
+                    dst[k] = a + r * std::cos(kTwoPi * u2);
+                    dst[k + 1] = a + r * std::sin(kTwoPi * u2);
+                }
+                if(count & 1)
+                {
+                    const float u1 = 1.0f - Philox::toUniform(bits[count - 1]);
+                    const float u2 = Philox::toUniform(bits[count]);
+                    dst[count - 1] = a + b * std::sqrt(-2.0f * std::log(u1)) * std::cos(kTwoPi * u2);
+                }
+            }
+            else
+            {
+                // a + (b - a) * U[0, 1)
+                for(size_t k = 0; k < count; k++)
+                {
+                    dst[k] = a + (b - a) * Philox::toUniform(bits[k]);
+                }
+            }
+        }
+    }
+}
+
+
+
+namespace Initializer
+{
+
+void setSeed(std::uint64_t seed)
+{
+    global_seed = seed;
+    stream_counter = 0;
+}
+
+
+
+std::uint64_t getSeed()
+{
+    return global_seed;
+}
+
+
+
+std::uint64_t nextStream()
+{
+    return stream_counter.fetch_add(1);
+}
+
+
+
+std::uint64_t deriveSeed()
+{
+    const std::uint64_t stream = nextStream();
+    const std::uint64_t seed = getSeed();
+    return (static_cast<std::uint64_t>(Philox::at(0, stream, seed)) << 32) | Philox::at(1, stream, seed);
+}
+
+
+
+void fill(Tensor &tensor, Scheme scheme, size_t fan_in, size_t fan_out, float scale)
+{
+    fill(tensor, scheme, fan_in, fan_out, scale, nextStream(), getSeed());
+}
+
+
+
+void fill(Tensor &tensor, Scheme scheme, size_t fan_in, size_t fan_out, float scale, std::uint64_t stream, std::uint64_t seed)
+{
+    if(!tensor.getCpuData())
+    {
+        tensor.allocateCpu();
+    }
+    float *data = tensor.getCpuData();
+    const size_t size = tensor.getSize();
+    if(scheme == Scheme::Zeros)
+    {
+        std::fill(data, data + size, 0.0f);
+        return;
+    }
+
+    const double fan_avg = static_cast<double>(std::max<size_t>(fan_in + fan_out, 1));
+    const double fan = static_cast<double>(std::max<size_t>(fan_in, 1));
+    bool normal = false;
+    double spread = scale; // standard deviation or bound
+    switch(scheme)
+    {
+        case Scheme::Normal: normal = true; break;
+        case Scheme::Uniform: break;
+        case Scheme::XavierNormal: normal = true; spread = std::sqrt(2.0 / fan_avg); break;
+        case Scheme::XavierUniform: spread = std::sqrt(6.0 / fan_avg); break;
+        case Scheme::HeNormal: normal = true; spread = std::sqrt(2.0 / fan); break;
+        case Scheme::HeUniform: spread = std::sqrt(6.0 / fan); break;
+        case Scheme::Zeros: break;
+    }
+    // Normal: mean a, deviation b. Uniform: range [a, b).
+    const float a = normal ? 0.0f : static_cast<float>(-spread);
+    const float b = static_cast<float>(spread);
+
+    const size_t chunks = (size + kParallelChunk - 1) / kParallelChunk;
+    const size_t threads = std::min<size_t>(chunks, std::max(1u, std::thread::hardware_concurrency()));
+    if(threads <= 1)
+    {
+        fillRange(data, 0, size, normal, a, b, stream, seed);
+        return;
+    }
+    std::atomic<size_t> next_chunk{0};
+    auto worker = [&]
+    {
+        for(size_t c = next_chunk.fetch_add(1); c < chunks; c = next_chunk.fetch_add(1))
+        {
+            fillRange(data, c * kParallelChunk, std::min(size, (c + 1) * kParallelChunk), normal, a, b, stream, seed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(size_t t = 1; t < threads; t++)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for(auto &thread : pool)
+    {
+        thread.join();
+    }
+}
+
+
+
+const char *name(Scheme scheme) noexcept
+{
+    switch(scheme)
+    {
+        case Scheme::Zeros: return "zeros";
+        case Scheme::Normal: return "normal";
+        case Scheme::Uniform: return "uniform";
+        case Scheme::XavierNormal: return "Xavier normal";
+        case Scheme::XavierUniform: return "Xavier uniform";
+        case Scheme::HeNormal: return "He normal";
+        case Scheme::HeUniform: return "He uniform";
+    }
+    return "unknown";
+}
+
+} // namespace Initializer
@@ -0,0 +1,58 @@
+// =============================================================================
+// File: src/nn/Initializer.h
+// =============================================================================
+//
+// Description: Deterministic parameter initialization. Every tensor draws from
+//              its own Philox stream under a global seed, and element i is a
+//              function of (seed, stream, i) alone, so large tensors are
+//              filled by several threads in parallel and the result does not
+//              depend on the thread count or the machine. Streams are numbered
+//              in the order tensors are initialized; setSeed() restarts the
+//              numbering, so a model built after it is reproducible.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+
+
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Initializer
+{
+    enum class Scheme : std::uint8_t
+    {
+        Zeros,
+        Normal,        // N(0, scale^2)
+        Uniform,       // U(-scale, scale)
+        XavierNormal,  // N(0, 2 / (fan_in + fan_out))
+        XavierUniform, // U(-a, a), a = sqrt(6 / (fan_in + fan_out))
+        HeNormal,      // N(0, 2 / fan_in)
+        HeUniform,     // U(-a, a), a = sqrt(6 / fan_in)
+    };
+
+    inline constexpr std::uint64_t kDefaultSeed = 0x5EED5EED5EED5EEDull;
+
+    void setSeed(std::uint64_t seed);
+    [[nodiscard]] std::uint64_t getSeed();
+    // Stream id for the next tensor to be initialized
+    [[nodiscard]] std::uint64_t nextStream();
+    // A 64-bit seed drawn from the next stream, for other random layers
+    [[nodiscard]] std::uint64_t deriveSeed();
+
+    // Fills tensor (allocating it if needed) from the next stream. scale is
+    // the standard deviation for Normal and the bound for Uniform; the
+    // fan-based schemes ignore it.
+    void fill(Tensor &tensor, Scheme scheme, size_t fan_in, size_t fan_out, float scale = 0.1f);
+    // Same with an explicit stream and seed
+    void fill(Tensor &tensor, Scheme scheme, size_t fan_in, size_t fan_out, float scale, std::uint64_t stream, std::uint64_t seed);
+
+    [[nodiscard]] const char *name(Scheme scheme) noexcept;
+}
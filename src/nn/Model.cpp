@@ -1,13 +1,20 @@
 #include "nn/Model.h"
+#include "nn/AllocationTracker.h"
 #include "nn/Loss.h"
+#include "nn/NumericHealth.h"
 #include "nn/layers/Dense.h"
 #include "nn/layers/Layer.h"
+#include "nn/layers/Normalization.h"
+#include "nn/layers/SparseDense.h"
 #include "nn/optimizers/Optimizer.h"
+#include "perf/PerfCounters.h"
 
 
 
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
 
 
 
@@ -17,6 +24,13 @@ Model::Model()
 
 
 
+Model::~Model()
+{
+    NumericHealth::forget(this);
+}
+
+
+
 void Model::add(std::unique_ptr<Layer> layer)
 {
     layers.push_back(std::move(layer));
@@ -35,9 +49,12 @@ void Model::compile(std::unique_ptr<Loss> loss_func, std::unique_ptr<Optimizer>
 Tensor Model::forward(const Tensor &input)
 {
     Tensor current_output = input;
-    for(auto &layer : layers)
+    for(size_t i = 0; i < layers.size(); i++)
     {
-        current_output = layer->forward(current_output);
+        if(layers[i]->isIdentity()) { continue; }
+        PerfCounters::Region region("forward", static_cast<int>(i));
+        AllocationTracker::Scope tag("forward", static_cast<int>(i));
+        current_output = layers[i]->forward(current_output);
     }
     return current_output;
 }
@@ -47,9 +64,12 @@ Tensor Model::forward(const Tensor &input)
 void Model::backward(const Tensor &grad)
 {
     Tensor current_grad = grad;
-    for(auto it = layers.rbegin(); it != layers.rend(); it++)
+    for(size_t i = layers.size(); i-- > 0;)
     {
-        current_grad = (*it)->backward(current_grad);
+        if(layers[i]->isIdentity()) { continue; }
+        PerfCounters::Region region("backward", static_cast<int>(i));
+        AllocationTracker::Scope tag("backward", static_cast<int>(i));
+        current_grad = layers[i]->backward(current_grad);
     }
 }
 
@@ -57,13 +77,85 @@ void Model::backward(const Tensor &grad)
 
 float Model::train_step(const Tensor &X_batch, const Tensor &y_batch)
 {
+    step_count++;
+    const bool sampled = (health_interval > 0) && (step_count % health_interval == 0);
+    const bool clipping = max_grad_norm > 0.0f;
+    NumericHealth::Collect collect(sampled, sampled || clipping);
+    if(sampled || clipping)
+    {
+        for(auto &layer : layers) { layer->resetHealth(); }
+    }
+
     Tensor y_pred = this->forward(X_batch);
-    float loss = loss_func->forward(y_pred, y_batch);
-    Tensor grad = loss_func->backward(y_pred, y_batch);
+    float loss = 0.0f;
+    Tensor grad;
+    {
+        AllocationTracker::Scope tag("loss");
+        loss = loss_func->forward(y_pred, y_batch);
+        grad = loss_func->backward(y_pred, y_batch);
+    }
     this->backward(grad);
-    for(auto &layer : layers)
+
+    NumericHealth::Report report;
+    report.step = step_count;
+    report.loss = loss;
+    report.source = this;
+    if(sampled || clipping)
+    {
+        double grad_sq = 0.0;
+        bool grads_finite = true;
+        for(const auto &layer : layers)
+        {
+            grad_sq += layer->getHealth().grad_sq;
+            grads_finite = grads_finite && (layer->getHealth().grad_non_finite == 0);
+        }
+        report.grad_norm = std::sqrt(grad_sq);
+        if(clipping)
+        {
+            report.skipped = !grads_finite || !std::isfinite(loss);
+            if(report.grad_norm > max_grad_norm)
+            {
+                report.clip_scale = static_cast<float>(max_grad_norm / report.grad_norm);
+            }
+        }
+    }
+
+    if(report.skipped)
     {
-        layer->update(*optimizer);
+        skipped_steps++;
+    }
+    else
+    {
+        PerfCounters::Region region("optimizer step");
+        AllocationTracker::Scope tag("optimizer step");
+        optimizer->setGradientScale(report.clip_scale);
+        for(auto &layer : layers)
+        {
+            layer->update(*optimizer);
+        }
+        optimizer->setGradientScale(1.0f);
+    }
+
+    if(pruning.prunesAt(step_count - pruning_origin))
+    {
+        const float sparsity = pruning.sparsityAt(step_count - pruning_origin);
+        for(auto &layer : layers)
+        {
+            auto *dense = dynamic_cast<Dense *>(layer.get());
+            if(dense && (dense->weights.getSize() >= pruning.min_weights))
+            {
+                Pruning::pruneByMagnitude(*dense, sparsity, pruning.block);
+            }
+        }
+    }
+
+    if(sampled || report.skipped || !std::isfinite(loss))
+    {
+        for(size_t i = 0; (sampled || clipping) && (i < layers.size()); i++)
+        {
+            report.layers.push_back({i, layers[i]->getTypeName(), layers[i]->getHealth()});
+        }
+        NumericHealth::publish(std::move(report));
     }
     return loss;
 }
@@ -72,9 +164,20 @@ float Model::train_step(const Tensor &X_batch, const Tensor &y_batch)
 
 std::pair<float, float> Model::evaluate(const Tensor &X_test, const Tensor &y_test)
 {
-    // Forward pass on test data
+    // Forward pass on test data, with layers in inference mode
     auto t0 = std::chrono::high_resolution_clock::now();
-    Tensor y_pred = this->forward(X_test);
+    setTraining(false);
+    Tensor y_pred;
+    try
+    {
+        y_pred = this->forward(X_test);
+    }
+    catch(...)
+    {
+        setTraining(true);
+        throw;
+    }
+    setTraining(true);
     auto t1 = std::chrono::high_resolution_clock::now();
 
     // Calculate loss
@@ -172,3 +275,123 @@ void Model::setBackend(Backend type)
         // Add other layer types that support backend selection here
     }
 }
+
+
+
+void Model::setTraining(bool is_training)
+{
+    for(auto &layer : layers)
+    {
+        layer->setTraining(is_training);
+    }
+}
+
+
+
+size_t Model::setPruning(const PruningSchedule &schedule)
+{
+    pruning = schedule;
+    pruning_origin = step_count;
+    size_t masked = 0;
+    for(auto &layer : layers)
+    {
+        auto *dense = dynamic_cast<Dense *>(layer.get());
+        if(!dense || !dense->isPruned())
+        {
+            continue;
+        }
+        masked++;
+        if(!schedule.enabled())
+        {
+            dense->clearPruningMask();
+        }
+    }
+    return masked;
+}
+
+
+
+size_t Model::sparsify(SparseFormat format, size_t block, float min_sparsity)
+{
+    size_t replaced = 0;
+    for(auto &layer : layers)
+    {
+        auto *dense = dynamic_cast<Dense *>(layer.get());
+        if(!dense || (dense->getBackendType() != Backend::CPU) || (Pruning::sparsity(dense->weights) < min_sparsity))
+        {
+            continue;
+        }
+        layer = std::make_unique<SparseDense>(*dense, format, block);
+        replaced++;
+    }
+    return replaced;
+}
+
+
+
+Model::Snapshot Model::snapshot()
+{
+    Snapshot result;
+    for(auto &layer : layers)
+    {
+        for(Tensor *tensor : layer->getStateTensors())
+        {
+            result.tensors.push_back(*tensor);
+        }
+    }
+    if(optimizer)
+    {
+        result.optimizer_state = optimizer->saveState();
+    }
+    result.step_count = step_count;
+    result.skipped_steps = skipped_steps;
+    return result;
+}
+
+
+
+void Model::restore(const Snapshot &snapshot)
+{
+    size_t next = 0;
+    for(auto &layer : layers)
+    {
+        for(Tensor *tensor : layer->getStateTensors())
+        {
+            if(next >= snapshot.tensors.size())
+            {
+                throw std::invalid_argument("Model::restore: snapshot does not match the model's layers");
+            }
+            *tensor = snapshot.tensors[next++];
+        }
+    }
+    if(next != snapshot.tensors.size())
+    {
+        throw std::invalid_argument("Model::restore: snapshot does not match the model's layers");
+    }
+    if(optimizer)
+    {
+        optimizer->restoreState(snapshot.optimizer_state.get());
+    }
+    step_count = snapshot.step_count;
+    skipped_steps = snapshot.skipped_steps;
+}
+
+
+
+size_t Model::foldBatchNorm()
+{
+    size_t folded = 0;
+    for(size_t i = 0; (i + 1) < layers.size(); i++)
+    {
+        auto *dense = dynamic_cast<Dense *>(layers[i].get());
+        auto *bn = dynamic_cast<BatchNorm1d *>(layers[i + 1].get());
+        if((!dense) || (!bn) || (bn->getNumFeatures() != dense->weights.getCols()))
+        {
+            continue;
+        }
+        bn->foldInto(*dense);
+        layers.erase(layers.begin() + static_cast<std::ptrdiff_t>(i + 1));
+        folded++;
+    }
+    return folded;
+}
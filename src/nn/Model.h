@@ -2,7 +2,9 @@
 
 
 
+#include "backend/cpu/CpuOps.h"
 #include "nn/Loss.h"
+#include "nn/Pruning.h"
 #include "nn/Tensor.h"
 #include "nn/layers/Layer.h"
 #include "nn/nn_types.h"
@@ -19,6 +21,7 @@ class Model
 {
 public:
     Model();
+    ~Model();
     void add(std::unique_ptr<Layer> layer);
 
     void compile(std::unique_ptr<Loss> loss_func, std::unique_ptr<Optimizer> optimizer);
@@ -33,13 +36,73 @@ public:
     [[nodiscard]] std::pair<float, float> evaluate(const Tensor &X_test, const Tensor &y_test);
 
     [[nodiscard]] const std::vector<std::unique_ptr<Layer>> &getLayers() const { return layers; }
+    [[nodiscard]] Loss *getLoss() const { return loss_func.get(); }
+    [[nodiscard]] Optimizer *getOptimizer() const { return optimizer.get(); }
 
     // Set backend for all layers that support it
     void setBackend(Backend type);
 
+    // Switch every layer between training and inference behaviour
+    void setTraining(bool is_training);
+
+    // Inference-time graph pass: folds each BatchNorm1d that directly follows
+    // a Dense into that Dense's weights/biases and removes it. Returns the
+    // number of layers folded. The model should not be trained afterwards.
+    size_t foldBatchNorm();
+
+    // Every n-th train_step (0 = never) layers collect NumericHealth
+    // statistics in their existing loops and a report is published. A step
+    // with a non-finite loss or gradient always publishes one.
+    void setHealthInterval(size_t every_n_steps) { health_interval = every_n_steps; }
+    [[nodiscard]] size_t getHealthInterval() const noexcept { return health_interval; }
+
+    // Scales the gradients of each step so their global L2 norm is at most
+    // max_norm (0 = off), and skips updates whose gradients are not finite
+    void setGradientClipping(float max_norm) { max_grad_norm = max_norm; }
+    [[nodiscard]] float getGradientClipping() const noexcept { return max_grad_norm; }
+    [[nodiscard]] size_t getSkippedSteps() const noexcept { return skipped_steps; }
+
+    // Gradual magnitude pruning of the Dense layers, applied after the
+    // optimizer step on the schedule's steps (counted from the next
+    // train_step); pruned weights stay zero through later updates. An
+    // enabled schedule keeps the masks of an earlier run and prunes on from
+    // them; a disabled one clears them so the weights can grow back.
+    // Returns the number of layers that had a mask.
+    size_t setPruning(const PruningSchedule &schedule);
+    [[nodiscard]] const PruningSchedule &getPruning() const noexcept { return pruning; }
+
+    // Inference-time pass: replaces each CPU Dense layer whose weights are at
+    // least min_sparsity zero with a SparseDense in the given format.
+    // Returns the number of layers replaced. The model should not be trained
+    // afterwards.
+    size_t sparsify(SparseFormat format = SparseFormat::Csr, size_t block = 4, float min_sparsity = 0.5f);
+
+    // Everything train_step changes: each layer's state tensors, the
+    // optimizer state and the step counters. Trial runs (calibration)
+    // restore it so training resumes exactly where it was.
+    struct Snapshot
+    {
+        std::vector<Tensor> tensors;
+        std::unique_ptr<Optimizer::State> optimizer_state;
+        size_t step_count = 0;
+        size_t skipped_steps = 0;
+    };
+    [[nodiscard]] Snapshot snapshot();
+    // The model must still have the layers it had when snapshot was taken
+    void restore(const Snapshot &snapshot);
+
 private:
+    // ModelBatch runs train_step's arithmetic outside it and counts the steps
+    friend class ModelBatch;
+
     std::vector<std::unique_ptr<Layer>> layers;
     std::unique_ptr<Loss> loss_func;
     std::unique_ptr<Optimizer> optimizer;
     Backend backendType = Backend::CPU;
+    size_t health_interval = 0;
+    float max_grad_norm = 0.0f;
+    size_t step_count = 0;
+    size_t skipped_steps = 0;
+    PruningSchedule pruning;
+    size_t pruning_origin = 0; // step_count when the schedule was set
 };
@@ -0,0 +1,425 @@
+// =============================================================================
+// File: src/nn/ModelBatch.cpp
+// =============================================================================
+//
+// Description: Implements ModelBatch. Activations and gradients of all K
+//              models live in one buffer per stage, laid out model-major, so
+//              each grouped GEMM addresses model k at a fixed offset. The
+//              element-wise epilogues and the losses follow the arithmetic of
+//              Dense, Activation, Softmax and Loss exactly, so a batched step
+//              matches K separate Model::train_step calls.
+//
+// =============================================================================
+
+#include "nn/ModelBatch.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+#include "nn/Loss.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Softmax.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+
+
+namespace
+{
+    [[nodiscard]] const Tensor &pick(const std::vector<const Tensor *> &tensors, size_t k)
+    {
+        return *tensors[(tensors.size() == 1) ? 0 : k];
+    }
+}
+
+
+
+ModelBatch::ModelBatch(std::vector<Model *> models)
+    : models{std::move(models)}
+{
+    if(this->models.empty())
+    {
+        throw std::invalid_argument("ModelBatch: no models given");
+    }
+    const size_t count = this->models.size();
+    const auto &reference = this->models.front()->getLayers();
+    for(size_t k = 0; k < count; k++)
+    {
+        Model *model = this->models[k];
+        if(!model || !model->getOptimizer() || !model->getLoss())
+        {
+            throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " is not compiled");
+        }
+        if(model->getGradientClipping() > 0.0f)
+        {
+            throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " uses gradient clipping, which the batched step does not apply");
+        }
+        if(model->getPruning().enabled())
+        {
+            throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " has a pruning schedule, which the batched step does not apply");
+        }
+        if(model->getHealthInterval() > 0)
+        {
+            throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " samples numeric health, which the batched step does not report");
+        }
+        const bool is_cross_entropy = dynamic_cast<CrossEntropyLoss *>(model->getLoss()) != nullptr;
+        if(!is_cross_entropy && !dynamic_cast<MeanSquaredError *>(model->getLoss()))
+        {
+            throw std::invalid_argument("ModelBatch: unsupported loss in model " + std::to_string(k));
+        }
+        if(k == 0)
+        {
+            cross_entropy = is_cross_entropy;
+        }
+        else if(is_cross_entropy != cross_entropy)
+        {
+            throw std::invalid_argument("ModelBatch: models use different losses");
+        }
+
+        const auto &layers = model->getLayers();
+        if(layers.size() != reference.size())
+        {
+            throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " has a different architecture");
+        }
+        size_t stage = 0;
+        for(size_t i = 0; i < layers.size(); i++)
+        {
+            Layer *layer = layers[i].get();
+            if(std::strcmp(layer->getTypeName(), reference[i]->getTypeName()) != 0)
+            {
+                throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " has a different architecture");
+            }
+            if(auto *dense = dynamic_cast<Dense *>(layer))
+            {
+                if(dense->getBackendType() != Backend::CPU)
+                {
+                    throw std::invalid_argument("ModelBatch: Dense layers must use the CPU backend");
+                }
+                if(k == 0)
+                {
+                    Stage next;
+                    next.inputs = dense->weights.getRows();
+                    next.outputs = dense->weights.getCols();
+                    if(!stages.empty() && (stages.back().outputs != next.inputs))
+                    {
+                        throw std::invalid_argument("ModelBatch: Dense layer " + std::to_string(i) + " does not match its input");
+                    }
+                    stages.push_back(std::move(next));
+                }
+                else if((stage >= stages.size()) || (dense->weights.getRows() != stages[stage].inputs) ||
+                        (dense->weights.getCols() != stages[stage].outputs))
+                {
+                    throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " has a different architecture");
+                }
+                stages[stage].dense.push_back(dense);
+                stage++;
+                continue;
+            }
+
+            // Anything else is the epilogue of the preceding Dense layer
+            Epilogue epilogue = Epilogue::None;
+            if(auto *activation = dynamic_cast<Activation *>(layer))
+            {
+                epilogue = (activation->getType() == ActivationType::ReLU) ? Epilogue::ReLU : Epilogue::Sigmoid;
+            }
+            else if(dynamic_cast<Softmax *>(layer) && (i + 1 == layers.size()))
+            {
+                epilogue = Epilogue::Softmax;
+            }
+            else
+            {
+                throw std::invalid_argument(std::string("ModelBatch: unsupported layer ") + layer->getTypeName() + " at position " + std::to_string(i));
+            }
+            if((stage == 0) || (i == 0) || !dynamic_cast<Dense *>(layers[i - 1].get()))
+            {
+                throw std::invalid_argument("ModelBatch: activations must directly follow a Dense layer");
+            }
+            if(k == 0)
+            {
+                stages[stage - 1].epilogue = epilogue;
+            }
+            else if(stages[stage - 1].epilogue != epilogue)
+            {
+                throw std::invalid_argument("ModelBatch: model " + std::to_string(k) + " has a different architecture");
+            }
+        }
+    }
+    if(stages.empty())
+    {
+        throw std::invalid_argument("ModelBatch: models have no Dense layers");
+    }
+    a_ptrs.resize(count);
+    b_ptrs.resize(count);
+    c_ptrs.resize(count);
+}
+
+
+
+void ModelBatch::ensureCapacity(size_t rows)
+{
+    if(rows == capacity_rows)
+    {
+        return;
+    }
+    const size_t count = models.size();
+    size_t widest = 0;
+    for(Stage &stage : stages)
+    {
+        stage.activations.assign(count * rows * stage.outputs, 0.0f);
+        widest = std::max({widest, stage.inputs, stage.outputs});
+    }
+    delta.assign(count * rows * widest, 0.0f);
+    delta_prev.assign(count * rows * widest, 0.0f);
+    capacity_rows = rows;
+}
+
+
+
+void ModelBatch::runForward(const std::vector<const Tensor *> &X, size_t rows)
+{
+    const size_t count = models.size();
+    for(size_t s = 0; s < stages.size(); s++)
+    {
+        Stage &stage = stages[s];
+        const size_t in = stage.inputs;
+        const size_t out = stage.outputs;
+        for(size_t k = 0; k < count; k++)
+        {
+            a_ptrs[k] = (s == 0) ? pick(X, k).getCpuData() : stages[s - 1].activations.data() + k * rows * in;
+            b_ptrs[k] = stage.dense[k]->weights.getCpuData();
+            c_ptrs[k] = stage.activations.data() + k * rows * out;
+        }
+        CpuOps::gemmGrouped(false, false, rows, out, in, 1.0f, a_ptrs.data(), in, b_ptrs.data(), out, 0.0f, c_ptrs.data(), out, count);
+
+        // Bias and activation epilogue, row by row
+        for(size_t k = 0; k < count; k++)
+        {
+            const float *bias = stage.dense[k]->biases.getCpuData();
+            for(size_t i = 0; i < rows; i++)
+            {
+                float *row = c_ptrs[k] + i * out;
+                for(size_t j = 0; j < out; j++)
+                {
+                    row[j] += bias[j];
+                }
+                switch(stage.epilogue)
+                {
+                    case Epilogue::None:
+                        break;
+                    case Epilogue::ReLU:
+                        for(size_t j = 0; j < out; j++) { row[j] = std::max(0.0f, row[j]); }
+                        break;
+                    case Epilogue::Sigmoid:
+                        for(size_t j = 0; j < out; j++) { row[j] = 1.0f / (1.0f + std::exp(-row[j])); }
+                        break;
+                    case Epilogue::Softmax:
+                    {
+                        const float max_val = *std::max_element(row, row + out);
+                        float sum = 0.0f;
+                        for(size_t j = 0; j < out; j++)
+                        {
+                            row[j] = std::exp(row[j] - max_val);
+                            sum += row[j];
+                        }
+                        for(size_t j = 0; j < out; j++) { row[j] /= sum; }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+std::vector<Tensor> ModelBatch::forward(const std::vector<const Tensor *> &X)
+{
+    const size_t count = models.size();
+    if((X.size() != 1) && (X.size() != count))
+    {
+        throw std::invalid_argument("ModelBatch::forward: expected one input or one per model");
+    }
+    const size_t rows = X.front()->getRows();
+    for(const Tensor *input : X)
+    {
+        if((input->getRows() != rows) || (input->getCols() != stages.front().inputs))
+        {
+            throw std::invalid_argument("ModelBatch::forward: inputs must share one shape matching the first layer");
+        }
+    }
+    ensureCapacity(rows);
+    runForward(X, rows);
+
+    const Stage &last = stages.back();
+    std::vector<Tensor> outputs;
+    outputs.reserve(count);
+    for(size_t k = 0; k < count; k++)
+    {
+        Tensor output{{rows, last.outputs}};
+        const float *src = last.activations.data() + k * rows * last.outputs;
+        std::copy(src, src + rows * last.outputs, output.getCpuData());
+        outputs.push_back(std::move(output));
+    }
+    return outputs;
+}
+
+
+
+std::vector<float> ModelBatch::train_step(const std::vector<const Tensor *> &X, const std::vector<const Tensor *> &y)
+{
+    const size_t count = models.size();
+    if(((X.size() != 1) && (X.size() != count)) || ((y.size() != 1) && (y.size() != count)))
+    {
+        throw std::invalid_argument("ModelBatch::train_step: expected one batch or one per model");
+    }
+    const size_t rows = X.front()->getRows();
+    const Stage &last = stages.back();
+    for(size_t k = 0; k < count; k++)
+    {
+        const Tensor &input = pick(X, k);
+        const Tensor &target = pick(y, k);
+        if((input.getRows() != rows) || (input.getCols() != stages.front().inputs) || (target.getRows() != rows))
+        {
+            throw std::invalid_argument("ModelBatch::train_step: batches must share one shape matching the first layer");
+        }
+        const bool one_hot = target.getCols() == last.outputs;
+        if(!one_hot && (!cross_entropy || (target.getCols() != 1)))
+        {
+            throw std::invalid_argument("ModelBatch::train_step: targets do not match the output layer");
+        }
+    }
+    if(rows == 0)
+    {
+        return std::vector<float>(count, 0.0f);
+    }
+    ensureCapacity(rows);
+    runForward(X, rows);
+
+    // Loss and its gradient w.r.t. the last stage's outputs
+    std::vector<float> losses(count, 0.0f);
+    const size_t out = last.outputs;
+    for(size_t k = 0; k < count; k++)
+    {
+        const float *pred = last.activations.data() + k * rows * out;
+        const float *target = pick(y, k).getCpuData();
+        float *grad = delta.data() + k * rows * out;
+        float loss = 0.0f;
+        if(cross_entropy && (pick(y, k).getCols() == 1))
+        {
+            for(size_t i = 0; i < rows; i++)
+            {
+                const int class_idx = static_cast<int>(target[i]);
+                for(size_t j = 0; j < out; j++)
+                {
+                    grad[i * out + j] = pred[i * out + j] / rows;
+                }
+                if((class_idx >= 0) && (class_idx < static_cast<int>(out)))
+                {
+                    loss -= std::log(std::max(pred[i * out + class_idx], 1e-9f));
+                    grad[i * out + class_idx] = (pred[i * out + class_idx] - 1.0f) / rows;
+                }
+            }
+            loss /= rows;
+        }
+        else if(cross_entropy)
+        {
+            for(size_t i = 0; i < rows * out; i++)
+            {
+                if(target[i] > 0.0f)
+                {
+                    loss -= std::log(std::max(pred[i], 1e-9f));
+                }
+                grad[i] = (pred[i] - target[i]) / rows;
+            }
+            loss /= rows;
+        }
+        else
+        {
+            const size_t size = rows * out;
+            for(size_t i = 0; i < size; i++)
+            {
+                const float diff = pred[i] - target[i];
+                loss += diff * diff;
+                grad[i] = 2 * diff / size;
+            }
+            loss /= size;
+        }
+        losses[k] = loss;
+    }
+
+    // Backward, last stage first; delta holds dL/d(stage output)
+    for(size_t s = stages.size(); s-- > 0;)
+    {
+        Stage &stage = stages[s];
+        const size_t in = stage.inputs;
+        const size_t width = stage.outputs;
+        const size_t elements = count * rows * width;
+        if(stage.epilogue == Epilogue::ReLU)
+        {
+            for(size_t i = 0; i < elements; i++) { delta[i] *= (stage.activations[i] > 0) ? 1.0f : 0.0f; }
+        }
+        else if(stage.epilogue == Epilogue::Sigmoid)
+        {
+            for(size_t i = 0; i < elements; i++) { delta[i] *= stage.activations[i] * (1.0f - stage.activations[i]); }
+        }
+        // Softmax passes the cross-entropy gradient through, as Softmax::backward does
+
+        // dW = X^T dZ
+        for(size_t k = 0; k < count; k++)
+        {
+            a_ptrs[k] = (s == 0) ? pick(X, k).getCpuData() : stages[s - 1].activations.data() + k * rows * in;
+            b_ptrs[k] = delta.data() + k * rows * width;
+            c_ptrs[k] = stage.dense[k]->getGradWeights().getCpuData();
+        }
+        CpuOps::gemmGrouped(true, false, in, width, rows, 1.0f, a_ptrs.data(), in, b_ptrs.data(), width, 0.0f, c_ptrs.data(), width, count);
+
+        // db: column means of dZ, as Dense::backward computes them
+        for(size_t k = 0; k < count; k++)
+        {
+            const float *g = delta.data() + k * rows * width;
+            float *grad_biases = stage.dense[k]->getGradBiases().getCpuData();
+            for(size_t j = 0; j < width; j++)
+            {
+                float sum = 0;
+                for(size_t i = 0; i < rows; i++)
+                {
+                    sum += g[i * width + j];
+                }
+                grad_biases[j] = sum / rows;
+            }
+        }
+
+        // dX = dZ W^T, not needed below the first stage
+        if(s > 0)
+        {
+            for(size_t k = 0; k < count; k++)
+            {
+                a_ptrs[k] = delta.data() + k * rows * width;
+                b_ptrs[k] = stage.dense[k]->weights.getCpuData();
+                c_ptrs[k] = delta_prev.data() + k * rows * in;
+            }
+            CpuOps::gemmGrouped(false, true, rows, in, width, 1.0f, a_ptrs.data(), width, b_ptrs.data(), width, 0.0f, c_ptrs.data(), in, count);
+            delta.swap(delta_prev);
+        }
+    }
+
+    // Every model steps with its own optimizer state and learning rate
+    for(size_t k = 0; k < count; k++)
+    {
+        models[k]->step_count++;
+        Optimizer &optimizer = *models[k]->getOptimizer();
+        for(Stage &stage : stages)
+        {
+            stage.dense[k]->update(optimizer);
+        }
+    }
+    return losses;
+}
@@ -0,0 +1,89 @@
+// =============================================================================
+// File: src/nn/ModelBatch.h
+// =============================================================================
+//
+// Description: Trains K compiled Models of one MLP architecture together, for
+//              ensembles, hyperparameter trials or cross-validation folds.
+//              Every Dense layer of the K models runs as one grouped GEMM
+//              (CpuOps::gemmGrouped) over the models' own weight tensors, so
+//              a small network that leaves most cores idle on its own keeps
+//              all of the GEMM threads (CpuOps::setThreads) busy. Each model keeps its weights, gradients and
+//              optimizer state; after training the Models are used as usual.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Model.h"
+#include "nn/Tensor.h"
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+class Dense;
+
+
+
+class ModelBatch
+{
+public:
+    // The models must be compiled, on the CPU backend, and made of Dense
+    // layers each optionally followed by a ReLU/Sigmoid Activation, with an
+    // optional final Softmax; all must have the same layer shapes and the
+    // same loss (CrossEntropyLoss or MeanSquaredError). Gradient clipping,
+    // a pruning schedule and health sampling are not applied by the batched
+    // step, so models with any of them set are rejected too. Throws
+    // std::invalid_argument otherwise. The models must outlive the batch.
+    explicit ModelBatch(std::vector<Model *> models);
+
+    [[nodiscard]] size_t size() const noexcept { return models.size(); }
+    [[nodiscard]] Model &getModel(size_t index) { return *models[index]; }
+
+    // One training step of every model on its own batch; X and y hold one
+    // entry per model, or a single entry shared by all. Every batch must have
+    // the same number of rows. Returns the loss of each model, equal to what
+    // Model::train_step would return for the same batch, and advances each
+    // model's step count as Model::train_step does.
+    std::vector<float> train_step(const std::vector<const Tensor *> &X, const std::vector<const Tensor *> &y);
+
+    // Forward pass of every model; row-major outputs, one per model
+    [[nodiscard]] std::vector<Tensor> forward(const std::vector<const Tensor *> &X);
+
+private:
+    enum class Epilogue : std::uint8_t
+    {
+        None,
+        ReLU,
+        Sigmoid,
+        Softmax,
+    };
+
+    struct Stage
+    {
+        size_t inputs = 0;
+        size_t outputs = 0;
+        Epilogue epilogue = Epilogue::None;
+        std::vector<Dense *> dense; // one per model
+        std::vector<float> activations; // K x rows x outputs, after the epilogue
+    };
+
+    void ensureCapacity(size_t rows);
+    void runForward(const std::vector<const Tensor *> &X, size_t rows);
+
+    std::vector<Model *> models;
+    std::vector<Stage> stages;
+    bool cross_entropy = false;
+    size_t capacity_rows = 0;
+    std::vector<float> delta;      // gradient w.r.t. the current stage's outputs
+    std::vector<float> delta_prev; // gradient w.r.t. its inputs
+    std::vector<const float *> a_ptrs;
+    std::vector<const float *> b_ptrs;
+    std::vector<float *> c_ptrs;
+};
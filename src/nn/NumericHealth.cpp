@@ -0,0 +1,158 @@
+// =============================================================================
+// File: src/nn/NumericHealth.cpp
+// =============================================================================
+//
+// Description: Implements the per-thread collection switches and the report
+//              channels, one per publishing Model so a diverging model
+//              (a tuning trial, say) is never mistaken for another.
+//
+// =============================================================================
+
+#include "nn/NumericHealth.h"
+
+
+
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+
+
+namespace
+{
+    thread_local bool collect_activations = false;
+    thread_local bool collect_gradients = false;
+
+    struct Channel
+    {
+        NumericHealth::Report last_report;
+        size_t report_count = 0;
+    };
+
+    std::mutex channel_mutex;
+    std::unordered_map<const void *, Channel> channels;
+}
+
+
+
+namespace NumericHealth
+{
+
+Collect::Collect(bool activations, bool gradients) noexcept
+    : previous_activations{collect_activations}, previous_gradients{collect_gradients}
+{
+    collect_activations = activations;
+    collect_gradients = gradients;
+}
+
+
+
+Collect::~Collect()
+{
+    collect_activations = previous_activations;
+    collect_gradients = previous_gradients;
+}
+
+
+
+bool collectingActivations() noexcept
+{
+    return collect_activations;
+}
+
+
+
+bool collectingGradients() noexcept
+{
+    return collect_gradients;
+}
+
+
+
+bool Report::healthy() const noexcept
+{
+    if(!std::isfinite(loss) || skipped)
+    {
+        return false;
+    }
+    for(const LayerReport &layer : layers)
+    {
+        if(layer.stats.output.nonFinite() > 0 || layer.stats.grad_non_finite > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+void publish(Report report)
+{
+    std::lock_guard<std::mutex> lock(channel_mutex);
+    Channel &channel = channels[report.source];
+    channel.last_report = std::move(report);
+    channel.report_count++;
+}
+
+
+
+Report latest(const void *source)
+{
+    std::lock_guard<std::mutex> lock(channel_mutex);
+    const auto it = channels.find(source);
+    return (it == channels.end()) ? Report{} : it->second.last_report;
+}
+
+
+
+size_t published(const void *source)
+{
+    std::lock_guard<std::mutex> lock(channel_mutex);
+    const auto it = channels.find(source);
+    return (it == channels.end()) ? 0 : it->second.report_count;
+}
+
+
+
+void forget(const void *source)
+{
+    std::lock_guard<std::mutex> lock(channel_mutex);
+    channels.erase(source);
+}
+
+
+
+std::vector<std::string> describe(const Report &report)
+{
+    std::vector<std::string> lines;
+    char line[256];
+    std::snprintf(line, sizeof(line), "Health step %zu: loss %.6g, grad norm %.4g, clip scale %.3f%s%s",
+                  report.step, report.loss, report.grad_norm, report.clip_scale,
+                  report.skipped ? ", update skipped" : "", report.healthy() ? "" : " [NON-FINITE]");
+    lines.emplace_back(line);
+    for(const LayerReport &layer : report.layers)
+    {
+        const TensorStats &out = layer.stats.output;
+        if(out.count == 0 && layer.stats.grad_count == 0) { continue; }
+        std::string text = "  [" + std::to_string(layer.index) + "] " + layer.type;
+        if(out.count > 0)
+        {
+            std::snprintf(line, sizeof(line), " | out mean %.4g max|x| %.4g zero %.1f%% nan %llu inf %llu",
+                          out.mean(), out.max_abs, 100.0 * out.zeroFraction(),
+                          static_cast<unsigned long long>(out.nan), static_cast<unsigned long long>(out.inf));
+            text += line;
+        }
+        if(layer.stats.grad_count > 0)
+        {
+            std::snprintf(line, sizeof(line), " | grad norm %.4g non-finite %llu",
+                          layer.stats.gradNorm(), static_cast<unsigned long long>(layer.stats.grad_non_finite));
+            text += line;
+        }
+        lines.push_back(std::move(text));
+    }
+    return lines;
+}
+
+} // namespace NumericHealth
@@ -0,0 +1,135 @@
+// =============================================================================
+// File: src/nn/NumericHealth.h
+// =============================================================================
+//
+// Description: Numerical health statistics of a training step. Layers fold
+//              NaN/Inf counts, the mean and largest magnitude of their output,
+//              its zero fraction (dead ReLUs) and the sum of squares of their
+//              parameter gradients into loops they already run: bias and
+//              activation epilogues, gradient reductions. Collection is
+//              switched on per thread by NumericHealth::Collect, so steps that
+//              are not sampled pay one predictable branch per element. Model
+//              samples every N steps, uses the gradient sums for global norm
+//              clipping and publishes a Report on its own channel, which the
+//              GUI polls for the model it trains.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace NumericHealth
+{
+    struct TensorStats
+    {
+        std::uint64_t count = 0;
+        std::uint64_t nan = 0;
+        std::uint64_t inf = 0;
+        std::uint64_t zeros = 0;
+        double sum = 0.0;      // finite values only
+        float max_abs = 0.0f;  // finite values only
+
+        // Inline so kernel loops can fold in the value they just wrote
+        void observe(float v) noexcept
+        {
+            count++;
+            if(std::isnan(v)) { nan++; return; }
+            if(std::isinf(v)) { inf++; return; }
+            zeros += (v == 0.0f);
+            sum += v;
+            max_abs = std::max(max_abs, std::fabs(v));
+        }
+
+        [[nodiscard]] std::uint64_t nonFinite() const noexcept { return nan + inf; }
+        [[nodiscard]] double mean() const noexcept
+        {
+            const std::uint64_t finite = count - nonFinite();
+            return (finite > 0) ? sum / static_cast<double>(finite) : 0.0;
+        }
+        [[nodiscard]] double zeroFraction() const noexcept
+        {
+            return (count > 0) ? static_cast<double>(zeros) / static_cast<double>(count) : 0.0;
+        }
+    };
+
+    struct LayerStats
+    {
+        TensorStats output;              // filled on sampled steps
+        double grad_sq = 0.0;            // sum of squared finite parameter gradients
+        std::uint64_t grad_count = 0;
+        std::uint64_t grad_non_finite = 0;
+
+        void observeGrad(float g) noexcept
+        {
+            grad_count++;
+            if(std::isfinite(g)) { grad_sq += static_cast<double>(g) * g; }
+            else { grad_non_finite++; }
+        }
+
+        void observeGrads(const float *g, size_t n) noexcept
+        {
+            for(size_t i = 0; i < n; i++) { observeGrad(g[i]); }
+        }
+
+        [[nodiscard]] double gradNorm() const noexcept { return std::sqrt(grad_sq); }
+    };
+
+    // Enables collection on this thread until destroyed; scopes nest
+    class Collect
+    {
+    public:
+        Collect(bool activations, bool gradients) noexcept;
+        ~Collect();
+
+        Collect(const Collect &) = delete;
+        Collect &operator=(const Collect &) = delete;
+
+    private:
+        bool previous_activations;
+        bool previous_gradients;
+    };
+
+    [[nodiscard]] bool collectingActivations() noexcept;
+    [[nodiscard]] bool collectingGradients() noexcept;
+
+    struct LayerReport
+    {
+        size_t index = 0;
+        std::string type;
+        LayerStats stats;
+    };
+
+    struct Report
+    {
+        size_t step = 0;            // 0 until the first report
+        float loss = 0.0f;
+        double grad_norm = 0.0;     // global L2 norm before clipping
+        float clip_scale = 1.0f;    // applied to every gradient this step
+        bool skipped = false;       // update skipped for non-finite gradients
+        const void *source = nullptr; // the Model that published it
+        std::vector<LayerReport> layers;
+
+        [[nodiscard]] bool healthy() const noexcept;
+    };
+
+    // The metrics channels, keyed by Report::source: the most recent report
+    // of a source and how many it has published. forget drops a channel
+    // once its Model is destroyed.
+    void publish(Report report);
+    [[nodiscard]] Report latest(const void *source);
+    [[nodiscard]] size_t published(const void *source);
+    void forget(const void *source);
+
+    // One summary line, then one line per layer with statistics
+    [[nodiscard]] std::vector<std::string> describe(const Report &report);
+}
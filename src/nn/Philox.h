@@ -0,0 +1,143 @@
+// =============================================================================
+// File: src/nn/Philox.h
+// =============================================================================
+//
+// Description: Philox4x32-10 counter-based random number generator (Salmon et
+//              al., "Parallel Random Numbers: As Easy as 1, 2, 3"). Each
+//              128-bit counter maps to four independent 32-bit outputs under a
+//              64-bit key, so any element of a random stream can be computed
+//              directly from its index. This makes generation order- and
+//              thread-count-independent and lets simple loops vectorize.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+
+namespace Philox
+{
+    using Block = std::array<std::uint32_t, 4>;
+
+    inline Block generate(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3, std::uint64_t key)
+    {
+        constexpr std::uint32_t kMul0 = 0xD2511F53u;
+        constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+        constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+        constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+
+        std::uint32_t k0 = static_cast<std::uint32_t>(key);
+        std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+        for(int round = 0; round < 10; round++)
+        {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(kMul0) * c0;
+            const std::uint64_t p1 = static_cast<std::uint64_t>(kMul1) * c2;
+            const std::uint32_t hi0 = static_cast<std::uint32_t>(p0 >> 32);
+            const std::uint32_t lo0 = static_cast<std::uint32_t>(p0);
+            const std::uint32_t hi1 = static_cast<std::uint32_t>(p1 >> 32);
+            const std::uint32_t lo1 = static_cast<std::uint32_t>(p1);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += kWeyl0;
+            k1 += kWeyl1;
+        }
+        return {c0, c1, c2, c3};
+    }
+
+
+
+    // 32-bit value number `index` of the stream identified by (key, stream)
+    inline std::uint32_t at(std::uint64_t index, std::uint64_t stream, std::uint64_t key)
+    {
+        const std::uint64_t block = index >> 2;
+        const Block out = generate(static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32),
+                                   static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32), key);
+        return out[index & 3];
+    }
+
+
+
+    // Fill out[0..count) with values first_index .. first_index + count - 1 of
+    // the stream. Whole blocks are processed kLanes at a time in
+    // structure-of-arrays form so each round is a vectorizable lane loop.
+    inline void fill(std::uint32_t *out, size_t count, std::uint64_t first_index, std::uint64_t stream, std::uint64_t key)
+    {
+        constexpr size_t kLanes = 16;
+        constexpr std::uint32_t kMul0 = 0xD2511F53u;
+        constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+        constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+        constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+
+        size_t i = 0;
+        // Unaligned head until first_index + i is a multiple of 4
+        while((i < count) && (((first_index + i) & 3) != 0))
+        {
+            out[i] = at(first_index + i, stream, key);
+            i++;
+        }
+
+        const std::uint32_t s0 = static_cast<std::uint32_t>(stream);
+        const std::uint32_t s1 = static_cast<std::uint32_t>(stream >> 32);
+        while((i + 4) <= count)
+        {
+            const size_t lanes = std::min(kLanes, (count - i) / 4);
+            const std::uint64_t first_block = (first_index + i) >> 2;
+            std::uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+            for(size_t l = 0; l < kLanes; l++)
+            {
+                c0[l] = static_cast<std::uint32_t>(first_block + l);
+                c1[l] = static_cast<std::uint32_t>((first_block + l) >> 32);
+                c2[l] = s0;
+                c3[l] = s1;
+            }
+            std::uint32_t k0 = static_cast<std::uint32_t>(key);
+            std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+            for(int round = 0; round < 10; round++)
+            {
+                for(size_t l = 0; l < kLanes; l++)
+                {
+                    const std::uint64_t p0 = static_cast<std::uint64_t>(kMul0) * c0[l];
+                    const std::uint64_t p1 = static_cast<std::uint64_t>(kMul1) * c2[l];
+                    const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+                    const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+                    c1[l] = static_cast<std::uint32_t>(p1);
+                    c3[l] = static_cast<std::uint32_t>(p0);
+                    c0[l] = n0;
+                    c2[l] = n2;
+                }
+                k0 += kWeyl0;
+                k1 += kWeyl1;
+            }
+            for(size_t l = 0; l < lanes; l++)
+            {
+                out[i + 4 * l] = c0[l];
+                out[i + 4 * l + 1] = c1[l];
+                out[i + 4 * l + 2] = c2[l];
+                out[i + 4 * l + 3] = c3[l];
+            }
+            i += 4 * lanes;
+        }
+
+        for(; i < count; i++)
+        {
+            out[i] = at(first_index + i, stream, key);
+        }
+    }
+
+
+
+    // Uniform float in [0, 1) from the top 24 bits
+    inline float toUniform(std::uint32_t value)
+    {
+        return static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+    }
+}
@@ -0,0 +1,149 @@
+// =============================================================================
+// File: src/nn/Pruning.cpp
+// =============================================================================
+//
+// Description: Implements magnitude pruning. Weights pruned by an earlier pass
+//              are exactly zero, so they rank first again and the set of
+//              pruned weights only grows as the schedule ramps up.
+//
+// =============================================================================
+
+#include "nn/Pruning.h"
+
+
+
+#include "nn/layers/Dense.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+
+
+float PruningSchedule::sparsityAt(size_t step) const noexcept
+{
+    if(!enabled() || (step < begin_step))
+    {
+        return 0.0f;
+    }
+    if(step >= end_step)
+    {
+        return target_sparsity;
+    }
+    const float progress = static_cast<float>(step - begin_step) / static_cast<float>(end_step - begin_step);
+    const float remaining = 1.0f - progress;
+    return target_sparsity * (1.0f - remaining * remaining * remaining);
+}
+
+
+
+bool PruningSchedule::prunesAt(size_t step) const noexcept
+{
+    if(!enabled() || (step < begin_step) || (step > end_step))
+    {
+        return false;
+    }
+    return (step == end_step) || ((step - begin_step) % std::max<size_t>(interval, 1) == 0);
+}
+
+
+
+void Pruning::pruneByMagnitude(Dense &dense, float sparsity, size_t block)
+{
+    Tensor &weights = dense.weights;
+    const size_t rows = weights.getRows();
+    const size_t cols = weights.getCols();
+    const size_t size = weights.getSize();
+    const size_t target = static_cast<size_t>(std::ceil(std::clamp(sparsity, 0.0f, 1.0f) * static_cast<float>(size)));
+    float *w = weights.getCpuData();
+
+    Tensor mask{weights.getShape()};
+    float *keep = mask.getCpuData();
+    std::fill_n(keep, size, 1.0f);
+
+    if(block <= 1)
+    {
+        // Ties are broken by index so the pruned set is deterministic
+        std::vector<std::uint32_t> order(size);
+        std::iota(order.begin(), order.end(), 0u);
+        auto smaller = [w](std::uint32_t lhs, std::uint32_t rhs)
+        {
+            const float a = std::fabs(w[lhs]);
+            const float b = std::fabs(w[rhs]);
+            return (a < b) || ((a == b) && (lhs < rhs));
+        };
+        if((target > 0) && (target < size))
+        {
+            std::nth_element(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(target), order.end(), smaller);
+        }
+        for(size_t i = 0; i < target; i++)
+        {
+            keep[order[i]] = 0.0f;
+        }
+    }
+    else
+    {
+        // Tiles ranked by mean magnitude, so partial edge tiles compare fairly
+        struct Tile
+        {
+            float score;
+            size_t row;
+            size_t col;
+        };
+        std::vector<Tile> tiles;
+        for(size_t r0 = 0; r0 < rows; r0 += block)
+        {
+            for(size_t c0 = 0; c0 < cols; c0 += block)
+            {
+                const size_t height = std::min(block, rows - r0);
+                const size_t width = std::min(block, cols - c0);
+                float sum = 0.0f;
+                for(size_t r = r0; r < r0 + height; r++)
+                {
+                    for(size_t c = c0; c < c0 + width; c++) { sum += std::fabs(w[r * cols + c]); }
+                }
+                tiles.push_back({sum / static_cast<float>(height * width), r0, c0});
+            }
+        }
+        std::stable_sort(tiles.begin(), tiles.end(), [](const Tile &a, const Tile &b) { return a.score < b.score; });
+        size_t pruned = 0;
+        for(size_t t = 0; (t < tiles.size()) && (pruned < target); t++)
+        {
+            const size_t height = std::min(block, rows - tiles[t].row);
+            const size_t width = std::min(block, cols - tiles[t].col);
+            for(size_t r = tiles[t].row; r < tiles[t].row + height; r++)
+            {
+                std::fill_n(keep + r * cols + tiles[t].col, width, 0.0f);
+            }
+            pruned += height * width;
+        }
+    }
+
+    for(size_t i = 0; i < size; i++)
+    {
+        w[i] *= keep[i];
+    }
+    if(dense.getBackendType() == Backend::GPU)
+    {
+        weights.freeGpu();
+    }
+    dense.setPruningMask(std::move(mask));
+}
+
+
+
+float Pruning::sparsity(const Tensor &weights)
+{
+    if(weights.getSize() == 0)
+    {
+        return 0.0f;
+    }
+    const float *w = weights.getCpuData();
+    const size_t zeros = static_cast<size_t>(std::count(w, w + weights.getSize(), 0.0f));
+    return static_cast<float>(zeros) / static_cast<float>(weights.getSize());
+}
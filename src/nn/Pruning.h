@@ -0,0 +1,62 @@
+// =============================================================================
+// File: src/nn/Pruning.h
+// =============================================================================
+//
+// Description: Gradual magnitude pruning of Dense layers. A PruningSchedule
+//              ramps the target sparsity from 0 to its final value along the
+//              cubic curve of Zhu & Gupta (2017), pruning every few steps so
+//              the network can recover in between. Each pruning pass zeroes
+//              the smallest weights (or block x block tiles, ranked by mean
+//              magnitude, for the Blocked sparse kernels) and installs a mask
+//              that keeps them at zero through every optimizer update. After
+//              training, Model::sparsify swaps the pruned layers for
+//              SparseDense.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+
+
+
+#include <cstddef>
+
+
+
+class Dense;
+
+
+
+struct PruningSchedule
+{
+    float target_sparsity = 0.0f; // fraction of each layer's weights zeroed at end_step, 0 = off
+    size_t begin_step = 0;
+    size_t end_step = 1000;
+    size_t interval = 100;        // steps between pruning passes
+    size_t block = 1;             // 1 prunes single weights, b prunes b x b tiles
+    size_t min_weights = 4096;    // smaller Dense layers (the classifier, say) stay dense
+
+    [[nodiscard]] bool enabled() const noexcept { return target_sparsity > 0.0f; }
+
+    // s(t) = s_f * (1 - (1 - (t - t0) / (t1 - t0))^3) between begin and end
+    [[nodiscard]] float sparsityAt(size_t step) const noexcept;
+
+    // True on the steps a pruning pass runs: every interval from begin_step
+    // and once more at end_step
+    [[nodiscard]] bool prunesAt(size_t step) const noexcept;
+};
+
+
+
+namespace Pruning
+{
+    // Zeroes the smallest-magnitude weights of dense (tiles when block > 1)
+    // until at least sparsity of them are zero, and sets its pruning mask
+    void pruneByMagnitude(Dense &dense, float sparsity, size_t block = 1);
+
+    // Fraction of exact zeros in weights
+    [[nodiscard]] float sparsity(const Tensor &weights);
+}
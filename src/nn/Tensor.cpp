@@ -12,6 +12,11 @@
 
 
 
+#include "nn/AllocationTracker.h"
+#include "nn/Initializer.h"
+
+
+
 #ifdef USE_CUDA
 #include <cuda_runtime.h>
 #endif
@@ -21,7 +26,6 @@
 #include <algorithm>
 #include <iostream>
 #include <numeric>
-#include <random>
 #include <stdexcept>
 
 
@@ -118,7 +122,7 @@ Tensor &Tensor::operator=(const Tensor &other)
 
 
 
-Tensor::Tensor(Tensor &&other) noexcept : shape{std::move(other.shape)}, totalSize{other.totalSize}, cpu_data{other.cpu_data}, gpu_data{other.gpu_data}
+Tensor::Tensor(Tensor &&other) noexcept : shape{std::move(other.shape)}, totalSize{other.totalSize}, cpu_data{other.cpu_data}, gpu_data{other.gpu_data}, cpu_storage{other.cpu_storage}
 {
     other.cpu_data = nullptr;
     other.gpu_data = nullptr;
@@ -141,6 +145,7 @@ Tensor &Tensor::operator=(Tensor &&other) noexcept
     totalSize = other.totalSize;
     cpu_data = other.cpu_data;
     gpu_data = other.gpu_data;
+    cpu_storage = other.cpu_storage;
 
     other.cpu_data = nullptr;
     other.gpu_data = nullptr;
@@ -156,18 +161,7 @@ Tensor &Tensor::operator=(Tensor &&other) noexcept
 
 void Tensor::initializeRandom()
 {
-    if(!cpu_data)
-    {
-        allocateCpu();
-    }
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<float> dist{0.0f, 0.1f};
-
-    for(size_t i = 0; i < totalSize; i++)
-    {
-        cpu_data[i] = dist(gen);
-    }
+    Initializer::fill(*this, Initializer::Scheme::Normal, 0, 0, 0.1f);
 }
 
 
@@ -196,7 +190,9 @@ void Tensor::allocateCpu()
     {
         return;
     }
-    cpu_data = new float[totalSize];
+    // Large buffers may be backed by huge pages, see HostMemory
+    cpu_data = HostMemory::allocate(totalSize, cpu_storage);
+    AllocationTracker::recordAllocation(totalSize * sizeof(float));
 }
 
 
@@ -274,7 +270,8 @@ void Tensor::freeCpu()
 {
     if(cpu_data)
     {
-        delete[] cpu_data;
+        HostMemory::release(cpu_data, totalSize, cpu_storage);
+        AllocationTracker::recordFree(totalSize * sizeof(float));
         cpu_data = nullptr;
     }
 }
@@ -13,6 +13,10 @@
 
 
 
+#include "nn/HostMemory.h"
+
+
+
 // --- Standard Includes ---
 #include <cstddef>
 #include <vector>
@@ -50,6 +54,8 @@ public:
 
     // --- Public Methods ---
 
+    // N(0, 0.01) from the next Initializer stream; reproducible under
+    // Initializer::setSeed. Layers use Initializer::fill with a fan-based scheme.
     void initializeRandom();
 
 
@@ -133,5 +139,6 @@ private:
     size_t totalSize;
     float *cpu_data;
     float *gpu_data;
+    HostMemory::Storage cpu_storage = HostMemory::Storage::Heap;
 };
 
@@ -0,0 +1,148 @@
+// =============================================================================
+// File: src/nn/autograd/GradCheck.cpp
+// =============================================================================
+//
+// Description: Implements finite-difference gradient checks for the Tape.
+//
+// =============================================================================
+
+#include "nn/autograd/GradCheck.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+
+
+namespace
+{
+    float evaluate(const GradCheck::Builder &build, const std::vector<Tensor *> &params)
+    {
+        Tape tape;
+        std::vector<Tape::Var> vars;
+        for(Tensor *p : params) { vars.push_back(tape.parameter(*p)); }
+        return tape.value(build(tape, vars)).getCpuData()[0];
+    }
+
+
+
+    Tensor randomTensor(size_t rows, size_t cols, std::mt19937 &rng, float stddev = 1.0f)
+    {
+        std::normal_distribution<float> dist(0.0f, stddev);
+        Tensor t{{rows, cols}};
+        for(size_t i = 0; i < t.getSize(); i++) { t.getCpuData()[i] = dist(rng); }
+        return t;
+    }
+}
+
+
+
+namespace GradCheck
+{
+    Result check(const std::string &name, const Builder &build, const std::vector<Tensor *> &params,
+                 float epsilon, float tolerance, size_t max_checks_per_param)
+    {
+        Result result;
+        result.name = name;
+
+        Tape tape;
+        std::vector<Tape::Var> vars;
+        for(Tensor *p : params) { vars.push_back(tape.parameter(*p)); }
+        const Tape::Var loss = build(tape, vars);
+        if(tape.value(loss).getSize() != 1)
+        {
+            throw std::invalid_argument("GradCheck: the expression must reduce to a {1, 1} value.");
+        }
+        tape.backward(loss);
+
+        for(size_t p = 0; p < params.size(); p++)
+        {
+            Tensor &param = *params[p];
+            const Tensor &analytic = tape.grad(vars[p]);
+            const size_t stride = std::max<size_t>(1, param.getSize() / max_checks_per_param);
+            for(size_t i = 0; i < param.getSize(); i += stride)
+            {
+                const float original = param.getCpuData()[i];
+                param.getCpuData()[i] = original + epsilon;
+                const float plus = evaluate(build, params);
+                param.getCpuData()[i] = original - epsilon;
+                const float minus = evaluate(build, params);
+                param.getCpuData()[i] = original;
+
+                const float numeric = (plus - minus) / (2.0f * epsilon);
+                const float exact = (analytic.getSize() != 0) ? analytic.getCpuData()[i] : 0.0f;
+                const float abs_error = std::fabs(numeric - exact);
+                const float rel_error = abs_error / std::max({std::fabs(numeric), std::fabs(exact), 1e-2f});
+                result.max_abs_error = std::max(result.max_abs_error, abs_error);
+                result.max_rel_error = std::max(result.max_rel_error, rel_error);
+                result.checked++;
+            }
+        }
+        result.passed = (result.max_rel_error <= tolerance);
+        return result;
+    }
+
+
+
+    std::vector<Result> runBuiltinChecks()
+    {
+        std::mt19937 rng(1234);
+        std::vector<Result> results;
+
+        // Random weights turn every output into a distinct scalar contribution
+        Tensor a = randomTensor(4, 5, rng);
+        Tensor b = randomTensor(5, 3, rng);
+        Tensor c = randomTensor(4, 3, rng);
+        Tensor w43 = randomTensor(4, 3, rng);
+        Tensor bias = randomTensor(1, 3, rng);
+        Tensor target = randomTensor(4, 3, rng);
+        Tensor labels{{4, 1}};
+        for(size_t i = 0; i < 4; i++) { labels.getCpuData()[i] = static_cast<float>(i % 3); }
+
+        auto weighted = [&w43](Tape &t, Tape::Var v) { return t.sum(t.mul(v, t.constant(w43))); };
+
+        results.push_back(check("matmul", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.matmul(p[0], p[1])); }, {&a, &b}));
+        results.push_back(check("add", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.add(p[0], p[1])); }, {&c, &target}));
+        results.push_back(check("add_bias", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.addBias(p[0], p[1])); }, {&c, &bias}));
+        results.push_back(check("mul", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.mul(p[0], p[1])); }, {&c, &target}));
+        results.push_back(check("scale", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.scale(p[0], -0.7f)); }, {&c}));
+        results.push_back(check("relu", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.relu(p[0])); }, {&c}));
+        results.push_back(check("sigmoid", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.sigmoid(p[0])); }, {&c}));
+        results.push_back(check("tanh", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.tanh(p[0])); }, {&c}));
+        results.push_back(check("softmax", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.softmax(p[0])); }, {&c}));
+        results.push_back(check("mean", [&](Tape &t, const std::vector<Tape::Var> &p) { return t.mean(t.mul(p[0], p[0])); }, {&c}));
+        results.push_back(check("mse", [&](Tape &t, const std::vector<Tape::Var> &p) { return t.mse(p[0], target); }, {&c}));
+        results.push_back(check("linear", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.linear(p[0], p[1], p[2])); }, {&a, &b, &bias}));
+        results.push_back(check("linear_relu", [&](Tape &t, const std::vector<Tape::Var> &p) { return weighted(t, t.linearRelu(p[0], p[1], p[2])); }, {&a, &b, &bias}));
+        results.push_back(check("softmax_cross_entropy (indices)",
+                                [&](Tape &t, const std::vector<Tape::Var> &p) { return t.softmaxCrossEntropy(t.linear(p[0], p[1], p[2]), labels); },
+                                {&a, &b, &bias}));
+        results.push_back(check("softmax_cross_entropy (one-hot)",
+                                [&](Tape &t, const std::vector<Tape::Var> &p)
+                                {
+                                    Tensor one_hot{{4, 3}};
+                                    std::fill(one_hot.getCpuData(), one_hot.getCpuData() + one_hot.getSize(), 0.0f);
+                                    for(size_t i = 0; i < 4; i++) { one_hot.getCpuData()[i * 3 + (i % 3)] = 1.0f; }
+                                    return t.softmaxCrossEntropy(p[0], one_hot);
+                                },
+                                {&c}));
+        return results;
+    }
+
+
+
+    std::string formatResult(const Result &result)
+    {
+        std::ostringstream oss;
+        oss << "[GradCheck] " << std::left << std::setw(34) << result.name << std::right
+            << (result.passed ? " PASS" : " FAIL") << "  checked " << result.checked
+            << std::scientific << std::setprecision(2)
+            << "  max abs " << result.max_abs_error << "  max rel " << result.max_rel_error;
+        return oss.str();
+    }
+}
@@ -0,0 +1,49 @@
+// =============================================================================
+// File: src/nn/autograd/GradCheck.h
+// =============================================================================
+//
+// Description: Finite-difference gradient checking for the autograd Tape.
+//              check() compares the analytic gradient of a scalar expression
+//              against central differences on a sample of parameter elements;
+//              runBuiltinChecks() applies it to every built-in and fused op so
+//              new or re-registered ops can be validated from inside the app.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/autograd/Tape.h"
+
+
+
+#include <functional>
+#include <string>
+#include <vector>
+
+
+
+namespace GradCheck
+{
+    struct Result
+    {
+        std::string name;
+        size_t checked = 0;        // parameter elements compared
+        float max_abs_error = 0.0f;
+        float max_rel_error = 0.0f;
+        bool passed = false;
+    };
+
+    // Builds a {1, 1} expression from the tape variables of `params`, in order
+    using Builder = std::function<Tape::Var(Tape &tape, const std::vector<Tape::Var> &params)>;
+
+    [[nodiscard]] Result check(const std::string &name, const Builder &build, const std::vector<Tensor *> &params,
+                               float epsilon = 1e-2f, float tolerance = 2e-2f, size_t max_checks_per_param = 64);
+
+    // One check per built-in and fused op on small random inputs
+    [[nodiscard]] std::vector<Result> runBuiltinChecks();
+
+    [[nodiscard]] std::string formatResult(const Result &result);
+}
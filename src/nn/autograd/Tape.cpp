@@ -0,0 +1,855 @@
+#include "nn/autograd/Tape.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+
+
+namespace
+{
+    Tensor zerosLike(const std::vector<size_t> &shape)
+    {
+        Tensor t{shape};
+        std::fill(t.getCpuData(), t.getCpuData() + t.getSize(), 0.0f);
+        return t;
+    }
+
+
+
+    void requireSameShape(const Tensor &a, const Tensor &b, const char *op)
+    {
+        if(a.getShape() != b.getShape())
+        {
+            throw std::invalid_argument(std::string("Tape: ") + op + " requires operands of the same shape.");
+        }
+    }
+
+
+
+    // c{m,n} = a{m,k} * b{k,n}
+    Tensor matmulForward(const Tensor &a, const Tensor &b)
+    {
+        if(a.getCols() != b.getRows())
+        {
+            throw std::invalid_argument("Tape: matmul inner dimensions do not match.");
+        }
+        Tensor c{{a.getRows(), b.getCols()}};
+        CpuOps::gemm(false, false, a.getRows(), b.getCols(), a.getCols(), 1.0f, a.getCpuData(), a.getCols(), b.getCpuData(), b.getCols(),
+                     0.0f, c.getCpuData(), c.getCols());
+        return c;
+    }
+
+
+
+    // Gradients of c = a * b (+ bias when there is a third input) for the
+    // inputs that need them
+    void linearBackward(const Tape::OpContext &ctx, const float *g, size_t m, std::vector<Tensor> &grads)
+    {
+        const Tensor &x = *ctx.inputs[0];
+        const Tensor &w = *ctx.inputs[1];
+        const size_t k = w.getRows();
+        const size_t n = w.getCols();
+        if(ctx.needs_grad[0])
+        {
+            grads[0] = Tensor{{m, k}};
+            CpuOps::gemm(false, true, m, k, n, 1.0f, g, n, w.getCpuData(), n, 0.0f, grads[0].getCpuData(), k);
+        }
+        if(ctx.needs_grad[1])
+        {
+            grads[1] = Tensor{{k, n}};
+            CpuOps::gemm(true, false, k, n, m, 1.0f, x.getCpuData(), k, g, n, 0.0f, grads[1].getCpuData(), n);
+        }
+        if((grads.size() > 2) && ctx.needs_grad[2])
+        {
+            grads[2] = zerosLike({1, n});
+            float *db = grads[2].getCpuData();
+            for(size_t i = 0; i < m; i++)
+            {
+                for(size_t j = 0; j < n; j++)
+                {
+                    db[j] += g[i * n + j];
+                }
+            }
+        }
+    }
+
+
+
+    Tensor linearForward(const std::vector<const Tensor *> &in, bool relu)
+    {
+        Tensor out = matmulForward(*in[0], *in[1]);
+        const Tensor &b = *in[2];
+        if(b.getSize() != out.getCols())
+        {
+            throw std::invalid_argument("Tape: linear bias width does not match the weights.");
+        }
+        float *y = out.getCpuData();
+        const float *pb = b.getCpuData();
+        const size_t n = out.getCols();
+        for(size_t i = 0; i < out.getRows(); i++)
+        {
+            for(size_t j = 0; j < n; j++)
+            {
+                const float v = y[i * n + j] + pb[j];
+                y[i * n + j] = relu ? std::max(0.0f, v) : v;
+            }
+        }
+        return out;
+    }
+
+
+
+    template <typename F>
+    Tensor mapUnary(const Tensor &x, F f)
+    {
+        Tensor y{x.getShape()};
+        for(size_t i = 0; i < x.getSize(); i++)
+        {
+            y.getCpuData()[i] = f(x.getCpuData()[i]);
+        }
+        return y;
+    }
+
+
+
+    // grad = g * f(y) element-wise, where y is the saved output
+    template <typename F>
+    Tensor fromOutput(const Tensor &g, const Tensor &y, F f)
+    {
+        Tensor dx{g.getShape()};
+        for(size_t i = 0; i < g.getSize(); i++)
+        {
+            dx.getCpuData()[i] = g.getCpuData()[i] * f(y.getCpuData()[i]);
+        }
+        return dx;
+    }
+
+
+
+    Tensor scalar(float v)
+    {
+        Tensor t{{1, 1}};
+        t.getCpuData()[0] = v;
+        return t;
+    }
+
+
+
+    Tensor filled(const std::vector<size_t> &shape, float v)
+    {
+        Tensor t{shape};
+        std::fill(t.getCpuData(), t.getCpuData() + t.getSize(), v);
+        return t;
+    }
+
+
+
+    void registerBuiltins(std::unordered_map<std::string, std::unique_ptr<Tape::OpDef>> &ops)
+    {
+        using Ctx = Tape::OpContext;
+        using In = std::vector<const Tensor *>;
+        auto put = [&ops](Tape::OpDef def) { auto name = def.name; ops[name] = std::make_unique<Tape::OpDef>(std::move(def)); };
+
+        put({"matmul", 2, 0b11, false,
+             [](const In &in, const Tensor &, Tensor &) { return matmulForward(*in[0], *in[1]); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads) { linearBackward(ctx, g.getCpuData(), g.getRows(), grads); }});
+
+        put({"add", 2, 0, false,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 requireSameShape(*in[0], *in[1], "add");
+                 Tensor y{in[0]->getShape()};
+                 for(size_t i = 0; i < y.getSize(); i++) { y.getCpuData()[i] = in[0]->getCpuData()[i] + in[1]->getCpuData()[i]; }
+                 return y;
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 if(ctx.needs_grad[0]) { grads[0] = g; }
+                 if(ctx.needs_grad[1]) { grads[1] = g; }
+             }});
+
+        put({"add_bias", 2, 0, false,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 const Tensor &x = *in[0];
+                 const Tensor &b = *in[1];
+                 if(b.getSize() != x.getCols())
+                 {
+                     throw std::invalid_argument("Tape: add_bias expects a {1, cols} bias.");
+                 }
+                 Tensor y{x.getShape()};
+                 const size_t n = x.getCols();
+                 for(size_t i = 0; i < x.getSize(); i++) { y.getCpuData()[i] = x.getCpuData()[i] + b.getCpuData()[i % n]; }
+                 return y;
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 if(ctx.needs_grad[0]) { grads[0] = g; }
+                 if(ctx.needs_grad[1])
+                 {
+                     const size_t n = g.getCols();
+                     grads[1] = zerosLike({1, n});
+                     for(size_t i = 0; i < g.getSize(); i++) { grads[1].getCpuData()[i % n] += g.getCpuData()[i]; }
+                 }
+             }});
+
+        put({"mul", 2, 0b11, false,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 requireSameShape(*in[0], *in[1], "mul");
+                 Tensor y{in[0]->getShape()};
+                 for(size_t i = 0; i < y.getSize(); i++) { y.getCpuData()[i] = in[0]->getCpuData()[i] * in[1]->getCpuData()[i]; }
+                 return y;
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 for(size_t k = 0; k < 2; k++)
+                 {
+                     if(!ctx.needs_grad[k]) { continue; }
+                     const Tensor &other = *ctx.inputs[1 - k];
+                     grads[k] = Tensor{g.getShape()};
+                     for(size_t i = 0; i < g.getSize(); i++) { grads[k].getCpuData()[i] = g.getCpuData()[i] * other.getCpuData()[i]; }
+                 }
+             }});
+
+        put({"scale", 1, 0, false,
+             [](const In &in, const Tensor &attr, Tensor &)
+             {
+                 const float f = attr.getCpuData()[0];
+                 return mapUnary(*in[0], [f](float v) { return v * f; });
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 const float f = ctx.attr->getCpuData()[0];
+                 grads[0] = mapUnary(g, [f](float v) { return v * f; });
+             }});
+
+        put({"relu", 1, 0, true,
+             [](const In &in, const Tensor &, Tensor &) { return mapUnary(*in[0], [](float v) { return std::max(0.0f, v); }); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 grads[0] = fromOutput(g, *ctx.output, [](float y) { return (y > 0.0f) ? 1.0f : 0.0f; });
+             }});
+
+        put({"sigmoid", 1, 0, true,
+             [](const In &in, const Tensor &, Tensor &) { return mapUnary(*in[0], [](float v) { return 1.0f / (1.0f + std::exp(-v)); }); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 grads[0] = fromOutput(g, *ctx.output, [](float y) { return y * (1.0f - y); });
+             }});
+
+        put({"tanh", 1, 0, true,
+             [](const In &in, const Tensor &, Tensor &) { return mapUnary(*in[0], [](float v) { return std::tanh(v); }); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 grads[0] = fromOutput(g, *ctx.output, [](float y) { return 1.0f - y * y; });
+             }});
+
+        put({"softmax", 1, 0, true,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 const Tensor &x = *in[0];
+                 Tensor y{x.getShape()};
+                 const size_t n = x.getCols();
+                 for(size_t i = 0; i < x.getRows(); i++)
+                 {
+                     const float *xi = x.getCpuData() + i * n;
+                     float *yi = y.getCpuData() + i * n;
+                     const float max_val = *std::max_element(xi, xi + n);
+                     float sum = 0.0f;
+                     for(size_t j = 0; j < n; j++) { yi[j] = std::exp(xi[j] - max_val); sum += yi[j]; }
+                     for(size_t j = 0; j < n; j++) { yi[j] /= sum; }
+                 }
+                 return y;
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 const Tensor &y = *ctx.output;
+                 const size_t n = y.getCols();
+                 grads[0] = Tensor{y.getShape()};
+                 for(size_t i = 0; i < y.getRows(); i++)
+                 {
+                     const float *yi = y.getCpuData() + i * n;
+                     const float *gi = g.getCpuData() + i * n;
+                     float dot = 0.0f;
+                     for(size_t j = 0; j < n; j++) { dot += gi[j] * yi[j]; }
+                     for(size_t j = 0; j < n; j++) { grads[0].getCpuData()[i * n + j] = yi[j] * (gi[j] - dot); }
+                 }
+             }});
+
+        put({"sum", 1, 0, false,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 float s = 0.0f;
+                 for(size_t i = 0; i < in[0]->getSize(); i++) { s += in[0]->getCpuData()[i]; }
+                 return scalar(s);
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads) { grads[0] = filled(ctx.input_shapes[0], g.getCpuData()[0]); }});
+
+        put({"mean", 1, 0, false,
+             [](const In &in, const Tensor &, Tensor &)
+             {
+                 float s = 0.0f;
+                 for(size_t i = 0; i < in[0]->getSize(); i++) { s += in[0]->getCpuData()[i]; }
+                 return scalar(s / static_cast<float>(in[0]->getSize()));
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 const float count = static_cast<float>(ctx.input_shapes[0][0] * ctx.input_shapes[0][1]);
+                 grads[0] = filled(ctx.input_shapes[0], g.getCpuData()[0] / count);
+             }});
+
+        // Same definition as MeanSquaredError
+        put({"mse", 1, 0b1, false,
+             [](const In &in, const Tensor &target, Tensor &)
+             {
+                 requireSameShape(*in[0], target, "mse");
+                 float s = 0.0f;
+                 for(size_t i = 0; i < target.getSize(); i++)
+                 {
+                     const float d = in[0]->getCpuData()[i] - target.getCpuData()[i];
+                     s += d * d;
+                 }
+                 return scalar(s / static_cast<float>(target.getSize()));
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 const Tensor &p = *ctx.inputs[0];
+                 const Tensor &t = *ctx.attr;
+                 const float f = 2.0f * g.getCpuData()[0] / static_cast<float>(t.getSize());
+                 grads[0] = Tensor{p.getShape()};
+                 for(size_t i = 0; i < p.getSize(); i++) { grads[0].getCpuData()[i] = f * (p.getCpuData()[i] - t.getCpuData()[i]); }
+             }});
+
+        // --- Fused ops ---
+
+        put({"linear", 3, 0b011, false,
+             [](const In &in, const Tensor &, Tensor &) { return linearForward(in, false); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads) { linearBackward(ctx, g.getCpuData(), g.getRows(), grads); }});
+
+        put({"linear_relu", 3, 0b011, true,
+             [](const In &in, const Tensor &, Tensor &) { return linearForward(in, true); },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 Tensor dz = fromOutput(g, *ctx.output, [](float y) { return (y > 0.0f) ? 1.0f : 0.0f; });
+                 linearBackward(ctx, dz.getCpuData(), dz.getRows(), grads);
+             }});
+
+        // Forward computes the loss and stashes d(loss)/d(logits) = (p - y) / N,
+        // so neither the probabilities nor the logits are kept.
+        put({"softmax_cross_entropy", 1, 0, false,
+             [](const In &in, const Tensor &targets, Tensor &stash)
+             {
+                 const Tensor &x = *in[0];
+                 const size_t rows = x.getRows();
+                 const size_t n = x.getCols();
+                 const bool one_hot = (targets.getShape() == x.getShape());
+                 if((!one_hot) && ((targets.getCols() != 1) || (targets.getRows() != rows)))
+                 {
+                     throw std::invalid_argument("Incompatible shapes for cross entropy loss.");
+                 }
+                 stash = Tensor{x.getShape()};
+                 const float inv_rows = 1.0f / static_cast<float>(rows);
+                 float loss = 0.0f;
+                 for(size_t i = 0; i < rows; i++)
+                 {
+                     const float *xi = x.getCpuData() + i * n;
+                     float *pi = stash.getCpuData() + i * n;
+                     const float max_val = *std::max_element(xi, xi + n);
+                     float sum = 0.0f;
+                     for(size_t j = 0; j < n; j++) { pi[j] = std::exp(xi[j] - max_val); sum += pi[j]; }
+                     const float log_sum = std::log(sum);
+                     for(size_t j = 0; j < n; j++)
+                     {
+                         const float t = one_hot ? targets.getCpuData()[i * n + j]
+                                                 : ((static_cast<size_t>(targets.getCpuData()[i]) == j) ? 1.0f : 0.0f);
+                         if(t > 0.0f) { loss -= t * (xi[j] - max_val - log_sum); }
+                         pi[j] = (pi[j] / sum - t) * inv_rows;
+                     }
+                 }
+                 return scalar(loss * inv_rows);
+             },
+             [](const Ctx &ctx, const Tensor &g, std::vector<Tensor> &grads)
+             {
+                 const float f = g.getCpuData()[0];
+                 grads[0] = mapUnary(*ctx.stash, [f](float v) { return v * f; });
+             }});
+    }
+
+
+
+    std::mutex &registryMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+
+
+    std::unordered_map<std::string, std::unique_ptr<Tape::OpDef>> &registry()
+    {
+        static std::unordered_map<std::string, std::unique_ptr<Tape::OpDef>> ops = []
+        {
+            std::unordered_map<std::string, std::unique_ptr<Tape::OpDef>> init;
+            registerBuiltins(init);
+            return init;
+        }();
+        return ops;
+    }
+}
+
+
+
+// --- Registry ---
+
+void Tape::registerOp(OpDef op)
+{
+    if(op.name.empty() || (!op.forward) || (!op.backward) || (op.arity == 0) || (op.arity > 32))
+    {
+        throw std::invalid_argument("Tape::registerOp requires a name, 1-32 inputs and forward/backward rules.");
+    }
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto &ops = registry();
+    auto it = ops.find(op.name);
+    if(it != ops.end())
+    {
+        // Replace in place so pointers held by recorded nodes stay valid
+        *it->second = std::move(op);
+    }
+    else
+    {
+        auto name = op.name;
+        ops[name] = std::make_unique<OpDef>(std::move(op));
+    }
+}
+
+
+
+const Tape::OpDef &Tape::findOp(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto &ops = registry();
+    auto it = ops.find(name);
+    if(it == ops.end())
+    {
+        throw std::out_of_range("Tape: no op registered under '" + name + "'.");
+    }
+    return *it->second;
+}
+
+
+
+// --- Leaves ---
+
+Tape::Var Tape::leaf(const Tensor *external, Tensor *parameter, bool requires_grad)
+{
+    Node node;
+    node.external = external;
+    node.parameter = parameter;
+    node.shape = external->getShape();
+    node.requires_grad = requires_grad;
+    nodes.push_back(std::move(node));
+    return Var{nodes.size() - 1};
+}
+
+
+
+Tape::Var Tape::constant(const Tensor &value)
+{
+    return leaf(&value, nullptr, false);
+}
+
+
+
+Tape::Var Tape::input(const Tensor &value, bool requires_grad)
+{
+    return leaf(&value, nullptr, requires_grad);
+}
+
+
+
+Tape::Var Tape::parameter(Tensor &value)
+{
+    return leaf(&value, &value, true);
+}
+
+
+
+// --- Ops ---
+
+Tape::Var Tape::matmul(Var a, Var b)
+{
+    static const OpDef &op = findOp("matmul");
+    return apply(op, {a, b});
+}
+
+
+
+Tape::Var Tape::add(Var a, Var b)
+{
+    static const OpDef &op = findOp("add");
+    return apply(op, {a, b});
+}
+
+
+
+Tape::Var Tape::addBias(Var x, Var bias)
+{
+    static const OpDef &op = findOp("add_bias");
+    return apply(op, {x, bias});
+}
+
+
+
+Tape::Var Tape::mul(Var a, Var b)
+{
+    static const OpDef &op = findOp("mul");
+    return apply(op, {a, b});
+}
+
+
+
+Tape::Var Tape::scale(Var x, float factor)
+{
+    static const OpDef &op = findOp("scale");
+    const Tensor attr = scalar(factor);
+    return apply(op, {x}, &attr);
+}
+
+
+
+Tape::Var Tape::relu(Var x)
+{
+    static const OpDef &op = findOp("relu");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::sigmoid(Var x)
+{
+    static const OpDef &op = findOp("sigmoid");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::tanh(Var x)
+{
+    static const OpDef &op = findOp("tanh");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::softmax(Var x)
+{
+    static const OpDef &op = findOp("softmax");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::sum(Var x)
+{
+    static const OpDef &op = findOp("sum");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::mean(Var x)
+{
+    static const OpDef &op = findOp("mean");
+    return apply(op, {x});
+}
+
+
+
+Tape::Var Tape::mse(Var prediction, const Tensor &target)
+{
+    static const OpDef &op = findOp("mse");
+    return apply(op, {prediction}, &target);
+}
+
+
+
+Tape::Var Tape::linear(Var x, Var weights, Var bias)
+{
+    static const OpDef &op = findOp("linear");
+    return apply(op, {x, weights, bias});
+}
+
+
+
+Tape::Var Tape::linearRelu(Var x, Var weights, Var bias)
+{
+    static const OpDef &op = findOp("linear_relu");
+    return apply(op, {x, weights, bias});
+}
+
+
+
+Tape::Var Tape::softmaxCrossEntropy(Var logits, const Tensor &targets)
+{
+    static const OpDef &op = findOp("softmax_cross_entropy");
+    return apply(op, {logits}, &targets);
+}
+
+
+
+Tape::Var Tape::apply(const std::string &name, const std::vector<Var> &inputs, const Tensor *attr)
+{
+    return apply(findOp(name), inputs, attr);
+}
+
+
+
+Tape::Var Tape::apply(const OpDef &op, const std::vector<Var> &inputs, const Tensor *attr)
+{
+    if(inputs.size() != op.arity)
+    {
+        throw std::invalid_argument("Tape: op '" + op.name + "' expects " + std::to_string(op.arity) + " inputs.");
+    }
+    std::vector<const Tensor *> values;
+    values.reserve(inputs.size());
+    bool requires_grad = false;
+    for(const Var &v : inputs)
+    {
+        values.push_back(&valueOf(v.id));
+        requires_grad = requires_grad || nodes[v.id].requires_grad;
+    }
+
+    Node node;
+    node.op = &op;
+    if(attr) { node.attr = *attr; }
+    node.value = op.forward(values, node.attr, node.stash);
+    node.shape = node.value.getShape();
+    node.requires_grad = requires_grad;
+    for(const Var &v : inputs) { node.inputs.push_back(v.id); }
+
+    // Nothing will run backward through this node, so it saves nothing
+    if(requires_grad)
+    {
+        for(size_t i = 0; i < inputs.size(); i++)
+        {
+            if(op.saved_inputs & (1u << i)) { nodes[inputs[i].id].saved_uses++; }
+        }
+        if(op.saves_output) { node.saved_uses++; }
+    }
+    else
+    {
+        node.stash = Tensor{};
+    }
+
+    track(node.value);
+    track(node.stash);
+    nodes.push_back(std::move(node));
+    stats.ops++;
+    return Var{nodes.size() - 1};
+}
+
+
+
+// --- Backward ---
+
+void Tape::backward(Var root)
+{
+    if(valueOf(root.id).getSize() != 1)
+    {
+        throw std::invalid_argument("Tape::backward without a seed needs a {1, 1} root.");
+    }
+    backward(root, scalar(1.0f));
+}
+
+
+
+void Tape::backward(Var root, const Tensor &grad_root)
+{
+    if(root.id >= nodes.size())
+    {
+        throw std::out_of_range("Tape: variable does not belong to this tape.");
+    }
+    if(grad_root.getShape() != nodes[root.id].shape)
+    {
+        throw std::invalid_argument("Tape: backward seed must match the root's shape.");
+    }
+    if(!nodes[root.id].requires_grad)
+    {
+        return;
+    }
+
+    // Intermediates no backward rule reads are dead from here on
+    for(size_t id = 0; id < root.id; id++)
+    {
+        Node &node = nodes[id];
+        if(node.op && (node.saved_uses == 0) && (node.value.getSize() != 0))
+        {
+            release(node.value);
+            stats.freed_early++;
+        }
+    }
+
+    nodes[root.id].grad = grad_root;
+    track(nodes[root.id].grad);
+
+    for(size_t id = root.id + 1; id-- > 0;)
+    {
+        Node &node = nodes[id];
+        if(!node.op) { continue; }
+
+        const OpDef &op = *node.op;
+        auto drop_saved = [&]()
+        {
+            for(size_t i = 0; i < node.inputs.size(); i++)
+            {
+                if(!(op.saved_inputs & (1u << i))) { continue; }
+                Node &in = nodes[node.inputs[i]];
+                if((in.saved_uses > 0) && (--in.saved_uses == 0) && in.op && (node.inputs[i] != root.id))
+                {
+                    release(in.value);
+                    stats.freed_early++;
+                }
+            }
+            if(op.saves_output && (node.saved_uses > 0) && (--node.saved_uses == 0) && (id != root.id))
+            {
+                release(node.value);
+                stats.freed_early++;
+            }
+            release(node.stash);
+        };
+
+        if((!node.requires_grad) || (node.grad.getSize() == 0))
+        {
+            if(node.requires_grad) { drop_saved(); }
+            continue;
+        }
+
+        OpContext ctx;
+        for(size_t i = 0; i < node.inputs.size(); i++)
+        {
+            const Node &in = nodes[node.inputs[i]];
+            ctx.inputs.push_back((op.saved_inputs & (1u << i)) ? &valueOf(node.inputs[i]) : nullptr);
+            ctx.input_shapes.push_back(in.shape);
+            ctx.needs_grad.push_back(in.requires_grad);
+        }
+        ctx.output = op.saves_output ? &node.value : nullptr;
+        ctx.attr = (node.attr.getSize() != 0) ? &node.attr : nullptr;
+        ctx.stash = (node.stash.getSize() != 0) ? &node.stash : nullptr;
+
+        std::vector<Tensor> grad_inputs(node.inputs.size());
+        op.backward(ctx, node.grad, grad_inputs);
+
+        for(size_t i = 0; i < node.inputs.size(); i++)
+        {
+            Tensor &g = grad_inputs[i];
+            Node &in = nodes[node.inputs[i]];
+            if((g.getSize() == 0) || (!in.requires_grad)) { continue; }
+            if(g.getShape() != in.shape)
+            {
+                throw std::runtime_error("Tape: op '" + op.name + "' produced a gradient of the wrong shape.");
+            }
+            if(in.grad.getSize() == 0)
+            {
+                in.grad = std::move(g);
+                track(in.grad);
+            }
+            else
+            {
+                float *dst = in.grad.getCpuData();
+                const float *src = g.getCpuData();
+                for(size_t k = 0; k < g.getSize(); k++) { dst[k] += src[k]; }
+            }
+        }
+
+        release(node.grad);
+        drop_saved();
+    }
+}
+
+
+
+// --- Accessors ---
+
+const Tensor &Tape::valueOf(size_t id) const
+{
+    if(id >= nodes.size())
+    {
+        throw std::out_of_range("Tape: variable does not belong to this tape.");
+    }
+    const Node &node = nodes[id];
+    if(node.external) { return *node.external; }
+    if((node.value.getSize() == 0) && (!node.shape.empty()))
+    {
+        throw std::runtime_error("Tape: value was released after its last backward use.");
+    }
+    return node.value;
+}
+
+
+
+const Tensor &Tape::value(Var v) const
+{
+    return valueOf(v.id);
+}
+
+
+
+const Tensor &Tape::grad(Var v) const
+{
+    if(v.id >= nodes.size())
+    {
+        throw std::out_of_range("Tape: variable does not belong to this tape.");
+    }
+    return nodes[v.id].grad;
+}
+
+
+
+void Tape::step(Optimizer &optimizer)
+{
+    for(auto &node : nodes)
+    {
+        if(node.parameter && (node.grad.getSize() != 0))
+        {
+            optimizer.update(*node.parameter, node.grad);
+        }
+    }
+}
+
+
+
+void Tape::clear()
+{
+    nodes.clear();
+    stats.ops = 0;
+    stats.freed_early = 0;
+    stats.live_floats = 0;
+}
+
+
+
+void Tape::release(Tensor &t)
+{
+    if(t.getSize() == 0) { return; }
+    stats.live_floats -= std::min(stats.live_floats, t.getSize());
+    t = Tensor{};
+}
+
+
+
+void Tape::track(const Tensor &t)
+{
+    stats.live_floats += t.getSize();
+    stats.peak_live_floats = std::max(stats.peak_live_floats, stats.live_floats);
+}
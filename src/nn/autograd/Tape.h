@@ -0,0 +1,155 @@
+// =============================================================================
+// File: src/nn/autograd/Tape.h
+// =============================================================================
+//
+// Description: Declares Tape, a reverse-mode automatic differentiation engine
+//              over 2D Tensors. Operations are executed eagerly and recorded
+//              in order; backward() replays them in reverse. Each op declares
+//              which of its inputs (and whether its output) the backward rule
+//              reads, so every other intermediate is released when backward
+//              starts and saved tensors are released as soon as their last
+//              backward consumer has run. Ops live in a global registry; hot
+//              patterns (linear, linear+ReLU, softmax+cross-entropy) are
+//              registered as single fused ops, and callers can register their
+//              own with Tape::registerOp.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+
+class Tape
+{
+public:
+    // Handle to a value recorded on a tape
+    struct Var
+    {
+        size_t id = 0;
+    };
+
+    // What a backward rule can see. Inputs that the op did not ask to save
+    // (and the output, unless saved) are null by the time backward runs.
+    struct OpContext
+    {
+        std::vector<const Tensor *> inputs;
+        std::vector<std::vector<size_t>> input_shapes;
+        std::vector<bool> needs_grad;
+        const Tensor *output = nullptr;
+        const Tensor *attr = nullptr;  // constant operand, e.g. loss targets
+        const Tensor *stash = nullptr; // extra tensor the forward chose to keep
+    };
+
+    using ForwardFn = std::function<Tensor(const std::vector<const Tensor *> &inputs, const Tensor &attr, Tensor &stash)>;
+    // Fill grad_inputs[i] for each input with needs_grad[i]; entries left
+    // empty are treated as zero.
+    using BackwardFn = std::function<void(const OpContext &ctx, const Tensor &grad_output, std::vector<Tensor> &grad_inputs)>;
+
+    struct OpDef
+    {
+        std::string name;
+        size_t arity = 1;
+        std::uint32_t saved_inputs = 0; // bit i set: backward reads input i
+        bool saves_output = false;
+        ForwardFn forward;
+        BackwardFn backward;
+    };
+
+    struct Stats
+    {
+        size_t ops = 0;
+        size_t freed_early = 0;       // tensors released before the end of backward
+        size_t live_floats = 0;       // values, stashes and gradients currently held
+        size_t peak_live_floats = 0;
+    };
+
+    // Registers or replaces an op; the built-in and fused ops are registered
+    // on first use of the registry.
+    static void registerOp(OpDef op);
+    [[nodiscard]] static const OpDef &findOp(const std::string &name);
+
+    // --- Leaves ---
+
+    // External tensors are referenced, not copied, and must outlive the tape.
+    [[nodiscard]] Var constant(const Tensor &value);
+    [[nodiscard]] Var input(const Tensor &value, bool requires_grad = true);
+    [[nodiscard]] Var parameter(Tensor &value);
+
+    // --- Built-in ops ---
+
+    [[nodiscard]] Var matmul(Var a, Var b);
+    [[nodiscard]] Var add(Var a, Var b);
+    [[nodiscard]] Var addBias(Var x, Var bias); // bias {1, cols} broadcast over rows
+    [[nodiscard]] Var mul(Var a, Var b);
+    [[nodiscard]] Var scale(Var x, float factor);
+    [[nodiscard]] Var relu(Var x);
+    [[nodiscard]] Var sigmoid(Var x);
+    [[nodiscard]] Var tanh(Var x);
+    [[nodiscard]] Var softmax(Var x);
+    [[nodiscard]] Var sum(Var x);  // {1, 1}
+    [[nodiscard]] Var mean(Var x); // {1, 1}
+    [[nodiscard]] Var mse(Var prediction, const Tensor &target);
+
+    // --- Fused ops ---
+
+    [[nodiscard]] Var linear(Var x, Var weights, Var bias);
+    [[nodiscard]] Var linearRelu(Var x, Var weights, Var bias);
+    // Mean cross-entropy of softmax(logits); targets are one-hot or class indices
+    [[nodiscard]] Var softmaxCrossEntropy(Var logits, const Tensor &targets);
+
+    // Records a registered op by name
+    [[nodiscard]] Var apply(const std::string &name, const std::vector<Var> &inputs, const Tensor *attr = nullptr);
+    [[nodiscard]] Var apply(const OpDef &op, const std::vector<Var> &inputs, const Tensor *attr = nullptr);
+
+    // Reverse pass from a {1, 1} value, or from any value with an explicit seed
+    void backward(Var root);
+    void backward(Var root, const Tensor &grad_root);
+
+    [[nodiscard]] const Tensor &value(Var v) const;
+    [[nodiscard]] const Tensor &grad(Var v) const; // empty when no gradient reached v
+
+    // Applies the optimizer to every parameter that received a gradient
+    void step(Optimizer &optimizer);
+
+    // Drops all records; buffers of the record vector are kept for reuse
+    void clear();
+
+    [[nodiscard]] size_t size() const noexcept { return nodes.size(); }
+    [[nodiscard]] const Stats &getStats() const noexcept { return stats; }
+
+private:
+    struct Node
+    {
+        const OpDef *op = nullptr;   // null for leaves
+        std::vector<size_t> inputs;
+        std::vector<size_t> shape;
+        Tensor value;
+        Tensor stash;
+        Tensor attr;
+        Tensor grad;
+        const Tensor *external = nullptr;
+        Tensor *parameter = nullptr;
+        bool requires_grad = false;
+        size_t saved_uses = 0;       // backward rules that still need this value
+    };
+
+    [[nodiscard]] Var leaf(const Tensor *external, Tensor *parameter, bool requires_grad);
+    [[nodiscard]] const Tensor &valueOf(size_t id) const;
+    void release(Tensor &t);
+    void track(const Tensor &t);
+
+    std::vector<Node> nodes;
+    Stats stats;
+};
@@ -0,0 +1,795 @@
+#include "nn/graph/ExecutionPlan.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+#include "nn/Loss.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Normalization.h"
+#include "nn/layers/Softmax.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace
+{
+    void ensureShape(Tensor &t, size_t rows, size_t cols)
+    {
+        if((t.getRows() != rows) || (t.getCols() != cols) || (t.getShape().size() != 2))
+        {
+            t = Tensor{{rows, cols}};
+        }
+    }
+
+
+
+    // y[r] = x[r] * W for each row, streaming W once per row without packing
+    void gemv(const float *x, const float *w, float *y, size_t rows, size_t in, size_t out)
+    {
+        for(size_t r = 0; r < rows; r++)
+        {
+            float *yr = y + r * out;
+            std::fill(yr, yr + out, 0.0f);
+            for(size_t p = 0; p < in; p++)
+            {
+                const float xp = x[r * in + p];
+                if(xp == 0.0f) { continue; }
+                const float *wp = w + p * out;
+                for(size_t j = 0; j < out; j++)
+                {
+                    yr[j] += xp * wp[j];
+                }
+            }
+        }
+    }
+
+
+
+    void biasEpilogue(float *y, const float *b, size_t rows, size_t cols)
+    {
+        for(size_t i = 0; i < rows; i++)
+        {
+            float *yi = y + i * cols;
+            for(size_t j = 0; j < cols; j++)
+            {
+                yi[j] += b[j];
+            }
+        }
+    }
+
+
+
+    void biasActivationEpilogue(float *y, const float *b, size_t rows, size_t cols, ActivationType act)
+    {
+        for(size_t i = 0; i < rows; i++)
+        {
+            float *yi = y + i * cols;
+            if(act == ActivationType::ReLU)
+            {
+                for(size_t j = 0; j < cols; j++)
+                {
+                    yi[j] = std::max(0.0f, yi[j] + b[j]);
+                }
+            }
+            else
+            {
+                for(size_t j = 0; j < cols; j++)
+                {
+                    yi[j] = 1.0f / (1.0f + std::exp(-(yi[j] + b[j])));
+                }
+            }
+        }
+    }
+
+
+
+    void applyActivation(const float *x, float *y, size_t count, ActivationType act)
+    {
+        if(act == ActivationType::ReLU)
+        {
+            for(size_t i = 0; i < count; i++) { y[i] = std::max(0.0f, x[i]); }
+        }
+        else
+        {
+            for(size_t i = 0; i < count; i++) { y[i] = 1.0f / (1.0f + std::exp(-x[i])); }
+        }
+    }
+
+
+
+    // dx = dy * f'(x), written in terms of the saved output y = f(x)
+    void activationGrad(const float *dy, const float *y, float *dx, size_t count, ActivationType act, bool accumulate)
+    {
+        if(act == ActivationType::ReLU)
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                const float g = (y[i] > 0.0f) ? dy[i] : 0.0f;
+                dx[i] = accumulate ? dx[i] + g : g;
+            }
+        }
+        else
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                const float g = dy[i] * y[i] * (1.0f - y[i]);
+                dx[i] = accumulate ? dx[i] + g : g;
+            }
+        }
+    }
+
+
+
+    void softmaxRows(const float *x, float *y, size_t rows, size_t cols)
+    {
+        for(size_t i = 0; i < rows; i++)
+        {
+            const float *xi = x + i * cols;
+            float *yi = y + i * cols;
+            const float max_val = *std::max_element(xi, xi + cols);
+            float sum = 0.0f;
+            for(size_t j = 0; j < cols; j++)
+            {
+                yi[j] = std::exp(xi[j] - max_val);
+                sum += yi[j];
+            }
+            const float inv = 1.0f / sum;
+            for(size_t j = 0; j < cols; j++)
+            {
+                yi[j] *= inv;
+            }
+        }
+    }
+
+
+
+    const char *opName(ExecutionPlan::OpCode op)
+    {
+        switch(op)
+        {
+            case ExecutionPlan::OpCode::Dense: return "Dense";
+            case ExecutionPlan::OpCode::DenseActivation: return "DenseActivation";
+            case ExecutionPlan::OpCode::Activation: return "Activation";
+            case ExecutionPlan::OpCode::Softmax: return "Softmax";
+            case ExecutionPlan::OpCode::SoftmaxCrossEntropy: return "SoftmaxCrossEntropy";
+            case ExecutionPlan::OpCode::Add: return "Add";
+            case ExecutionPlan::OpCode::Layer: return "Layer";
+        }
+        return "?";
+    }
+}
+
+
+
+// --- GraphCompiler ---
+
+ExecutionPlan GraphCompiler::compile(Graph &graph, const CompileOptions &options)
+{
+    using NodeKind = Graph::NodeKind;
+    using OpCode = ExecutionPlan::OpCode;
+    const auto &nodes = graph.getNodes();
+    const Graph::NodeId output = graph.getOutput();
+    if(nodes.empty() || (nodes[graph.getInput()].kind != NodeKind::Input) || (output >= nodes.size()))
+    {
+        throw std::invalid_argument("GraphCompiler requires a graph with an input and an output node.");
+    }
+
+    ExecutionPlan plan{graph, options};
+    plan.stats.graph_nodes = nodes.size();
+
+    // Pass 1: dead-node elimination. Only nodes that reach the output survive.
+    std::vector<bool> live(nodes.size(), false);
+    live[output] = true;
+    for(Graph::NodeId id = output + 1; id-- > 0;)
+    {
+        if(!live[id]) { continue; }
+        for(Graph::NodeId in : nodes[id].inputs) { live[in] = true; }
+    }
+
+    // Layers that are pass-through at inference time (Dropout) are aliased to
+    // their input instead of getting a step. Inference plans also fold each
+    // BatchNorm1d fed by a Dense that nothing else reads: the Dense step runs
+    // a plan-owned copy with the running statistics baked in and the
+    // normalization node aliases it.
+    std::vector<size_t> readers(nodes.size(), 0);
+    for(Graph::NodeId id = 0; id < nodes.size(); id++)
+    {
+        if(!live[id]) { continue; }
+        for(Graph::NodeId in : nodes[id].inputs) { readers[in]++; }
+    }
+    std::vector<Dense *> lowered_dense(nodes.size(), nullptr);
+    std::vector<Graph::NodeId> repr(nodes.size());
+    for(Graph::NodeId id = 0; id < nodes.size(); id++)
+    {
+        repr[id] = id;
+        if((!live[id]) || (nodes[id].kind != NodeKind::Layer) || options.training) { continue; }
+        if(nodes[id].layer->isIdentity())
+        {
+            repr[id] = repr[nodes[id].inputs[0]];
+            continue;
+        }
+        auto *bn = dynamic_cast<BatchNorm1d *>(nodes[id].layer.get());
+        const Graph::NodeId in = nodes[id].inputs[0];
+        auto *dense = bn ? dynamic_cast<Dense *>(nodes[in].layer.get()) : nullptr;
+        if(dense && (readers[in] == 1) && (dense->weights.getCols() == bn->getNumFeatures()))
+        {
+            auto folded = std::make_unique<Dense>(*dense);
+            bn->foldInto(*folded);
+            lowered_dense[in] = folded.get();
+            plan.folded_layers.push_back(std::move(folded));
+            repr[id] = in;
+            plan.stats.folded_batch_norm++;
+        }
+    }
+    auto loweredDense = [&](Graph::NodeId id)
+    {
+        return lowered_dense[id] ? lowered_dense[id] : static_cast<Dense *>(nodes[id].layer.get());
+    };
+    const Graph::NodeId out_value = repr[output];
+
+    std::vector<size_t> consumers(nodes.size(), 0);
+    std::vector<Graph::NodeId> sole_consumer(nodes.size(), 0);
+    for(Graph::NodeId id = 0; id < nodes.size(); id++)
+    {
+        if((!live[id]) || (repr[id] != id)) { continue; }
+        for(Graph::NodeId in : nodes[id].inputs)
+        {
+            consumers[repr[in]]++;
+            sole_consumer[repr[in]] = id;
+        }
+    }
+
+    // Pass 2: operator fusion
+    std::vector<bool> fused_away(nodes.size(), false);
+    std::vector<Graph::NodeId> fused_dense(nodes.size(), 0);
+    if(options.fuse)
+    {
+        for(Graph::NodeId id = 0; id < nodes.size(); id++)
+        {
+            if((!live[id]) || (repr[id] != id) || (id == out_value) || (consumers[id] != 1)) { continue; }
+            if(!dynamic_cast<Dense *>(nodes[id].layer.get())) { continue; }
+            const Graph::NodeId next = sole_consumer[id];
+            if(dynamic_cast<Activation *>(nodes[next].layer.get()))
+            {
+                fused_away[id] = true;
+                fused_dense[next] = id;
+                plan.stats.fused_dense_activation++;
+            }
+        }
+    }
+    const bool fuse_softmax_ce = options.fuse && options.training && (dynamic_cast<CrossEntropyLoss *>(graph.getLoss()) != nullptr);
+
+    // Pass 3: lowering to steps
+    for(Graph::NodeId id = 0; id < nodes.size(); id++)
+    {
+        if(!live[id])
+        {
+            plan.stats.eliminated_nodes++;
+            continue;
+        }
+        if(repr[id] != id)
+        {
+            plan.stats.eliminated_nodes++;
+            continue;
+        }
+        const auto &node = nodes[id];
+        if((node.kind == NodeKind::Input) || fused_away[id]) { continue; }
+
+        ExecutionPlan::Step step;
+        step.node = id;
+        step.width = node.width;
+        if(node.kind == NodeKind::Add)
+        {
+            step.op = OpCode::Add;
+            step.input_node[0] = repr[node.inputs[0]];
+            step.input_node[1] = repr[node.inputs[1]];
+        }
+        else if(auto *act = dynamic_cast<Activation *>(node.layer.get()))
+        {
+            step.activation = act->getType();
+            const Graph::NodeId in = repr[node.inputs[0]];
+            if(fused_away[in])
+            {
+                step.op = OpCode::DenseActivation;
+                step.dense = loweredDense(fused_dense[id]);
+                step.input_node[0] = repr[nodes[in].inputs[0]];
+            }
+            else
+            {
+                step.op = OpCode::Activation;
+                step.input_node[0] = in;
+            }
+        }
+        else if(dynamic_cast<Dense *>(node.layer.get()))
+        {
+            step.op = OpCode::Dense;
+            step.dense = loweredDense(id);
+            step.input_node[0] = repr[node.inputs[0]];
+        }
+        else if(dynamic_cast<Softmax *>(node.layer.get()))
+        {
+            step.op = (fuse_softmax_ce && (id == out_value)) ? OpCode::SoftmaxCrossEntropy : OpCode::Softmax;
+            step.input_node[0] = repr[node.inputs[0]];
+            if(step.op == OpCode::SoftmaxCrossEntropy) { plan.stats.fused_softmax_cross_entropy++; }
+        }
+        else
+        {
+            step.op = OpCode::Layer;
+            step.layer = node.layer.get();
+            step.input_node[0] = repr[node.inputs[0]];
+            plan.stats.opaque_steps++;
+        }
+
+        // Pass 4: kernel selection from the expected shape
+        if(step.dense)
+        {
+            step.kernel = (options.batch_size == 1) ? ExecutionPlan::Kernel::Gemv : ExecutionPlan::Kernel::Gemm;
+            step.param_index = plan.grad_weights.size();
+            if(options.training)
+            {
+                plan.grad_weights.emplace_back(step.dense->weights.getShape());
+                plan.grad_biases.emplace_back(step.dense->biases.getShape());
+            }
+            else
+            {
+                plan.grad_weights.emplace_back();
+                plan.grad_biases.emplace_back();
+            }
+        }
+        plan.steps.push_back(step);
+    }
+    if(plan.steps.empty())
+    {
+        throw std::invalid_argument("GraphCompiler: the output does not depend on any layer.");
+    }
+
+    // Pass 5: memory planning. A value's buffer is released after its last
+    // reader unless backward needs it; the output of a step is allocated
+    // before its inputs are released so no kernel runs in place.
+    const size_t end = plan.steps.size();
+    std::vector<size_t> last_use(nodes.size(), 0);
+    for(size_t i = 0; i < plan.steps.size(); i++)
+    {
+        const auto &step = plan.steps[i];
+        const size_t arity = (step.op == OpCode::Add) ? 2 : 1;
+        for(size_t a = 0; a < arity; a++)
+        {
+            last_use[step.input_node[a]] = std::max(last_use[step.input_node[a]], i);
+        }
+        if(options.training)
+        {
+            // Dense needs its input for dW; activations and softmax read their output
+            if(step.dense) { last_use[step.input_node[0]] = end; }
+            if((step.op != OpCode::Dense) && (step.op != OpCode::Add) && (step.op != OpCode::Layer)) { last_use[step.node] = end; }
+        }
+    }
+    last_use[out_value] = end;
+
+    std::vector<size_t> slot_of(nodes.size(), 0);
+    std::vector<size_t> slot_width{0}; // slot 0 is the caller's input
+    std::vector<size_t> free_slots;
+    plan.input_slot = 0;
+    slot_of[graph.getInput()] = 0;
+    for(size_t i = 0; i < plan.steps.size(); i++)
+    {
+        auto &step = plan.steps[i];
+        size_t slot = 0;
+        auto reuse = std::find_if(free_slots.begin(), free_slots.end(),
+                                  [&](size_t s) { return (step.width != 0) && (slot_width[s] == step.width); });
+        if(reuse != free_slots.end())
+        {
+            slot = *reuse;
+            free_slots.erase(reuse);
+        }
+        else
+        {
+            slot = slot_width.size();
+            slot_width.push_back(step.width);
+        }
+        slot_of[step.node] = slot;
+        step.out_slot = slot;
+        const size_t arity = (step.op == OpCode::Add) ? 2 : 1;
+        for(size_t a = 0; a < arity; a++)
+        {
+            step.in_slot[a] = slot_of[step.input_node[a]];
+        }
+        for(size_t a = 0; a < arity; a++)
+        {
+            const Graph::NodeId in = step.input_node[a];
+            if((last_use[in] == i) && (slot_of[in] != plan.input_slot) &&
+               (std::find(free_slots.begin(), free_slots.end(), slot_of[in]) == free_slots.end()))
+            {
+                free_slots.push_back(slot_of[in]);
+            }
+        }
+        plan.stats.naive_floats += options.batch_size * step.width;
+    }
+    plan.output_slot = slot_of[out_value];
+
+    plan.slots.resize(slot_width.size());
+    for(size_t s = 1; s < slot_width.size(); s++)
+    {
+        if(slot_width[s] != 0)
+        {
+            plan.slots[s] = Tensor{{options.batch_size, slot_width[s]}};
+            plan.stats.planned_floats += options.batch_size * slot_width[s];
+        }
+    }
+    plan.grads.resize(nodes.size());
+    plan.grad_set.assign(nodes.size(), false);
+
+    plan.stats.steps = plan.steps.size();
+    plan.stats.values = plan.steps.size();
+    plan.stats.slots = slot_width.size() - 1;
+    return plan;
+}
+
+
+
+// --- ExecutionPlan ---
+
+ExecutionPlan::ExecutionPlan(Graph &graph, const CompileOptions &options) : graph{&graph}, options{options}
+{
+}
+
+
+
+void ExecutionPlan::forwardPass()
+{
+    for(const Step &step : steps)
+    {
+        switch(step.op)
+        {
+            case OpCode::Dense:
+            case OpCode::DenseActivation:
+            {
+                const Tensor &x = value(step.in_slot[0]);
+                const Tensor &w = step.dense->weights;
+                const size_t rows = x.getRows();
+                const size_t in = w.getRows();
+                const size_t out = w.getCols();
+                if(x.getCols() != in)
+                {
+                    throw std::invalid_argument("ExecutionPlan: Dense input width does not match its weights.");
+                }
+                Tensor &y = slots[step.out_slot];
+                ensureShape(y, rows, out);
+                const Kernel kernel = (rows == options.batch_size) ? step.kernel : ((rows == 1) ? Kernel::Gemv : Kernel::Gemm);
+                if(kernel == Kernel::Gemv)
+                {
+                    gemv(x.getCpuData(), w.getCpuData(), y.getCpuData(), rows, in, out);
+                }
+                else
+                {
+                    CpuOps::gemm(false, false, rows, out, in, 1.0f, x.getCpuData(), in, w.getCpuData(), out, 0.0f, y.getCpuData(), out);
+                }
+                if(step.op == OpCode::DenseActivation)
+                {
+                    biasActivationEpilogue(y.getCpuData(), step.dense->biases.getCpuData(), rows, out, step.activation);
+                }
+                else
+                {
+                    biasEpilogue(y.getCpuData(), step.dense->biases.getCpuData(), rows, out);
+                }
+                break;
+            }
+            case OpCode::Activation:
+            {
+                const Tensor &x = value(step.in_slot[0]);
+                Tensor &y = slots[step.out_slot];
+                ensureShape(y, x.getRows(), x.getCols());
+                applyActivation(x.getCpuData(), y.getCpuData(), x.getSize(), step.activation);
+                break;
+            }
+            case OpCode::Softmax:
+            case OpCode::SoftmaxCrossEntropy:
+            {
+                const Tensor &x = value(step.in_slot[0]);
+                Tensor &y = slots[step.out_slot];
+                ensureShape(y, x.getRows(), x.getCols());
+                softmaxRows(x.getCpuData(), y.getCpuData(), x.getRows(), x.getCols());
+                break;
+            }
+            case OpCode::Add:
+            {
+                const Tensor &a = value(step.in_slot[0]);
+                const Tensor &b = value(step.in_slot[1]);
+                if(a.getShape() != b.getShape())
+                {
+                    throw std::runtime_error("ExecutionPlan: residual add received tensors of different shapes.");
+                }
+                Tensor &y = slots[step.out_slot];
+                ensureShape(y, a.getRows(), a.getCols());
+                const float *pa = a.getCpuData();
+                const float *pb = b.getCpuData();
+                float *py = y.getCpuData();
+                for(size_t i = 0; i < y.getSize(); i++)
+                {
+                    py[i] = pa[i] + pb[i];
+                }
+                break;
+            }
+            case OpCode::Layer:
+            {
+                const Tensor &x = value(step.in_slot[0]);
+                slots[step.out_slot] = step.layer->isIdentity() ? x : step.layer->forward(x);
+                break;
+            }
+        }
+    }
+}
+
+
+
+const Tensor &ExecutionPlan::run(const Tensor &input)
+{
+    input_ref = &input;
+    forwardPass();
+    input_ref = nullptr;
+    return slots[output_slot];
+}
+
+
+
+void ExecutionPlan::backwardPass(const Tensor &grad_output)
+{
+    const auto &nodes = graph->getNodes();
+    std::fill(grad_set.begin(), grad_set.end(), false);
+
+    // Returns the gradient buffer for `node`; `accumulate` reports whether
+    // another consumer already wrote into it.
+    auto gradFor = [&](Graph::NodeId node, size_t rows, size_t cols, bool &accumulate) -> Tensor &
+    {
+        accumulate = grad_set[node];
+        if(!accumulate)
+        {
+            ensureShape(grads[node], rows, cols);
+            grad_set[node] = true;
+        }
+        return grads[node];
+    };
+    auto addInto = [&](Graph::NodeId node, const Tensor &g)
+    {
+        if(nodes[node].kind == Graph::NodeKind::Input) { return; }
+        bool accumulate = false;
+        Tensor &dst = gradFor(node, g.getRows(), g.getCols(), accumulate);
+        float *d = dst.getCpuData();
+        const float *s = g.getCpuData();
+        for(size_t i = 0; i < g.getSize(); i++)
+        {
+            d[i] = accumulate ? d[i] + s[i] : s[i];
+        }
+    };
+
+    const Graph::NodeId out_node = steps.back().node;
+    ensureShape(grads[out_node], grad_output.getRows(), grad_output.getCols());
+    std::copy(grad_output.getCpuData(), grad_output.getCpuData() + grad_output.getSize(), grads[out_node].getCpuData());
+    grad_set[out_node] = true;
+
+    for(size_t i = steps.size(); i-- > 0;)
+    {
+        const Step &step = steps[i];
+        if(!grad_set[step.node]) { continue; }
+        const Tensor &dy = grads[step.node];
+        const Graph::NodeId in = step.input_node[0];
+        const bool input_is_source = (nodes[in].kind == Graph::NodeKind::Input);
+
+        switch(step.op)
+        {
+            case OpCode::Dense:
+            case OpCode::DenseActivation:
+            {
+                const Tensor &x = value(step.in_slot[0]);
+                const Tensor &w = step.dense->weights;
+                const size_t rows = dy.getRows();
+                const size_t n_in = w.getRows();
+                const size_t n_out = w.getCols();
+                const float *dz = dy.getCpuData();
+                if(step.op == OpCode::DenseActivation)
+                {
+                    ensureShape(scratch, rows, n_out);
+                    activationGrad(dy.getCpuData(), slots[step.out_slot].getCpuData(), scratch.getCpuData(), dy.getSize(), step.activation, false);
+                    dz = scratch.getCpuData();
+                }
+
+                Tensor &gw = grad_weights[step.param_index];
+                CpuOps::gemm(true, false, n_in, n_out, rows, 1.0f, x.getCpuData(), n_in, dz, n_out, 0.0f, gw.getCpuData(), n_out);
+                // Same reduction as Dense::backward, which averages the bias gradient over rows
+                float *gb = grad_biases[step.param_index].getCpuData();
+                std::fill(gb, gb + n_out, 0.0f);
+                for(size_t r = 0; r < rows; r++)
+                {
+                    for(size_t j = 0; j < n_out; j++)
+                    {
+                        gb[j] += dz[r * n_out + j];
+                    }
+                }
+                for(size_t j = 0; j < n_out; j++)
+                {
+                    gb[j] /= static_cast<float>(rows);
+                }
+
+                // Nothing upstream consumes the gradient of the graph input
+                if(!input_is_source)
+                {
+                    bool accumulate = false;
+                    Tensor &dx = gradFor(in, rows, n_in, accumulate);
+                    CpuOps::gemm(false, true, rows, n_in, n_out, 1.0f, dz, n_out, w.getCpuData(), n_out,
+                                 accumulate ? 1.0f : 0.0f, dx.getCpuData(), n_in);
+                }
+                break;
+            }
+            case OpCode::Activation:
+            {
+                if(input_is_source) { break; }
+                bool accumulate = false;
+                Tensor &dx = gradFor(in, dy.getRows(), dy.getCols(), accumulate);
+                activationGrad(dy.getCpuData(), slots[step.out_slot].getCpuData(), dx.getCpuData(), dy.getSize(), step.activation, accumulate);
+                break;
+            }
+            case OpCode::Softmax:
+            case OpCode::SoftmaxCrossEntropy:
+                // Mirrors Softmax::backward: the incoming gradient is already
+                // taken with respect to the logits (softmax + cross-entropy)
+                addInto(in, dy);
+                break;
+            case OpCode::Add:
+                addInto(step.input_node[0], dy);
+                addInto(step.input_node[1], dy);
+                break;
+            case OpCode::Layer:
+                addInto(in, step.layer->isIdentity() ? dy : step.layer->backward(dy));
+                break;
+        }
+    }
+}
+
+
+
+void ExecutionPlan::applyUpdates()
+{
+    Optimizer &optimizer = *graph->getOptimizer();
+    for(const Step &step : steps)
+    {
+        if(!grad_set[step.node]) { continue; }
+        if(step.dense)
+        {
+            if(step.dense->isPruned())
+            {
+                optimizer.updateMasked(step.dense->weights, grad_weights[step.param_index], step.dense->getPruningMask());
+            }
+            else
+            {
+                optimizer.update(step.dense->weights, grad_weights[step.param_index]);
+            }
+            optimizer.update(step.dense->biases, grad_biases[step.param_index]);
+            if(step.dense->getBackendType() == Backend::GPU)
+            {
+                step.dense->weights.freeGpu();
+                step.dense->biases.freeGpu();
+            }
+        }
+        else if(step.layer)
+        {
+            step.layer->update(optimizer);
+        }
+    }
+}
+
+
+
+float ExecutionPlan::fusedSoftmaxCrossEntropy(const Tensor &y_true, Tensor &grad) const
+{
+    const Tensor &p = slots[output_slot];
+    const size_t rows = p.getRows();
+    const size_t cols = p.getCols();
+    const float inv_rows = 1.0f / static_cast<float>(rows);
+    const float *pp = p.getCpuData();
+    const float *t = y_true.getCpuData();
+    float *g = grad.getCpuData();
+    float loss = 0.0f;
+
+    if(y_true.getShape() == p.getShape())
+    {
+        for(size_t i = 0; i < rows * cols; i++)
+        {
+            if(t[i] > 0.0f) { loss -= std::log(std::max(pp[i], 1e-9f)); }
+            g[i] = (pp[i] - t[i]) * inv_rows;
+        }
+    }
+    else if((y_true.getCols() == 1) && (y_true.getRows() == rows))
+    {
+        for(size_t i = 0; i < rows; i++)
+        {
+            for(size_t j = 0; j < cols; j++)
+            {
+                g[i * cols + j] = pp[i * cols + j] * inv_rows;
+            }
+            const int class_idx = static_cast<int>(t[i]);
+            if((class_idx >= 0) && (class_idx < static_cast<int>(cols)))
+            {
+                loss -= std::log(std::max(pp[i * cols + class_idx], 1e-9f));
+                g[i * cols + class_idx] -= inv_rows;
+            }
+        }
+    }
+    else
+    {
+        throw std::invalid_argument("Incompatible shapes for cross entropy loss.");
+    }
+    return loss * inv_rows;
+}
+
+
+
+float ExecutionPlan::trainStep(const Tensor &X_batch, const Tensor &y_batch)
+{
+    if(!options.training)
+    {
+        throw std::logic_error("ExecutionPlan was compiled for inference only.");
+    }
+    if((!graph->getLoss()) || (!graph->getOptimizer()))
+    {
+        throw std::runtime_error("Graph needs a loss and an optimizer before training.");
+    }
+
+    input_ref = &X_batch;
+    forwardPass();
+    const Tensor &y_pred = slots[output_slot];
+
+    float loss = 0.0f;
+    if(steps.back().op == OpCode::SoftmaxCrossEntropy)
+    {
+        ensureShape(loss_grad, y_pred.getRows(), y_pred.getCols());
+        loss = fusedSoftmaxCrossEntropy(y_batch, loss_grad);
+    }
+    else
+    {
+        loss = graph->getLoss()->forward(y_pred, y_batch);
+        loss_grad = graph->getLoss()->backward(y_pred, y_batch);
+    }
+
+    backwardPass(loss_grad);
+    applyUpdates();
+    input_ref = nullptr;
+    return loss;
+}
+
+
+
+std::string ExecutionPlan::describe() const
+{
+    std::ostringstream oss;
+    for(size_t i = 0; i < steps.size(); i++)
+    {
+        const Step &step = steps[i];
+        oss << i << ": " << opName(step.op);
+        if((step.op == OpCode::Activation) || (step.op == OpCode::DenseActivation))
+        {
+            oss << ((step.activation == ActivationType::ReLU) ? "[ReLU]" : "[Sigmoid]");
+        }
+        if(step.dense)
+        {
+            oss << ' ' << step.dense->weights.getRows() << "->" << step.dense->weights.getCols()
+                << ((step.kernel == Kernel::Gemv) ? " gemv" : " gemm");
+        }
+        oss << "  slot " << step.in_slot[0];
+        if(step.op == OpCode::Add) { oss << " + slot " << step.in_slot[1]; }
+        oss << " -> slot " << step.out_slot << '\n';
+    }
+    oss << "nodes " << stats.graph_nodes << ", steps " << stats.steps << " (" << stats.opaque_steps << " opaque)"
+        << ", eliminated " << stats.eliminated_nodes << ", fused dense+act " << stats.fused_dense_activation
+        << ", fused softmax+ce " << stats.fused_softmax_cross_entropy << ", folded batchnorm " << stats.folded_batch_norm << '\n'
+        << "activation memory " << stats.planned_floats * sizeof(float) / 1024 << " KiB in " << stats.slots
+        << " slots (unplanned " << stats.naive_floats * sizeof(float) / 1024 << " KiB)";
+    return oss.str();
+}
@@ -0,0 +1,152 @@
+// =============================================================================
+// File: src/nn/graph/ExecutionPlan.h
+// =============================================================================
+//
+// Description: Declares GraphCompiler and ExecutionPlan. The compiler lowers a
+//              Graph into a flat list of steps: it removes nodes that do not
+//              reach the output, fuses Dense+bias+activation into a single GEMM
+//              with an epilogue and Softmax+CrossEntropy into one pass, folds
+//              BatchNorm1d into the preceding Dense for inference, plans
+//              activation memory by liveness so buffers are reused, and picks a
+//              GEMV or GEMM kernel per Dense from the expected batch shape. The
+//              plan then runs as a switch over step opcodes; only layers without
+//              a native lowering (Conv2D, pooling, normalization, ...) are still
+//              reached through their virtual forward/backward.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/graph/Graph.h"
+#include "nn/nn_types.h"
+
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+class Dense;
+
+
+
+struct CompileOptions
+{
+    size_t batch_size = 64; // expected rows per call, drives memory planning and kernel choice
+    bool training = true;   // keep the values backward needs alive; for inference plans call
+                            // Graph::setTraining(false) first so Dropout is elided. Inference
+                            // plans fold BatchNorm1d with the weights and statistics of compile
+                            // time, so recompile after training further.
+    bool fuse = true;       // enable the fusion passes
+};
+
+
+
+class ExecutionPlan
+{
+public:
+    enum class OpCode : std::uint8_t
+    {
+        Dense,
+        DenseActivation,     // GEMM with a fused bias + activation epilogue
+        Activation,
+        Softmax,
+        SoftmaxCrossEntropy, // softmax output whose loss and gradient are fused in trainStep
+        Add,
+        Layer,               // opaque layer, dispatched virtually
+    };
+
+    enum class Kernel : std::uint8_t
+    {
+        None,
+        Gemv, // single row: stream the weights once, no packing
+        Gemm, // blocked CpuOps::gemm
+    };
+
+    struct Step
+    {
+        OpCode op;
+        Kernel kernel = Kernel::None;
+        ActivationType activation = ActivationType::ReLU;
+        Graph::NodeId node = 0;           // graph node whose value this step produces
+        Graph::NodeId input_node[2] = {0, 0};
+        size_t in_slot[2] = {0, 0};
+        size_t out_slot = 0;
+        size_t width = 0;                 // output features, 0 if only known at run time
+        Dense *dense = nullptr;
+        ::Layer *layer = nullptr;
+        size_t param_index = 0;           // into grad_weights / grad_biases for Dense steps
+    };
+
+    struct Stats
+    {
+        size_t graph_nodes = 0;
+        size_t eliminated_nodes = 0;
+        size_t fused_dense_activation = 0;
+        size_t fused_softmax_cross_entropy = 0;
+        size_t folded_batch_norm = 0;
+        size_t steps = 0;
+        size_t opaque_steps = 0;
+        size_t values = 0;
+        size_t slots = 0;
+        size_t planned_floats = 0; // activation memory after slot reuse, at the compiled batch size
+        size_t naive_floats = 0;   // one buffer per value, as the interpreter keeps them
+    };
+
+    // Runs the forward pass. The returned reference stays valid until the next call.
+    [[nodiscard]] const Tensor &run(const Tensor &input);
+
+    // Forward, loss, backward and parameter update using the graph's loss and optimizer
+    [[nodiscard]] float trainStep(const Tensor &X_batch, const Tensor &y_batch);
+
+    [[nodiscard]] const Stats &getStats() const noexcept { return stats; }
+    [[nodiscard]] const std::vector<Step> &getSteps() const noexcept { return steps; }
+    [[nodiscard]] std::string describe() const;
+
+private:
+    friend class GraphCompiler;
+
+    ExecutionPlan(Graph &graph, const CompileOptions &options);
+
+    [[nodiscard]] const Tensor &value(size_t slot) const { return (slot == input_slot) ? *input_ref : slots[slot]; }
+    void forwardPass();
+    void backwardPass(const Tensor &grad_output);
+    void applyUpdates();
+    [[nodiscard]] float fusedSoftmaxCrossEntropy(const Tensor &y_true, Tensor &grad) const;
+
+    Graph *graph;
+    CompileOptions options;
+    std::vector<Step> steps;
+    std::vector<Tensor> slots;
+    size_t input_slot = 0;
+    size_t output_slot = 0;
+    const Tensor *input_ref = nullptr;
+
+    // Backward state, indexed by graph node id
+    std::vector<Tensor> grads;
+    std::vector<bool> grad_set;
+    std::vector<Tensor> grad_weights;
+    std::vector<Tensor> grad_biases;
+    Tensor scratch; // pre-activation gradient of fused Dense steps
+    Tensor loss_grad;
+
+    // Copies of the Dense layers a BatchNorm1d was folded into; their steps
+    // point here so the graph's own layers stay trainable
+    std::vector<std::unique_ptr<::Layer>> folded_layers;
+
+    Stats stats;
+};
+
+
+
+class GraphCompiler
+{
+public:
+    [[nodiscard]] static ExecutionPlan compile(Graph &graph, const CompileOptions &options = {});
+};
@@ -0,0 +1,254 @@
+#include "nn/graph/Graph.h"
+
+
+
+#include "nn/layers/Conv2D.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Embedding.h"
+#include "nn/layers/Pooling.h"
+
+
+
+#include <stdexcept>
+
+
+
+namespace
+{
+    void accumulate(Tensor &into, const Tensor &grad)
+    {
+        if(into.getSize() == 0)
+        {
+            into = grad;
+            return;
+        }
+        if(into.getShape() != grad.getShape())
+        {
+            throw std::runtime_error("Graph backward: gradient shapes disagree at a fan-out node.");
+        }
+        float *dst = into.getCpuData();
+        const float *src = grad.getCpuData();
+        for(size_t i = 0; i < into.getSize(); i++)
+        {
+            dst[i] += src[i];
+        }
+    }
+}
+
+
+
+Graph::Graph() : input_node{0}, output_node{0}
+{
+}
+
+
+
+void Graph::checkNode(NodeId node) const
+{
+    if(node >= nodes.size())
+    {
+        throw std::out_of_range("Graph node id does not exist.");
+    }
+}
+
+
+
+Graph::NodeId Graph::input(size_t width)
+{
+    if(has_input)
+    {
+        throw std::invalid_argument("Graph supports a single input node.");
+    }
+    nodes.push_back(Node{NodeKind::Input, nullptr, {}, width});
+    input_node = nodes.size() - 1;
+    has_input = true;
+    return input_node;
+}
+
+
+
+Graph::NodeId Graph::add(std::unique_ptr<::Layer> layer, NodeId input)
+{
+    checkNode(input);
+    if(!layer)
+    {
+        throw std::invalid_argument("Graph::add requires a layer.");
+    }
+    const size_t width = inferWidth(*layer, nodes[input].width);
+    nodes.push_back(Node{NodeKind::Layer, std::move(layer), {input}, width});
+    return nodes.size() - 1;
+}
+
+
+
+Graph::NodeId Graph::addResidual(NodeId a, NodeId b)
+{
+    checkNode(a);
+    checkNode(b);
+    const size_t wa = nodes[a].width;
+    const size_t wb = nodes[b].width;
+    if((wa != 0) && (wb != 0) && (wa != wb))
+    {
+        throw std::invalid_argument("Residual add requires both branches to have the same width.");
+    }
+    nodes.push_back(Node{NodeKind::Add, nullptr, {a, b}, (wa != 0) ? wa : wb});
+    return nodes.size() - 1;
+}
+
+
+
+void Graph::setOutput(NodeId node)
+{
+    checkNode(node);
+    output_node = node;
+    has_output = true;
+}
+
+
+
+size_t Graph::inferWidth(const ::Layer &layer, size_t input_width)
+{
+    if(const auto *dense = dynamic_cast<const Dense *>(&layer))
+    {
+        return dense->weights.getCols();
+    }
+    if(const auto *conv = dynamic_cast<const Conv2D *>(&layer))
+    {
+        return conv->getOutputSize();
+    }
+    if(const auto *pool = dynamic_cast<const MaxPool2D *>(&layer))
+    {
+        return pool->getOutputSize();
+    }
+    if(const auto *pool = dynamic_cast<const AvgPool2D *>(&layer))
+    {
+        return pool->getOutputSize();
+    }
+    if(const auto *pool = dynamic_cast<const GlobalAvgPool *>(&layer))
+    {
+        return pool->getOutputSize();
+    }
+    if(dynamic_cast<const Embedding *>(&layer))
+    {
+        return 0; // depends on the number of ids per row
+    }
+    // Activation, Softmax, Dropout and the normalization layers keep the width
+    return input_width;
+}
+
+
+
+Tensor Graph::forward(const Tensor &input)
+{
+    if((!has_input) || (!has_output))
+    {
+        throw std::runtime_error("Graph needs an input and an output node before it can run.");
+    }
+    values.assign(nodes.size(), Tensor{});
+    for(NodeId id = 0; id <= output_node; id++)
+    {
+        Node &node = nodes[id];
+        switch(node.kind)
+        {
+            case NodeKind::Input:
+                values[id] = input;
+                break;
+            case NodeKind::Layer:
+                values[id] = node.layer->isIdentity() ? values[node.inputs[0]] : node.layer->forward(values[node.inputs[0]]);
+                break;
+            case NodeKind::Add:
+            {
+                const Tensor &a = values[node.inputs[0]];
+                const Tensor &b = values[node.inputs[1]];
+                if(a.getShape() != b.getShape())
+                {
+                    throw std::runtime_error("Residual add received tensors of different shapes.");
+                }
+                Tensor sum{a.getShape()};
+                for(size_t i = 0; i < sum.getSize(); i++)
+                {
+                    sum.getCpuData()[i] = a.getCpuData()[i] + b.getCpuData()[i];
+                }
+                values[id] = std::move(sum);
+                break;
+            }
+        }
+    }
+    return values[output_node];
+}
+
+
+
+void Graph::backward(const Tensor &grad)
+{
+    if(values.size() != nodes.size())
+    {
+        throw std::runtime_error("Graph backward requires a preceding forward.");
+    }
+    std::vector<Tensor> grads(nodes.size());
+    grads[output_node] = grad;
+    has_grad.assign(nodes.size(), false);
+    for(NodeId id = output_node + 1; id-- > 0;)
+    {
+        Node &node = nodes[id];
+        if(grads[id].getSize() == 0)
+        {
+            continue; // not on a path to the output
+        }
+        has_grad[id] = true;
+        switch(node.kind)
+        {
+            case NodeKind::Input:
+                break;
+            case NodeKind::Layer:
+                if(node.layer->isIdentity())
+                {
+                    accumulate(grads[node.inputs[0]], grads[id]);
+                }
+                else
+                {
+                    accumulate(grads[node.inputs[0]], node.layer->backward(grads[id]));
+                }
+                break;
+            case NodeKind::Add:
+                accumulate(grads[node.inputs[0]], grads[id]);
+                accumulate(grads[node.inputs[1]], grads[id]);
+                break;
+        }
+        grads[id] = Tensor{};
+    }
+}
+
+
+
+float Graph::train_step(const Tensor &X_batch, const Tensor &y_batch)
+{
+    if((!loss_func) || (!optimizer))
+    {
+        throw std::runtime_error("Graph needs a loss and an optimizer before training.");
+    }
+    Tensor y_pred = forward(X_batch);
+    float loss = loss_func->forward(y_pred, y_batch);
+    backward(loss_func->backward(y_pred, y_batch));
+    for(NodeId id = 0; id < nodes.size(); id++)
+    {
+        if(nodes[id].layer && has_grad[id])
+        {
+            nodes[id].layer->update(*optimizer);
+        }
+    }
+    return loss;
+}
+
+
+
+void Graph::setTraining(bool is_training)
+{
+    for(auto &node : nodes)
+    {
+        if(node.layer)
+        {
+            node.layer->setTraining(is_training);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// =============================================================================
+// File: src/nn/graph/Graph.h
+// =============================================================================
+//
+// Description: Declares Graph, a DAG model where layers are nodes connected by
+//              explicit tensor edges. Unlike the sequential Model it supports
+//              fan-out and skip connections (residual adds). A Graph can run
+//              directly (interpreted, one virtual call per layer) or be lowered
+//              by GraphCompiler into an ExecutionPlan.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Loss.h"
+#include "nn/Tensor.h"
+#include "nn/layers/Layer.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+
+class Graph
+{
+public:
+    using NodeId = size_t;
+
+    enum class NodeKind : std::uint8_t
+    {
+        Input,
+        Layer,
+        Add, // element-wise sum of two tensors (skip connection)
+    };
+
+    struct Node
+    {
+        NodeKind kind;
+        std::unique_ptr<::Layer> layer; // set for NodeKind::Layer
+        std::vector<NodeId> inputs;
+        size_t width = 0;               // features per row, 0 if not known statically
+    };
+
+    Graph();
+
+    // Nodes may only reference earlier nodes, so insertion order is a valid
+    // topological order.
+    NodeId input(size_t width);
+    NodeId add(std::unique_ptr<::Layer> layer, NodeId input);
+    NodeId addResidual(NodeId a, NodeId b);
+    void setOutput(NodeId node);
+
+    void setLoss(std::unique_ptr<Loss> loss) { loss_func = std::move(loss); }
+    void setOptimizer(std::unique_ptr<Optimizer> opt) { optimizer = std::move(opt); }
+
+    // Interpreted execution
+    [[nodiscard]] Tensor forward(const Tensor &input);
+    void backward(const Tensor &grad);
+    [[nodiscard]] float train_step(const Tensor &X_batch, const Tensor &y_batch);
+    void setTraining(bool is_training);
+
+    [[nodiscard]] const std::vector<Node> &getNodes() const noexcept { return nodes; }
+    [[nodiscard]] NodeId getInput() const noexcept { return input_node; }
+    [[nodiscard]] NodeId getOutput() const noexcept { return output_node; }
+    [[nodiscard]] Loss *getLoss() const noexcept { return loss_func.get(); }
+    [[nodiscard]] Optimizer *getOptimizer() const noexcept { return optimizer.get(); }
+
+    // Static output width of a layer for the given input width (0 if unknown)
+    [[nodiscard]] static size_t inferWidth(const ::Layer &layer, size_t input_width);
+
+private:
+    void checkNode(NodeId node) const;
+
+    std::vector<Node> nodes;
+    NodeId input_node;
+    NodeId output_node;
+    bool has_input = false;
+    bool has_output = false;
+    std::unique_ptr<Loss> loss_func;
+    std::unique_ptr<Optimizer> optimizer;
+
+    // Interpreter state: per-node values from the last forward
+    std::vector<Tensor> values;
+    std::vector<bool> has_grad; // nodes reached by the last backward
+};
@@ -34,9 +34,12 @@ Tensor Activation::forward(const Tensor &input)
 {
     this->last_input = input;
     Tensor output{input.getShape()};
+    // Zero outputs of a ReLU are its dead units in the health statistics
+    NumericHealth::TensorStats *stats = NumericHealth::collectingActivations() ? &health.output : nullptr;
     for (size_t i = 0; i < input.getSize(); i++)
     {
         output.getCpuData()[i] = activation_func(input.getCpuData()[i]);
+        if (stats) { stats->observe(output.getCpuData()[i]); }
     }
     return output;
 }
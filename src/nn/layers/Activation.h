@@ -17,6 +17,8 @@ public:
     Activation(ActivationType type);
     [[nodiscard]] Tensor forward(const Tensor & input) override;
     [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Activation"; }
+    [[nodiscard]] ActivationType getType() const noexcept { return type; }
 
 private:
     ActivationType type;
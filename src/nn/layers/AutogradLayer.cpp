@@ -0,0 +1,119 @@
+#include "nn/layers/AutogradLayer.h"
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+
+
+// --- AutogradLayer ---
+
+Tensor AutogradLayer::forward(const Tensor &input)
+{
+    // The tape references the input, so keep a copy that outlives this call
+    this->last_input = input;
+    tape.clear();
+    has_gradients = false;
+    input_var = tape.input(last_input, true);
+    parameter_vars.clear();
+    for(Tensor *p : parameters)
+    {
+        parameter_vars.push_back(tape.parameter(*p));
+    }
+    output_var = build(tape, input_var, parameter_vars);
+    return tape.value(output_var);
+}
+
+
+
+Tensor AutogradLayer::backward(const Tensor &grad_output)
+{
+    if(tape.size() == 0)
+    {
+        throw std::runtime_error("AutogradLayer backward requires a preceding forward.");
+    }
+    tape.backward(output_var, grad_output);
+    has_gradients = true;
+    if(NumericHealth::collectingGradients())
+    {
+        for(Tape::Var parameter : parameter_vars)
+        {
+            const Tensor &grad = tape.grad(parameter);
+            health.observeGrads(grad.getCpuData(), grad.getSize());
+        }
+    }
+    const Tensor &grad_input = tape.grad(input_var);
+    if(grad_input.getSize() == 0)
+    {
+        Tensor zeros{last_input.getShape()};
+        std::fill(zeros.getCpuData(), zeros.getCpuData() + zeros.getSize(), 0.0f);
+        return zeros;
+    }
+    return grad_input;
+}
+
+
+
+void AutogradLayer::update(Optimizer &optimizer)
+{
+    if(has_gradients)
+    {
+        tape.step(optimizer);
+    }
+}
+
+
+
+// --- GatedDense ---
+
+GatedDense::GatedDense(size_t input_size, size_t output_size)
+    : weights{{input_size, output_size}}, biases{{1, output_size}},
+      gate_weights{{input_size, output_size}}, gate_biases{{1, output_size}}
+{
+    initializeParameters(Initializer::Scheme::XavierUniform);
+    registerParameter(weights);
+    registerParameter(biases);
+    registerParameter(gate_weights);
+    registerParameter(gate_biases);
+}
+
+
+
+void GatedDense::initializeParameters(Initializer::Scheme scheme)
+{
+    Initializer::fill(weights, scheme, weights.getRows(), weights.getCols());
+    Initializer::fill(biases, Initializer::Scheme::Zeros, 0, 0);
+    Initializer::fill(gate_weights, scheme, gate_weights.getRows(), gate_weights.getCols());
+    Initializer::fill(gate_biases, Initializer::Scheme::Zeros, 0, 0);
+}
+
+
+
+Tape::Var GatedDense::build(Tape &tape, Tape::Var input, const std::vector<Tape::Var> &params)
+{
+    const Tape::Var value = tape.linear(input, params[0], params[1]);
+    const Tape::Var gate = tape.sigmoid(tape.linear(input, params[2], params[3]));
+    return tape.mul(value, gate);
+}
+
+
+
+OpCost GatedDense::forwardCost(const Tensor &input) const
+{
+    // Two Dense products, a sigmoid and the gating multiply
+    const double b = static_cast<double>(input.getRows());
+    const double in = static_cast<double>(weights.getRows());
+    const double out = static_cast<double>(weights.getCols());
+    return {4.0 * b * in * out + 4.0 * b * out, (b * in + 2.0 * (in * out + out) + b * out) * sizeof(float)};
+}
+
+
+
+OpCost GatedDense::backwardCost(const Tensor &input) const
+{
+    const double b = static_cast<double>(input.getRows());
+    const double in = static_cast<double>(weights.getRows());
+    const double out = static_cast<double>(weights.getCols());
+    return {8.0 * b * in * out + 6.0 * b * out, (b * out + 2.0 * b * in + 4.0 * (in * out + out)) * sizeof(float)};
+}
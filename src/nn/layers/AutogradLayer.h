@@ -0,0 +1,66 @@
+#pragma once
+
+
+
+#include "nn/autograd/Tape.h"
+#include "nn/layers/Layer.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <vector>
+
+
+
+// Base for layers whose gradients come from the autograd Tape instead of a
+// hand-written backward. Subclasses register their parameter tensors and
+// describe the forward computation in build(); forward records it on a
+// per-layer tape, backward replays the tape seeded with grad_output, and
+// update applies the optimizer to every registered parameter.
+class AutogradLayer : public Layer
+{
+public:
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    void update(Optimizer & optimizer) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return parameters; }
+
+    [[nodiscard]] const Tape &getTape() const noexcept { return tape; }
+
+protected:
+    void registerParameter(Tensor & parameter) { parameters.push_back(&parameter); }
+
+    // Record the layer's computation; `params` follow registration order
+    [[nodiscard]] virtual Tape::Var build(Tape & tape, Tape::Var input, const std::vector<Tape::Var> & params) = 0;
+
+private:
+    Tape tape;
+    std::vector<Tensor *> parameters;
+    std::vector<Tape::Var> parameter_vars;
+    Tape::Var input_var;
+    Tape::Var output_var;
+    bool has_gradients = false;
+};
+
+
+
+// Gated linear unit: (x W + b) * sigmoid(x V + c). Written purely in tape ops,
+// with no backward of its own.
+class GatedDense final : public AutogradLayer
+{
+public:
+    GatedDense(size_t input_size, size_t output_size);
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "GatedDense"; }
+    // Xavier uniform by default, for both branches
+    void initializeParameters(Initializer::Scheme scheme) override;
+
+    Tensor weights;      // {input, output}
+    Tensor biases;       // {1, output}
+    Tensor gate_weights; // {input, output}
+    Tensor gate_biases;  // {1, output}
+
+protected:
+    [[nodiscard]] Tape::Var build(Tape & tape, Tape::Var input, const std::vector<Tape::Var> & params) override;
+};
@@ -0,0 +1,483 @@
+#include "nn/layers/Conv2D.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+
+
+namespace
+{
+    // Winograd F(2x2, 3x3) transforms (Lavin & Gray). Each helper applies the
+    // 1D transform along rows and then along columns of a small tile.
+
+    // U = G g G^T, g is 3x3 and U is 4x4
+    void winogradFilterTransform(const float g[3][3], float u[4][4])
+    {
+        float tmp[4][3];
+        for(size_t j = 0; j < 3; j++)
+        {
+            tmp[0][j] = g[0][j];
+            tmp[1][j] = 0.5f * (g[0][j] + g[1][j] + g[2][j]);
+            tmp[2][j] = 0.5f * (g[0][j] - g[1][j] + g[2][j]);
+            tmp[3][j] = g[2][j];
+        }
+        for(size_t i = 0; i < 4; i++)
+        {
+            u[i][0] = tmp[i][0];
+            u[i][1] = 0.5f * (tmp[i][0] + tmp[i][1] + tmp[i][2]);
+            u[i][2] = 0.5f * (tmp[i][0] - tmp[i][1] + tmp[i][2]);
+            u[i][3] = tmp[i][2];
+        }
+    }
+
+
+
+    // V = B^T d B, d and V are 4x4
+    void winogradInputTransform(const float d[4][4], float v[4][4])
+    {
+        float tmp[4][4];
+        for(size_t j = 0; j < 4; j++)
+        {
+            tmp[0][j] = d[0][j] - d[2][j];
+            tmp[1][j] = d[1][j] + d[2][j];
+            tmp[2][j] = d[2][j] - d[1][j];
+            tmp[3][j] = d[1][j] - d[3][j];
+        }
+        for(size_t i = 0; i < 4; i++)
+        {
+            v[i][0] = tmp[i][0] - tmp[i][2];
+            v[i][1] = tmp[i][1] + tmp[i][2];
+            v[i][2] = tmp[i][2] - tmp[i][1];
+            v[i][3] = tmp[i][1] - tmp[i][3];
+        }
+    }
+
+
+
+    // Y = A^T m A, m is 4x4 and Y is 2x2
+    void winogradOutputTransform(const float m[4][4], float y[2][2])
+    {
+        float tmp[2][4];
+        for(size_t j = 0; j < 4; j++)
+        {
+            tmp[0][j] = m[0][j] + m[1][j] + m[2][j];
+            tmp[1][j] = m[1][j] - m[2][j] - m[3][j];
+        }
+        for(size_t i = 0; i < 2; i++)
+        {
+            y[i][0] = tmp[i][0] + tmp[i][1] + tmp[i][2];
+            y[i][1] = tmp[i][1] - tmp[i][2] - tmp[i][3];
+        }
+    }
+}
+
+
+
+Conv2D::Conv2D(size_t in_channels, size_t in_height, size_t in_width, size_t out_channels,
+               size_t kernel_size, size_t stride, size_t padding, DataLayout layout)
+    : in_channels{in_channels}, in_height{in_height}, in_width{in_width}, out_channels{out_channels},
+      kernel_size{kernel_size}, stride{stride}, padding{padding}, out_height{0}, out_width{0}, layout{layout}
+{
+    if((kernel_size == 0) || (stride == 0))
+    {
+        throw std::invalid_argument("Conv2D requires a non-zero kernel size and stride.");
+    }
+    if(((in_height + 2 * padding) < kernel_size) || ((in_width + 2 * padding) < kernel_size))
+    {
+        throw std::invalid_argument("Conv2D kernel is larger than the padded input.");
+    }
+    out_height = (in_height + 2 * padding - kernel_size) / stride + 1;
+    out_width = (in_width + 2 * padding - kernel_size) / stride + 1;
+
+    const size_t patch_size = in_channels * kernel_size * kernel_size;
+    weights = Tensor{{out_channels, patch_size}};
+    biases = Tensor{{1, out_channels}};
+    grad_weights = Tensor{{out_channels, patch_size}};
+    grad_biases = Tensor{{1, out_channels}};
+    initializeParameters(Initializer::Scheme::HeNormal);
+}
+
+
+
+void Conv2D::initializeParameters(Initializer::Scheme scheme)
+{
+    const size_t taps = kernel_size * kernel_size;
+    Initializer::fill(weights, scheme, in_channels * taps, out_channels * taps);
+    Initializer::fill(biases, Initializer::Scheme::Zeros, 0, 0);
+}
+
+
+
+bool Conv2D::usesWinograd() const noexcept
+{
+    return winograd_enabled && (kernel_size == 3) && (stride == 1);
+}
+
+
+
+size_t Conv2D::inputIndex(size_t c, size_t y, size_t x) const noexcept
+{
+    if(layout == DataLayout::NCHW)
+    {
+        return (c * in_height + y) * in_width + x;
+    }
+    return (y * in_width + x) * in_channels + c;
+}
+
+
+
+size_t Conv2D::outputIndex(size_t c, size_t y, size_t x) const noexcept
+{
+    if(layout == DataLayout::NCHW)
+    {
+        return (c * out_height + y) * out_width + x;
+    }
+    return (y * out_width + x) * out_channels + c;
+}
+
+
+
+void Conv2D::im2col(const float *image, float *col) const
+{
+    const size_t out_pixels = out_height * out_width;
+    for(size_t c = 0; c < in_channels; c++)
+    {
+        for(size_t ky = 0; ky < kernel_size; ky++)
+        {
+            for(size_t kx = 0; kx < kernel_size; kx++)
+            {
+                float *col_row = col + ((c * kernel_size + ky) * kernel_size + kx) * out_pixels;
+                for(size_t oy = 0; oy < out_height; oy++)
+                {
+                    // Unsigned wrap-around makes out-of-range rows/cols fail the bounds check
+                    const size_t iy = oy * stride + ky - padding;
+                    for(size_t ox = 0; ox < out_width; ox++)
+                    {
+                        const size_t ix = ox * stride + kx - padding;
+                        col_row[oy * out_width + ox] = ((iy < in_height) && (ix < in_width)) ? image[inputIndex(c, iy, ix)] : 0.0f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+void Conv2D::col2im(const float *col, float *image) const
+{
+    const size_t out_pixels = out_height * out_width;
+    for(size_t c = 0; c < in_channels; c++)
+    {
+        for(size_t ky = 0; ky < kernel_size; ky++)
+        {
+            for(size_t kx = 0; kx < kernel_size; kx++)
+            {
+                const float *col_row = col + ((c * kernel_size + ky) * kernel_size + kx) * out_pixels;
+                for(size_t oy = 0; oy < out_height; oy++)
+                {
+                    const size_t iy = oy * stride + ky - padding;
+                    if(iy >= in_height) { continue; }
+                    for(size_t ox = 0; ox < out_width; ox++)
+                    {
+                        const size_t ix = ox * stride + kx - padding;
+                        if(ix < in_width) { image[inputIndex(c, iy, ix)] += col_row[oy * out_width + ox]; }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+Tensor Conv2D::forward(const Tensor &input)
+{
+    if(input.getCols() != in_channels * in_height * in_width)
+    {
+        throw std::invalid_argument("Conv2D input width does not match in_channels * in_height * in_width.");
+    }
+    this->last_input = input;
+    Tensor output{{input.getRows(), getOutputSize()}};
+
+    if(usesWinograd())
+    {
+        forwardWinograd(input, output);
+    }
+    else
+    {
+        forwardGemm(input, output);
+    }
+
+    this->last_output = output;
+    return output;
+}
+
+
+
+void Conv2D::forwardGemm(const Tensor &input, Tensor &output)
+{
+    // Lower one image at a time so the column buffer stays cache-sized
+    // instead of materialising im2col for the whole batch.
+    const size_t patch_size = in_channels * kernel_size * kernel_size;
+    const size_t out_pixels = out_height * out_width;
+    col_buffer.resize(patch_size * out_pixels);
+    NumericHealth::TensorStats *stats = NumericHealth::collectingActivations() ? &health.output : nullptr;
+
+    for(size_t n = 0; n < input.getRows(); n++)
+    {
+        const float *image = input.getCpuData() + n * input.getCols();
+        float *out = output.getCpuData() + n * output.getCols();
+        im2col(image, col_buffer.data());
+
+        if(layout == DataLayout::NCHW)
+        {
+            // out[OC x P] = W[OC x CKK] * col[CKK x P]
+            CpuOps::gemm(false, false, out_channels, out_pixels, patch_size,
+                         1.0f, weights.getCpuData(), patch_size, col_buffer.data(), out_pixels,
+                         0.0f, out, out_pixels);
+            for(size_t oc = 0; oc < out_channels; oc++)
+            {
+                const float b = biases.getCpuData()[oc];
+                for(size_t p = 0; p < out_pixels; p++)
+                {
+                    out[oc * out_pixels + p] += b;
+                    if(stats) { stats->observe(out[oc * out_pixels + p]); }
+                }
+            }
+        }
+        else
+        {
+            // out[P x OC] = col^T[P x CKK] * W^T[CKK x OC]
+            CpuOps::gemm(true, true, out_pixels, out_channels, patch_size,
+                         1.0f, col_buffer.data(), out_pixels, weights.getCpuData(), patch_size,
+                         0.0f, out, out_channels);
+            for(size_t p = 0; p < out_pixels; p++)
+            {
+                for(size_t oc = 0; oc < out_channels; oc++)
+                {
+                    out[p * out_channels + oc] += biases.getCpuData()[oc];
+                    if(stats) { stats->observe(out[p * out_channels + oc]); }
+                }
+            }
+        }
+    }
+}
+
+
+
+void Conv2D::forwardWinograd(const Tensor &input, Tensor &output)
+{
+    const size_t batch = input.getRows();
+    const size_t tiles_h = (out_height + 1) / 2;
+    const size_t tiles_w = (out_width + 1) / 2;
+    const size_t tiles_per_image = tiles_h * tiles_w;
+    const size_t num_tiles = batch * tiles_per_image;
+
+    winograd_u.resize(16 * out_channels * in_channels);
+    winograd_v.resize(16 * in_channels * num_tiles);
+    winograd_m.resize(16 * out_channels * num_tiles);
+
+    // Filter transform: U[xi][oc][ic]
+    for(size_t oc = 0; oc < out_channels; oc++)
+    {
+        for(size_t ic = 0; ic < in_channels; ic++)
+        {
+            float g[3][3];
+            float u[4][4];
+            const float *w = weights.getCpuData() + oc * weights.getCols() + ic * 9;
+            for(size_t i = 0; i < 3; i++)
+            {
+                for(size_t j = 0; j < 3; j++) { g[i][j] = w[i * 3 + j]; }
+            }
+            winogradFilterTransform(g, u);
+            for(size_t xi = 0; xi < 16; xi++)
+            {
+                winograd_u[(xi * out_channels + oc) * in_channels + ic] = u[xi / 4][xi % 4];
+            }
+        }
+    }
+
+    // Input transform: V[xi][ic][tile], tiles overlap by 2 pixels
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *image = input.getCpuData() + n * input.getCols();
+        for(size_t ic = 0; ic < in_channels; ic++)
+        {
+            for(size_t ty = 0; ty < tiles_h; ty++)
+            {
+                for(size_t tx = 0; tx < tiles_w; tx++)
+                {
+                    float d[4][4];
+                    float v[4][4];
+                    for(size_t i = 0; i < 4; i++)
+                    {
+                        const size_t iy = 2 * ty + i - padding;
+                        for(size_t j = 0; j < 4; j++)
+                        {
+                            const size_t ix = 2 * tx + j - padding;
+                            d[i][j] = ((iy < in_height) && (ix < in_width)) ? image[inputIndex(ic, iy, ix)] : 0.0f;
+                        }
+                    }
+                    winogradInputTransform(d, v);
+                    const size_t tile = n * tiles_per_image + ty * tiles_w + tx;
+                    for(size_t xi = 0; xi < 16; xi++)
+                    {
+                        winograd_v[(xi * in_channels + ic) * num_tiles + tile] = v[xi / 4][xi % 4];
+                    }
+                }
+            }
+        }
+    }
+
+    // 16 independent GEMMs: M[xi] = U[xi] (OC x IC) * V[xi] (IC x tiles)
+    for(size_t xi = 0; xi < 16; xi++)
+    {
+        CpuOps::gemm(false, false, out_channels, num_tiles, in_channels,
+                     1.0f, winograd_u.data() + xi * out_channels * in_channels, in_channels,
+                     winograd_v.data() + xi * in_channels * num_tiles, num_tiles,
+                     0.0f, winograd_m.data() + xi * out_channels * num_tiles, num_tiles);
+    }
+
+    // Output transform, cropping partial tiles at the right/bottom edges
+    NumericHealth::TensorStats *stats = NumericHealth::collectingActivations() ? &health.output : nullptr;
+    for(size_t n = 0; n < batch; n++)
+    {
+        float *out = output.getCpuData() + n * output.getCols();
+        for(size_t oc = 0; oc < out_channels; oc++)
+        {
+            const float b = biases.getCpuData()[oc];
+            for(size_t ty = 0; ty < tiles_h; ty++)
+            {
+                for(size_t tx = 0; tx < tiles_w; tx++)
+                {
+                    const size_t tile = n * tiles_per_image + ty * tiles_w + tx;
+                    float m[4][4];
+                    float y[2][2];
+                    for(size_t xi = 0; xi < 16; xi++)
+                    {
+                        m[xi / 4][xi % 4] = winograd_m[(xi * out_channels + oc) * num_tiles + tile];
+                    }
+                    winogradOutputTransform(m, y);
+                    for(size_t i = 0; i < 2; i++)
+                    {
+                        const size_t oy = 2 * ty + i;
+                        if(oy >= out_height) { continue; }
+                        for(size_t j = 0; j < 2; j++)
+                        {
+                            const size_t ox = 2 * tx + j;
+                            if(ox >= out_width) { continue; }
+                            out[outputIndex(oc, oy, ox)] = y[i][j] + b;
+                            if(stats) { stats->observe(y[i][j] + b); }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+Tensor Conv2D::backward(const Tensor &grad_output)
+{
+    const size_t batch = grad_output.getRows();
+    const size_t patch_size = in_channels * kernel_size * kernel_size;
+    const size_t out_pixels = out_height * out_width;
+
+    Tensor grad_input{{batch, last_input.getCols()}};
+    std::fill(grad_input.getCpuData(), grad_input.getCpuData() + grad_input.getSize(), 0.0f);
+    std::fill(grad_weights.getCpuData(), grad_weights.getCpuData() + grad_weights.getSize(), 0.0f);
+    std::fill(grad_biases.getCpuData(), grad_biases.getCpuData() + grad_biases.getSize(), 0.0f);
+
+    col_buffer.resize(patch_size * out_pixels);
+    col_grad_buffer.resize(patch_size * out_pixels);
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *grad_out = grad_output.getCpuData() + n * grad_output.getCols();
+        // Recompute the lowered input instead of caching it for the whole batch
+        im2col(last_input.getCpuData() + n * last_input.getCols(), col_buffer.data());
+
+        if(layout == DataLayout::NCHW)
+        {
+            // dW += dY[OC x P] * col^T[P x CKK]
+            CpuOps::gemm(false, true, out_channels, patch_size, out_pixels,
+                         1.0f, grad_out, out_pixels, col_buffer.data(), out_pixels,
+                         1.0f, grad_weights.getCpuData(), patch_size);
+            // dcol = W^T[CKK x OC] * dY[OC x P]
+            CpuOps::gemm(true, false, patch_size, out_pixels, out_channels,
+                         1.0f, weights.getCpuData(), patch_size, grad_out, out_pixels,
+                         0.0f, col_grad_buffer.data(), out_pixels);
+        }
+        else
+        {
+            // dW += dY^T[OC x P] * col^T[P x CKK]
+            CpuOps::gemm(true, true, out_channels, patch_size, out_pixels,
+                         1.0f, grad_out, out_channels, col_buffer.data(), out_pixels,
+                         1.0f, grad_weights.getCpuData(), patch_size);
+            // dcol = W^T[CKK x OC] * dY^T[OC x P]
+            CpuOps::gemm(true, true, patch_size, out_pixels, out_channels,
+                         1.0f, weights.getCpuData(), patch_size, grad_out, out_channels,
+                         0.0f, col_grad_buffer.data(), out_pixels);
+        }
+        col2im(col_grad_buffer.data(), grad_input.getCpuData() + n * grad_input.getCols());
+
+        for(size_t oc = 0; oc < out_channels; oc++)
+        {
+            float sum = 0.0f;
+            for(size_t oy = 0; oy < out_height; oy++)
+            {
+                for(size_t ox = 0; ox < out_width; ox++) { sum += grad_out[outputIndex(oc, oy, ox)]; }
+            }
+            grad_biases.getCpuData()[oc] += sum;
+        }
+    }
+
+    // dW accumulates over the whole batch, so it is only final here
+    if(NumericHealth::collectingGradients())
+    {
+        health.observeGrads(grad_weights.getCpuData(), grad_weights.getSize());
+        health.observeGrads(grad_biases.getCpuData(), grad_biases.getSize());
+    }
+    return grad_input;
+}
+
+
+
+OpCost Conv2D::forwardCost(const Tensor &input) const
+{
+    // Direct-convolution count, so Winograd shows up as a higher effective rate
+    const double b = static_cast<double>(input.getRows());
+    const double outputs = b * static_cast<double>(getOutputSize());
+    const double taps = static_cast<double>(in_channels * kernel_size * kernel_size);
+    return {2.0 * outputs * taps + outputs,
+            (static_cast<double>(input.getSize()) + static_cast<double>(weights.getSize() + biases.getSize()) + outputs) * sizeof(float)};
+}
+
+
+
+OpCost Conv2D::backwardCost(const Tensor &input) const
+{
+    // Weight and input gradients are one convolution each
+    const double b = static_cast<double>(input.getRows());
+    const double outputs = b * static_cast<double>(getOutputSize());
+    const double taps = static_cast<double>(in_channels * kernel_size * kernel_size);
+    const double params = static_cast<double>(weights.getSize() + biases.getSize());
+    return {4.0 * outputs * taps + outputs,
+            (outputs + 2.0 * static_cast<double>(input.getSize()) + static_cast<double>(weights.getSize()) + params) * sizeof(float)};
+}
+
+
+
+void Conv2D::update(Optimizer &optimizer)
+{
+    optimizer.update(weights, grad_weights);
+    optimizer.update(biases, grad_biases);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+
+
+#include "nn/layers/Layer.h"
+#include "nn/nn_types.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <vector>
+
+
+
+// 2D convolution over flattened image rows. Each input row holds one image of
+// in_channels x in_height x in_width values in the given layout, and each
+// output row holds out_channels x out_height x out_width values in the same
+// layout, so Conv2D composes with Dense/Activation without reshaping.
+class Conv2D final : public Layer
+{
+public:
+    Conv2D(size_t in_channels, size_t in_height, size_t in_width, size_t out_channels,
+           size_t kernel_size, size_t stride = 1, size_t padding = 0, DataLayout layout = DataLayout::NCHW);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Conv2D"; }
+    void update(Optimizer & optimizer) override;
+    // He normal by default
+    void initializeParameters(Initializer::Scheme scheme) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return {&weights, &biases}; }
+
+    [[nodiscard]] size_t getOutChannels() const noexcept { return out_channels; }
+    [[nodiscard]] size_t getOutHeight() const noexcept { return out_height; }
+    [[nodiscard]] size_t getOutWidth() const noexcept { return out_width; }
+    [[nodiscard]] size_t getOutputSize() const noexcept { return out_channels * out_height * out_width; }
+    [[nodiscard]] DataLayout getLayout() const noexcept { return layout; }
+
+    // Winograd F(2,3) is used for 3x3/stride-1 forward passes unless disabled
+    void setWinogradEnabled(bool enabled) { winograd_enabled = enabled; }
+    [[nodiscard]] bool usesWinograd() const noexcept;
+
+    Tensor weights; // {out_channels, in_channels * kernel_size * kernel_size}
+    Tensor biases;  // {1, out_channels}
+
+private:
+    // Lower one image into a (C*K*K) x (OH*OW) column matrix
+    void im2col(const float *image, float *col) const;
+    // Scatter-add a column matrix back into one image (adjoint of im2col)
+    void col2im(const float *col, float *image) const;
+
+    void forwardGemm(const Tensor &input, Tensor &output);
+    void forwardWinograd(const Tensor &input, Tensor &output);
+
+    [[nodiscard]] size_t inputIndex(size_t c, size_t y, size_t x) const noexcept;
+    [[nodiscard]] size_t outputIndex(size_t c, size_t y, size_t x) const noexcept;
+
+    size_t in_channels;
+    size_t in_height;
+    size_t in_width;
+    size_t out_channels;
+    size_t kernel_size;
+    size_t stride;
+    size_t padding;
+    size_t out_height;
+    size_t out_width;
+    DataLayout layout;
+    bool winograd_enabled = true;
+
+    Tensor grad_weights;
+    Tensor grad_biases;
+
+    // Scratch reused across steps to keep the hot loop allocation-free
+    std::vector<float> col_buffer;
+    std::vector<float> col_grad_buffer;
+    std::vector<float> winograd_u;
+    std::vector<float> winograd_v;
+    std::vector<float> winograd_m;
+};
@@ -15,14 +15,71 @@
 
 
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace
+{
+    // Bias epilogue of the forward GEMM, folding each output into the
+    // health statistics when they are collected
+    void addBias(Tensor &output, const Tensor &biases, NumericHealth::TensorStats *stats)
+    {
+        const size_t cols = output.getCols();
+        const float *b = biases.getCpuData();
+        for(size_t i = 0; i < output.getRows(); i++)
+        {
+            float *row = output.getCpuData() + i * cols;
+            for(size_t j = 0; j < cols; j++)
+            {
+                row[j] += b[j];
+                if(stats) { stats->observe(row[j]); }
+            }
+        }
+    }
+
+
+
+    // Bias gradient: column sums of dY averaged over the batch
+    void biasGradient(const Tensor &grad_output, Tensor &grad_biases, NumericHealth::LayerStats *stats)
+    {
+        const size_t rows = grad_output.getRows();
+        const size_t cols = grad_output.getCols();
+        const float *g = grad_output.getCpuData();
+        for(size_t j = 0; j < cols; j++)
+        {
+            float sum = 0;
+            for(size_t i = 0; i < rows; i++)
+            {
+                sum += g[i * cols + j];
+            }
+            const float average = sum / rows;
+            grad_biases.getCpuData()[j] = average;
+            if(stats) { stats->observeGrad(average); }
+        }
+    }
+}
 
 
 
 Dense::Dense(size_t input_size, size_t output_size)
     : weights{{input_size, output_size}}, biases{{1, output_size}}, grad_weights{{input_size, output_size}}, grad_biases{{1, output_size}}
 {
-    weights.initializeRandom();
-    biases.initializeRandom();
+    initializeParameters(Initializer::Scheme::XavierUniform);
+}
+
+
+
+void Dense::initializeParameters(Initializer::Scheme scheme)
+{
+    Initializer::fill(weights, scheme, weights.getRows(), weights.getCols());
+    Initializer::fill(biases, Initializer::Scheme::Zeros, 0, 0);
+    if(backendType == Backend::GPU)
+    {
+        weights.freeGpu();
+        biases.freeGpu();
+    }
 }
 
 
@@ -31,6 +88,7 @@ Tensor Dense::forward(const Tensor &input)
 {
     this->last_input = input;
     Tensor output{{input.getRows(), weights.getCols()}};
+    NumericHealth::TensorStats *stats = NumericHealth::collectingActivations() ? &health.output : nullptr;
 
     // Choose the appropriate backend for matrix multiplication
     try
@@ -54,25 +112,13 @@ Tensor Dense::forward(const Tensor &input)
             output.toCpu();
 
             // Apply biases
-            for(size_t i = 0; i < output.getRows(); i++)
-            {
-                for(size_t j = 0; j < output.getCols(); j++)
-                {
-                    output.set(i, j, output.get(i, j) + biases.get(0, j));
-                }
-            }
+            addBias(output, biases, stats);
         }
         else
         {
             // CPU operations - fallback by default
             CpuOps::matmul(input, weights, output);
-            for(size_t i = 0; i < output.getRows(); i++)
-            {
-                for(size_t j = 0; j < output.getCols(); j++)
-                {
-                    output.set(i, j, output.get(i, j) + biases.get(0, j));
-                }
-            }
+            addBias(output, biases, stats);
         }
     }
     catch(const std::exception &e)
@@ -83,13 +129,7 @@ Tensor Dense::forward(const Tensor &input)
         // If GPU operations fail, fall back to CPU
         backendType = Backend::CPU;
         CpuOps::matmul(input, weights, output);
-        for(size_t i = 0; i < output.getRows(); i++)
-        {
-            for(size_t j = 0; j < output.getCols(); j++)
-            {
-                output.set(i, j, output.get(i, j) + biases.get(0, j));
-            }
-        }
+        addBias(output, biases, stats);
     }
 
     this->last_output = output;
@@ -103,6 +143,7 @@ Tensor Dense::backward(const Tensor &grad_output)
     Tensor last_input_T = last_input.transpose();
     Tensor weights_T = weights.transpose();
     Tensor grad_input{{grad_output.getRows(), weights_T.getCols()}};
+    NumericHealth::LayerStats *grad_stats = NumericHealth::collectingGradients() ? &health : nullptr;
 
     try
     {
@@ -126,15 +167,7 @@ Tensor Dense::backward(const Tensor &grad_output)
             grad_weights.toCpu();
 
             // Sum gradients for biases across the batch (CPU for now)
-            for(size_t j = 0; j < grad_output.getCols(); j++)
-            {
-                float sum = 0;
-                for(size_t i = 0; i < grad_output.getRows(); i++)
-                {
-                    sum += grad_output.get(i, j);
-                }
-                grad_biases.set(0, j, sum / grad_output.getRows()); // Average gradient
-            }
+            biasGradient(grad_output, grad_biases, grad_stats);
 
             // Do matrix multiplication for input gradients
             GpuOps::matmul(grad_output, weights_T, grad_input);
@@ -148,15 +181,7 @@ Tensor Dense::backward(const Tensor &grad_output)
             CpuOps::matmul(last_input_T, grad_output, grad_weights);
 
             // Sum gradients for biases across the batch
-            for(size_t j = 0; j < grad_output.getCols(); j++)
-            {
-                float sum = 0;
-                for(size_t i = 0; i < grad_output.getRows(); i++)
-                {
-                    sum += grad_output.get(i, j);
-                }
-                grad_biases.set(0, j, sum / grad_output.getRows()); // Average gradient
-            }
+            biasGradient(grad_output, grad_biases, grad_stats);
 
             CpuOps::matmul(grad_output, weights_T, grad_input);
         }
@@ -172,27 +197,64 @@ Tensor Dense::backward(const Tensor &grad_output)
         CpuOps::matmul(last_input_T, grad_output, grad_weights);
 
         // Sum gradients for biases across the batch
-        for(size_t j = 0; j < grad_output.getCols(); j++)
-        {
-            float sum = 0;
-            for(size_t i = 0; i < grad_output.getRows(); i++)
-            {
-                sum += grad_output.get(i, j);
-            }
-            grad_biases.set(0, j, sum / grad_output.getRows()); // Average gradient
-        }
+        biasGradient(grad_output, grad_biases, grad_stats);
 
         CpuOps::matmul(grad_output, weights_T, grad_input);
     }
 
+    // dW comes out of the GEMM, which has no epilogue hook; this pass is
+    // parameter-sized and only runs while gradients are collected
+    if(grad_stats)
+    {
+        grad_stats->observeGrads(grad_weights.getCpuData(), grad_weights.getSize());
+    }
     return grad_input;
 }
 
 
 
+OpCost Dense::forwardCost(const Tensor &input) const
+{
+    const double b = static_cast<double>(input.getRows());
+    const double in = static_cast<double>(weights.getRows());
+    const double out = static_cast<double>(weights.getCols());
+    return {2.0 * b * in * out + b * out, (b * in + in * out + out + b * out) * sizeof(float)};
+}
+
+
+
+OpCost Dense::backwardCost(const Tensor &input) const
+{
+    // dW = X^T dY, db = column sums of dY, dX = dY W^T
+    const double b = static_cast<double>(input.getRows());
+    const double in = static_cast<double>(weights.getRows());
+    const double out = static_cast<double>(weights.getCols());
+    return {4.0 * b * in * out + b * out, (b * out + b * in + 2.0 * in * out + out + b * in) * sizeof(float)};
+}
+
+
+
+void Dense::setPruningMask(Tensor mask)
+{
+    if(mask.getShape() != weights.getShape())
+    {
+        throw std::invalid_argument("Dense: pruning mask shape does not match the weights");
+    }
+    pruning_mask = std::move(mask);
+}
+
+
+
 void Dense::update(Optimizer &optimizer)
 {
-    optimizer.update(weights, grad_weights);
+    if(isPruned())
+    {
+        optimizer.updateMasked(weights, grad_weights, pruning_mask);
+    }
+    else
+    {
+        optimizer.update(weights, grad_weights);
+    }
     optimizer.update(biases, grad_biases);
     // Ensure GPU copies are refreshed on next forward after CPU updates
     if(backendType == Backend::GPU)
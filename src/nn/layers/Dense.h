@@ -14,16 +14,35 @@ public:
     Dense(size_t input_size, size_t output_size);
     [[nodiscard]] Tensor forward(const Tensor & input) override;
     [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Dense"; }
     void update(Optimizer & optimizer) override;
+    // Xavier uniform by default
+    void initializeParameters(Initializer::Scheme scheme) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return {&weights, &biases, &pruning_mask}; }
 
     void setBackendType(Backend type) { backendType = type; }
     [[nodiscard]] Backend getBackendType() const { return backendType; }
 
+    // Gradients from the last backward; exposed so they can be reduced
+    // across workers before update() applies them
+    [[nodiscard]] Tensor &getGradWeights() noexcept { return grad_weights; }
+    [[nodiscard]] Tensor &getGradBiases() noexcept { return grad_biases; }
+
+    // Pruning mask (1 keeps a weight, 0 pins it to 0) applied by every
+    // update through Optimizer::updateMasked; empty when not pruned
+    void setPruningMask(Tensor mask);
+    void clearPruningMask() { pruning_mask = Tensor{}; }
+    [[nodiscard]] const Tensor &getPruningMask() const noexcept { return pruning_mask; }
+    [[nodiscard]] bool isPruned() const noexcept { return pruning_mask.getSize() != 0; }
+
     Tensor weights;
     Tensor biases;
 
 private:
     Tensor grad_weights;
     Tensor grad_biases;
+    Tensor pruning_mask;
     Backend backendType = Backend::CPU;
 };
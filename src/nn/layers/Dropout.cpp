@@ -0,0 +1,117 @@
+#include "nn/layers/Dropout.h"
+
+
+
+#include "nn/Initializer.h"
+#include "nn/Philox.h"
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+
+
+Dropout::Dropout(float rate, std::uint64_t seed) : rate{rate}, seed{seed}
+{
+    if((rate < 0.0f) || (rate >= 1.0f))
+    {
+        throw std::invalid_argument("Dropout rate must be in [0, 1).");
+    }
+    if(this->seed == 0)
+    {
+        this->seed = Initializer::deriveSeed(); // reproducible under Initializer::setSeed
+    }
+}
+
+
+
+Tensor Dropout::forward(const Tensor &input)
+{
+    if(isIdentity())
+    {
+        return input;
+    }
+
+    const size_t n = input.getSize();
+    const std::uint32_t threshold = static_cast<std::uint32_t>(std::min(static_cast<double>(rate) * 4294967296.0, 4294967295.0));
+    const float scale = 1.0f / (1.0f - rate);
+    const float *x = input.getCpuData();
+    Tensor output{input.getShape()};
+    float *y = output.getCpuData();
+
+    mask_elements = n;
+    mask.resize((n + 63) / 64);
+    std::uint32_t random_bits[64];
+
+    // One 64-bit mask word per 64 elements; each element's draw is value
+    // (word * 64 + bit) of the stream for this step
+    for(size_t w = 0; w < mask.size(); w++)
+    {
+        const size_t base = w * 64;
+        const size_t count = std::min<size_t>(64, n - base);
+        Philox::fill(random_bits, count, base, step, seed);
+
+        std::uint64_t bits = 0;
+        for(size_t b = 0; b < count; b++)
+        {
+            const bool keep = random_bits[b] >= threshold;
+            bits |= static_cast<std::uint64_t>(keep) << b;
+            y[base + b] = keep ? x[base + b] * scale : 0.0f;
+        }
+        mask[w] = bits;
+    }
+    step++;
+
+    return output;
+}
+
+
+
+Tensor Dropout::backward(const Tensor &grad_output)
+{
+    if(isIdentity())
+    {
+        return grad_output;
+    }
+    if(grad_output.getSize() != mask_elements)
+    {
+        throw std::invalid_argument("Dropout backward gradient does not match the last forward.");
+    }
+
+    const float scale = 1.0f / (1.0f - rate);
+    const float *dy = grad_output.getCpuData();
+    Tensor grad_input{grad_output.getShape()};
+    float *dx = grad_input.getCpuData();
+
+    for(size_t w = 0; w < mask.size(); w++)
+    {
+        const size_t base = w * 64;
+        const size_t count = std::min<size_t>(64, mask_elements - base);
+        const std::uint64_t bits = mask[w];
+        for(size_t b = 0; b < count; b++)
+        {
+            dx[base + b] = ((bits >> b) & 1u) ? dy[base + b] * scale : 0.0f;
+        }
+    }
+
+    return grad_input;
+}
+
+
+
+OpCost Dropout::forwardCost(const Tensor &input) const
+{
+    // Mask generation is counted as one operation per element; the mask is
+    // written as one bit per element
+    const double n = static_cast<double>(input.getSize());
+    return {2.0 * n, 2.0 * n * sizeof(float) + n / 8.0};
+}
+
+
+
+OpCost Dropout::backwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {n, 2.0 * n * sizeof(float) + n / 8.0};
+}
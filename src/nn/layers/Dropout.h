@@ -0,0 +1,37 @@
+#pragma once
+
+
+
+#include "nn/layers/Layer.h"
+
+
+
+#include <cstdint>
+#include <vector>
+
+
+
+// Inverted dropout. Masks come from a counter-based Philox stream indexed by
+// (step, element), and are kept bit-packed (1 bit per element) for backward.
+// In inference mode the layer is an identity that Model::forward skips.
+class Dropout final : public Layer
+{
+public:
+    explicit Dropout(float rate, std::uint64_t seed = 0);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] bool isIdentity() const noexcept override { return (!training) || (rate <= 0.0f); }
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Dropout"; }
+
+    [[nodiscard]] float getRate() const noexcept { return rate; }
+    [[nodiscard]] size_t getMaskBytes() const noexcept { return mask.size() * sizeof(std::uint64_t); }
+
+private:
+    float rate;
+    std::uint64_t seed;
+    std::uint64_t step = 0;
+    size_t mask_elements = 0;
+    std::vector<std::uint64_t> mask;
+};
@@ -0,0 +1,159 @@
+#include "nn/layers/Embedding.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+
+namespace
+{
+    // splitmix64 finalizer: cheap and well mixed for integer ids
+    std::uint64_t mixId(std::uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+}
+
+
+
+Embedding::Embedding(size_t vocab_size, size_t embedding_dim, size_t hash_buckets)
+    : vocab_size{vocab_size}, embedding_dim{embedding_dim}, hash_buckets{hash_buckets}
+{
+    const size_t rows = (hash_buckets > 0) ? hash_buckets : vocab_size;
+    if((rows == 0) || (embedding_dim == 0))
+    {
+        throw std::invalid_argument("Embedding requires a non-empty table.");
+    }
+    weights = Tensor{{rows, embedding_dim}};
+    initializeParameters(Initializer::Scheme::Normal);
+    slot_of_row.assign(rows, -1);
+}
+
+
+
+void Embedding::initializeParameters(Initializer::Scheme scheme)
+{
+    Initializer::fill(weights, scheme, embedding_dim, embedding_dim);
+}
+
+
+
+size_t Embedding::rowFor(float id) const
+{
+    if((id < 0.0f) || (std::floor(id) != id))
+    {
+        throw std::out_of_range("Embedding token id must be a non-negative integer.");
+    }
+    const auto token = static_cast<std::uint64_t>(id);
+    if(hash_buckets > 0)
+    {
+        return static_cast<size_t>(mixId(token) % hash_buckets);
+    }
+    if(token >= vocab_size)
+    {
+        throw std::out_of_range("Embedding token id exceeds vocab_size.");
+    }
+    return static_cast<size_t>(token);
+}
+
+
+
+Tensor Embedding::forward(const Tensor &input)
+{
+    const size_t batch = input.getRows();
+    const size_t sequence_length = input.getCols();
+    Tensor output{{batch, sequence_length * embedding_dim}};
+    last_rows.resize(input.getSize());
+
+    for(size_t i = 0; i < input.getSize(); i++)
+    {
+        const size_t row = rowFor(input.getCpuData()[i]);
+        last_rows[i] = row;
+        const float *src = weights.getCpuData() + row * embedding_dim;
+        std::copy(src, src + embedding_dim, output.getCpuData() + i * embedding_dim);
+    }
+
+    // Only the resolved rows are needed for backward, not a copy of the input
+    last_input_shape = input.getShape();
+    return output;
+}
+
+
+
+Tensor Embedding::backward(const Tensor &grad_output)
+{
+    if(grad_output.getSize() != last_rows.size() * embedding_dim)
+    {
+        throw std::invalid_argument("Embedding backward gradient does not match the last forward.");
+    }
+
+    // Reset the row->slot map for rows touched by the previous step only
+    for(size_t row : touched_rows) { slot_of_row[row] = -1; }
+    touched_rows.clear();
+    for(size_t row : last_rows)
+    {
+        if(slot_of_row[row] < 0)
+        {
+            slot_of_row[row] = static_cast<std::int64_t>(touched_rows.size());
+            touched_rows.push_back(row);
+        }
+    }
+
+    // Sum the gradients of repeated tokens into one row each
+    if(grad_rows.getRows() != touched_rows.size())
+    {
+        grad_rows = Tensor{{touched_rows.size(), embedding_dim}};
+    }
+    std::fill(grad_rows.getCpuData(), grad_rows.getCpuData() + grad_rows.getSize(), 0.0f);
+    for(size_t i = 0; i < last_rows.size(); i++)
+    {
+        float *dst = grad_rows.getCpuData() + static_cast<size_t>(slot_of_row[last_rows[i]]) * embedding_dim;
+        const float *src = grad_output.getCpuData() + i * embedding_dim;
+        for(size_t j = 0; j < embedding_dim; j++) { dst[j] += src[j]; }
+    }
+    if(NumericHealth::collectingGradients())
+    {
+        health.observeGrads(grad_rows.getCpuData(), grad_rows.getSize());
+    }
+
+    // Token ids are not differentiable; hand back zeros of the input shape
+    Tensor grad_input{last_input_shape};
+    std::fill(grad_input.getCpuData(), grad_input.getCpuData() + grad_input.getSize(), 0.0f);
+    return grad_input;
+}
+
+
+
+OpCost Embedding::forwardCost(const Tensor &input) const
+{
+    // Pure gather: reads ids and table rows, writes the output
+    const double tokens = static_cast<double>(input.getSize());
+    return {0.0, (tokens + 2.0 * tokens * static_cast<double>(embedding_dim)) * sizeof(float)};
+}
+
+
+
+OpCost Embedding::backwardCost(const Tensor &input) const
+{
+    // Accumulates each token's gradient row into its table row
+    const double tokens = static_cast<double>(input.getSize());
+    const double values = tokens * static_cast<double>(embedding_dim);
+    return {values, 3.0 * values * sizeof(float)};
+}
+
+
+
+void Embedding::update(Optimizer &optimizer)
+{
+    if(touched_rows.empty())
+    {
+        return;
+    }
+    optimizer.updateRows(weights, touched_rows, grad_rows);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+
+
+#include "nn/layers/Layer.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <cstdint>
+#include <vector>
+
+
+
+// Token-id lookup table. Input is {batch, sequence_length} holding integer ids
+// stored as floats; output is {batch, sequence_length * embedding_dim}.
+// Backward produces a row-sparse gradient (only the rows seen in the batch)
+// which update() hands to Optimizer::updateRows.
+class Embedding final : public Layer
+{
+public:
+    // hash_buckets > 0 maps arbitrary ids into that many rows (the hashing
+    // trick) instead of requiring ids < vocab_size
+    Embedding(size_t vocab_size, size_t embedding_dim, size_t hash_buckets = 0);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Embedding"; }
+    void update(Optimizer & optimizer) override;
+    // N(0, 0.01) by default; fan-based schemes use embedding_dim for both fans
+    void initializeParameters(Initializer::Scheme scheme) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return {&weights}; }
+
+    [[nodiscard]] size_t getEmbeddingDim() const noexcept { return embedding_dim; }
+    [[nodiscard]] size_t getTouchedRowCount() const noexcept { return touched_rows.size(); }
+
+    Tensor weights; // {rows, embedding_dim}
+
+private:
+    [[nodiscard]] size_t rowFor(float id) const;
+
+    size_t vocab_size;
+    size_t embedding_dim;
+    size_t hash_buckets;
+
+    std::vector<size_t> last_input_shape;
+    std::vector<size_t> last_rows;     // table row per input token
+    std::vector<size_t> touched_rows;  // unique rows in the last batch
+    Tensor grad_rows;                  // {touched_rows.size(), embedding_dim}
+    std::vector<std::int64_t> slot_of_row; // row -> index into touched_rows, -1 if untouched
+};
@@ -1 +1,18 @@
 #include "nn/layers/Layer.h"
+
+
+
+OpCost Layer::forwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {n, 2.0 * n * sizeof(float)};
+}
+
+
+
+OpCost Layer::backwardCost(const Tensor &input) const
+{
+    // Reads the output gradient and the saved activation, writes the input gradient
+    const double n = static_cast<double>(input.getSize());
+    return {n, 3.0 * n * sizeof(float)};
+}
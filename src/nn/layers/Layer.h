@@ -2,7 +2,14 @@
 
 
 
+#include "nn/Initializer.h"
+#include "nn/NumericHealth.h"
 #include "nn/Tensor.h"
+#include "nn/nn_types.h"
+
+
+
+#include <vector>
 
 
 
@@ -15,7 +22,38 @@ public:
     virtual void update(class Optimizer &optimizer) {}
     [[nodiscard]] const Tensor &getLastOutput() const { return last_output; }
 
+    // Layers that behave differently at inference time (normalization,
+    // regularization) check this flag; Model toggles it for evaluation
+    virtual void setTraining(bool is_training) { training = is_training; }
+    [[nodiscard]] bool isTraining() const noexcept { return training; }
+
+    // True when forward/backward currently pass tensors through unchanged,
+    // which lets Model skip the layer instead of copying
+    [[nodiscard]] virtual bool isIdentity() const noexcept { return false; }
+
+    // Analytic FLOPs and bytes of forward/backward for this input, for the
+    // roofline report. The default models a one-operation elementwise layer.
+    [[nodiscard]] virtual OpCost forwardCost(const Tensor &input) const;
+    [[nodiscard]] virtual OpCost backwardCost(const Tensor &input) const;
+    [[nodiscard]] virtual const char *getTypeName() const noexcept { return "Layer"; }
+
+    // Refills the weights with scheme, using fans from the layer's shape, and
+    // zeroes the biases. Constructors apply each layer's default scheme;
+    // layers without parameters ignore it.
+    virtual void initializeParameters(Initializer::Scheme scheme) {}
+
+    // Tensors that training changes (parameters, running statistics, masks)
+    // in a fixed order, so Model::snapshot can copy and restore them
+    [[nodiscard]] virtual std::vector<Tensor *> getStateTensors() { return {}; }
+
+    // Statistics gathered by the last forward/backward run under
+    // NumericHealth::Collect; layers without hooks leave them empty
+    [[nodiscard]] const NumericHealth::LayerStats &getHealth() const noexcept { return health; }
+    void resetHealth() noexcept { health = {}; }
+
 protected:
     Tensor last_input;
     Tensor last_output;
+    bool training = true;
+    NumericHealth::LayerStats health;
 };
@@ -0,0 +1,331 @@
+#include "nn/layers/Normalization.h"
+
+
+
+#include "nn/layers/Dense.h"
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+
+// --- BatchNorm1d ---
+
+BatchNorm1d::BatchNorm1d(size_t num_features, float momentum, float epsilon)
+    : gamma{{1, num_features}}, beta{{1, num_features}}, running_mean{{1, num_features}}, running_var{{1, num_features}},
+      num_features{num_features}, momentum{momentum}, epsilon{epsilon},
+      grad_gamma{{1, num_features}}, grad_beta{{1, num_features}}
+{
+    std::fill(gamma.getCpuData(), gamma.getCpuData() + num_features, 1.0f);
+    std::fill(beta.getCpuData(), beta.getCpuData() + num_features, 0.0f);
+    std::fill(running_mean.getCpuData(), running_mean.getCpuData() + num_features, 0.0f);
+    std::fill(running_var.getCpuData(), running_var.getCpuData() + num_features, 1.0f);
+}
+
+
+
+Tensor BatchNorm1d::forward(const Tensor &input)
+{
+    if(input.getCols() != num_features)
+    {
+        throw std::invalid_argument("BatchNorm1d input width does not match num_features.");
+    }
+    const size_t batch = input.getRows();
+    const float *x = input.getCpuData();
+    const float *g = gamma.getCpuData();
+    const float *b = beta.getCpuData();
+    Tensor output{input.getShape()};
+    float *y = output.getCpuData();
+
+    if(!training)
+    {
+        const float *rm = running_mean.getCpuData();
+        const float *rv = running_var.getCpuData();
+        for(size_t i = 0; i < batch; i++)
+        {
+            for(size_t j = 0; j < num_features; j++)
+            {
+                y[i * num_features + j] = (x[i * num_features + j] - rm[j]) / std::sqrt(rv[j] + epsilon) * g[j] + b[j];
+            }
+        }
+        return output;
+    }
+
+    // Welford's update over rows yields mean and variance in a single sweep;
+    // walking rows keeps the per-feature accumulators unit-stride.
+    std::vector<float> mean(num_features, 0.0f);
+    std::vector<float> m2(num_features, 0.0f);
+    for(size_t i = 0; i < batch; i++)
+    {
+        const float inv_count = 1.0f / static_cast<float>(i + 1);
+        const float *row = x + i * num_features;
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const float delta = row[j] - mean[j];
+            mean[j] += delta * inv_count;
+            m2[j] += delta * (row[j] - mean[j]);
+        }
+    }
+
+    inv_std.resize(num_features);
+    float *rm = running_mean.getCpuData();
+    float *rv = running_var.getCpuData();
+    for(size_t j = 0; j < num_features; j++)
+    {
+        const float var = m2[j] / static_cast<float>(batch);
+        inv_std[j] = 1.0f / std::sqrt(var + epsilon);
+        const float unbiased = (batch > 1) ? m2[j] / static_cast<float>(batch - 1) : var;
+        rm[j] = (1.0f - momentum) * rm[j] + momentum * mean[j];
+        rv[j] = (1.0f - momentum) * rv[j] + momentum * unbiased;
+    }
+
+    if(x_hat.getShape() != input.getShape())
+    {
+        x_hat = Tensor{input.getShape()};
+    }
+    float *xh = x_hat.getCpuData();
+    for(size_t i = 0; i < batch; i++)
+    {
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const size_t k = i * num_features + j;
+            xh[k] = (x[k] - mean[j]) * inv_std[j];
+            y[k] = xh[k] * g[j] + b[j];
+        }
+    }
+
+    return output;
+}
+
+
+
+Tensor BatchNorm1d::backward(const Tensor &grad_output)
+{
+    if(grad_output.getShape() != x_hat.getShape())
+    {
+        throw std::invalid_argument("BatchNorm1d backward requires a preceding training-mode forward of the same shape.");
+    }
+    const size_t batch = grad_output.getRows();
+    const float *dy = grad_output.getCpuData();
+    const float *xh = x_hat.getCpuData();
+    const float *g = gamma.getCpuData();
+    float *dgamma = grad_gamma.getCpuData();
+    float *dbeta = grad_beta.getCpuData();
+    std::fill(dgamma, dgamma + num_features, 0.0f);
+    std::fill(dbeta, dbeta + num_features, 0.0f);
+
+    // One pass for both reductions; they are exactly dgamma and dbeta
+    for(size_t i = 0; i < batch; i++)
+    {
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const size_t k = i * num_features + j;
+            dbeta[j] += dy[k];
+            dgamma[j] += dy[k] * xh[k];
+        }
+    }
+
+    Tensor grad_input{grad_output.getShape()};
+    float *dx = grad_input.getCpuData();
+    const float n = static_cast<float>(batch);
+    for(size_t i = 0; i < batch; i++)
+    {
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const size_t k = i * num_features + j;
+            dx[k] = g[j] * inv_std[j] / n * (n * dy[k] - dbeta[j] - xh[k] * dgamma[j]);
+        }
+    }
+
+    if(NumericHealth::collectingGradients())
+    {
+        health.observeGrads(dgamma, num_features);
+        health.observeGrads(dbeta, num_features);
+    }
+    return grad_input;
+}
+
+
+
+OpCost BatchNorm1d::forwardCost(const Tensor &input) const
+{
+    // Mean and variance passes, then normalize, scale and shift
+    const double n = static_cast<double>(input.getSize());
+    return {7.0 * n, 4.0 * n * sizeof(float)};
+}
+
+
+
+OpCost BatchNorm1d::backwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {9.0 * n, 4.0 * n * sizeof(float)};
+}
+
+
+
+void BatchNorm1d::update(Optimizer &optimizer)
+{
+    optimizer.update(gamma, grad_gamma);
+    optimizer.update(beta, grad_beta);
+}
+
+
+
+void BatchNorm1d::foldInto(Dense &dense) const
+{
+    if(dense.weights.getCols() != num_features)
+    {
+        throw std::invalid_argument("BatchNorm1d::foldInto: Dense output width does not match num_features.");
+    }
+
+    // y = gamma * (xW + b - mean) / sqrt(var + eps) + beta
+    //   = x (W * s) + ((b - mean) * s + beta),  s = gamma / sqrt(var + eps)
+    const size_t rows = dense.weights.getRows();
+    float *w = dense.weights.getCpuData();
+    float *b = dense.biases.getCpuData();
+    for(size_t j = 0; j < num_features; j++)
+    {
+        const float scale = gamma.getCpuData()[j] / std::sqrt(running_var.getCpuData()[j] + epsilon);
+        for(size_t r = 0; r < rows; r++)
+        {
+            w[r * num_features + j] *= scale;
+        }
+        b[j] = (b[j] - running_mean.getCpuData()[j]) * scale + beta.getCpuData()[j];
+    }
+    // Force the GPU copies to be refreshed on the next forward
+    dense.weights.freeGpu();
+    dense.biases.freeGpu();
+}
+
+
+
+// --- LayerNorm ---
+
+LayerNorm::LayerNorm(size_t num_features, float epsilon)
+    : gamma{{1, num_features}}, beta{{1, num_features}}, num_features{num_features}, epsilon{epsilon},
+      grad_gamma{{1, num_features}}, grad_beta{{1, num_features}}
+{
+    std::fill(gamma.getCpuData(), gamma.getCpuData() + num_features, 1.0f);
+    std::fill(beta.getCpuData(), beta.getCpuData() + num_features, 0.0f);
+}
+
+
+
+Tensor LayerNorm::forward(const Tensor &input)
+{
+    if(input.getCols() != num_features)
+    {
+        throw std::invalid_argument("LayerNorm input width does not match num_features.");
+    }
+    const size_t batch = input.getRows();
+    const float *g = gamma.getCpuData();
+    const float *b = beta.getCpuData();
+    Tensor output{input.getShape()};
+    if(x_hat.getShape() != input.getShape())
+    {
+        x_hat = Tensor{input.getShape()};
+    }
+    inv_std.resize(batch);
+
+    for(size_t i = 0; i < batch; i++)
+    {
+        const float *x = input.getCpuData() + i * num_features;
+        float *xh = x_hat.getCpuData() + i * num_features;
+        float *y = output.getCpuData() + i * num_features;
+
+        float mean = 0.0f;
+        float m2 = 0.0f;
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const float delta = x[j] - mean;
+            mean += delta / static_cast<float>(j + 1);
+            m2 += delta * (x[j] - mean);
+        }
+        const float istd = 1.0f / std::sqrt(m2 / static_cast<float>(num_features) + epsilon);
+        inv_std[i] = istd;
+
+        for(size_t j = 0; j < num_features; j++)
+        {
+            xh[j] = (x[j] - mean) * istd;
+            y[j] = xh[j] * g[j] + b[j];
+        }
+    }
+
+    return output;
+}
+
+
+
+Tensor LayerNorm::backward(const Tensor &grad_output)
+{
+    if(grad_output.getShape() != x_hat.getShape())
+    {
+        throw std::invalid_argument("LayerNorm backward requires a preceding forward of the same shape.");
+    }
+    const size_t batch = grad_output.getRows();
+    const float *g = gamma.getCpuData();
+    float *dgamma = grad_gamma.getCpuData();
+    float *dbeta = grad_beta.getCpuData();
+    std::fill(dgamma, dgamma + num_features, 0.0f);
+    std::fill(dbeta, dbeta + num_features, 0.0f);
+    Tensor grad_input{grad_output.getShape()};
+    const float d = static_cast<float>(num_features);
+
+    for(size_t i = 0; i < batch; i++)
+    {
+        const float *dy = grad_output.getCpuData() + i * num_features;
+        const float *xh = x_hat.getCpuData() + i * num_features;
+        float *dx = grad_input.getCpuData() + i * num_features;
+
+        // Parameter gradients and both row reductions in one pass
+        float sum_g = 0.0f;
+        float sum_g_xh = 0.0f;
+        for(size_t j = 0; j < num_features; j++)
+        {
+            const float gj = dy[j] * g[j];
+            sum_g += gj;
+            sum_g_xh += gj * xh[j];
+            dgamma[j] += dy[j] * xh[j];
+            dbeta[j] += dy[j];
+        }
+        for(size_t j = 0; j < num_features; j++)
+        {
+            dx[j] = inv_std[i] / d * (d * dy[j] * g[j] - sum_g - xh[j] * sum_g_xh);
+        }
+    }
+
+    if(NumericHealth::collectingGradients())
+    {
+        health.observeGrads(dgamma, num_features);
+        health.observeGrads(dbeta, num_features);
+    }
+    return grad_input;
+}
+
+
+
+OpCost LayerNorm::forwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {7.0 * n, 4.0 * n * sizeof(float)};
+}
+
+
+
+OpCost LayerNorm::backwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {9.0 * n, 4.0 * n * sizeof(float)};
+}
+
+
+
+void LayerNorm::update(Optimizer &optimizer)
+{
+    optimizer.update(gamma, grad_gamma);
+    optimizer.update(beta, grad_beta);
+}
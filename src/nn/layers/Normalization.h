@@ -0,0 +1,83 @@
+#pragma once
+
+
+
+#include "nn/layers/Layer.h"
+#include "nn/optimizers/Optimizer.h"
+
+
+
+#include <vector>
+
+
+
+class Dense;
+
+
+
+// Batch normalization over the rows of a {batch, features} tensor. Training
+// uses batch statistics and updates running estimates; inference uses the
+// running estimates, which foldInto bakes into a preceding Dense (see
+// Model::foldBatchNorm and inference ExecutionPlans).
+class BatchNorm1d final : public Layer
+{
+public:
+    BatchNorm1d(size_t num_features, float momentum = 0.1f, float epsilon = 1e-5f);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "BatchNorm1d"; }
+    void update(Optimizer & optimizer) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return {&gamma, &beta, &running_mean, &running_var}; }
+
+    [[nodiscard]] size_t getNumFeatures() const noexcept { return num_features; }
+    [[nodiscard]] float getEpsilon() const noexcept { return epsilon; }
+
+    // Rewrites dense, whose output feeds this layer, so it produces what the
+    // pair computes at inference time
+    void foldInto(Dense &dense) const;
+
+    Tensor gamma;        // {1, features}
+    Tensor beta;         // {1, features}
+    Tensor running_mean; // {1, features}
+    Tensor running_var;  // {1, features}
+
+private:
+    size_t num_features;
+    float momentum;
+    float epsilon;
+
+    Tensor grad_gamma;
+    Tensor grad_beta;
+    Tensor x_hat;               // normalized input saved for backward
+    std::vector<float> inv_std; // per feature, from the last training batch
+};
+
+
+
+// Layer normalization over the features of each row independently
+class LayerNorm final : public Layer
+{
+public:
+    LayerNorm(size_t num_features, float epsilon = 1e-5f);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "LayerNorm"; }
+    void update(Optimizer & optimizer) override;
+    [[nodiscard]] std::vector<Tensor *> getStateTensors() override { return {&gamma, &beta}; }
+
+    Tensor gamma; // {1, features}
+    Tensor beta;  // {1, features}
+
+private:
+    size_t num_features;
+    float epsilon;
+
+    Tensor grad_gamma;
+    Tensor grad_beta;
+    Tensor x_hat;
+    std::vector<float> inv_std; // per row
+};
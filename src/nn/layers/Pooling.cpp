@@ -0,0 +1,425 @@
+#include "nn/layers/Pooling.h"
+
+
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+
+namespace
+{
+    size_t pooledExtent(size_t in_extent, size_t pool_size, size_t stride)
+    {
+        if((pool_size == 0) || (stride == 0) || (in_extent < pool_size))
+        {
+            throw std::invalid_argument("Pooling window does not fit the input.");
+        }
+        return (in_extent - pool_size) / stride + 1;
+    }
+}
+
+
+
+// --- MaxPool2D ---
+
+MaxPool2D::MaxPool2D(size_t channels, size_t in_height, size_t in_width, size_t pool_size, size_t stride, DataLayout layout)
+    : channels{channels}, in_height{in_height}, in_width{in_width}, pool_size{pool_size},
+      stride{(stride == 0) ? pool_size : stride}, out_height{0}, out_width{0}, layout{layout}
+{
+    if((pool_size * pool_size) > 256)
+    {
+        throw std::invalid_argument("MaxPool2D window must have at most 256 elements.");
+    }
+    out_height = pooledExtent(in_height, pool_size, this->stride);
+    out_width = pooledExtent(in_width, pool_size, this->stride);
+}
+
+
+
+Tensor MaxPool2D::forward(const Tensor &input)
+{
+    if(input.getCols() != channels * in_height * in_width)
+    {
+        throw std::invalid_argument("MaxPool2D input width does not match channels * in_height * in_width.");
+    }
+    const size_t batch = input.getRows();
+    Tensor output{{batch, getOutputSize()}};
+    argmax.resize(batch * getOutputSize());
+    last_batch = batch;
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *image = input.getCpuData() + n * input.getCols();
+        float *out = output.getCpuData() + n * output.getCols();
+        std::uint8_t *arg = argmax.data() + n * output.getCols();
+
+        if(layout == DataLayout::NHWC)
+        {
+            // Channels are contiguous: each window step is a unit-stride
+            // compare/select across all channels of one pixel
+            for(size_t oy = 0; oy < out_height; oy++)
+            {
+                for(size_t ox = 0; ox < out_width; ox++)
+                {
+                    float *best = out + (oy * out_width + ox) * channels;
+                    std::uint8_t *best_idx = arg + (oy * out_width + ox) * channels;
+                    std::fill(best, best + channels, -std::numeric_limits<float>::infinity());
+                    std::fill(best_idx, best_idx + channels, static_cast<std::uint8_t>(0));
+                    for(size_t ky = 0; ky < pool_size; ky++)
+                    {
+                        for(size_t kx = 0; kx < pool_size; kx++)
+                        {
+                            const float *pixel = image + ((oy * stride + ky) * in_width + (ox * stride + kx)) * channels;
+                            const std::uint8_t k = static_cast<std::uint8_t>(ky * pool_size + kx);
+                            for(size_t c = 0; c < channels; c++)
+                            {
+                                const bool greater = pixel[c] > best[c];
+                                best[c] = greater ? pixel[c] : best[c];
+                                best_idx[c] = greater ? k : best_idx[c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                const float *plane = image + c * in_height * in_width;
+                for(size_t oy = 0; oy < out_height; oy++)
+                {
+                    for(size_t ox = 0; ox < out_width; ox++)
+                    {
+                        float best = -std::numeric_limits<float>::infinity();
+                        std::uint8_t best_idx = 0;
+                        for(size_t ky = 0; ky < pool_size; ky++)
+                        {
+                            const float *row = plane + (oy * stride + ky) * in_width + ox * stride;
+                            for(size_t kx = 0; kx < pool_size; kx++)
+                            {
+                                if(row[kx] > best)
+                                {
+                                    best = row[kx];
+                                    best_idx = static_cast<std::uint8_t>(ky * pool_size + kx);
+                                }
+                            }
+                        }
+                        const size_t o = (c * out_height + oy) * out_width + ox;
+                        out[o] = best;
+                        arg[o] = best_idx;
+                    }
+                }
+            }
+        }
+    }
+
+    return output;
+}
+
+
+
+Tensor MaxPool2D::backward(const Tensor &grad_output)
+{
+    if((grad_output.getRows() != last_batch) || (grad_output.getCols() != getOutputSize()))
+    {
+        throw std::invalid_argument("MaxPool2D backward called with a gradient that does not match the last forward.");
+    }
+    const size_t batch = grad_output.getRows();
+    Tensor grad_input{{batch, channels * in_height * in_width}};
+    std::fill(grad_input.getCpuData(), grad_input.getCpuData() + grad_input.getSize(), 0.0f);
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *grad_out = grad_output.getCpuData() + n * grad_output.getCols();
+        const std::uint8_t *arg = argmax.data() + n * grad_output.getCols();
+        float *grad_in = grad_input.getCpuData() + n * grad_input.getCols();
+
+        for(size_t oy = 0; oy < out_height; oy++)
+        {
+            for(size_t ox = 0; ox < out_width; ox++)
+            {
+                for(size_t c = 0; c < channels; c++)
+                {
+                    const size_t o = (layout == DataLayout::NHWC) ? (oy * out_width + ox) * channels + c : (c * out_height + oy) * out_width + ox;
+                    const size_t iy = oy * stride + arg[o] / pool_size;
+                    const size_t ix = ox * stride + arg[o] % pool_size;
+                    const size_t i = (layout == DataLayout::NHWC) ? (iy * in_width + ix) * channels + c : (c * in_height + iy) * in_width + ix;
+                    grad_in[i] += grad_out[o];
+                }
+            }
+        }
+    }
+
+    return grad_input;
+}
+
+
+
+OpCost MaxPool2D::forwardCost(const Tensor &input) const
+{
+    const double outputs = static_cast<double>(input.getRows() * getOutputSize());
+    return {outputs * static_cast<double>(pool_size * pool_size), (static_cast<double>(input.getSize()) + outputs) * sizeof(float)};
+}
+
+
+
+OpCost MaxPool2D::backwardCost(const Tensor &input) const
+{
+    // Scatters each output gradient to its recorded argmax (one byte each)
+    const double outputs = static_cast<double>(input.getRows() * getOutputSize());
+    return {outputs, (static_cast<double>(input.getSize()) + outputs) * sizeof(float) + outputs * sizeof(std::uint8_t)};
+}
+
+
+
+// --- AvgPool2D ---
+
+AvgPool2D::AvgPool2D(size_t channels, size_t in_height, size_t in_width, size_t pool_size, size_t stride, DataLayout layout)
+    : channels{channels}, in_height{in_height}, in_width{in_width}, pool_size{pool_size},
+      stride{(stride == 0) ? pool_size : stride}, out_height{0}, out_width{0}, layout{layout}
+{
+    out_height = pooledExtent(in_height, pool_size, this->stride);
+    out_width = pooledExtent(in_width, pool_size, this->stride);
+}
+
+
+
+Tensor AvgPool2D::forward(const Tensor &input)
+{
+    if(input.getCols() != channels * in_height * in_width)
+    {
+        throw std::invalid_argument("AvgPool2D input width does not match channels * in_height * in_width.");
+    }
+    const size_t batch = input.getRows();
+    const float scale = 1.0f / static_cast<float>(pool_size * pool_size);
+    Tensor output{{batch, getOutputSize()}};
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *image = input.getCpuData() + n * input.getCols();
+        float *out = output.getCpuData() + n * output.getCols();
+
+        if(layout == DataLayout::NHWC)
+        {
+            for(size_t oy = 0; oy < out_height; oy++)
+            {
+                for(size_t ox = 0; ox < out_width; ox++)
+                {
+                    float *acc = out + (oy * out_width + ox) * channels;
+                    std::fill(acc, acc + channels, 0.0f);
+                    for(size_t ky = 0; ky < pool_size; ky++)
+                    {
+                        for(size_t kx = 0; kx < pool_size; kx++)
+                        {
+                            const float *pixel = image + ((oy * stride + ky) * in_width + (ox * stride + kx)) * channels;
+                            for(size_t c = 0; c < channels; c++) { acc[c] += pixel[c]; }
+                        }
+                    }
+                    for(size_t c = 0; c < channels; c++) { acc[c] *= scale; }
+                }
+            }
+        }
+        else
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                const float *plane = image + c * in_height * in_width;
+                for(size_t oy = 0; oy < out_height; oy++)
+                {
+                    for(size_t ox = 0; ox < out_width; ox++)
+                    {
+                        float sum = 0.0f;
+                        for(size_t ky = 0; ky < pool_size; ky++)
+                        {
+                            const float *row = plane + (oy * stride + ky) * in_width + ox * stride;
+                            for(size_t kx = 0; kx < pool_size; kx++) { sum += row[kx]; }
+                        }
+                        out[(c * out_height + oy) * out_width + ox] = sum * scale;
+                    }
+                }
+            }
+        }
+    }
+
+    return output;
+}
+
+
+
+Tensor AvgPool2D::backward(const Tensor &grad_output)
+{
+    const size_t batch = grad_output.getRows();
+    const float scale = 1.0f / static_cast<float>(pool_size * pool_size);
+    Tensor grad_input{{batch, channels * in_height * in_width}};
+    std::fill(grad_input.getCpuData(), grad_input.getCpuData() + grad_input.getSize(), 0.0f);
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *grad_out = grad_output.getCpuData() + n * grad_output.getCols();
+        float *grad_in = grad_input.getCpuData() + n * grad_input.getCols();
+
+        if(layout == DataLayout::NHWC)
+        {
+            for(size_t oy = 0; oy < out_height; oy++)
+            {
+                for(size_t ox = 0; ox < out_width; ox++)
+                {
+                    const float *g = grad_out + (oy * out_width + ox) * channels;
+                    for(size_t ky = 0; ky < pool_size; ky++)
+                    {
+                        for(size_t kx = 0; kx < pool_size; kx++)
+                        {
+                            float *pixel = grad_in + ((oy * stride + ky) * in_width + (ox * stride + kx)) * channels;
+                            for(size_t c = 0; c < channels; c++) { pixel[c] += g[c] * scale; }
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                float *plane = grad_in + c * in_height * in_width;
+                for(size_t oy = 0; oy < out_height; oy++)
+                {
+                    for(size_t ox = 0; ox < out_width; ox++)
+                    {
+                        const float g = grad_out[(c * out_height + oy) * out_width + ox] * scale;
+                        for(size_t ky = 0; ky < pool_size; ky++)
+                        {
+                            float *row = plane + (oy * stride + ky) * in_width + ox * stride;
+                            for(size_t kx = 0; kx < pool_size; kx++) { row[kx] += g; }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return grad_input;
+}
+
+
+
+OpCost AvgPool2D::forwardCost(const Tensor &input) const
+{
+    const double outputs = static_cast<double>(input.getRows() * getOutputSize());
+    return {outputs * static_cast<double>(pool_size * pool_size), (static_cast<double>(input.getSize()) + outputs) * sizeof(float)};
+}
+
+
+
+OpCost AvgPool2D::backwardCost(const Tensor &input) const
+{
+    const double outputs = static_cast<double>(input.getRows() * getOutputSize());
+    return {outputs * static_cast<double>(pool_size * pool_size), (static_cast<double>(input.getSize()) + outputs) * sizeof(float)};
+}
+
+
+
+// --- GlobalAvgPool ---
+
+GlobalAvgPool::GlobalAvgPool(size_t channels, size_t in_height, size_t in_width, DataLayout layout)
+    : channels{channels}, in_height{in_height}, in_width{in_width}, layout{layout}
+{
+    if((in_height == 0) || (in_width == 0))
+    {
+        throw std::invalid_argument("GlobalAvgPool requires a non-empty spatial extent.");
+    }
+}
+
+
+
+Tensor GlobalAvgPool::forward(const Tensor &input)
+{
+    if(input.getCols() != channels * in_height * in_width)
+    {
+        throw std::invalid_argument("GlobalAvgPool input width does not match channels * in_height * in_width.");
+    }
+    const size_t batch = input.getRows();
+    const size_t pixels = in_height * in_width;
+    const float scale = 1.0f / static_cast<float>(pixels);
+    Tensor output{{batch, channels}};
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *image = input.getCpuData() + n * input.getCols();
+        float *out = output.getCpuData() + n * channels;
+        std::fill(out, out + channels, 0.0f);
+
+        if(layout == DataLayout::NHWC)
+        {
+            for(size_t p = 0; p < pixels; p++)
+            {
+                const float *pixel = image + p * channels;
+                for(size_t c = 0; c < channels; c++) { out[c] += pixel[c]; }
+            }
+        }
+        else
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                const float *plane = image + c * pixels;
+                float sum = 0.0f;
+                for(size_t p = 0; p < pixels; p++) { sum += plane[p]; }
+                out[c] = sum;
+            }
+        }
+        for(size_t c = 0; c < channels; c++) { out[c] *= scale; }
+    }
+
+    return output;
+}
+
+
+
+Tensor GlobalAvgPool::backward(const Tensor &grad_output)
+{
+    const size_t batch = grad_output.getRows();
+    const size_t pixels = in_height * in_width;
+    const float scale = 1.0f / static_cast<float>(pixels);
+    Tensor grad_input{{batch, channels * pixels}};
+
+    for(size_t n = 0; n < batch; n++)
+    {
+        const float *g = grad_output.getCpuData() + n * channels;
+        float *grad_in = grad_input.getCpuData() + n * grad_input.getCols();
+
+        if(layout == DataLayout::NHWC)
+        {
+            for(size_t p = 0; p < pixels; p++)
+            {
+                for(size_t c = 0; c < channels; c++) { grad_in[p * channels + c] = g[c] * scale; }
+            }
+        }
+        else
+        {
+            for(size_t c = 0; c < channels; c++)
+            {
+                std::fill(grad_in + c * pixels, grad_in + (c + 1) * pixels, g[c] * scale);
+            }
+        }
+    }
+
+    return grad_input;
+}
+
+
+
+OpCost GlobalAvgPool::forwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {n, (n + static_cast<double>(input.getRows() * channels)) * sizeof(float)};
+}
+
+
+
+OpCost GlobalAvgPool::backwardCost(const Tensor &input) const
+{
+    const double n = static_cast<double>(input.getSize());
+    return {n, (n + static_cast<double>(input.getRows() * channels)) * sizeof(float)};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+
+
+#include "nn/layers/Layer.h"
+#include "nn/nn_types.h"
+
+
+
+#include <cstdint>
+#include <vector>
+
+
+
+// Pooling layers share Conv2D's convention: every row is one flattened image
+// of channels x height x width values in the given layout.
+
+
+
+class MaxPool2D final : public Layer
+{
+public:
+    // stride == 0 means stride = pool_size (non-overlapping windows)
+    MaxPool2D(size_t channels, size_t in_height, size_t in_width, size_t pool_size = 2, size_t stride = 0, DataLayout layout = DataLayout::NCHW);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "MaxPool2D"; }
+
+    [[nodiscard]] size_t getOutHeight() const noexcept { return out_height; }
+    [[nodiscard]] size_t getOutWidth() const noexcept { return out_width; }
+    [[nodiscard]] size_t getOutputSize() const noexcept { return channels * out_height * out_width; }
+
+private:
+    size_t channels;
+    size_t in_height;
+    size_t in_width;
+    size_t pool_size;
+    size_t stride;
+    size_t out_height;
+    size_t out_width;
+    DataLayout layout;
+
+    // Position of the max inside its window (ky * pool_size + kx), one byte
+    // per output element instead of a full copy of the input
+    std::vector<std::uint8_t> argmax;
+    size_t last_batch = 0;
+};
+
+
+
+class AvgPool2D final : public Layer
+{
+public:
+    AvgPool2D(size_t channels, size_t in_height, size_t in_width, size_t pool_size = 2, size_t stride = 0, DataLayout layout = DataLayout::NCHW);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "AvgPool2D"; }
+
+    [[nodiscard]] size_t getOutHeight() const noexcept { return out_height; }
+    [[nodiscard]] size_t getOutWidth() const noexcept { return out_width; }
+    [[nodiscard]] size_t getOutputSize() const noexcept { return channels * out_height * out_width; }
+
+private:
+    size_t channels;
+    size_t in_height;
+    size_t in_width;
+    size_t pool_size;
+    size_t stride;
+    size_t out_height;
+    size_t out_width;
+    DataLayout layout;
+};
+
+
+
+class GlobalAvgPool final : public Layer
+{
+public:
+    GlobalAvgPool(size_t channels, size_t in_height, size_t in_width, DataLayout layout = DataLayout::NCHW);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "GlobalAvgPool"; }
+
+    [[nodiscard]] size_t getOutputSize() const noexcept { return channels; }
+
+private:
+    size_t channels;
+    size_t in_height;
+    size_t in_width;
+    DataLayout layout;
+};
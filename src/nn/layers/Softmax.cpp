@@ -103,3 +103,21 @@ Tensor Softmax::backward(const Tensor &grad_output)
         return grad_input;
     }
 }
+
+
+
+OpCost Softmax::forwardCost(const Tensor &input) const
+{
+    // Row max, subtract, exp, sum and divide
+    const double n = static_cast<double>(input.getSize());
+    return {5.0 * n, 2.0 * n * sizeof(float)};
+}
+
+
+
+OpCost Softmax::backwardCost(const Tensor &input) const
+{
+    // Jacobian-vector product: a dot product per row, then a scaled difference
+    const double n = static_cast<double>(input.getSize());
+    return {4.0 * n, 3.0 * n * sizeof(float)};
+}
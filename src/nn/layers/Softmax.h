@@ -12,6 +12,9 @@ public:
     Softmax();
     [[nodiscard]] Tensor forward(const Tensor & input) override;
     [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] OpCost backwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "Softmax"; }
 
 private:
     Tensor last_output;
@@ -0,0 +1,65 @@
+#include "nn/layers/SparseDense.h"
+
+
+
+#include "nn/layers/Dense.h"
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+
+
+SparseDense::SparseDense(const Dense &dense, SparseFormat format, size_t block)
+    : biases{dense.biases},
+      weights{CpuOps::compress(dense.weights.getCpuData(), dense.weights.getRows(), dense.weights.getCols(), format, block)}
+{
+}
+
+
+
+Tensor SparseDense::forward(const Tensor &input)
+{
+    if(input.getCols() != weights.rows)
+    {
+        throw std::invalid_argument("SparseDense: input width does not match its weights.");
+    }
+    const size_t rows = input.getRows();
+    const size_t cols = weights.cols;
+    Tensor output{{rows, cols}};
+    const float *b = biases.getCpuData();
+    for(size_t i = 0; i < rows; i++)
+    {
+        std::copy(b, b + cols, output.getCpuData() + i * cols);
+    }
+    CpuOps::spmm(rows, input.getCpuData(), input.getCols(), weights, output.getCpuData(), cols);
+    this->last_output = output;
+    return output;
+}
+
+
+
+Tensor SparseDense::backward(const Tensor &)
+{
+    throw std::logic_error("SparseDense is inference-only; train the Dense layer before Model::sparsify.");
+}
+
+
+
+OpCost SparseDense::forwardCost(const Tensor &input) const
+{
+    OpCost cost = CpuOps::spmmCost(input.getRows(), weights);
+    const double bias_elements = static_cast<double>(input.getRows()) * static_cast<double>(weights.cols);
+    cost.flops += bias_elements;
+    cost.bytes += static_cast<double>(weights.cols) * sizeof(float);
+    return cost;
+}
+
+
+
+float SparseDense::getDensity() const noexcept
+{
+    const size_t dense_size = weights.rows * weights.cols;
+    return (dense_size == 0) ? 0.0f : static_cast<float>(weights.storedValues()) / static_cast<float>(dense_size);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+
+
+#include "backend/cpu/CpuOps.h"
+#include "nn/layers/Layer.h"
+
+
+
+class Dense;
+
+
+
+// Inference-only replacement for a pruned Dense: the weights are kept as a
+// SparseMatrix and forward runs CpuOps::spmm, so its cost scales with the
+// stored values rather than inputs x outputs. Built by Model::sparsify once
+// training is over; backward throws.
+class SparseDense final : public Layer
+{
+public:
+    // Compresses the current weights of dense (zeros are dropped, or all-zero
+    // tiles when format is Blocked) and copies its biases
+    explicit SparseDense(const Dense &dense, SparseFormat format = SparseFormat::Csr, size_t block = 4);
+    [[nodiscard]] Tensor forward(const Tensor & input) override;
+    [[nodiscard]] Tensor backward(const Tensor & grad_output) override;
+    [[nodiscard]] OpCost forwardCost(const Tensor & input) const override;
+    [[nodiscard]] const char *getTypeName() const noexcept override { return "SparseDense"; }
+
+    [[nodiscard]] const SparseMatrix &getWeights() const noexcept { return weights; }
+    [[nodiscard]] size_t getInputSize() const noexcept { return weights.rows; }
+    [[nodiscard]] size_t getOutputSize() const noexcept { return weights.cols; }
+    // Stored values over inputs x outputs
+    [[nodiscard]] float getDensity() const noexcept;
+    // Weight and bias bytes, against inputs x outputs + outputs floats dense
+    [[nodiscard]] size_t getStorageBytes() const noexcept { return weights.storageBytes() + biases.getSize() * sizeof(float); }
+
+    Tensor biases;
+
+private:
+    SparseMatrix weights;
+};
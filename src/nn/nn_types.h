@@ -31,3 +31,31 @@ enum class Backend : std::uint8_t
     CPU,
     GPU,
 };
+
+
+
+enum class DataLayout : std::uint8_t
+{
+    NCHW,
+    NHWC,
+};
+
+
+
+// Analytic work of one kernel call: floating-point operations and the bytes
+// it must move at minimum, every operand read or written once. Used for
+// roofline reporting; transcendental functions count as one operation.
+struct OpCost
+{
+    double flops = 0.0;
+    double bytes = 0.0;
+
+    [[nodiscard]] double intensity() const noexcept { return (bytes > 0.0) ? flops / bytes : 0.0; }
+
+    OpCost &operator+=(const OpCost &other) noexcept
+    {
+        flops += other.flops;
+        bytes += other.bytes;
+        return *this;
+    }
+};
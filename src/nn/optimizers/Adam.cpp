@@ -2,6 +2,10 @@
 
 
 
+#include <cmath>
+
+
+
 Adam::Adam(float learning_rate, float beta1, float beta2, float epsilon)
     : Optimizer{learning_rate}, beta1{beta1}, beta2{beta2}, epsilon{epsilon}
 {
@@ -9,7 +13,7 @@ Adam::Adam(float learning_rate, float beta1, float beta2, float epsilon)
 
 
 
-void Adam::update(Tensor &weights, const Tensor &grad_weights)
+Adam::Moments &Adam::momentsFor(const Tensor &weights)
 {
     const void *key = static_cast<const void *>(&weights);
     auto &moments = state_by_param[key];
@@ -25,17 +29,104 @@ void Adam::update(Tensor &weights, const Tensor &grad_weights)
         }
         moments.t = 0;
     }
+    return moments;
+}
+
 
+
+void Adam::update(Tensor &weights, const Tensor &grad_weights)
+{
+    auto &moments = momentsFor(weights);
     moments.t++;
 
+    const float bias_correction1 = 1 - std::pow(beta1, static_cast<float>(moments.t));
+    const float bias_correction2 = 1 - std::pow(beta2, static_cast<float>(moments.t));
+
     for (size_t i = 0; i < weights.getSize(); i++)
     {
-        moments.m.getCpuData()[i] = beta1 * moments.m.getCpuData()[i] + (1 - beta1) * grad_weights.getCpuData()[i];
-        moments.v.getCpuData()[i] = beta2 * moments.v.getCpuData()[i] + (1 - beta2) * grad_weights.getCpuData()[i] * grad_weights.getCpuData()[i];
+        const float g = grad_scale * grad_weights.getCpuData()[i];
+        moments.m.getCpuData()[i] = beta1 * moments.m.getCpuData()[i] + (1 - beta1) * g;
+        moments.v.getCpuData()[i] = beta2 * moments.v.getCpuData()[i] + (1 - beta2) * g * g;
 
-        float m_hat = moments.m.getCpuData()[i] / (1 - std::pow(beta1, moments.t));
-        float v_hat = moments.v.getCpuData()[i] / (1 - std::pow(beta2, moments.t));
+        float m_hat = moments.m.getCpuData()[i] / bias_correction1;
+        float v_hat = moments.v.getCpuData()[i] / bias_correction2;
 
         weights.getCpuData()[i] -= learning_rate * m_hat / (std::sqrt(v_hat) + epsilon);
     }
 }
+
+
+
+void Adam::updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows)
+{
+    auto &moments = momentsFor(weights);
+    moments.t++;
+
+    const float bias_correction1 = 1 - std::pow(beta1, static_cast<float>(moments.t));
+    const float bias_correction2 = 1 - std::pow(beta2, static_cast<float>(moments.t));
+    const size_t cols = weights.getCols();
+
+    for (size_t k = 0; k < rows.size(); k++)
+    {
+        const size_t offset = rows[k] * cols;
+        float *w = weights.getCpuData() + offset;
+        float *m = moments.m.getCpuData() + offset;
+        float *v = moments.v.getCpuData() + offset;
+        const float *g = grad_rows.getCpuData() + k * cols;
+        for (size_t j = 0; j < cols; j++)
+        {
+            const float gj = grad_scale * g[j];
+            m[j] = beta1 * m[j] + (1 - beta1) * gj;
+            v[j] = beta2 * v[j] + (1 - beta2) * gj * gj;
+            w[j] -= learning_rate * (m[j] / bias_correction1) / (std::sqrt(v[j] / bias_correction2) + epsilon);
+        }
+    }
+}
+
+
+
+void Adam::updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask)
+{
+    auto &moments = momentsFor(weights);
+    moments.t++;
+
+    const float bias_correction1 = 1 - std::pow(beta1, static_cast<float>(moments.t));
+    const float bias_correction2 = 1 - std::pow(beta2, static_cast<float>(moments.t));
+    float *w = weights.getCpuData();
+    float *m = moments.m.getCpuData();
+    float *v = moments.v.getCpuData();
+    const float *g = grad_weights.getCpuData();
+    const float *keep = mask.getCpuData();
+
+    for (size_t i = 0; i < weights.getSize(); i++)
+    {
+        if (keep[i] == 0.0f)
+        {
+            w[i] = 0.0f;
+            continue;
+        }
+        const float gi = grad_scale * g[i];
+        m[i] = beta1 * m[i] + (1 - beta1) * gi;
+        v[i] = beta2 * v[i] + (1 - beta2) * gi * gi;
+        w[i] -= learning_rate * (m[i] / bias_correction1) / (std::sqrt(v[i] / bias_correction2) + epsilon);
+    }
+}
+
+
+
+std::unique_ptr<Optimizer::State> Adam::saveState() const
+{
+    auto saved = std::make_unique<SavedState>();
+    saved->state_by_param = state_by_param;
+    return saved;
+}
+
+
+
+void Adam::restoreState(const State *state)
+{
+    if (const auto *saved = dynamic_cast<const SavedState *>(state))
+    {
+        state_by_param = saved->state_by_param;
+    }
+}
@@ -17,6 +17,15 @@ public:
     Adam(float learning_rate = 0.001f, float beta1 = 0.9f, float beta2 = 0.999f, float epsilon = 1e-8);
     void update(Tensor &weights, const Tensor &grad_weights) override;
 
+    // Lazy Adam: moments are only decayed and applied for the given rows
+    void updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows) override;
+
+    // Pruned entries keep their moments frozen and their weights at 0
+    void updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask) override;
+
+    [[nodiscard]] std::unique_ptr<State> saveState() const override;
+    void restoreState(const State *state) override;
+
 private:
     float beta1;
     float beta2;
@@ -28,4 +37,11 @@ private:
         int t = 0;
     };
     std::unordered_map<const void *, Moments> state_by_param;
+
+    struct SavedState final : State
+    {
+        std::unordered_map<const void *, Moments> state_by_param;
+    };
+
+    [[nodiscard]] Moments &momentsFor(const Tensor &weights);
 };
@@ -2,6 +2,42 @@
 
 
 
+#include <algorithm>
+
+
+
 Optimizer::Optimizer(float learning_rate) : learning_rate{learning_rate}
 {
 }
+
+
+
+void Optimizer::updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows)
+{
+    const size_t cols = weights.getCols();
+    Tensor dense_grad{weights.getShape()};
+    std::fill(dense_grad.getCpuData(), dense_grad.getCpuData() + dense_grad.getSize(), 0.0f);
+    for (size_t k = 0; k < rows.size(); k++)
+    {
+        std::copy(grad_rows.getCpuData() + k * cols, grad_rows.getCpuData() + (k + 1) * cols, dense_grad.getCpuData() + rows[k] * cols);
+    }
+    update(weights, dense_grad);
+}
+
+
+
+void Optimizer::updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask)
+{
+    Tensor masked_grad{weights.getShape()};
+    const float *g = grad_weights.getCpuData();
+    const float *m = mask.getCpuData();
+    for (size_t i = 0; i < masked_grad.getSize(); i++)
+    {
+        masked_grad.getCpuData()[i] = g[i] * m[i];
+    }
+    update(weights, masked_grad);
+    for (size_t i = 0; i < weights.getSize(); i++)
+    {
+        weights.getCpuData()[i] *= m[i];
+    }
+}
@@ -6,14 +6,47 @@
 
 
 
+#include <memory>
+#include <vector>
+
+
+
 class Optimizer
 {
 public:
     Optimizer(float learning_rate = 0.01f);
     virtual ~Optimizer() = default;
     virtual void update(Tensor &weights, const Tensor &grad_weights) = 0;
+
+    // Row-sparse update: grad_rows is {rows.size(), weights.getCols()} and
+    // row k holds the gradient for weights row rows[k]. The default scatters
+    // into a dense gradient; optimizers override it to touch only those rows.
+    virtual void updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows);
+
+    // Masked update for pruned weights: mask has the shape of weights and
+    // entries where it is 0 are neither updated nor allowed to drift from
+    // 0. The default masks a dense gradient copy and re-zeroes the weights;
+    // optimizers override it to skip the pruned entries and their state.
+    virtual void updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask);
+
     void setLearningRate(float lr) { learning_rate = lr; }
+    [[nodiscard]] float getLearningRate() const noexcept { return learning_rate; }
+
+    // Multiplies every gradient update() and updateRows() apply, so clipping
+    // costs no extra pass over the gradients; Model restores 1 after a step
+    void setGradientScale(float scale) { grad_scale = scale; }
+    [[nodiscard]] float getGradientScale() const noexcept { return grad_scale; }
+
+    // Copy of the per-parameter state (Adam's moments and step counts) so
+    // trial steps can be undone; stateless optimizers return nullptr
+    struct State
+    {
+        virtual ~State() = default;
+    };
+    [[nodiscard]] virtual std::unique_ptr<State> saveState() const { return nullptr; }
+    virtual void restoreState(const State *state) {}
 
 protected:
     float learning_rate;
+    float grad_scale = 1.0f;
 };
@@ -10,8 +10,40 @@ SGD::SGD(float learning_rate) : Optimizer{learning_rate}
 
 void SGD::update(Tensor &weights, const Tensor &grad_weights)
 {
+    const float step = learning_rate * grad_scale;
     for (size_t i = 0; i < weights.getSize(); i++)
     {
-        weights.getCpuData()[i] -= learning_rate * grad_weights.getCpuData()[i];
+        weights.getCpuData()[i] -= step * grad_weights.getCpuData()[i];
+    }
+}
+
+
+
+void SGD::updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows)
+{
+    const size_t cols = weights.getCols();
+    const float step = learning_rate * grad_scale;
+    for (size_t k = 0; k < rows.size(); k++)
+    {
+        float *w = weights.getCpuData() + rows[k] * cols;
+        const float *g = grad_rows.getCpuData() + k * cols;
+        for (size_t j = 0; j < cols; j++)
+        {
+            w[j] -= step * g[j];
+        }
+    }
+}
+
+
+
+void SGD::updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask)
+{
+    const float step = learning_rate * grad_scale;
+    float *w = weights.getCpuData();
+    const float *g = grad_weights.getCpuData();
+    const float *m = mask.getCpuData();
+    for (size_t i = 0; i < weights.getSize(); i++)
+    {
+        w[i] = m[i] * (w[i] - step * g[i]);
     }
 }
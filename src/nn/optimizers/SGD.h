@@ -11,4 +11,6 @@ class SGD final : public Optimizer
 public:
     SGD(float learning_rate = 0.01f);
     void update(Tensor &weights, const Tensor &grad_weights) override;
+    void updateRows(Tensor &weights, const std::vector<size_t> &rows, const Tensor &grad_rows) override;
+    void updateMasked(Tensor &weights, const Tensor &grad_weights, const Tensor &mask) override;
 };
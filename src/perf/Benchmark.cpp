@@ -0,0 +1,777 @@
+// =============================================================================
+// File: src/perf/Benchmark.cpp
+// =============================================================================
+//
+// Description: Implements the layer micro-benchmarks. Inputs are filled with
+//              random values once; each case runs one warm-up iteration
+//              before the timed ones so scratch buffers are already sized.
+//
+// =============================================================================
+
+#include "perf/Benchmark.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+#include "distributed/HogwildTrainer.h"
+#include "nn/AllocationTracker.h"
+#include "nn/HostMemory.h"
+#include "nn/Initializer.h"
+#include "nn/Loss.h"
+#include "nn/Model.h"
+#include "nn/ModelBatch.h"
+#include "nn/Pruning.h"
+#include "nn/graph/ExecutionPlan.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Conv2D.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Dropout.h"
+#include "nn/layers/Normalization.h"
+#include "nn/layers/Pooling.h"
+#include "nn/layers/Softmax.h"
+#include "nn/layers/SparseDense.h"
+#include "nn/optimizers/SGD.h"
+#include "perf/Roofline.h"
+#include "utils/Numa.h"
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+
+
+
+namespace
+{
+    Tensor randomInput(size_t rows, size_t cols)
+    {
+        Tensor t{{rows, cols}};
+        t.initializeRandom();
+        return t;
+    }
+
+
+
+    // Sparse binary features (about 2% set) labelled by a fixed random linear
+    // teacher, the kind of wide tabular input Hogwild is suited to
+    void sparseTabularTask(size_t rows, size_t features, size_t classes, std::mt19937 &rng, const std::vector<float> &teacher, Tensor &X, Tensor &y)
+    {
+        X = Tensor{{rows, features}};
+        y = Tensor{{rows, classes}};
+        std::fill_n(X.getCpuData(), X.getSize(), 0.0f);
+        std::fill_n(y.getCpuData(), y.getSize(), 0.0f);
+        std::bernoulli_distribution active(0.02);
+        std::vector<float> score(classes);
+        for(size_t r = 0; r < rows; r++)
+        {
+            std::fill(score.begin(), score.end(), 0.0f);
+            for(size_t f = 0; f < features; f++)
+            {
+                if(!active(rng)) { continue; }
+                X.getCpuData()[r * features + f] = 1.0f;
+                for(size_t c = 0; c < classes; c++) { score[c] += teacher[f * classes + c]; }
+            }
+            const size_t label = static_cast<size_t>(std::max_element(score.begin(), score.end()) - score.begin());
+            y.getCpuData()[r * classes + label] = 1.0f;
+        }
+    }
+
+
+
+    constexpr size_t kTaskFeatures = 1024;
+    constexpr size_t kTaskClasses = 10;
+    constexpr size_t kTaskHidden = 64;
+
+    struct SparseTask
+    {
+        Tensor X_train, y_train, X_val, y_val;
+    };
+
+    SparseTask makeSparseTask()
+    {
+        std::mt19937 rng(1234);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::vector<float> teacher(kTaskFeatures * kTaskClasses);
+        for(float &w : teacher) { w = normal(rng); }
+        SparseTask task;
+        sparseTabularTask(16384, kTaskFeatures, kTaskClasses, rng, teacher, task.X_train, task.y_train);
+        sparseTabularTask(2048, kTaskFeatures, kTaskClasses, rng, teacher, task.X_val, task.y_val);
+        return task;
+    }
+
+
+
+    Benchmark::TrainerResult runTrainerCase(const std::string &name, HogwildOptions options, const SparseTask &task, size_t epochs)
+    {
+        const auto factory = []
+        {
+            auto model = std::make_unique<Model>();
+            model->add(std::make_unique<Dense>(kTaskFeatures, kTaskHidden));
+            model->add(std::make_unique<Activation>(ActivationType::ReLU));
+            model->add(std::make_unique<Dense>(kTaskHidden, kTaskClasses));
+            model->add(std::make_unique<Softmax>());
+            model->compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>());
+            return model;
+        };
+        options.learning_rate = 0.2f;
+        HogwildTrainer trainer(factory, options);
+        const HogwildStats stats = trainer.train(task.X_train, task.y_train, epochs);
+
+        Benchmark::TrainerResult result;
+        result.name = name;
+        result.threads = stats.threads;
+        result.seconds = stats.seconds;
+        result.samples_per_second = (stats.seconds > 0.0) ? static_cast<double>(stats.samples) / stats.seconds : 0.0;
+        result.final_loss = stats.final_loss;
+        result.val_accuracy = trainer.getModel().evaluate(task.X_val, task.y_val).second;
+        result.updates_dropped = stats.updates_dropped;
+        result.mean_staleness = stats.mean_staleness;
+        return result;
+    }
+}
+
+
+
+namespace Benchmark
+{
+
+Result timeLayer(const std::string &name, Layer &layer, const Tensor &input, size_t iterations, double forward_flops)
+{
+    using clock = std::chrono::steady_clock;
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+
+    // Warm-up sizes scratch buffers and caches
+    Tensor output = layer.forward(input);
+    Tensor grad = output;
+    (void)layer.backward(grad);
+
+    double fwd_total = 0.0;
+    double bwd_total = 0.0;
+    for(size_t i = 0; i < iterations; i++)
+    {
+        auto t0 = clock::now();
+        output = layer.forward(input);
+        auto t1 = clock::now();
+        Tensor grad_input = layer.backward(grad);
+        auto t2 = clock::now();
+        fwd_total += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        bwd_total += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    }
+
+    if(iterations > 0)
+    {
+        result.forward_ms = fwd_total / static_cast<double>(iterations);
+        result.backward_ms = bwd_total / static_cast<double>(iterations);
+    }
+    if(forward_flops <= 0.0)
+    {
+        forward_flops = layer.forwardCost(input).flops;
+    }
+    if((forward_flops > 0.0) && (result.forward_ms > 0.0))
+    {
+        result.forward_gflops = forward_flops / (result.forward_ms * 1e6);
+    }
+    return result;
+}
+
+
+
+std::vector<Result> runLayerBenchmarks(size_t batch_size, size_t iterations)
+{
+    std::vector<Result> results;
+
+    // CIFAR-10 stem: 3x32x32 -> 32 channels
+    Tensor cifar = randomInput(batch_size, 3 * 32 * 32);
+    {
+        Conv2D conv{3, 32, 32, 32, 3, 1, 1};
+        results.push_back(timeLayer("Conv2D 3->32 3x3 (Winograd)", conv, cifar, iterations));
+        conv.setWinogradEnabled(false);
+        results.push_back(timeLayer("Conv2D 3->32 3x3 (GEMM)", conv, cifar, iterations));
+    }
+
+    // Second stage after 2x2 pooling: 32x16x16 -> 64 channels
+    Tensor stage2 = randomInput(batch_size, 32 * 16 * 16);
+    {
+        Conv2D conv{32, 16, 16, 64, 3, 1, 1};
+        results.push_back(timeLayer("Conv2D 32->64 3x3 (Winograd)", conv, stage2, iterations));
+        conv.setWinogradEnabled(false);
+        results.push_back(timeLayer("Conv2D 32->64 3x3 (GEMM)", conv, stage2, iterations));
+    }
+
+    // Pooling over the 32x32x32 stem output in both layouts
+    Tensor feature_map = randomInput(batch_size, 32 * 32 * 32);
+    {
+        MaxPool2D pool{32, 32, 32, 2, 0, DataLayout::NCHW};
+        results.push_back(timeLayer("MaxPool2D 2x2 NCHW", pool, feature_map, iterations));
+    }
+    {
+        MaxPool2D pool{32, 32, 32, 2, 0, DataLayout::NHWC};
+        results.push_back(timeLayer("MaxPool2D 2x2 NHWC", pool, feature_map, iterations));
+    }
+    {
+        AvgPool2D pool{32, 32, 32, 2, 0, DataLayout::NCHW};
+        results.push_back(timeLayer("AvgPool2D 2x2 NCHW", pool, feature_map, iterations));
+    }
+    {
+        AvgPool2D pool{32, 32, 32, 2, 0, DataLayout::NHWC};
+        results.push_back(timeLayer("AvgPool2D 2x2 NHWC", pool, feature_map, iterations));
+    }
+    {
+        GlobalAvgPool pool{32, 32, 32, DataLayout::NHWC};
+        results.push_back(timeLayer("GlobalAvgPool NHWC", pool, feature_map, iterations));
+    }
+
+    {
+        Dropout dropout{0.5f};
+        results.push_back(timeLayer("Dropout 0.5 (32x32x32)", dropout, feature_map, iterations));
+    }
+
+    // The fully connected layer convolutions are meant to replace
+    {
+        Dense dense{3072, 512};
+        results.push_back(timeLayer("Dense 3072->512", dense, cifar, iterations));
+    }
+
+    return results;
+}
+
+
+
+std::vector<Result> runHugePageBenchmarks(size_t batch_size, size_t iterations)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr size_t kRows = 16384;
+    constexpr size_t kCols = 3072;
+    const HostMemory::HugePageMode previous = HostMemory::getHugePageMode();
+    const HostMemory::HugePageMode huge = (previous == HostMemory::HugePageMode::Off) ? HostMemory::HugePageMode::Transparent : previous;
+
+    std::vector<Result> results;
+    for(const auto mode : {HostMemory::HugePageMode::Off, huge})
+    {
+        HostMemory::setHugePageMode(mode);
+        const std::string suffix = (mode == HostMemory::HugePageMode::Off) ? " (4K pages)" : " (huge pages)";
+
+        Tensor dataset{{kRows, kCols}};
+        std::fill_n(dataset.getCpuData(), dataset.getSize(), 0.5f);
+        Tensor batch{{batch_size, kCols}};
+        std::mt19937 rng(99);
+        std::uniform_int_distribution<size_t> pick(0, kRows - 1);
+
+        // Gathers scattered rows, the access pattern of DataManager::getTrainBatch
+        Result gather;
+        gather.name = "Row gather " + std::to_string(batch_size) + "x" + std::to_string(kCols) + suffix;
+        gather.iterations = iterations * 10;
+        const auto start = clock::now();
+        for(size_t i = 0; i < gather.iterations; i++)
+        {
+            for(size_t r = 0; r < batch_size; r++)
+            {
+                std::copy_n(dataset.getCpuData() + pick(rng) * kCols, kCols, batch.getCpuData() + r * kCols);
+            }
+        }
+        gather.forward_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / static_cast<double>(gather.iterations);
+        results.push_back(gather);
+
+        Dense dense{kCols, 512};
+        results.push_back(timeLayer("Dense 3072->512" + suffix, dense, batch, iterations));
+    }
+    HostMemory::setHugePageMode(previous);
+    HostMemory::trimCache(); // do not keep the synthetic dataset mapped
+    return results;
+}
+
+
+
+std::string formatResult(const Result &result)
+{
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%-30s fwd %8.3f ms  bwd %8.3f ms  %6.2f GFLOP/s",
+                  result.name.c_str(), result.forward_ms, result.backward_ms, result.forward_gflops);
+    return std::string(buffer);
+}
+
+
+
+std::vector<std::string> runRooflineReport(size_t batch_size, size_t iterations)
+{
+    // Profiles come first so the peaks can be measured on as many threads as
+    // the kernels actually ran on (tuned GEMMs may use more than getThreads)
+    std::vector<std::pair<std::string, std::vector<Roofline::LayerProfile>>> profiles;
+    CpuOps::resetThreadsUsed();
+    auto profile = [&](const std::string &title, Model &model, size_t inputs)
+    {
+        model.compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>());
+        Tensor X = randomInput(batch_size, inputs);
+        Tensor y{{batch_size, 10}};
+        std::fill_n(y.getCpuData(), y.getSize(), 0.0f);
+        for(size_t r = 0; r < batch_size; r++) { y.getCpuData()[r * 10 + r % 10] = 1.0f; }
+        profiles.emplace_back(title + ", batch " + std::to_string(batch_size), Roofline::profileModel(model, X, y, iterations));
+    };
+
+    Model mlp;
+    mlp.add(std::make_unique<Dense>(784, 128));
+    mlp.add(std::make_unique<Activation>(ActivationType::ReLU));
+    mlp.add(std::make_unique<Dense>(128, 10));
+    mlp.add(std::make_unique<Softmax>());
+    profile("MNIST MLP 784-128-10", mlp, 784);
+
+    Model cnn;
+    cnn.add(std::make_unique<Conv2D>(3, 32, 32, 32, 3, 1, 1));
+    cnn.add(std::make_unique<Activation>(ActivationType::ReLU));
+    cnn.add(std::make_unique<MaxPool2D>(32, 32, 32, 2));
+    cnn.add(std::make_unique<Conv2D>(32, 16, 16, 64, 3, 1, 1));
+    cnn.add(std::make_unique<Activation>(ActivationType::ReLU));
+    cnn.add(std::make_unique<MaxPool2D>(64, 16, 16, 2));
+    cnn.add(std::make_unique<Dense>(64 * 8 * 8, 10));
+    cnn.add(std::make_unique<Softmax>());
+    profile("CIFAR-10 CNN conv32-pool-conv64-pool-dense", cnn, 3 * 32 * 32);
+
+    const Roofline::MachinePeaks peaks = Roofline::measurePeaks(std::max(CpuOps::getThreads(), CpuOps::getThreadsUsed()));
+    std::vector<std::string> lines = {Roofline::formatPeaks(peaks)};
+    for(auto &[title, layers] : profiles)
+    {
+        lines.push_back(title);
+        for(std::string &line : Roofline::report(layers, peaks))
+        {
+            lines.push_back(std::move(line));
+        }
+    }
+    return lines;
+}
+
+
+
+std::vector<std::string> runAllocationCheck(size_t batch_size, bool *passed)
+{
+    std::vector<std::string> lines;
+    Tensor X = randomInput(batch_size, 784);
+    Tensor y_onehot{{batch_size, 10}};
+    Tensor y_index{{batch_size, 1}};
+    std::fill_n(y_onehot.getCpuData(), y_onehot.getSize(), 0.0f);
+    for(size_t r = 0; r < batch_size; r++)
+    {
+        y_onehot.getCpuData()[r * 10 + r % 10] = 1.0f;
+        y_index.getCpuData()[r] = static_cast<float>(r % 10);
+    }
+
+    Graph graph;
+    Graph::NodeId node = graph.input(784);
+    node = graph.add(std::make_unique<Dense>(784, 128), node);
+    node = graph.add(std::make_unique<Activation>(ActivationType::ReLU), node);
+    node = graph.add(std::make_unique<Dense>(128, 10), node);
+    node = graph.add(std::make_unique<Softmax>(), node);
+    graph.setOutput(node);
+    graph.setLoss(std::make_unique<CrossEntropyLoss>());
+    graph.setOptimizer(std::make_unique<SGD>(0.01f));
+    CompileOptions options;
+    options.batch_size = batch_size;
+    ExecutionPlan plan = GraphCompiler::compile(graph, options);
+
+    bool ok = true;
+    try
+    {
+        AllocationTracker::expectNoSteadyStateAllocations([&] { (void)plan.trainStep(X, y_index); }, "ExecutionPlan::trainStep");
+        lines.push_back("PASS ExecutionPlan::trainStep allocates no tensors per step after warm-up");
+    }
+    catch(const std::exception &e)
+    {
+        ok = false;
+        lines.push_back(std::string("FAIL ") + e.what());
+    }
+
+    Model model;
+    model.add(std::make_unique<Dense>(784, 128));
+    model.add(std::make_unique<Activation>(ActivationType::ReLU));
+    model.add(std::make_unique<Dense>(128, 10));
+    model.add(std::make_unique<Softmax>());
+    model.compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>(0.01f));
+    const auto state = AllocationTracker::measureSteadyState([&] { (void)model.train_step(X, y_onehot); });
+    char line[160];
+    std::snprintf(line, sizeof(line), "Model::train_step: %.1f tensors (%.1f KB) allocated per step",
+                  state.allocations_per_step, state.bytes_per_step / 1024.0);
+    lines.push_back(line);
+    for(const auto &site : state.sites)
+    {
+        std::snprintf(line, sizeof(line), "  %-24s %6.1f per step", site.name.c_str(),
+                      static_cast<double>(site.allocations) / static_cast<double>(state.steps));
+        lines.push_back(line);
+    }
+
+    if(passed) { *passed = ok; }
+    return lines;
+}
+
+
+
+std::vector<std::string> runModelBatchComparison(size_t models, size_t batch_size, size_t steps)
+{
+    models = std::max<size_t>(models, 1);
+    steps = std::max<size_t>(steps, 1);
+    // Two identical sets of K MNIST MLPs: one steps model by model, the
+    // other as a ModelBatch
+    auto build = [models]
+    {
+        std::vector<std::unique_ptr<Model>> set;
+        Initializer::setSeed(Initializer::kDefaultSeed);
+        for(size_t k = 0; k < models; k++)
+        {
+            auto model = std::make_unique<Model>();
+            model->add(std::make_unique<Dense>(784, 128));
+            model->add(std::make_unique<Activation>(ActivationType::ReLU));
+            model->add(std::make_unique<Dense>(128, 64));
+            model->add(std::make_unique<Activation>(ActivationType::ReLU));
+            model->add(std::make_unique<Dense>(64, 10));
+            model->add(std::make_unique<Softmax>());
+            model->compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>(0.01f));
+            set.push_back(std::move(model));
+        }
+        return set;
+    };
+    const std::uint64_t previous_seed = Initializer::getSeed();
+    auto sequential = build();
+    auto grouped = build();
+    Initializer::setSeed(previous_seed);
+
+    std::vector<Tensor> inputs;
+    std::vector<Tensor> targets;
+    for(size_t k = 0; k < models; k++)
+    {
+        inputs.push_back(randomInput(batch_size, 784));
+        Tensor y{{batch_size, 1}};
+        for(size_t r = 0; r < batch_size; r++)
+        {
+            y.getCpuData()[r] = static_cast<float>((r + k) % 10);
+        }
+        targets.push_back(std::move(y));
+    }
+    std::vector<const Tensor *> X;
+    std::vector<const Tensor *> y;
+    std::vector<Model *> members;
+    for(size_t k = 0; k < models; k++)
+    {
+        X.push_back(&inputs[k]);
+        y.push_back(&targets[k]);
+        members.push_back(grouped[k].get());
+    }
+    ModelBatch batch(members);
+
+    // Both paths get the same thread budget; with none set, every hardware
+    // thread, so the grouped GEMMs have cores to fill
+    const size_t previous_threads = CpuOps::getThreads();
+    const size_t threads = (previous_threads > 0) ? previous_threads : std::max(1u, std::thread::hardware_concurrency());
+    CpuOps::setThreads(threads);
+
+    float max_difference = 0.0f;
+    double sequential_seconds = 0.0;
+    double grouped_seconds = 0.0;
+    for(size_t step = 0; step <= steps; step++)
+    {
+        std::vector<float> expected(models);
+        auto start = std::chrono::steady_clock::now();
+        for(size_t k = 0; k < models; k++)
+        {
+            expected[k] = sequential[k]->train_step(inputs[k], targets[k]);
+        }
+        const double sequential_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        const std::vector<float> losses = batch.train_step(X, y);
+        const double grouped_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Step 0 is the warm-up
+        if(step > 0)
+        {
+            sequential_seconds += sequential_elapsed;
+            grouped_seconds += grouped_elapsed;
+        }
+        for(size_t k = 0; k < models; k++)
+        {
+            max_difference = std::max(max_difference, std::fabs(losses[k] - expected[k]));
+        }
+    }
+    CpuOps::setThreads(previous_threads);
+
+    const double samples = static_cast<double>(models * batch_size * steps);
+    std::vector<std::string> lines;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%zu x MLP 784-128-64-10, batch %zu, %zu threads: sequential %.0f samples/s, ModelBatch %.0f samples/s (%.2fx)",
+                  models, batch_size, threads, samples / sequential_seconds, samples / grouped_seconds, sequential_seconds / grouped_seconds);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "  max loss difference over %zu steps: %.2e", steps + 1, static_cast<double>(max_difference));
+    lines.push_back(line);
+    return lines;
+}
+
+
+
+std::vector<std::string> runSparseBenchmarks(size_t batch_size, size_t iterations)
+{
+    iterations = std::max<size_t>(iterations, 1);
+    auto timeForward = [&](Layer &layer, const Tensor &input)
+    {
+        (void)layer.forward(input);
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < iterations; i++)
+        {
+            (void)layer.forward(input);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(iterations);
+    };
+
+    // The CIFAR-10 classifier's wide layer, dense and then pruned
+    Tensor X = randomInput(batch_size, 3072);
+    Dense base{3072, 512};
+    const double dense_ms = timeForward(base, X);
+    const OpCost dense_cost = base.forwardCost(X);
+    const double dense_bytes = static_cast<double>((base.weights.getSize() + base.biases.getSize()) * sizeof(float));
+
+    std::vector<std::string> lines;
+    char line[192];
+    std::snprintf(line, sizeof(line), "Dense 3072->512 batch %zu: %.3f ms, %.1f MFLOP, %.2f MB", batch_size, dense_ms,
+                  dense_cost.flops / 1e6, dense_bytes / (1024.0 * 1024.0));
+    lines.push_back(line);
+
+    struct Variant
+    {
+        const char *name;
+        SparseFormat format;
+        size_t block;
+    };
+    constexpr Variant kVariants[] = {{"CSR", SparseFormat::Csr, 1}, {"Blocked 4x4", SparseFormat::Blocked, 4}, {"Blocked 8x8", SparseFormat::Blocked, 8}};
+    for(const float sparsity : {0.5f, 0.8f, 0.9f, 0.95f})
+    {
+        for(const Variant &variant : kVariants)
+        {
+            Dense pruned = base;
+            Pruning::pruneByMagnitude(pruned, sparsity, variant.block);
+            const Tensor expected = pruned.forward(X);
+            SparseDense sparse{pruned, variant.format, variant.block};
+            const double sparse_ms = timeForward(sparse, X);
+            const Tensor actual = sparse.forward(X);
+            float max_difference = 0.0f;
+            for(size_t i = 0; i < actual.getSize(); i++)
+            {
+                max_difference = std::max(max_difference, std::fabs(actual.getCpuData()[i] - expected.getCpuData()[i]));
+            }
+            const OpCost cost = sparse.forwardCost(X);
+            std::snprintf(line, sizeof(line), "  %2.0f%% %-11s %.3f ms (%.2fx), %.1f MFLOP (%.2fx), %.2f MB (%.2fx), max diff %.1e",
+                          100.0f * sparsity, variant.name, sparse_ms, dense_ms / sparse_ms, cost.flops / 1e6, dense_cost.flops / cost.flops,
+                          static_cast<double>(sparse.getStorageBytes()) / (1024.0 * 1024.0), dense_bytes / static_cast<double>(sparse.getStorageBytes()),
+                          static_cast<double>(max_difference));
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+
+
+std::vector<std::string> runBatchNormFoldCheck(size_t batch_size, size_t iterations, bool *passed)
+{
+    iterations = std::max<size_t>(iterations, 1);
+    Tensor X = randomInput(batch_size, 784);
+    Tensor y{{batch_size, 10}};
+    std::fill_n(y.getCpuData(), y.getSize(), 0.0f);
+    for(size_t r = 0; r < batch_size; r++)
+    {
+        y.getCpuData()[r * 10 + r % 10] = 1.0f;
+    }
+
+    // A few steps move the running statistics and the affine parameters away
+    // from the identity they start at
+    Initializer::setSeed(Initializer::kDefaultSeed);
+    auto hidden = std::make_unique<Dense>(784, 256);
+    auto norm = std::make_unique<BatchNorm1d>(256);
+    auto head = std::make_unique<Dense>(256, 10);
+    const Dense &hidden_ref = *hidden;
+    const BatchNorm1d &norm_ref = *norm;
+    const Dense &head_ref = *head;
+    Model model;
+    model.add(std::move(hidden));
+    model.add(std::move(norm));
+    model.add(std::make_unique<Activation>(ActivationType::ReLU));
+    model.add(std::move(head));
+    model.add(std::make_unique<Softmax>());
+    model.compile(std::make_unique<CrossEntropyLoss>(), std::make_unique<SGD>(0.05f));
+    for(size_t i = 0; i < 20; i++)
+    {
+        (void)model.train_step(X, y);
+    }
+    model.setTraining(false);
+
+    // The same trained layers as a graph, for the inference plan
+    Graph graph;
+    Graph::NodeId node = graph.input(784);
+    node = graph.add(std::make_unique<Dense>(hidden_ref), node);
+    node = graph.add(std::make_unique<BatchNorm1d>(norm_ref), node);
+    node = graph.add(std::make_unique<Activation>(ActivationType::ReLU), node);
+    node = graph.add(std::make_unique<Dense>(head_ref), node);
+    node = graph.add(std::make_unique<Softmax>(), node);
+    graph.setOutput(node);
+    graph.setTraining(false);
+
+    auto timeForward = [&](auto &&forward)
+    {
+        (void)forward();
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < iterations; i++)
+        {
+            (void)forward();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(iterations);
+    };
+    auto maxDifference = [](const Tensor &actual, const Tensor &expected)
+    {
+        float difference = 0.0f;
+        for(size_t i = 0; i < actual.getSize(); i++)
+        {
+            difference = std::max(difference, std::fabs(actual.getCpuData()[i] - expected.getCpuData()[i]));
+        }
+        return difference;
+    };
+    constexpr float kTolerance = 1e-5f;
+
+    const Tensor expected = model.forward(X);
+    const double unfolded_ms = timeForward([&] { return model.forward(X); });
+
+    CompileOptions options;
+    options.batch_size = batch_size;
+    options.training = false;
+    ExecutionPlan plan = GraphCompiler::compile(graph, options);
+    const float plan_difference = maxDifference(plan.run(X), expected);
+    const double plan_ms = timeForward([&] { return plan.run(X).getSize(); });
+
+    const size_t folded = model.foldBatchNorm();
+    const float model_difference = maxDifference(model.forward(X), expected);
+    const double folded_ms = timeForward([&] { return model.forward(X); });
+
+    std::vector<std::string> lines;
+    char line[192];
+    std::snprintf(line, sizeof(line), "Dense 784->256 + BatchNorm1d MLP batch %zu: unfolded %.3f ms, folded %.3f ms (%.2fx), inference plan %.3f ms",
+                  batch_size, unfolded_ms, folded_ms, unfolded_ms / folded_ms, plan_ms);
+    lines.push_back(line);
+    const bool model_ok = (folded == 1) && (model_difference <= kTolerance);
+    std::snprintf(line, sizeof(line), "%s Model::foldBatchNorm folded %zu layer(s), max diff %.1e", model_ok ? "PASS" : "FAIL", folded,
+                  static_cast<double>(model_difference));
+    lines.push_back(line);
+    const bool plan_ok = (plan.getStats().folded_batch_norm == 1) && (plan_difference <= kTolerance);
+    std::snprintf(line, sizeof(line), "%s inference ExecutionPlan folded %zu layer(s), max diff %.1e", plan_ok ? "PASS" : "FAIL",
+                  plan.getStats().folded_batch_norm, static_cast<double>(plan_difference));
+    lines.push_back(line);
+
+    if(passed) { *passed = model_ok && plan_ok; }
+    return lines;
+}
+
+
+
+std::vector<TrainerResult> runParallelSgdComparison(size_t threads, size_t epochs)
+{
+    if(threads == 0)
+    {
+        threads = std::max(2u, std::thread::hardware_concurrency());
+    }
+    const SparseTask task = makeSparseTask();
+
+    struct Case
+    {
+        std::string name;
+        ParallelSgdMode mode;
+        size_t threads;
+        size_t max_staleness;
+    };
+    const std::vector<Case> cases = {
+        {"Sync SGD", ParallelSgdMode::Synchronous, 1, 0},
+        {"Sync data-parallel", ParallelSgdMode::Synchronous, threads, 0},
+        {"Hogwild", ParallelSgdMode::Hogwild, threads, 0},
+        {"Hogwild bounded", ParallelSgdMode::Hogwild, threads, threads},
+    };
+
+    std::vector<TrainerResult> results;
+    for(const auto &c : cases)
+    {
+        HogwildOptions options;
+        options.mode = c.mode;
+        options.threads = c.threads;
+        options.max_staleness = c.max_staleness;
+        results.push_back(runTrainerCase(c.name, options, task, epochs));
+    }
+    return results;
+}
+
+
+
+std::vector<TrainerResult> runNumaComparison(size_t threads, size_t epochs)
+{
+    if(threads == 0)
+    {
+        threads = std::max<size_t>(2, Numa::topology().cpuCount());
+    }
+    const SparseTask task = makeSparseTask();
+
+    struct Case
+    {
+        std::string name;
+        Numa::PinPolicy pin;
+        Numa::DataPlacement placement;
+    };
+    const std::vector<Case> cases = {
+        {"Hogwild unpinned", Numa::PinPolicy::None, Numa::DataPlacement::FirstTouch},
+        {"Hogwild compact", Numa::PinPolicy::Compact, Numa::DataPlacement::FirstTouch},
+        {"Hogwild scatter", Numa::PinPolicy::Scatter, Numa::DataPlacement::FirstTouch},
+        {"Scatter+interleave", Numa::PinPolicy::Scatter, Numa::DataPlacement::Interleave},
+        {"Scatter+replicate", Numa::PinPolicy::Scatter, Numa::DataPlacement::Replicate},
+    };
+
+    std::vector<TrainerResult> results;
+    for(const auto &c : cases)
+    {
+        HogwildOptions options;
+        options.threads = threads;
+        options.pin_policy = c.pin;
+        options.data_placement = c.placement;
+        results.push_back(runTrainerCase(c.name, options, task, epochs));
+    }
+    return results;
+}
+
+
+
+std::vector<std::string> describeNuma()
+{
+    std::vector<std::string> lines = {Numa::describe()};
+    const auto bandwidth = Numa::measureBandwidth();
+    for(size_t from = 0; from < bandwidth.size(); from++)
+    {
+        std::string line = "  read GB/s from node" + std::to_string(from) + ":";
+        for(double gbps : bandwidth[from])
+        {
+            char cell[32];
+            std::snprintf(cell, sizeof(cell), " %7.2f", gbps);
+            line += cell;
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+
+
+std::string formatResult(const TrainerResult &result)
+{
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%-20s x%-2zu %9.0f samples/s  loss %6.4f  val acc %5.3f  staleness %5.2f  dropped %zu",
+                  result.name.c_str(), result.threads, result.samples_per_second, result.final_loss,
+                  result.val_accuracy, result.mean_staleness, result.updates_dropped);
+    return std::string(buffer);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,98 @@
+// =============================================================================
+// File: src/perf/Benchmark.h
+// =============================================================================
+//
+// Description: Declares the in-application micro-benchmark suite. It times
+//              forward and backward passes of individual layers on synthetic
+//              inputs shaped like the MNIST/CIFAR-10 workloads, so kernel
+//              changes can be compared on the machine the app runs on.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/layers/Layer.h"
+
+
+
+#include <string>
+#include <vector>
+
+
+
+namespace Benchmark
+{
+    struct Result
+    {
+        std::string name;
+        size_t iterations = 0;
+        double forward_ms = 0.0;  // mean per iteration
+        double backward_ms = 0.0; // mean per iteration
+        double forward_gflops = 0.0; // 0 when the FLOP count is not known
+    };
+
+    // Time forward/backward of a single layer on the given input. A zero
+    // forward_flops uses the layer's own forwardCost.
+    [[nodiscard]] Result timeLayer(const std::string &name, Layer &layer, const Tensor &input, size_t iterations, double forward_flops = 0.0);
+
+    // Convolution, pooling and dense layers on CIFAR-10-sized inputs
+    [[nodiscard]] std::vector<Result> runLayerBenchmarks(size_t batch_size = 64, size_t iterations = 10);
+
+    [[nodiscard]] std::string formatResult(const Result &result);
+
+    // Measured machine peaks, then the roofline of one training step of the
+    // MNIST MLP and of the small CIFAR-10 CNN
+    [[nodiscard]] std::vector<std::string> runRooflineReport(size_t batch_size = 64, size_t iterations = 10);
+
+    // Steady-state Tensor allocations of one MNIST MLP training step: the
+    // compiled ExecutionPlan step must allocate nothing after warm-up
+    // (passed is set accordingly); Model::train_step is listed per site
+    [[nodiscard]] std::vector<std::string> runAllocationCheck(size_t batch_size = 64, bool *passed = nullptr);
+
+    // K identical MNIST MLPs trained step by step and as one ModelBatch
+    // (grouped GEMM), with throughput and the largest loss difference
+    [[nodiscard]] std::vector<std::string> runModelBatchComparison(size_t models = 8, size_t batch_size = 64, size_t steps = 20);
+
+    // The CIFAR-10 Dense 3072->512 layer dense, then magnitude-pruned to 50-95%
+    // and run as SparseDense (CSR and blocked): latency, FLOPs and size of
+    // each against the dense layer, and the largest output difference
+    [[nodiscard]] std::vector<std::string> runSparseBenchmarks(size_t batch_size = 64, size_t iterations = 20);
+
+    // An MNIST MLP with BatchNorm1d after its hidden Dense, trained a few
+    // steps, run for inference as is, through Model::foldBatchNorm and as an
+    // inference ExecutionPlan: forward latency of each, and passed is set
+    // when both folded outputs match the unfolded ones
+    [[nodiscard]] std::vector<std::string> runBatchNormFoldCheck(size_t batch_size = 64, size_t iterations = 20, bool *passed = nullptr);
+
+    // Random-row batch gather from a CIFAR-sized dataset and a wide Dense
+    // layer, with tensor storage on 4 KB pages and then on huge pages
+    [[nodiscard]] std::vector<Result> runHugePageBenchmarks(size_t batch_size = 64, size_t iterations = 20);
+
+    struct TrainerResult
+    {
+        std::string name;
+        size_t threads = 0;
+        double seconds = 0.0;
+        double samples_per_second = 0.0;
+        float final_loss = 0.0f;     // mean training loss of the last epoch
+        float val_accuracy = 0.0f;
+        size_t updates_dropped = 0;  // Hogwild staleness bound
+        double mean_staleness = 0.0;
+    };
+
+    // Synchronous data-parallel vs Hogwild SGD on a sparse synthetic tabular
+    // task, reporting throughput and convergence side by side
+    [[nodiscard]] std::vector<TrainerResult> runParallelSgdComparison(size_t threads = 0, size_t epochs = 3);
+
+    // Hogwild throughput under each thread pinning and dataset placement
+    // policy; threads defaults to one per available CPU
+    [[nodiscard]] std::vector<TrainerResult> runNumaComparison(size_t threads = 0, size_t epochs = 2);
+
+    // Detected topology and the node-to-node read bandwidth matrix
+    [[nodiscard]] std::vector<std::string> describeNuma();
+
+    [[nodiscard]] std::string formatResult(const TrainerResult &result);
+}
@@ -0,0 +1,405 @@
+// =============================================================================
+// File: src/perf/PerfCounters.cpp
+// =============================================================================
+//
+// Description: Implements the perf_event_open region counters. Counters are
+//              opened individually rather than as one group, so a CPU that
+//              cannot schedule them all at once multiplexes them and each is
+//              scaled by its enabled/running time instead of the whole group
+//              failing.
+//
+// =============================================================================
+
+#include "perf/PerfCounters.h"
+
+
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+
+
+namespace
+{
+    std::atomic<bool> enabled{false};
+
+    struct Accumulator
+    {
+        std::uint64_t calls = 0;
+        double seconds = 0.0;
+        std::array<double, PerfCounters::kCounterCount> counts{};
+    };
+
+    std::mutex regions_mutex;
+    std::map<std::pair<std::string_view, int>, size_t> region_index;
+    std::vector<std::pair<std::pair<std::string_view, int>, Accumulator>> regions; // first-seen order
+
+    std::mutex status_mutex;
+    std::string open_error; // first failure reported by the kernel
+    std::array<std::atomic<bool>, PerfCounters::kCounterCount> ever_opened{};
+
+
+
+    std::int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+
+    // One counter file descriptor per event for the calling thread
+    struct ThreadCounters
+    {
+        std::array<int, PerfCounters::kCounterCount> fds;
+        bool any_open = false;
+
+        ThreadCounters()
+        {
+            fds.fill(-1);
+#ifdef __linux__
+            auto open = [&](PerfCounters::Counter counter, std::uint32_t type, std::uint64_t config) -> bool
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = type;
+                attr.config = config;
+                attr.exclude_kernel = 1; // allowed up to perf_event_paranoid 2
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+                if(fd < 0)
+                {
+                    std::lock_guard<std::mutex> lock(status_mutex);
+                    if(open_error.empty())
+                    {
+                        open_error = std::strerror(errno);
+                    }
+                    return false;
+                }
+                fds[static_cast<size_t>(counter)] = fd;
+                ever_opened[static_cast<size_t>(counter)] = true;
+                any_open = true;
+                return true;
+            };
+            auto cache = [](std::uint64_t cache_id, std::uint64_t result) -> std::uint64_t
+            {
+                return cache_id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+            };
+
+            using PerfCounters::Counter;
+            open(Counter::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            open(Counter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            // Generic cache events map to the last level on most CPUs; they
+            // are the fallback where the LL cache events are not exposed
+            if(!open(Counter::LlcReferences, PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_ACCESS)))
+            {
+                open(Counter::LlcReferences, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+            }
+            if(!open(Counter::LlcMisses, PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS)))
+            {
+                open(Counter::LlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            }
+            open(Counter::DtlbMisses, PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS));
+            open(Counter::Branches, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+            open(Counter::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+        }
+
+        ~ThreadCounters()
+        {
+#ifdef __linux__
+            for(int fd : fds)
+            {
+                if(fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        ThreadCounters(const ThreadCounters &) = delete;
+        ThreadCounters &operator=(const ThreadCounters &) = delete;
+
+        void read(std::array<std::uint64_t, PerfCounters::kCounterCount> &counts,
+                  std::array<std::uint64_t, PerfCounters::kCounterCount> &time_enabled,
+                  std::array<std::uint64_t, PerfCounters::kCounterCount> &time_running) const
+        {
+#ifdef __linux__
+            for(size_t i = 0; i < fds.size(); i++)
+            {
+                std::uint64_t values[3] = {};
+                if((fds[i] >= 0) && (::read(fds[i], values, sizeof(values)) == static_cast<ssize_t>(sizeof(values))))
+                {
+                    counts[i] = values[0];
+                    time_enabled[i] = values[1];
+                    time_running[i] = values[2];
+                }
+            }
+#else
+            (void)counts;
+            (void)time_enabled;
+            (void)time_running;
+#endif
+        }
+    };
+
+
+
+    ThreadCounters &threadCounters()
+    {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+
+
+
+    double ratio(double numerator, double denominator)
+    {
+        return (denominator > 0.0) ? numerator / denominator : 0.0;
+    }
+}
+
+
+
+namespace PerfCounters
+{
+
+double RegionStats::ipc() const noexcept
+{
+    return ratio(get(Counter::Instructions), get(Counter::Cycles));
+}
+
+
+
+double RegionStats::llcMissRate() const noexcept
+{
+    return ratio(get(Counter::LlcMisses), get(Counter::LlcReferences));
+}
+
+
+
+double RegionStats::llcMpki() const noexcept
+{
+    return ratio(1000.0 * get(Counter::LlcMisses), get(Counter::Instructions));
+}
+
+
+
+double RegionStats::dtlbMpki() const noexcept
+{
+    return ratio(1000.0 * get(Counter::DtlbMisses), get(Counter::Instructions));
+}
+
+
+
+double RegionStats::branchMissRate() const noexcept
+{
+    return ratio(get(Counter::BranchMisses), get(Counter::Branches));
+}
+
+
+
+void setEnabled(bool value)
+{
+    enabled = value;
+}
+
+
+
+bool isEnabled()
+{
+    return enabled;
+}
+
+
+
+bool available()
+{
+    return threadCounters().any_open;
+}
+
+
+
+std::string status()
+{
+#ifdef __linux__
+    const bool open = available();
+    std::ostringstream out;
+    size_t count = 0;
+    for(const auto &opened : ever_opened)
+    {
+        count += opened ? 1 : 0;
+    }
+    if(open)
+    {
+        out << "Hardware counters: " << count << "/" << kCounterCount << " events available";
+    }
+    else
+    {
+        out << "Hardware counters unavailable";
+    }
+    std::lock_guard<std::mutex> lock(status_mutex);
+    if(!open_error.empty() && (count < kCounterCount))
+    {
+        int paranoid = 0;
+        std::ifstream("/proc/sys/kernel/perf_event_paranoid") >> paranoid;
+        out << (open ? " (some failed: " : " (") << open_error << ", perf_event_paranoid " << paranoid << ")";
+    }
+    if(!open)
+    {
+        out << "; regions record wall time only";
+    }
+    return out.str();
+#else
+    return "Hardware counters require Linux perf_event_open; regions record wall time only";
+#endif
+}
+
+
+
+Region::Region(std::string_view region_name, int region_index) : name{region_name}, index{region_index}
+{
+    if(!enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    active = true;
+    threadCounters().read(start_counts, start_enabled, start_running);
+    start_ns = nowNs();
+}
+
+
+
+Region::~Region()
+{
+    if(!active)
+    {
+        return;
+    }
+    const std::int64_t end_ns = nowNs();
+    std::array<std::uint64_t, kCounterCount> counts{}, time_enabled{}, time_running{};
+    ThreadCounters &counters = threadCounters();
+    counters.read(counts, time_enabled, time_running);
+
+    std::array<double, kCounterCount> deltas{};
+    for(size_t i = 0; i < kCounterCount; i++)
+    {
+        const double running = static_cast<double>(time_running[i] - start_running[i]);
+        const double scale = (running > 0.0) ? static_cast<double>(time_enabled[i] - start_enabled[i]) / running : 1.0;
+        deltas[i] = static_cast<double>(counts[i] - start_counts[i]) * scale;
+    }
+
+    std::lock_guard<std::mutex> lock(regions_mutex);
+    const auto key = std::make_pair(name, index);
+    auto it = region_index.find(key);
+    if(it == region_index.end())
+    {
+        it = region_index.emplace(key, regions.size()).first;
+        regions.emplace_back(key, Accumulator{});
+    }
+    Accumulator &acc = regions[it->second].second;
+    acc.calls++;
+    acc.seconds += static_cast<double>(end_ns - start_ns) * 1e-9;
+    for(size_t i = 0; i < kCounterCount; i++)
+    {
+        acc.counts[i] += deltas[i];
+    }
+}
+
+
+
+std::vector<RegionStats> report()
+{
+    std::vector<RegionStats> result;
+    std::lock_guard<std::mutex> lock(regions_mutex);
+    for(const auto &[key, acc] : regions)
+    {
+        RegionStats stats;
+        stats.name = std::string(key.first);
+        if(key.second >= 0)
+        {
+            stats.name += " [" + std::to_string(key.second) + "]";
+        }
+        stats.calls = acc.calls;
+        stats.seconds = acc.seconds;
+        stats.counts = acc.counts;
+        for(size_t i = 0; i < kCounterCount; i++)
+        {
+            stats.measured[i] = ever_opened[i];
+        }
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+
+
+void reset()
+{
+    std::lock_guard<std::mutex> lock(regions_mutex);
+    region_index.clear();
+    regions.clear();
+}
+
+
+
+std::string formatRegion(const RegionStats &region)
+{
+    std::ostringstream out;
+    out << std::left << std::setw(24) << region.name << std::right << " " << std::setw(6) << region.calls << " calls "
+        << std::fixed << std::setprecision(3) << std::setw(9) << region.seconds * 1000.0 / static_cast<double>(std::max<std::uint64_t>(region.calls, 1)) << " ms";
+    if(region.has(Counter::Cycles) && region.has(Counter::Instructions))
+    {
+        out << " | IPC " << std::setprecision(2) << region.ipc();
+    }
+    if(region.has(Counter::LlcMisses))
+    {
+        out << " | LLC " << std::setprecision(2) << region.llcMpki() << " MPKI";
+        if(region.has(Counter::LlcReferences))
+        {
+            out << " (" << std::setprecision(1) << region.llcMissRate() * 100.0 << "% miss)";
+        }
+    }
+    if(region.has(Counter::DtlbMisses))
+    {
+        out << " | dTLB " << std::setprecision(3) << region.dtlbMpki() << " MPKI";
+    }
+    if(region.has(Counter::BranchMisses) && region.has(Counter::Branches))
+    {
+        out << " | branch miss " << std::setprecision(2) << region.branchMissRate() * 100.0 << "%";
+    }
+    return out.str();
+}
+
+
+
+std::vector<std::string> describe()
+{
+    std::vector<std::string> lines = {status()};
+    for(const RegionStats &region : report())
+    {
+        lines.push_back(formatRegion(region));
+    }
+    return lines;
+}
+
+} // namespace PerfCounters
@@ -0,0 +1,99 @@
+// =============================================================================
+// File: src/perf/PerfCounters.h
+// =============================================================================
+//
+// Description: Hardware performance counters around named code regions. On
+//              Linux each thread lazily opens perf_event_open counters for
+//              cycles, instructions, last-level cache references and misses,
+//              dTLB misses, branches and branch misses, restricted to user
+//              space. A PerfCounters::Region accumulates the counter deltas,
+//              wall time and call count of its scope; the report derives IPC
+//              and miss rates per region. Counters only see the thread that
+//              opened the region, so GEMM worker threads are not included
+//              unless CpuOps runs single-threaded. Where counters cannot be
+//              opened (containers, perf_event_paranoid, other platforms)
+//              regions still record calls and wall time.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+namespace PerfCounters
+{
+    enum class Counter : std::uint8_t
+    {
+        Cycles,
+        Instructions,
+        LlcReferences,
+        LlcMisses,
+        DtlbMisses,
+        Branches,
+        BranchMisses,
+    };
+
+    inline constexpr size_t kCounterCount = 7;
+
+    struct RegionStats
+    {
+        std::string name;
+        std::uint64_t calls = 0;
+        double seconds = 0.0;
+        std::array<double, kCounterCount> counts{}; // scaled for multiplexing
+        std::array<bool, kCounterCount> measured{}; // false when the counter could not be opened
+
+        [[nodiscard]] double get(Counter counter) const noexcept { return counts[static_cast<size_t>(counter)]; }
+        [[nodiscard]] bool has(Counter counter) const noexcept { return measured[static_cast<size_t>(counter)]; }
+        [[nodiscard]] double ipc() const noexcept;
+        [[nodiscard]] double llcMissRate() const noexcept;    // misses per reference
+        [[nodiscard]] double llcMpki() const noexcept;        // misses per 1000 instructions
+        [[nodiscard]] double dtlbMpki() const noexcept;
+        [[nodiscard]] double branchMissRate() const noexcept; // misses per branch
+    };
+
+    // Regions are no-ops until enabled (off by default)
+    void setEnabled(bool enabled);
+    [[nodiscard]] bool isEnabled();
+
+    // Whether counters could be opened on this thread, and why not
+    [[nodiscard]] bool available();
+    [[nodiscard]] std::string status();
+
+    // Scoped measurement. name must outlive the report (a string literal);
+    // index distinguishes instances such as layer numbers, -1 for none.
+    class Region
+    {
+    public:
+        explicit Region(std::string_view name, int index = -1);
+        ~Region();
+
+        Region(const Region &) = delete;
+        Region &operator=(const Region &) = delete;
+
+    private:
+        std::string_view name;
+        int index;
+        bool active = false;
+        std::array<std::uint64_t, kCounterCount> start_counts{};
+        std::array<std::uint64_t, kCounterCount> start_enabled{};
+        std::array<std::uint64_t, kCounterCount> start_running{};
+        std::int64_t start_ns = 0;
+    };
+
+    // Regions in first-seen order, summed over threads
+    [[nodiscard]] std::vector<RegionStats> report();
+    void reset();
+
+    [[nodiscard]] std::string formatRegion(const RegionStats &region);
+    [[nodiscard]] std::vector<std::string> describe();
+}
@@ -0,0 +1,271 @@
+// =============================================================================
+// File: src/perf/Roofline.cpp
+// =============================================================================
+//
+// Description: Implements the peak probes and the per-layer roofline profile.
+//
+// =============================================================================
+
+#include "perf/Roofline.h"
+
+
+
+#include "nn/Loss.h"
+#include "nn/Model.h"
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+
+
+    double secondsSince(clock_type::time_point start)
+    {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+
+
+    // 32 independent multiply-add chains: enough to cover the latency of the
+    // vector units without spilling registers. Returns FLOPs executed.
+    double multiplyAddProbe(double min_seconds, float &sink)
+    {
+        constexpr size_t kLanes = 32;
+        constexpr size_t kInner = 4096;
+        alignas(64) float acc[kLanes];
+        for(size_t l = 0; l < kLanes; l++)
+        {
+            acc[l] = 1.0f + static_cast<float>(l) * 1e-3f;
+        }
+        const float mul = 0.9999999f;
+        const float add = 1e-7f;
+        size_t rounds = 0;
+        const auto start = clock_type::now();
+        do
+        {
+            for(size_t r = 0; r < kInner; r++)
+            {
+                for(size_t l = 0; l < kLanes; l++)
+                {
+                    acc[l] = acc[l] * mul + add;
+                }
+            }
+            rounds++;
+        } while(secondsSince(start) < min_seconds);
+        float total = 0.0f;
+        for(float v : acc)
+        {
+            total += v;
+        }
+        sink = total;
+        return 2.0 * static_cast<double>(kLanes * kInner * rounds);
+    }
+
+
+
+    // STREAM triad a = b + s * c; counts 12 bytes per element (no
+    // write-allocate), as STREAM reports
+    double triadProbe(size_t elements, size_t repeats, float &sink)
+    {
+        std::vector<float> a(elements, 0.0f), b(elements, 1.0f), c(elements, 2.0f);
+        const float s = 3.0f;
+        double best = 1e30;
+        for(size_t r = 0; r < repeats; r++)
+        {
+            const auto start = clock_type::now();
+            for(size_t i = 0; i < elements; i++)
+            {
+                a[i] = b[i] + s * c[i];
+            }
+            best = std::min(best, secondsSince(start));
+            std::swap(a, b);
+        }
+        sink = a[elements / 2];
+        return 3.0 * static_cast<double>(elements * sizeof(float)) / best;
+    }
+
+
+
+    // Runs fn on n threads that start together; returns the summed results
+    template<typename Fn>
+    double runParallel(size_t n, Fn fn)
+    {
+        std::vector<double> results(n, 0.0);
+        std::vector<std::thread> threads;
+        for(size_t t = 1; t < n; t++)
+        {
+            threads.emplace_back([&, t] { results[t] = fn(); });
+        }
+        results[0] = fn();
+        for(auto &thread : threads)
+        {
+            thread.join();
+        }
+        double total = 0.0;
+        for(double r : results)
+        {
+            total += r;
+        }
+        return total;
+    }
+
+
+
+    const char *boundName(double intensity, const Roofline::MachinePeaks &peaks)
+    {
+        return (intensity < peaks.ridge()) ? "memory-bound" : "compute-bound";
+    }
+}
+
+
+
+namespace Roofline
+{
+
+double MachinePeaks::attainable(double intensity) const noexcept
+{
+    return std::min(gflops, intensity * gbps);
+}
+
+
+
+MachinePeaks measurePeaks(size_t threads)
+{
+    MachinePeaks peaks;
+    peaks.threads = std::max<size_t>(threads, 1);
+    std::atomic<float> keep{0.0f}; // keeps the probe results observable
+
+    const double flops = runParallel(peaks.threads, [&]
+    {
+        float sink = 0.0f;
+        const auto start = clock_type::now();
+        const double done = multiplyAddProbe(0.2, sink);
+        keep.store(sink, std::memory_order_relaxed);
+        return done / secondsSince(start);
+    });
+    peaks.gflops = flops / 1e9;
+
+    // 3 x 32 MB per thread is well past the last-level cache
+    const double bandwidth = runParallel(peaks.threads, [&]
+    {
+        float sink = 0.0f;
+        const double rate = triadProbe(size_t{8} << 20, 5, sink);
+        keep.store(sink, std::memory_order_relaxed);
+        return rate;
+    });
+    peaks.gbps = bandwidth / 1e9;
+    return peaks;
+}
+
+
+
+std::vector<LayerProfile> profileModel(Model &model, const Tensor &X, const Tensor &y, size_t iterations)
+{
+    Loss *loss = model.getLoss();
+    if(!loss)
+    {
+        throw std::runtime_error("Roofline: model must be compiled before profiling");
+    }
+    const auto &layers = model.getLayers();
+    std::vector<LayerProfile> profiles(layers.size());
+    std::vector<double> forward_ms(layers.size(), 0.0), backward_ms(layers.size(), 0.0);
+    model.setTraining(true);
+
+    // Iteration 0 is the warm-up; it also records each layer's costs
+    for(size_t it = 0; it <= iterations; it++)
+    {
+        Tensor current = X;
+        for(size_t i = 0; i < layers.size(); i++)
+        {
+            if(layers[i]->isIdentity()) { continue; }
+            if(it == 0)
+            {
+                profiles[i].index = i;
+                profiles[i].type = layers[i]->getTypeName();
+                profiles[i].forward.cost = layers[i]->forwardCost(current);
+                profiles[i].backward.cost = layers[i]->backwardCost(current);
+            }
+            const auto start = clock_type::now();
+            current = layers[i]->forward(current);
+            if(it > 0) { forward_ms[i] += secondsSince(start) * 1000.0; }
+        }
+        (void)loss->forward(current, y);
+        Tensor grad = loss->backward(current, y);
+        for(size_t i = layers.size(); i-- > 0;)
+        {
+            if(layers[i]->isIdentity()) { continue; }
+            const auto start = clock_type::now();
+            grad = layers[i]->backward(grad);
+            if(it > 0) { backward_ms[i] += secondsSince(start) * 1000.0; }
+        }
+    }
+
+    std::vector<LayerProfile> result;
+    for(size_t i = 0; i < layers.size(); i++)
+    {
+        if(profiles[i].type.empty()) { continue; } // identity in training mode
+        profiles[i].forward.ms = forward_ms[i] / static_cast<double>(std::max<size_t>(iterations, 1));
+        profiles[i].backward.ms = backward_ms[i] / static_cast<double>(std::max<size_t>(iterations, 1));
+        result.push_back(profiles[i]);
+    }
+    return result;
+}
+
+
+
+std::string formatPeaks(const MachinePeaks &peaks)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "Machine peaks (%zu thread%s): %.1f GFLOP/s multiply-add, %.1f GB/s STREAM triad, ridge %.2f FLOP/B",
+                  peaks.threads, (peaks.threads == 1) ? "" : "s", peaks.gflops, peaks.gbps, peaks.ridge());
+    return line;
+}
+
+
+
+std::string formatMeasurement(const std::string &label, const Measurement &measurement, const MachinePeaks &peaks)
+{
+    const double intensity = measurement.cost.intensity();
+    const double roof = peaks.attainable(intensity);
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-22s %8.3f ms %9.2f MFLOP %8.2f MB  AI %6.2f  %7.2f GFLOP/s %7.2f GB/s  %-13s %5.1f%% of roof",
+                  label.c_str(), measurement.ms, measurement.cost.flops / 1e6, measurement.cost.bytes / 1e6, intensity,
+                  measurement.gflops(), measurement.gbps(), boundName(intensity, peaks),
+                  (roof > 0.0) ? 100.0 * measurement.gflops() / roof : 0.0);
+    return line;
+}
+
+
+
+std::vector<std::string> report(const std::vector<LayerProfile> &layers, const MachinePeaks &peaks)
+{
+    std::vector<std::string> lines;
+    Measurement total;
+    for(const LayerProfile &layer : layers)
+    {
+        const std::string name = "[" + std::to_string(layer.index) + "] " + layer.type;
+        lines.push_back(formatMeasurement(name + " fwd", layer.forward, peaks));
+        lines.push_back(formatMeasurement(name + " bwd", layer.backward, peaks));
+        for(const Measurement *m : {&layer.forward, &layer.backward})
+        {
+            total.cost += m->cost;
+            total.ms += m->ms;
+        }
+    }
+    lines.push_back(formatMeasurement("step total", total, peaks));
+    return lines;
+}
+
+} // namespace Roofline
@@ -0,0 +1,80 @@
+// =============================================================================
+// File: src/perf/Roofline.h
+// =============================================================================
+//
+// Description: Roofline analysis of a model's layers. measurePeaks() probes
+//              the machine: a register-resident multiply-add loop gives the
+//              peak arithmetic rate and a STREAM triad over arrays larger than
+//              the caches gives the memory bandwidth, both as reached by code
+//              this binary is compiled to. profileModel() times each layer's
+//              forward and backward on a real batch and combines the times
+//              with the layers' analytic FLOP and byte counts. Each layer is
+//              then classed as compute- or bandwidth-bound by its arithmetic
+//              intensity against the ridge point, and reported as a fraction
+//              of the roof it sits under.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/nn_types.h"
+
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+
+class Model;
+
+
+
+namespace Roofline
+{
+    struct MachinePeaks
+    {
+        double gflops = 0.0;   // multiply-add throughput
+        double gbps = 0.0;     // STREAM triad bandwidth
+        size_t threads = 1;
+
+        // Arithmetic intensity (FLOP/byte) where the two roofs meet
+        [[nodiscard]] double ridge() const noexcept { return (gbps > 0.0) ? gflops / gbps : 0.0; }
+        // Best rate reachable at the given intensity
+        [[nodiscard]] double attainable(double intensity) const noexcept;
+    };
+
+    struct Measurement
+    {
+        OpCost cost;      // per call
+        double ms = 0.0;  // mean per call
+
+        [[nodiscard]] double gflops() const noexcept { return (ms > 0.0) ? cost.flops / (ms * 1e6) : 0.0; }
+        [[nodiscard]] double gbps() const noexcept { return (ms > 0.0) ? cost.bytes / (ms * 1e6) : 0.0; }
+    };
+
+    struct LayerProfile
+    {
+        size_t index = 0;
+        std::string type;
+        Measurement forward;
+        Measurement backward;
+    };
+
+    // Peaks with the given number of threads (each runs its own probe)
+    [[nodiscard]] MachinePeaks measurePeaks(size_t threads = 1);
+
+    // Forward, loss and backward on one batch, iterations times after a
+    // warm-up. Parameters are not updated.
+    [[nodiscard]] std::vector<LayerProfile> profileModel(Model &model, const Tensor &X, const Tensor &y, size_t iterations = 10);
+
+    [[nodiscard]] std::string formatPeaks(const MachinePeaks &peaks);
+    [[nodiscard]] std::string formatMeasurement(const std::string &label, const Measurement &measurement, const MachinePeaks &peaks);
+
+    // One line per layer and direction plus a step total
+    [[nodiscard]] std::vector<std::string> report(const std::vector<LayerProfile> &layers, const MachinePeaks &peaks);
+}
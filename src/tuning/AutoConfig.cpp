@@ -0,0 +1,286 @@
+// =============================================================================
+// File: src/tuning/AutoConfig.cpp
+// =============================================================================
+//
+// Description: Implements batch-size and thread-count calibration. Batch sizes
+//              are tried in increasing order; memory does not depend on the
+//              thread count, so the first batch size over budget ends the
+//              sweep.
+//
+// =============================================================================
+
+#include "tuning/AutoConfig.h"
+
+
+
+#include "backend/cpu/CpuOps.h"
+#include "backend/cpu/GemmAutotuner.h"
+#include "nn/HostMemory.h"
+#include "nn/Model.h"
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+
+
+namespace
+{
+    std::vector<size_t> defaultThreadCounts()
+    {
+        const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<size_t> counts;
+        for(size_t threads = 1; threads < hardware; threads *= 2)
+        {
+            counts.push_back(threads);
+        }
+        counts.push_back(hardware);
+        return counts;
+    }
+
+
+
+    void gatherRandomRows(const Tensor &src, const std::vector<size_t> &rows, Tensor &dst)
+    {
+        const size_t cols = src.getCols();
+        if((dst.getRows() != rows.size()) || (dst.getCols() != cols))
+        {
+            dst = Tensor{{rows.size(), cols}};
+        }
+        for(size_t i = 0; i < rows.size(); i++)
+        {
+            std::copy_n(src.getCpuData() + rows[i] * cols, cols, dst.getCpuData() + i * cols);
+        }
+    }
+
+
+
+    // Snapshots the model and restores it after every candidate, so each one
+    // starts from the same state and the caller gets back the weights,
+    // optimizer state and step count it had. Also restores the learning
+    // rate, health sampling, thread count and shape recording however
+    // calibration ends.
+    class CalibrationGuard
+    {
+    public:
+        explicit CalibrationGuard(Model &model)
+            : model{model}, saved{model.snapshot()}, learning_rate{model.getOptimizer()->getLearningRate()},
+              health_interval{model.getHealthInterval()}, threads{CpuOps::getThreads()}
+        {
+            model.getOptimizer()->setLearningRate(0.0f);
+            model.setHealthInterval(0);
+            GemmAutotuner::setRecording(false);
+        }
+
+        ~CalibrationGuard()
+        {
+            model.restore(saved);
+            model.getOptimizer()->setLearningRate(learning_rate);
+            model.setHealthInterval(health_interval);
+            GemmAutotuner::setRecording(true);
+            if(!committed)
+            {
+                CpuOps::setThreads(threads);
+            }
+        }
+
+        CalibrationGuard(const CalibrationGuard &) = delete;
+        CalibrationGuard &operator=(const CalibrationGuard &) = delete;
+
+        void reset() { model.restore(saved); }
+        void commit() { committed = true; }
+        [[nodiscard]] float getLearningRate() const noexcept { return learning_rate; }
+
+    private:
+        Model &model;
+        Model::Snapshot saved;
+        float learning_rate;
+        size_t health_interval;
+        size_t threads;
+        bool committed = false;
+    };
+
+
+
+    CalibrationPoint measure(Model &model, const Tensor &X, const Tensor &y, size_t batch, size_t threads,
+                             std::uint64_t baseline, const AutoConfigOptions &options, std::mt19937_64 &rng)
+    {
+        using clock = std::chrono::steady_clock;
+        CpuOps::setThreads(threads);
+        std::uniform_int_distribution<size_t> pick(0, X.getRows() - 1);
+        std::vector<size_t> rows(batch);
+        Tensor xb, yb;
+        auto step = [&]
+        {
+            for(size_t &row : rows)
+            {
+                row = pick(rng);
+            }
+            gatherRandomRows(X, rows, xb);
+            gatherRandomRows(y, rows, yb);
+            (void)model.train_step(xb, yb);
+        };
+
+        // After the warm-up the layers' cached activations are sized for this
+        // batch, so the peak counts them and the step's temporaries but not
+        // the previous candidate's
+        for(size_t i = 0; i < options.warmup_steps; i++)
+        {
+            step();
+        }
+        HostMemory::resetPeak();
+
+        size_t steps = 0;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+        do
+        {
+            step();
+            steps++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while((steps < options.measure_steps) && (elapsed < options.max_seconds_per_candidate));
+
+        CalibrationPoint point;
+        point.batch_size = batch;
+        point.threads = threads;
+        point.samples_per_second = (elapsed > 0.0) ? static_cast<double>(steps * batch) / elapsed : 0.0;
+        point.step_bytes = HostMemory::peakBytes() - std::min(baseline, HostMemory::peakBytes());
+        point.within_budget = (options.memory_budget_bytes == 0) || (point.step_bytes <= options.memory_budget_bytes);
+        return point;
+    }
+}
+
+
+
+namespace AutoConfig
+{
+
+AutoConfigResult calibrate(Model &model, const Tensor &X, const Tensor &y, const AutoConfigOptions &options)
+{
+    if(!model.getOptimizer() || !model.getLoss())
+    {
+        throw std::runtime_error("AutoConfig: model must be compiled before calibration");
+    }
+    if((X.getRows() == 0) || (X.getRows() != y.getRows()))
+    {
+        throw std::invalid_argument("AutoConfig: inputs and targets must be non-empty with matching rows");
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<size_t> batch_sizes = options.batch_sizes;
+    std::sort(batch_sizes.begin(), batch_sizes.end());
+    batch_sizes.erase(std::unique(batch_sizes.begin(), batch_sizes.end()), batch_sizes.end());
+    std::erase_if(batch_sizes, [&](size_t batch) { return (batch == 0) || (batch > X.getRows()); });
+    if(batch_sizes.empty())
+    {
+        batch_sizes.push_back(X.getRows());
+    }
+    const std::vector<size_t> thread_counts = options.thread_counts.empty() ? defaultThreadCounts() : options.thread_counts;
+
+    // Parameters, optimizer state, their snapshot and the dataset are live
+    // before the first step; everything above them is charged to the batch
+    // size
+    CalibrationGuard guard(model);
+    const std::uint64_t baseline = HostMemory::liveBytes();
+    std::mt19937_64 rng(options.seed);
+    AutoConfigResult result;
+    model.setTraining(true);
+    for(size_t batch : batch_sizes)
+    {
+        bool over_budget = false;
+        for(size_t threads : thread_counts)
+        {
+            result.points.push_back(measure(model, X, y, batch, std::max<size_t>(threads, 1), baseline, options, rng));
+            guard.reset();
+            if(!result.points.back().within_budget)
+            {
+                over_budget = true;
+                break;
+            }
+        }
+        if(over_budget)
+        {
+            break;
+        }
+    }
+
+    // Fastest within budget; among near ties the smaller batch (better
+    // generalization per sample) and then the fewer threads win
+    double best_rate = 0.0;
+    for(const CalibrationPoint &point : result.points)
+    {
+        if(point.within_budget)
+        {
+            best_rate = std::max(best_rate, point.samples_per_second);
+        }
+    }
+    const CalibrationPoint *chosen = nullptr;
+    for(const CalibrationPoint &point : result.points)
+    {
+        if(point.within_budget && (point.samples_per_second >= best_rate * (1.0 - options.tie_tolerance)))
+        {
+            chosen = &point;
+            break; // points are ordered by batch size, then thread count
+        }
+    }
+    if(!chosen)
+    {
+        throw std::runtime_error("AutoConfig: no candidate fits the memory budget");
+    }
+
+    result.batch_size = chosen->batch_size;
+    result.threads = chosen->threads;
+    result.samples_per_second = chosen->samples_per_second;
+    result.step_bytes = chosen->step_bytes;
+    const double ratio = static_cast<double>(result.batch_size) / static_cast<double>(std::max<size_t>(options.reference_batch_size, 1));
+    switch(options.scaling)
+    {
+        case LearningRateScaling::None:
+            result.learning_rate = guard.getLearningRate();
+            break;
+        case LearningRateScaling::Linear:
+            result.learning_rate = static_cast<float>(guard.getLearningRate() * ratio);
+            break;
+        case LearningRateScaling::Sqrt:
+            result.learning_rate = static_cast<float>(guard.getLearningRate() * std::sqrt(ratio));
+            break;
+    }
+
+    CpuOps::setThreads(result.threads);
+    guard.commit();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+
+
+std::string formatPoint(const CalibrationPoint &point)
+{
+    std::ostringstream out;
+    out << "batch " << std::setw(4) << point.batch_size << ", " << std::setw(2) << point.threads << " threads: "
+        << std::fixed << std::setprecision(0) << std::setw(9) << point.samples_per_second << " samples/s, step memory "
+        << std::setprecision(1) << static_cast<double>(point.step_bytes) / (1024.0 * 1024.0) << " MB"
+        << (point.within_budget ? "" : " (over budget)");
+    return out.str();
+}
+
+
+
+std::string describe(const AutoConfigResult &result)
+{
+    std::ostringstream out;
+    out << "Auto-config: batch " << result.batch_size << ", " << result.threads << " GEMM threads, lr " << result.learning_rate
+        << " | " << std::fixed << std::setprecision(0) << result.samples_per_second << " samples/s, step memory "
+        << std::setprecision(1) << static_cast<double>(result.step_bytes) / (1024.0 * 1024.0) << " MB"
+        << " | " << result.points.size() << " candidates in " << result.seconds << " s";
+    return out.str();
+}
+
+} // namespace AutoConfig
@@ -0,0 +1,96 @@
+// =============================================================================
+// File: src/tuning/AutoConfig.h
+// =============================================================================
+//
+// Description: Picks the training batch size and GEMM thread count for this
+//              machine by measurement. Every candidate pair runs a few real
+//              train_step calls on rows of the training set, recording
+//              samples/s and the peak Tensor memory of a step. The fastest
+//              configuration whose step memory fits the budget wins; near
+//              ties go to the smaller batch and the fewer threads. The
+//              learning rate can be rescaled to the chosen batch size.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+class Model;
+
+
+
+enum class LearningRateScaling : std::uint8_t
+{
+    None,
+    Linear, // lr * batch / reference_batch (Goyal et al.)
+    Sqrt,   // lr * sqrt(batch / reference_batch), gentler for Adam
+};
+
+
+
+struct AutoConfigOptions
+{
+    std::vector<size_t> batch_sizes = {16, 32, 64, 128, 256, 512};
+    std::vector<size_t> thread_counts;              // empty = 1, 2, 4, ... up to the hardware threads
+    std::uint64_t memory_budget_bytes = 1ull << 30; // activations and temporaries of one step; 0 = unlimited
+    size_t warmup_steps = 2;
+    size_t measure_steps = 8;
+    double max_seconds_per_candidate = 0.5;          // measurement stops early after this long
+    double tie_tolerance = 0.05;                     // within 5% of the best counts as a tie
+    LearningRateScaling scaling = LearningRateScaling::None;
+    size_t reference_batch_size = 64;               // batch size the current learning rate was chosen for
+    std::uint64_t seed = 42;
+};
+
+
+
+struct CalibrationPoint
+{
+    size_t batch_size = 0;
+    size_t threads = 0;
+    double samples_per_second = 0.0;
+    std::uint64_t step_bytes = 0; // peak Tensor bytes above the live set before calibration
+    bool within_budget = true;
+};
+
+
+
+struct AutoConfigResult
+{
+    std::vector<CalibrationPoint> points;
+    size_t batch_size = 0;
+    size_t threads = 0;
+    float learning_rate = 0.0f;   // rescaled for batch_size when scaling is enabled
+    double samples_per_second = 0.0;
+    std::uint64_t step_bytes = 0;
+    double seconds = 0.0;         // total calibration time
+};
+
+
+
+namespace AutoConfig
+{
+    // Calibrates on rows of X/y. The model is snapshotted first and restored
+    // after every candidate, so its weights, normalization statistics,
+    // pruning masks, optimizer state and step count end as they started; the
+    // learning rate is held at zero while measuring and no health reports
+    // are sampled. The chosen thread count is applied through
+    // CpuOps::setThreads; batch size and learning rate are returned for the
+    // caller to apply.
+    [[nodiscard]] AutoConfigResult calibrate(Model &model, const Tensor &X, const Tensor &y, const AutoConfigOptions &options = {});
+
+    [[nodiscard]] std::string formatPoint(const CalibrationPoint &point);
+    [[nodiscard]] std::string describe(const AutoConfigResult &result);
+}
@@ -0,0 +1,549 @@
+// =============================================================================
+// File: src/tuning/HyperparameterSearch.cpp
+// =============================================================================
+//
+// Description: Implements the concurrent hyperparameter search. A shared
+//              scheduler hands out jobs ("train trial T up to E epochs") to a
+//              fixed set of worker threads; under ASHA a job is either a
+//              promotion of a finished trial to the next rung or a fresh trial
+//              at the lowest rung, so workers never wait for a rung to fill.
+//
+// =============================================================================
+
+#include "tuning/HyperparameterSearch.h"
+
+
+
+#include "nn/Loss.h"
+#include "nn/Model.h"
+#include "nn/layers/Activation.h"
+#include "nn/layers/Dense.h"
+#include "nn/layers/Softmax.h"
+#include "nn/optimizers/Adam.h"
+#include "nn/optimizers/SGD.h"
+
+
+
+#include "nlohmann/json.hpp"
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+
+
+namespace
+{
+    struct Trial
+    {
+        TrialResult result;
+        std::unique_ptr<Model> model;
+        std::mt19937_64 rng;
+        std::vector<size_t> order; // sample order of the current epoch
+        size_t order_pos = 0;
+        float first_epoch_loss = 0.0f;
+        bool running = false;
+        bool finished = false;     // diverged, failed or at the final budget
+        std::vector<bool> promoted; // per rung
+    };
+
+
+
+    struct Job
+    {
+        Trial *trial = nullptr;
+        size_t target_epochs = 0;
+        size_t rung = 0;
+    };
+
+
+
+    std::unique_ptr<Model> buildModel(const TrialConfig &config, size_t inputs, size_t classes)
+    {
+        auto model = std::make_unique<Model>();
+        size_t width = inputs;
+        for(size_t hidden : config.hidden_layers)
+        {
+            model->add(std::make_unique<Dense>(width, hidden));
+            model->add(std::make_unique<Activation>(config.activation));
+            width = hidden;
+        }
+        model->add(std::make_unique<Dense>(width, classes));
+        model->add(std::make_unique<Softmax>());
+
+        std::unique_ptr<Optimizer> optimizer;
+        if(config.optimizer == "sgd")
+        {
+            optimizer = std::make_unique<SGD>(config.learning_rate);
+        }
+        else if(config.optimizer == "adam")
+        {
+            optimizer = std::make_unique<Adam>(config.learning_rate);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown optimizer in search space: " + config.optimizer);
+        }
+        model->compile(std::make_unique<CrossEntropyLoss>(), std::move(optimizer));
+        return model;
+    }
+
+
+
+    // Copies the listed rows of a shared tensor into a trial-owned batch
+    void gatherRows(const Tensor &src, const size_t *rows, size_t count, Tensor &dst)
+    {
+        const size_t cols = src.getCols();
+        if((dst.getRows() != count) || (dst.getCols() != cols))
+        {
+            dst = Tensor{{count, cols}};
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            std::copy_n(src.getCpuData() + rows[i] * cols, cols, dst.getCpuData() + i * cols);
+        }
+    }
+
+
+
+    // Mean cross-entropy and accuracy on the first `limit` rows, in chunks
+    std::pair<float, float> evaluate(Model &model, const Tensor &X, const Tensor &y, size_t limit)
+    {
+        const size_t rows = std::min(limit, X.getRows());
+        if(rows == 0) { return {0.0f, 0.0f}; }
+        constexpr size_t kChunk = 1024;
+        std::vector<size_t> index(std::min(kChunk, rows));
+        Tensor xb, yb;
+        CrossEntropyLoss loss;
+        double loss_sum = 0.0;
+        size_t correct = 0;
+
+        model.setTraining(false);
+        for(size_t start = 0; start < rows; start += kChunk)
+        {
+            const size_t count = std::min(kChunk, rows - start);
+            index.resize(count);
+            std::iota(index.begin(), index.end(), start);
+            gatherRows(X, index.data(), count, xb);
+            gatherRows(y, index.data(), count, yb);
+            Tensor pred = model.forward(xb);
+            loss_sum += static_cast<double>(loss.forward(pred, yb)) * static_cast<double>(count);
+
+            const size_t classes = pred.getCols();
+            for(size_t i = 0; i < count; i++)
+            {
+                const float *p = pred.getCpuData() + i * classes;
+                const size_t predicted = static_cast<size_t>(std::max_element(p, p + classes) - p);
+                size_t truth = 0;
+                if(yb.getCols() == 1)
+                {
+                    truth = static_cast<size_t>(yb.getCpuData()[i]);
+                }
+                else
+                {
+                    const float *t = yb.getCpuData() + i * yb.getCols();
+                    truth = static_cast<size_t>(std::max_element(t, t + yb.getCols()) - t);
+                }
+                if(predicted == truth) { correct++; }
+            }
+        }
+        model.setTraining(true);
+        return {static_cast<float>(loss_sum / static_cast<double>(rows)), static_cast<float>(correct) / static_cast<float>(rows)};
+    }
+
+
+
+    std::vector<TrialConfig> gridConfigs(const SearchSpace &space, size_t limit)
+    {
+        std::vector<TrialConfig> configs;
+        for(const auto &hidden : space.hidden_layers)
+        {
+            for(const auto &opt : space.optimizers)
+            {
+                for(ActivationType act : space.activations)
+                {
+                    for(size_t batch : space.batch_sizes)
+                    {
+                        for(float lr : space.learning_rates)
+                        {
+                            if(configs.size() == limit) { return configs; }
+                            TrialConfig config;
+                            config.id = configs.size();
+                            config.learning_rate = lr;
+                            config.batch_size = batch;
+                            config.hidden_layers = hidden;
+                            config.optimizer = opt;
+                            config.activation = act;
+                            configs.push_back(std::move(config));
+                        }
+                    }
+                }
+            }
+        }
+        return configs;
+    }
+
+
+
+    TrialConfig randomConfig(const SearchSpace &space, size_t id, std::mt19937_64 &rng)
+    {
+        auto pick = [&rng](const auto &values) -> const auto &
+        {
+            std::uniform_int_distribution<size_t> dist(0, values.size() - 1);
+            return values[dist(rng)];
+        };
+        std::uniform_real_distribution<float> exponent(std::log(space.learning_rate_min), std::log(space.learning_rate_max));
+        TrialConfig config;
+        config.id = id;
+        config.learning_rate = std::exp(exponent(rng));
+        config.batch_size = pick(space.batch_sizes);
+        config.hidden_layers = pick(space.hidden_layers);
+        config.optimizer = pick(space.optimizers);
+        config.activation = pick(space.activations);
+        return config;
+    }
+}
+
+
+
+HyperparameterSearch::HyperparameterSearch(const Tensor &X_train, const Tensor &y_train, const Tensor &X_val, const Tensor &y_val)
+    : X_train{X_train}, y_train{y_train}, X_val{X_val}, y_val{y_val}, num_classes{0}
+{
+    if((X_train.getRows() == 0) || (X_train.getRows() != y_train.getRows()) || (X_val.getRows() != y_val.getRows()))
+    {
+        throw std::invalid_argument("HyperparameterSearch needs non-empty inputs with matching target rows.");
+    }
+    if(y_train.getCols() > 1)
+    {
+        num_classes = y_train.getCols();
+    }
+    else
+    {
+        const float *labels = y_train.getCpuData();
+        num_classes = static_cast<size_t>(*std::max_element(labels, labels + y_train.getRows())) + 1;
+    }
+}
+
+
+
+std::vector<TrialResult> HyperparameterSearch::run(const SearchSpace &space, const SearchOptions &options, const TrialCallback &on_trial)
+{
+    if(space.batch_sizes.empty() || space.hidden_layers.empty() || space.optimizers.empty() || space.activations.empty() ||
+       ((options.strategy == SearchStrategy::Grid) && space.learning_rates.empty()))
+    {
+        throw std::invalid_argument("Search space has an empty dimension.");
+    }
+    if((options.max_epochs == 0) || (options.num_trials == 0))
+    {
+        throw std::invalid_argument("Search needs at least one trial and one epoch.");
+    }
+    cancelled = false;
+    const auto wall_start = std::chrono::steady_clock::now();
+
+    // Epoch budgets per rung; Grid and Random use a single rung
+    std::vector<size_t> budgets;
+    if(options.strategy == SearchStrategy::ASHA)
+    {
+        const size_t eta = std::max<size_t>(2, options.reduction_factor);
+        for(size_t b = std::max<size_t>(1, options.min_epochs); b < options.max_epochs; b *= eta)
+        {
+            budgets.push_back(b);
+        }
+    }
+    budgets.push_back(options.max_epochs);
+
+    std::vector<TrialConfig> configs;
+    if(options.strategy == SearchStrategy::Grid)
+    {
+        configs = gridConfigs(space, options.num_trials);
+    }
+    else
+    {
+        std::mt19937_64 rng(options.seed);
+        for(size_t i = 0; i < options.num_trials; i++)
+        {
+            configs.push_back(randomConfig(space, i, rng));
+        }
+    }
+
+    std::vector<std::unique_ptr<Trial>> trials;
+    std::vector<std::vector<std::pair<float, Trial *>>> rung_results(budgets.size());
+    size_t next_config = 0;
+    size_t running = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::mutex callback_mutex;
+
+    // Called with the lock held. Promotions first, from the highest rung, so
+    // promising trials reach the full budget as early as possible.
+    auto nextJob = [&]() -> Job
+    {
+        const size_t eta = std::max<size_t>(2, options.reduction_factor);
+        for(size_t k = budgets.size() - 1; k-- > 0;)
+        {
+            auto &finished = rung_results[k];
+            std::sort(finished.begin(), finished.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            const size_t top = finished.size() / eta;
+            for(size_t i = 0; i < top; i++)
+            {
+                Trial *t = finished[i].second;
+                if((!t->promoted[k]) && (!t->finished))
+                {
+                    t->promoted[k] = true;
+                    return Job{t, budgets[k + 1], k + 1};
+                }
+            }
+        }
+        if(next_config < configs.size())
+        {
+            auto trial = std::make_unique<Trial>();
+            trial->result.config = configs[next_config++];
+            trial->rng.seed(options.seed ^ (0x9E3779B97F4A7C15ull * (trial->result.config.id + 1)));
+            trial->promoted.assign(budgets.size(), false);
+            trials.push_back(std::move(trial));
+            return Job{trials.back().get(), budgets[0], 0};
+        }
+        return Job{};
+    };
+
+    auto runJob = [&](const Job &job)
+    {
+        Trial &trial = *job.trial;
+        TrialResult &result = trial.result;
+        const TrialConfig &config = result.config;
+        const auto t0 = std::chrono::steady_clock::now();
+        try
+        {
+            if(!trial.model)
+            {
+                trial.model = buildModel(config, X_train.getCols(), num_classes);
+                trial.order.resize(X_train.getRows());
+                std::iota(trial.order.begin(), trial.order.end(), 0);
+                trial.order_pos = trial.order.size();
+            }
+            const size_t per_epoch = (options.samples_per_epoch == 0) ? X_train.getRows() : std::min(options.samples_per_epoch, X_train.getRows());
+            const size_t steps = std::max<size_t>(1, per_epoch / config.batch_size);
+            const size_t batch = std::min(config.batch_size, X_train.getRows());
+            Tensor xb, yb;
+
+            while((result.epochs_run < job.target_epochs) && (!cancelled))
+            {
+                double epoch_loss = 0.0;
+                for(size_t s = 0; (s < steps) && (!cancelled); s++)
+                {
+                    if((trial.order_pos + batch) > trial.order.size())
+                    {
+                        std::shuffle(trial.order.begin(), trial.order.end(), trial.rng);
+                        trial.order_pos = 0;
+                    }
+                    gatherRows(X_train, trial.order.data() + trial.order_pos, batch, xb);
+                    gatherRows(y_train, trial.order.data() + trial.order_pos, batch, yb);
+                    trial.order_pos += batch;
+                    epoch_loss += trial.model->train_step(xb, yb);
+                }
+                if(cancelled) { break; }
+                result.epochs_run++;
+                result.train_loss = static_cast<float>(epoch_loss / static_cast<double>(steps));
+                if(result.epochs_run == 1) { trial.first_epoch_loss = result.train_loss; }
+                if((!std::isfinite(result.train_loss)) ||
+                   ((result.epochs_run > 1) && (result.train_loss > options.divergence_factor * trial.first_epoch_loss)))
+                {
+                    result.status = TrialStatus::Diverged;
+                    trial.finished = true;
+                    break;
+                }
+            }
+
+            if(!trial.finished)
+            {
+                const auto [val_loss, val_accuracy] = evaluate(*trial.model, X_val, y_val, options.eval_samples);
+                result.val_loss = val_loss;
+                result.val_accuracy = val_accuracy;
+                result.rung = job.rung;
+                if(!std::isfinite(val_loss))
+                {
+                    result.status = TrialStatus::Diverged;
+                    trial.finished = true;
+                }
+                else if(cancelled)
+                {
+                    result.status = TrialStatus::Stopped;
+                    trial.finished = true;
+                }
+                else if(job.target_epochs >= options.max_epochs)
+                {
+                    result.status = TrialStatus::Completed;
+                    trial.finished = true;
+                }
+            }
+        }
+        catch(const std::exception &e)
+        {
+            result.status = TrialStatus::Failed;
+            result.error = e.what();
+            trial.finished = true;
+        }
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        // Models of trials that cannot continue are released right away
+        if(trial.finished)
+        {
+            trial.model.reset();
+            trial.order = {};
+        }
+        if(on_trial)
+        {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            on_trial(result);
+        }
+    };
+
+    size_t workers = (options.concurrency != 0) ? options.concurrency : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, configs.size());
+    std::vector<std::thread> threads;
+    for(size_t w = 0; w < workers; w++)
+    {
+        threads.emplace_back([&]()
+        {
+            for(;;)
+            {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]()
+                    {
+                        if(cancelled) { return true; }
+                        job = nextJob();
+                        return (job.trial != nullptr) || (running == 0);
+                    });
+                    if((job.trial == nullptr) || cancelled)
+                    {
+                        if(job.trial) { job.trial->finished = true; }
+                        cv.notify_all();
+                        return;
+                    }
+                    job.trial->running = true;
+                    running++;
+                }
+
+                runJob(job);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    job.trial->running = false;
+                    running--;
+                    if((!job.trial->finished) && (job.rung + 1 < budgets.size()))
+                    {
+                        rung_results[job.rung].emplace_back(job.trial->result.val_loss, job.trial);
+                    }
+                }
+                cv.notify_all();
+            }
+        });
+    }
+    for(auto &t : threads)
+    {
+        t.join();
+    }
+
+    std::vector<TrialResult> results;
+    for(auto &trial : trials)
+    {
+        if(!trial->finished)
+        {
+            // Never promoted past an intermediate rung
+            trial->result.status = TrialStatus::Stopped;
+        }
+        results.push_back(trial->result);
+    }
+    std::stable_sort(results.begin(), results.end(), [](const TrialResult &a, const TrialResult &b)
+    {
+        const bool a_ok = (a.status == TrialStatus::Completed) || (a.status == TrialStatus::Stopped);
+        const bool b_ok = (b.status == TrialStatus::Completed) || (b.status == TrialStatus::Stopped);
+        if(a_ok != b_ok) { return a_ok; }
+        if(a.epochs_run != b.epochs_run) { return a.epochs_run > b.epochs_run; }
+        return a.val_loss < b.val_loss;
+    });
+    last_wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return results;
+}
+
+
+
+const char *HyperparameterSearch::statusName(TrialStatus status)
+{
+    switch(status)
+    {
+        case TrialStatus::Completed: return "completed";
+        case TrialStatus::Stopped: return "stopped";
+        case TrialStatus::Diverged: return "diverged";
+        case TrialStatus::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+
+
+std::string HyperparameterSearch::toJson(const std::vector<TrialResult> &results, const SearchOptions &options, double wall_seconds)
+{
+    static const char *strategies[] = {"grid", "random", "asha"};
+    nlohmann::json report;
+    report["strategy"] = strategies[static_cast<size_t>(options.strategy)];
+    report["max_epochs"] = options.max_epochs;
+    report["min_epochs"] = options.min_epochs;
+    report["reduction_factor"] = options.reduction_factor;
+    report["seed"] = options.seed;
+    report["wall_seconds"] = wall_seconds;
+
+    double trial_seconds = 0.0;
+    nlohmann::json trials = nlohmann::json::array();
+    for(const auto &r : results)
+    {
+        trial_seconds += r.seconds;
+        nlohmann::json t;
+        t["id"] = r.config.id;
+        t["learning_rate"] = r.config.learning_rate;
+        t["batch_size"] = r.config.batch_size;
+        t["hidden_layers"] = r.config.hidden_layers;
+        t["optimizer"] = r.config.optimizer;
+        t["activation"] = (r.config.activation == ActivationType::ReLU) ? "relu" : "sigmoid";
+        t["status"] = statusName(r.status);
+        t["epochs"] = r.epochs_run;
+        t["rung"] = r.rung;
+        t["train_loss"] = std::isfinite(r.train_loss) ? nlohmann::json(r.train_loss) : nlohmann::json(nullptr);
+        t["val_loss"] = std::isfinite(r.val_loss) ? nlohmann::json(r.val_loss) : nlohmann::json(nullptr);
+        t["val_accuracy"] = r.val_accuracy;
+        t["seconds"] = r.seconds;
+        if(!r.error.empty()) { t["error"] = r.error; }
+        trials.push_back(std::move(t));
+    }
+    report["trials"] = std::move(trials);
+    report["trial_seconds"] = trial_seconds;
+    // Summed trial time over wall time: how many cores the search kept busy
+    report["parallel_speedup"] = (wall_seconds > 0.0) ? trial_seconds / wall_seconds : 0.0;
+    if(!results.empty())
+    {
+        report["best_id"] = results.front().config.id;
+    }
+    return report.dump(2);
+}
+
+
+
+bool HyperparameterSearch::writeReport(const std::string &path, const std::vector<TrialResult> &results, const SearchOptions &options, double wall_seconds)
+{
+    std::ofstream file(path);
+    if(!file) { return false; }
+    file << toJson(results, options, wall_seconds) << '\n';
+    return static_cast<bool>(file);
+}
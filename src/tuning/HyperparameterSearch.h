@@ -0,0 +1,140 @@
+// =============================================================================
+// File: src/tuning/HyperparameterSearch.h
+// =============================================================================
+//
+// Description: Declares HyperparameterSearch, which trains many small MLP
+//              trials concurrently against one shared, read-only copy of the
+//              dataset. Each worker thread owns one trial at a time and draws
+//              its own batches, so no data is copied per trial beyond the
+//              current batch. Grid, random and asynchronous successive halving
+//              (ASHA) strategies are supported; ASHA stops trials that fall
+//              out of the top 1/eta of their rung. Results can be written to a
+//              JSON report.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+#include "nn/nn_types.h"
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+
+enum class SearchStrategy : std::uint8_t
+{
+    Grid,
+    Random,
+    ASHA,
+};
+
+
+
+enum class TrialStatus : std::uint8_t
+{
+    Completed, // trained for the full epoch budget
+    Stopped,   // terminated early by successive halving or cancellation
+    Diverged,  // loss became NaN/Inf or exploded
+    Failed,    // threw an exception
+};
+
+
+
+struct SearchSpace
+{
+    // Grid uses the listed rates; Random and ASHA sample log-uniformly in
+    // [learning_rate_min, learning_rate_max]
+    std::vector<float> learning_rates = {1e-3f, 3e-3f, 1e-2f};
+    float learning_rate_min = 1e-4f;
+    float learning_rate_max = 3e-2f;
+    std::vector<size_t> batch_sizes = {32, 64, 128};
+    std::vector<std::vector<size_t>> hidden_layers = {{128}, {256, 128}, {512, 256}};
+    std::vector<std::string> optimizers = {"adam", "sgd"};
+    std::vector<ActivationType> activations = {ActivationType::ReLU};
+};
+
+
+
+struct SearchOptions
+{
+    SearchStrategy strategy = SearchStrategy::ASHA;
+    size_t num_trials = 32;            // cap for Grid, sample count for Random/ASHA
+    size_t max_epochs = 4;
+    size_t min_epochs = 1;             // ASHA: budget of the lowest rung
+    size_t reduction_factor = 3;       // ASHA: eta, promote the top 1/eta of a rung
+    size_t concurrency = 0;            // worker threads, 0 = hardware concurrency
+    size_t samples_per_epoch = 0;      // 0 = the whole training set
+    size_t eval_samples = 2000;        // validation rows scored after each budget
+    float divergence_factor = 4.0f;    // stop when epoch loss exceeds this multiple of the first
+    std::uint64_t seed = 42;
+};
+
+
+
+struct TrialConfig
+{
+    size_t id = 0;
+    float learning_rate = 0.0f;
+    size_t batch_size = 0;
+    std::vector<size_t> hidden_layers;
+    std::string optimizer;
+    ActivationType activation = ActivationType::ReLU;
+};
+
+
+
+struct TrialResult
+{
+    TrialConfig config;
+    TrialStatus status = TrialStatus::Stopped;
+    size_t epochs_run = 0;
+    size_t rung = 0;              // highest ASHA rung reached
+    float train_loss = 0.0f;      // mean loss of the last epoch
+    float val_loss = 0.0f;
+    float val_accuracy = 0.0f;
+    double seconds = 0.0;         // training and evaluation time of this trial
+    std::string error;
+};
+
+
+
+class HyperparameterSearch
+{
+public:
+    using TrialCallback = std::function<void(const TrialResult &)>;
+
+    // The tensors are referenced, not copied, and must stay unchanged while
+    // run() executes. Targets may be one-hot or a single column of indices.
+    HyperparameterSearch(const Tensor &X_train, const Tensor &y_train, const Tensor &X_val, const Tensor &y_val);
+
+    // Runs the search and returns every trial, best validation loss first.
+    // on_trial is invoked (serialized) each time a trial reaches a budget.
+    [[nodiscard]] std::vector<TrialResult> run(const SearchSpace &space, const SearchOptions &options, const TrialCallback &on_trial = {});
+
+    // Asks running trials to stop at their next batch
+    void cancel() { cancelled = true; }
+
+    [[nodiscard]] static std::string toJson(const std::vector<TrialResult> &results, const SearchOptions &options, double wall_seconds);
+    [[nodiscard]] static bool writeReport(const std::string &path, const std::vector<TrialResult> &results, const SearchOptions &options, double wall_seconds);
+    [[nodiscard]] static const char *statusName(TrialStatus status);
+
+    [[nodiscard]] double getLastWallSeconds() const noexcept { return last_wall_seconds; }
+
+private:
+    const Tensor &X_train;
+    const Tensor &y_train;
+    const Tensor &X_val;
+    const Tensor &y_val;
+    size_t num_classes;
+    std::atomic<bool> cancelled{false};
+    double last_wall_seconds = 0.0;
+};
@@ -0,0 +1,512 @@
+// =============================================================================
+// File: src/utils/EventLog.cpp
+// =============================================================================
+//
+// Description: Implements the event log. Each producing thread owns a ring of
+//              1024 records registered once in a global list; head and tail
+//              sit on separate cache lines and are the only shared state
+//              between the producer and the drain thread.
+//
+// =============================================================================
+
+#include "utils/EventLog.h"
+
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+    enum class Kind : std::uint8_t
+    {
+        Message,
+        Step,
+        Epoch,
+        Eval,
+        Timing,
+    };
+
+    // Numeric fields of a record, in output order; a NaN loss is a value,
+    // so presence is tracked separately
+    enum Field : std::uint8_t
+    {
+        Loss,
+        Accuracy,
+        SamplesPerSecond,
+        Milliseconds,
+        FieldCount,
+    };
+    constexpr const char *kFieldNames[FieldCount] = {"loss", "accuracy", "samples_per_s", "ms"};
+
+    struct Record
+    {
+        std::int64_t unix_us = 0;
+        Kind kind = Kind::Message;
+        std::uint8_t present = 0; // bit per Field
+        std::uint32_t epoch = 0;
+        std::uint64_t step = 0;
+        double values[FieldCount] = {};
+        char text[200] = {};
+        std::shared_ptr<const std::string> long_text; // set instead of text when it does not fit
+
+        void set(Field field, double value) noexcept
+        {
+            values[field] = value;
+            present |= static_cast<std::uint8_t>(1u << field);
+        }
+        [[nodiscard]] bool has(Field field) const noexcept { return (present >> field) & 1u; }
+        [[nodiscard]] const char *textData() const noexcept { return long_text ? long_text->c_str() : text; }
+    };
+
+    struct Ring
+    {
+        static constexpr size_t kCapacity = 1024; // power of two
+        std::array<Record, kCapacity> slots;
+        alignas(64) std::atomic<size_t> head{0}; // next write, advanced by the owning thread
+        alignas(64) std::atomic<size_t> tail{0}; // next read, advanced by the drain thread
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<Ring>> registry;
+
+    std::atomic<bool> is_running{false};
+    std::atomic<bool> has_file{false}; // nothing is queued without one
+    std::atomic<bool> echo_console{true};
+    std::atomic<size_t> step_interval{1};
+    std::atomic<std::uint64_t> dropped_records{0};
+    std::atomic<std::uint64_t> written_records{0};
+
+    // Drain thread state, guarded by state_mutex
+    std::mutex state_mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::thread drain_thread;
+    EventLog::Options active;
+    std::ofstream file;
+    bool stopping = false;
+    std::uint64_t flush_requested = 0;
+    std::uint64_t flush_done = 0;
+
+
+
+    Ring &threadRing()
+    {
+        thread_local const std::shared_ptr<Ring> ring = []
+        {
+            auto created = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            registry.push_back(created);
+            return created;
+        }();
+        return *ring;
+    }
+
+
+
+    void push(Record &record)
+    {
+        record.unix_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        Ring &ring = threadRing();
+        const size_t head = ring.head.load(std::memory_order_relaxed);
+        if(head - ring.tail.load(std::memory_order_acquire) == Ring::kCapacity)
+        {
+            dropped_records.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.slots[head & (Ring::kCapacity - 1)] = record;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+
+
+    void copyText(Record &record, std::string_view text)
+    {
+        if(text.size() >= sizeof(record.text))
+        {
+            record.long_text = std::make_shared<const std::string>(text);
+            return;
+        }
+        std::memcpy(record.text, text.data(), text.size());
+        record.text[text.size()] = '\0';
+    }
+
+
+
+    const char *kindName(Kind kind)
+    {
+        switch(kind)
+        {
+            case Kind::Message: return "message";
+            case Kind::Step: return "step";
+            case Kind::Epoch: return "epoch";
+            case Kind::Eval: return "eval";
+            case Kind::Timing: return "timing";
+        }
+        return "unknown";
+    }
+
+
+
+    void appendJsonString(std::string &out, const char *text)
+    {
+        out += '"';
+        for(const char *c = text; *c; c++)
+        {
+            switch(*c)
+            {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if(static_cast<unsigned char>(*c) < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(*c));
+                        out += escaped;
+                    }
+                    else
+                    {
+                        out += *c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+
+
+    void appendNumber(std::string &out, double value)
+    {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.7g", value); // float precision
+        out += number;
+    }
+
+
+
+    std::string formatJson(const Record &record)
+    {
+        std::string line = "{\"ts_us\":" + std::to_string(record.unix_us) + ",\"kind\":\"" + kindName(record.kind) + "\"";
+        if(record.kind == Kind::Step || record.kind == Kind::Epoch || record.kind == Kind::Eval)
+        {
+            line += ",\"epoch\":" + std::to_string(record.epoch);
+        }
+        if(record.kind == Kind::Step)
+        {
+            line += ",\"step\":" + std::to_string(record.step);
+        }
+        for(size_t f = 0; f < FieldCount; f++)
+        {
+            if(!record.has(static_cast<Field>(f))) { continue; }
+            line += ",\"";
+            line += kFieldNames[f];
+            line += "\":";
+            const double value = record.values[f];
+            if(std::isfinite(value)) { appendNumber(line, value); }
+            else { line += "null"; } // JSON has no NaN/Inf; a diverged loss still shows up
+        }
+        if(record.textData()[0] != '\0')
+        {
+            line += (record.kind == Kind::Timing) ? ",\"name\":" : ",\"text\":";
+            appendJsonString(line, record.textData());
+        }
+        line += "}\n";
+        return line;
+    }
+
+
+
+    std::string formatCsv(const Record &record)
+    {
+        std::string line = std::to_string(record.unix_us) + "," + kindName(record.kind) + ",";
+        if(record.kind == Kind::Step || record.kind == Kind::Epoch || record.kind == Kind::Eval)
+        {
+            line += std::to_string(record.epoch);
+        }
+        line += ",";
+        if(record.kind == Kind::Step) { line += std::to_string(record.step); }
+        for(size_t f = 0; f < FieldCount; f++)
+        {
+            line += ",";
+            if(record.has(static_cast<Field>(f))) { appendNumber(line, record.values[f]); }
+        }
+        line += ",\"";
+        for(const char *c = record.textData(); *c; c++)
+        {
+            if(*c == '"') { line += '"'; }
+            line += (*c == '\n') ? ' ' : *c;
+        }
+        line += "\"\n";
+        return line;
+    }
+
+
+
+    // Empties every ring, oldest record first; called on the drain thread
+    // (or by stop() after it has joined)
+    void drainRings()
+    {
+        std::vector<Record> batch;
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            for(const auto &ring : registry)
+            {
+                size_t tail = ring->tail.load(std::memory_order_relaxed);
+                const size_t head = ring->head.load(std::memory_order_acquire);
+                for(; tail != head; tail++)
+                {
+                    batch.push_back(ring->slots[tail & (Ring::kCapacity - 1)]);
+                }
+                ring->tail.store(tail, std::memory_order_release);
+            }
+            // Rings only the registry still holds belong to exited threads
+            // and were emptied above
+            std::erase_if(registry, [](const std::shared_ptr<Ring> &ring) { return ring.use_count() == 1; });
+        }
+        if(batch.empty())
+        {
+            return;
+        }
+        std::stable_sort(batch.begin(), batch.end(), [](const Record &a, const Record &b) { return a.unix_us < b.unix_us; });
+
+        std::string out;
+        for(const Record &record : batch)
+        {
+            if(file.is_open())
+            {
+                out += (active.format == EventLog::Format::Csv) ? formatCsv(record) : formatJson(record);
+            }
+        }
+        if(!out.empty())
+        {
+            file << out;
+            file.flush();
+        }
+        written_records.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+
+
+
+    void drainLoop()
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        while(true)
+        {
+            wake.wait_for(lock, active.flush_interval, [] { return stopping || (flush_requested != flush_done); });
+            const bool stop_now = stopping;
+            const std::uint64_t target = flush_requested;
+            lock.unlock();
+            drainRings();
+            lock.lock();
+            flush_done = target;
+            drained.notify_all();
+            if(stop_now)
+            {
+                return;
+            }
+        }
+    }
+}
+
+
+
+namespace EventLog
+{
+
+void start(const Options &options)
+{
+    stop();
+    std::lock_guard<std::mutex> lock(state_mutex);
+    active = options;
+    active.step_sample_interval = std::max<size_t>(options.step_sample_interval, 1);
+    active.flush_interval = std::max(options.flush_interval, std::chrono::milliseconds{1});
+    if(!active.path.empty())
+    {
+        file.open(active.path, std::ios::out | std::ios::trunc);
+        if(!file)
+        {
+            throw std::runtime_error("EventLog: cannot open " + active.path);
+        }
+        if(active.format == Format::Csv)
+        {
+            file << "ts_us,kind,epoch,step,loss,accuracy,samples_per_s,ms,text\n";
+        }
+    }
+    step_interval = active.step_sample_interval;
+    has_file = file.is_open();
+    echo_console = active.echo_console;
+    dropped_records = 0;
+    written_records = 0;
+    stopping = false;
+    flush_requested = flush_done = 0;
+    drain_thread = std::thread(drainLoop);
+    is_running = true;
+}
+
+
+
+void stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if(!drain_thread.joinable())
+        {
+            return;
+        }
+        is_running = false;
+        has_file = false;
+        stopping = true;
+    }
+    wake.notify_all();
+    drain_thread.join();
+    std::lock_guard<std::mutex> lock(state_mutex);
+    drainRings(); // records pushed while the thread was exiting
+    if(file.is_open())
+    {
+        file.close();
+    }
+}
+
+
+
+bool running()
+{
+    return is_running.load(std::memory_order_relaxed);
+}
+
+
+
+void flush()
+{
+    std::unique_lock<std::mutex> lock(state_mutex);
+    if(!drain_thread.joinable() || stopping)
+    {
+        return;
+    }
+    const std::uint64_t target = ++flush_requested;
+    wake.notify_all();
+    drained.wait(lock, [target] { return flush_done >= target || stopping; });
+}
+
+
+
+void message(std::string_view text)
+{
+    // Echoed here rather than by the drain thread so the console sees every
+    // message whole and in order with the program's other output
+    if(!running() || echo_console.load(std::memory_order_relaxed))
+    {
+        std::string line = "[APP_LOG] ";
+        line += text;
+        line += '\n';
+        std::cout << line;
+    }
+    if(!has_file.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    Record record;
+    record.kind = Kind::Message;
+    copyText(record, text);
+    push(record);
+}
+
+
+
+void step(size_t epoch, size_t step, float loss, double samples_per_second, double ms)
+{
+    if(!has_file.load(std::memory_order_relaxed) || (step % step_interval.load(std::memory_order_relaxed) != 0))
+    {
+        return;
+    }
+    Record record;
+    record.kind = Kind::Step;
+    record.epoch = static_cast<std::uint32_t>(epoch);
+    record.step = step;
+    record.set(Loss, loss);
+    record.set(SamplesPerSecond, samples_per_second);
+    record.set(Milliseconds, ms);
+    push(record);
+}
+
+
+
+void epoch(size_t epoch, float loss, double seconds)
+{
+    if(!has_file.load(std::memory_order_relaxed)) { return; }
+    Record record;
+    record.kind = Kind::Epoch;
+    record.epoch = static_cast<std::uint32_t>(epoch);
+    record.set(Loss, loss);
+    record.set(Milliseconds, seconds * 1000.0);
+    push(record);
+}
+
+
+
+void eval(size_t epoch, float loss, float accuracy, double samples_per_second)
+{
+    if(!has_file.load(std::memory_order_relaxed)) { return; }
+    Record record;
+    record.kind = Kind::Eval;
+    record.epoch = static_cast<std::uint32_t>(epoch);
+    record.set(Loss, loss);
+    record.set(Accuracy, accuracy);
+    record.set(SamplesPerSecond, samples_per_second);
+    push(record);
+}
+
+
+
+void timing(std::string_view name, double ms)
+{
+    if(!has_file.load(std::memory_order_relaxed)) { return; }
+    Record record;
+    record.kind = Kind::Timing;
+    record.set(Milliseconds, ms);
+    copyText(record, name);
+    push(record);
+}
+
+
+
+std::uint64_t dropped()
+{
+    return dropped_records;
+}
+
+
+
+std::string describe()
+{
+    std::lock_guard<std::mutex> lock(state_mutex);
+    std::ostringstream out;
+    out << "Event log: " << (drain_thread.joinable() ? "running" : "stopped");
+    if(!active.path.empty())
+    {
+        out << ", " << ((active.format == Format::Csv) ? "CSV" : "JSON Lines") << " to " << active.path;
+    }
+    out << ", steps 1/" << active.step_sample_interval << ", written " << written_records << ", dropped " << dropped_records;
+    return out.str();
+}
+
+} // namespace EventLog
@@ -0,0 +1,70 @@
+// =============================================================================
+// File: src/utils/EventLog.h
+// =============================================================================
+//
+// Description: Asynchronous structured event log. Producers write fixed-size
+//              records into a single-producer ring owned by their thread, so
+//              logging never takes a lock, allocates or touches stdout on the
+//              hot path; a full ring drops the record and counts it. A
+//              background thread drains every ring on a short interval, merges
+//              the records by time and appends them to a JSON Lines or CSV
+//              file. Messages are echoed to stdout as "[APP_LOG] ..." lines
+//              as they are logged, in full and in order with other console
+//              output; only their file records go through the rings. While
+//              the log is not running, other records are discarded.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+
+namespace EventLog
+{
+    enum class Format : std::uint8_t
+    {
+        JsonLines,
+        Csv,
+    };
+
+    struct Options
+    {
+        std::string path;                        // empty: no file, console echo only
+        Format format = Format::JsonLines;
+        bool echo_console = true;                // print message records as [APP_LOG] lines
+        size_t step_sample_interval = 1;         // keep one step record in N
+        std::chrono::milliseconds flush_interval{200};
+    };
+
+    // Starts the drain thread, restarting it if already running. The file
+    // is truncated; CSV files get a header row. Throws std::runtime_error if
+    // the file cannot be opened.
+    void start(const Options &options);
+    // Writes out every pending record and joins the drain thread
+    void stop();
+    [[nodiscard]] bool running();
+    // Blocks until everything recorded so far has been written
+    void flush();
+
+    // Printed immediately; text too long for a record's inline field is
+    // kept out of line so the file gets it whole
+    void message(std::string_view text);
+    // One training step; samples_per_second and ms cover train_step only
+    void step(size_t epoch, size_t step, float loss, double samples_per_second, double ms);
+    void epoch(size_t epoch, float loss, double seconds);
+    void eval(size_t epoch, float loss, float accuracy, double samples_per_second);
+    // A named duration, e.g. a tuning run or data load
+    void timing(std::string_view name, double ms);
+
+    // Records lost to full rings since start()
+    [[nodiscard]] std::uint64_t dropped();
+    [[nodiscard]] std::string describe();
+}
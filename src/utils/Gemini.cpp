@@ -3,11 +3,11 @@
 
 
 #include "nlohmann/json.hpp"
-#include "httplib.h"
 
 
 
 #include "utils/ApiKey.h"
+#include "utils/Http.h"
 
 
 
@@ -18,10 +18,12 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <utility>
 
 
 
-Gemini::Gemini()
+Gemini::Gemini(std::string endpoint)
+    : endpoint{std::move(endpoint)}
 {
 }
 
@@ -124,30 +126,27 @@ std::string Gemini::ask(const std::string &prompt, int retry_count)
     {
         return "Error: Maximum retry attempts reached.";
     }
-    httplib::Client cli("https://generativelanguage.googleapis.com");
-    cli.set_connection_timeout(30);
-    cli.set_read_timeout(30);
-
     nlohmann::json req_body;
     req_body["contents"][0]["parts"][0]["text"] = prompt;
     // Avoid unsupported generationConfig in v1; rely on prompt engineering for JSON-only
 
-    httplib::Headers headers = {
-        {"Content-Type", "application/json"}
-    };
-
     std::string api_key(ApiKey::kGemini);
     std::string path = "/v1/models/gemini-1.5-flash:generateContent?key=" + api_key; // Using lightweight model for simple instructions
 
-    auto res = cli.Post(path, headers, req_body.dump(), "application/json");
+    // Pooled keep-alive connection, so repeated prompts skip the TLS handshake
+    Http::RequestOptions options;
+    options.connect_timeout = std::chrono::seconds(30);
+    options.read_timeout = std::chrono::seconds(30);
+    options.follow_location = false;
+    const Http::Response res = Http::post(endpoint + path, req_body.dump(), "application/json", options);
 
-    if (res)
+    if (res.status >= 0)
     {
-        if (res->status == 200)
+        if (res.ok())
         {
             try
             {
-                auto json_res = nlohmann::json::parse(res->body);
+                auto json_res = nlohmann::json::parse(res.body);
                 if (json_res.contains("candidates") && (!json_res["candidates"].empty()))
                 {
                     return json_res["candidates"][0]["content"]["parts"][0]["text"];
@@ -164,11 +163,11 @@ std::string Gemini::ask(const std::string &prompt, int retry_count)
         }
         else
         {
-            std::cout << "[Gemini DEBUG] Response Status: " << res->status << std::endl;
-            std::cout << "[Gemini DEBUG] Response Body: " << res->body << std::endl;
+            std::cout << "[Gemini DEBUG] Response Status: " << res.status << std::endl;
+            std::cout << "[Gemini DEBUG] Response Body: " << res.body << std::endl;
 
             // If service is overloaded (503), retry with a short delay
-            if ((res->status == 503) && (retry_count > 1))
+            if ((res.status == 503) && (retry_count > 1))
             {
                 std::cout << "[Gemini] Service overloaded. Retrying in 2 seconds..." << std::endl;
                 std::this_thread::sleep_for(std::chrono::seconds(2));
@@ -176,14 +175,13 @@ std::string Gemini::ask(const std::string &prompt, int retry_count)
             }
 
             // If we still couldn't connect, return an error string (no forced offline fallback)
-            return std::string("Error: Gemini API status ") + std::to_string(res->status);
+            return std::string("Error: Gemini API status ") + std::to_string(res.status);
         }
     }
     else
     {
-        auto err = res.error();
-        std::cout << "[Gemini DEBUG] HTTP Error: " << httplib::to_string(err) << std::endl;
+        std::cout << "[Gemini DEBUG] HTTP Error: " << res.error << std::endl;
         // Network error, bubble up as error text
-        return std::string("Error: Network ") + httplib::to_string(err);
+        return std::string("Error: Network ") + res.error;
     }
 }
@@ -9,6 +9,13 @@
 class Gemini
 {
 public:
-    Gemini();
+    static constexpr const char *kDefaultEndpoint = "https://generativelanguage.googleapis.com";
+
+    // endpoint is scheme://host[:port]; a local stand-in speaking the same
+    // generateContent protocol can replace the real service
+    explicit Gemini(std::string endpoint = kDefaultEndpoint);
     [[nodiscard]] std::string ask(const std::string &prompt, int retry_count = 3);
+
+private:
+    std::string endpoint;
 };
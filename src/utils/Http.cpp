@@ -6,26 +6,334 @@
 
 
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+
+
+namespace
+{
+    struct HostPool
+    {
+        std::mutex mutex;
+        std::condition_variable returned;
+        std::vector<std::unique_ptr<httplib::Client>> idle;
+        size_t open = 0; // idle plus leased
+    };
+
+    std::mutex pools_mutex;
+    std::unordered_map<std::string, std::unique_ptr<HostPool>> pools;
+    std::atomic<size_t> max_per_host{4};
+    std::atomic<std::uint64_t> request_count{0};
+    std::atomic<std::uint64_t> opened_count{0};
+    std::atomic<std::uint64_t> reused_count{0};
+
+
+
+    // {scheme://host[:port], /path?query}
+    std::pair<std::string, std::string> splitUrl(const std::string &url)
+    {
+        const size_t scheme_end = url.find("://");
+        const size_t host_start = (scheme_end == std::string::npos) ? 0 : scheme_end + 3;
+        const size_t path_start = url.find('/', host_start);
+        std::string origin = url.substr(0, path_start);
+        if (scheme_end == std::string::npos)
+        {
+            origin = "http://" + origin;
+        }
+        return {origin, (path_start == std::string::npos) ? "/" : url.substr(path_start)};
+    }
+
+
+
+    HostPool &poolFor(const std::string &origin)
+    {
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        auto &pool = pools[origin];
+        if (!pool)
+        {
+            pool = std::make_unique<HostPool>();
+        }
+        return *pool;
+    }
+
+
+
+    // Exclusive use of one client, returned to the pool on destruction
+    // unless the request failed at the transport level
+    class Lease
+    {
+    public:
+        Lease(const std::string &origin, const Http::RequestOptions &options)
+        {
+            if (!options.reuse_connection)
+            {
+                client = std::make_unique<httplib::Client>(origin);
+                client->set_keep_alive(false);
+                opened_count++;
+            }
+            else
+            {
+                pool = &poolFor(origin);
+                std::unique_lock<std::mutex> lock(pool->mutex);
+                pool->returned.wait(lock, [this] { return !pool->idle.empty() || (pool->open < max_per_host); });
+                if (!pool->idle.empty())
+                {
+                    client = std::move(pool->idle.back());
+                    pool->idle.pop_back();
+                    reused_count++;
+                }
+                else
+                {
+                    pool->open++;
+                    lock.unlock();
+                    try
+                    {
+                        client = std::make_unique<httplib::Client>(origin);
+                    }
+                    catch (...)
+                    {
+                        lock.lock();
+                        pool->open--;
+                        pool->returned.notify_one();
+                        throw;
+                    }
+                    client->set_keep_alive(true);
+                    opened_count++;
+                }
+            }
+            client->set_follow_location(options.follow_location);
+            client->set_connection_timeout(static_cast<time_t>(options.connect_timeout.count()));
+            client->set_read_timeout(static_cast<time_t>(options.read_timeout.count()));
+        }
+
+        ~Lease()
+        {
+            if (!pool)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                if (healthy)
+                {
+                    pool->idle.push_back(std::move(client));
+                }
+                else
+                {
+                    pool->open--;
+                }
+            }
+            pool->returned.notify_one();
+        }
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        [[nodiscard]] httplib::Client &get() noexcept { return *client; }
+        void discard() noexcept { healthy = false; }
+
+    private:
+        HostPool *pool = nullptr;
+        std::unique_ptr<httplib::Client> client;
+        bool healthy = true;
+    };
+
+
+
+    template <class Send>
+    Http::Response perform(const std::string &url, const Http::RequestOptions &options, Send send)
+    {
+        request_count++;
+        const auto [origin, path] = splitUrl(url);
+        Lease lease(origin, options);
+        httplib::Result result = send(lease.get(), path);
+        Http::Response response;
+        if (result)
+        {
+            response.status = result->status;
+            response.body = std::move(result->body);
+        }
+        else
+        {
+            response.error = httplib::to_string(result.error());
+            lease.discard();
+        }
+        return response;
+    }
+
+
+
+    double percentile(std::vector<double> sorted, double fraction)
+    {
+        if (sorted.empty()) { return 0.0; }
+        std::sort(sorted.begin(), sorted.end());
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5));
+        return sorted[index];
+    }
+}
+
+
+
+Http::Response Http::get(const std::string &url, const RequestOptions &options)
+{
+    return perform(url, options, [](httplib::Client &client, const std::string &path) { return client.Get(path); });
+}
+
+
+
+Http::Response Http::post(const std::string &url, const std::string &body, const std::string &content_type, const RequestOptions &options)
+{
+    return perform(url, options, [&](httplib::Client &client, const std::string &path) { return client.Post(path, body, content_type); });
+}
+
+
+
+std::future<Http::Response> Http::getAsync(const std::string &url, const RequestOptions &options, Callback on_complete)
+{
+    return std::async(std::launch::async, [url, options, on_complete = std::move(on_complete)]
+    {
+        Response response = get(url, options);
+        if (on_complete)
+        {
+            on_complete(response);
+        }
+        return response;
+    });
+}
+
+
+
+void Http::setMaxConnectionsPerHost(size_t connections)
+{
+    max_per_host = std::max<size_t>(connections, 1);
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    for (auto &[origin, pool] : pools)
+    {
+        pool->returned.notify_all();
+    }
+}
+
+
+
+void Http::closeIdleConnections()
+{
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    for (auto &[origin, pool] : pools)
+    {
+        std::lock_guard<std::mutex> pool_lock(pool->mutex);
+        pool->open -= pool->idle.size();
+        pool->idle.clear();
+        pool->returned.notify_all();
+    }
+}
+
+
+
+std::string Http::describePool()
+{
+    size_t hosts = 0;
+    size_t idle = 0;
+    {
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        hosts = pools.size();
+        for (auto &[origin, pool] : pools)
+        {
+            std::lock_guard<std::mutex> pool_lock(pool->mutex);
+            idle += pool->idle.size();
+        }
+    }
+    return "HTTP pool: " + std::to_string(request_count.load()) + " requests, " + std::to_string(opened_count.load()) + " connections opened, " +
+           std::to_string(reused_count.load()) + " reused, " + std::to_string(idle) + " idle across " + std::to_string(hosts) +
+           " hosts (limit " + std::to_string(max_per_host.load()) + " per host)";
+}
+
+
+
+std::vector<std::string> Http::runLatencyBenchmark(const std::string &url, size_t requests)
+{
+    requests = std::max<size_t>(requests, 1);
+    std::vector<std::string> lines;
+    char line[256];
+    auto summarize = [&](const char *label, const std::vector<double> &ms, size_t failures, double wall_ms)
+    {
+        double total = 0.0;
+        for (double value : ms) { total += value; }
+        std::snprintf(line, sizeof(line), "%-20s mean %8.3f ms  p50 %8.3f ms  p95 %8.3f ms  %7.1f req/s  failures %zu",
+                      label, total / static_cast<double>(ms.size()), percentile(ms, 0.5), percentile(ms, 0.95),
+                      1000.0 * static_cast<double>(ms.size()) / std::max(wall_ms, 1e-9), failures);
+        lines.emplace_back(line);
+    };
+    auto timed = [](auto &&fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    lines.push_back("GET " + url + " x" + std::to_string(requests));
+    for (const bool reuse : {false, true})
+    {
+        RequestOptions options;
+        options.reuse_connection = reuse;
+        std::vector<double> ms;
+        size_t failures = 0;
+        const double wall = timed([&]
+        {
+            for (size_t i = 0; i < requests; i++)
+            {
+                ms.push_back(timed([&] { failures += get(url, options).ok() ? 0 : 1; }));
+            }
+        });
+        summarize(reuse ? "sequential, pooled" : "sequential, fresh", ms, failures, wall);
+    }
+
+    std::vector<double> ms(requests, 0.0);
+    std::atomic<size_t> failures{0};
+    const double wall = timed([&]
+    {
+        std::vector<std::future<Response>> pending;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < requests; i++)
+        {
+            pending.push_back(getAsync(url, {}, [&, i, start](const Response &response)
+            {
+                ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (!response.ok()) { failures++; }
+            }));
+        }
+        for (auto &future : pending) { future.wait(); }
+    });
+    summarize("concurrent, pooled", ms, failures, wall);
+    lines.push_back(describePool());
+    return lines;
+}
 
 
 
 void Http::downloadFile(const std::string &host, const std::string &path, const std::string &out_path)
 {
-    httplib::Client cli(host);
-    auto res = cli.Get(path.c_str());
+    const Response res = get(host + path);
 
-    if (res && (res->status == 200))
+    if (res.ok())
     {
         std::ofstream ofs(out_path, std::ios::binary);
-        ofs << res->body;
+        ofs << res.body;
     }
     else
     {
         std::string error_message = "[HTTP] Error: Download failed with status code: ";
-        if (res) { error_message += std::to_string(res->status); }
+        if (res.status >= 0) { error_message += std::to_string(res.status); }
         else { error_message += "unknown"; }
         throw std::runtime_error(error_message);
     }
@@ -35,13 +343,7 @@ void Http::downloadFile(const std::string &host, const std::string &path, const
 
 void Http::downloadFileFromUrl(const std::string &url, const std::string &out_path)
 {
-    std::string host;
-    std::string path;
-    size_t host_end;
-
-    if (url.rfind("https", 0) == 0) { host = url.substr(0, url.find("/", 8)); path = url.substr(url.find("/", 8)); }
-    else { host = url.substr(0, url.find("/", 7)); path = url.substr(url.find("/", 7)); }
-
+    const auto [host, path] = splitUrl(url);
     downloadFile(host, path, out_path);
 }
 
@@ -52,44 +354,21 @@ std::vector<unsigned char> Http::downloadAndDecompress(const std::string &url)
     std::cout << "[HTTP] Downloading and decompressing " << url << "..." << '\n';
 
     // 1. Download the file
-    std::string url_path = url;
-    std::string host;
-    if (url.rfind("http://", 0) == 0)
-    {
-        url_path = url.substr(7);
-    }
-    size_t path_start = url_path.find('/');
-    if (path_start != std::string::npos)
-    {
-        host = url_path.substr(0, path_start);
-        url_path = url_path.substr(path_start);
-    }
-    else
-    {
-        host = url_path;
-        url_path = "/";
-    }
-
-    httplib::Client cli(host.c_str());
-    cli.set_follow_location(true);
-    auto res = cli.Get(url_path.c_str());
+    Response res = get(url);
 
-    if ((!res) || (res->status != 200))
+    if (!res.ok())
     {
-        std::cerr << "[HTTP] Error: Failed to download " << url << ". Status: " << (res ? res->status : -1) << '\n';
-        std::string fallback_host = "ossci-datasets.s3.amazonaws.com";
-        std::string fallback_path = "/mnist/" + url.substr(url.find_last_of('/') + 1);
-        std::cout << "[HTTP] Attempting fallback URL: http://" << fallback_host << fallback_path << '\n';
-        httplib::Client fallback_cli(fallback_host.c_str());
-        fallback_cli.set_follow_location(true);
-        res = fallback_cli.Get(fallback_path.c_str());
-        if ((!res) || (res->status != 200))
+        std::cerr << "[HTTP] Error: Failed to download " << url << ". Status: " << res.status << '\n';
+        const std::string fallback_url = "http://ossci-datasets.s3.amazonaws.com/mnist/" + url.substr(url.find_last_of('/') + 1);
+        std::cout << "[HTTP] Attempting fallback URL: " << fallback_url << '\n';
+        res = get(fallback_url);
+        if (!res.ok())
         {
             throw std::runtime_error("Failed to download from both primary and fallback URLs.");
         }
     }
 
-    const std::vector<char> compressed_data(res->body.begin(), res->body.end());
+    const std::vector<char> compressed_data(res.body.begin(), res.body.end());
     std::cout << "[HTTP] Download successful. Compressed size: " << compressed_data.size() << " bytes." << '\n';
 
     // 2. Decompress the data using zlib
@@ -140,39 +419,22 @@ std::vector<unsigned char> Http::downloadAndDecompress(const std::string &url)
 
 std::vector<unsigned char> Http::downloadRawFile(const std::string &url)
 {
-    std::string host;
-    std::string path;
-
-    if (url.rfind("https", 0) == 0)
-    {
-        host = url.substr(0, url.find("/", 8));
-        path = url.substr(url.find("/", 8));
-    }
-    else
-    {
-        host = url.substr(0, url.find("/", 7));
-        path = url.substr(url.find("/", 7));
-    }
-
-    httplib::Client cli(host);
-    cli.set_read_timeout(60);
-    cli.set_connection_timeout(15);
-    auto res = cli.Get(path.c_str());
+    const Response res = get(url);
 
-    if (res && (res->status == 200))
+    if (res.ok())
     {
-        std::cout << "[HTTP] Successfully downloaded " << url << " (" << res->body.size() << " bytes)" << '\n';
+        std::cout << "[HTTP] Successfully downloaded " << url << " (" << res.body.size() << " bytes)" << '\n';
 
         // Convert the response body to a vector of unsigned chars
-        const unsigned char *data = reinterpret_cast<const unsigned char *>(res->body.data());
-        std::vector<unsigned char> file_data(data, data + res->body.size());
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(res.body.data());
+        std::vector<unsigned char> file_data(data, data + res.body.size());
         return file_data;
     }
     else
     {
         std::string error_message = "[HTTP] Error: Download failed with status code: ";
-        if (res) { error_message += std::to_string(res->status); }
-        else { error_message += "unknown (connection error or timeout)"; }
+        if (res.status >= 0) { error_message += std::to_string(res.status); }
+        else { error_message += "unknown (" + res.error + ")"; }
         throw std::runtime_error(error_message);
     }
 }
@@ -8,14 +8,58 @@
 
 
 // --- Standard Includes ---
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 
 
 
+// Requests go through a process-wide pool of keep-alive clients keyed by
+// scheme://host:port. A request borrows an idle connection to its host or
+// opens a new one; at most max_connections_per_host are open per host, and
+// further requests wait for one to be returned. Connections that fail are
+// dropped rather than returned.
 namespace Http
 {
+    struct Response
+    {
+        int status = -1;   // -1 when no response arrived
+        std::string body;
+        std::string error; // transport error, empty on a response
+        [[nodiscard]] bool ok() const noexcept { return status == 200; }
+    };
+
+    struct RequestOptions
+    {
+        std::chrono::seconds connect_timeout{15};
+        std::chrono::seconds read_timeout{60};
+        bool follow_location = true;
+        bool reuse_connection = true; // false: a one-off client, for comparison
+    };
+
+    using Callback = std::function<void(const Response &)>;
+
+    // url is [scheme://]host[:port]/path; the scheme defaults to http
+    [[nodiscard]] Response get(const std::string &url, const RequestOptions &options = {});
+    [[nodiscard]] Response post(const std::string &url, const std::string &body, const std::string &content_type, const RequestOptions &options = {});
+    // Runs the request on a background thread; on_complete, when given, is
+    // called there with the response before the future becomes ready
+    [[nodiscard]] std::future<Response> getAsync(const std::string &url, const RequestOptions &options = {}, Callback on_complete = {});
+
+    // Default 4; applies to connections opened afterwards
+    void setMaxConnectionsPerHost(size_t connections);
+    // Closes every idle connection
+    void closeIdleConnections();
+    [[nodiscard]] std::string describePool();
+
+    // Sequential GETs of url on fresh and on pooled connections, then the
+    // same number issued concurrently through the pool
+    [[nodiscard]] std::vector<std::string> runLatencyBenchmark(const std::string &url, size_t requests = 20);
+
     void downloadFile(const std::string &host, const std::string &path, const std::string &out_path);
 
     void downloadFileFromUrl(const std::string &url, const std::string &out_path);
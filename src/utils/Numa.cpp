@@ -0,0 +1,323 @@
+// =============================================================================
+// File: src/utils/Numa.cpp
+// =============================================================================
+//
+// Description: Implements topology detection, pinning and page placement for
+//              the Numa helpers.
+//
+// =============================================================================
+
+#include "utils/Numa.h"
+
+
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+
+
+namespace
+{
+#ifdef __linux__
+    // From <linux/mempolicy.h>; spelled out to avoid depending on numaif.h
+    constexpr int kMpolBind = 2;
+    constexpr int kMpolInterleave = 3;
+    constexpr unsigned kMpolMfMove = 1u << 1;
+    constexpr size_t kMaskWords = 16; // 1024 nodes
+
+
+
+    // "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+    std::vector<int> parseCpuList(const std::string &list)
+    {
+        std::vector<int> cpus;
+        std::stringstream ranges(list);
+        for(std::string range; std::getline(ranges, range, ',');)
+        {
+            if(range.empty() || (range == "\n")) { continue; }
+            const auto dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for(int cpu = first; cpu <= last; cpu++) { cpus.push_back(cpu); }
+        }
+        return cpus;
+    }
+
+
+
+    bool setPolicy(void *data, size_t bytes, int mode, const unsigned long *mask, unsigned flags)
+    {
+        // mbind works on whole pages; only pages fully inside the buffer are
+        // touched so neighbouring allocations keep their policy
+        const auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        const auto begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) & ~(page - 1);
+        const auto end = (reinterpret_cast<std::uintptr_t>(data) + bytes) & ~(page - 1);
+        if(end <= begin) { return false; }
+        return syscall(SYS_mbind, begin, end - begin, mode, mask, kMaskWords * 64 + 1, flags) == 0;
+    }
+#endif
+
+
+
+    bool pinToCpu(int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        if(cpu >= 64) { return false; }
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+
+
+    Numa::Topology detectTopology()
+    {
+        Numa::Topology topology;
+#ifdef __linux__
+        // Restrict to the CPUs this process may run on (containers, taskset)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        // Node ids may have gaps (offlined or absent nodes), so walk the
+        // online list rather than counting up from node0
+        std::string online;
+        if(std::ifstream file("/sys/devices/system/node/online"); file) { std::getline(file, online); }
+        for(int node : parseCpuList(online))
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!file) { continue; }
+            std::string list;
+            std::getline(file, list);
+            std::vector<int> cpus;
+            for(int cpu : parseCpuList(list))
+            {
+                if(!have_mask || CPU_ISSET(cpu, &allowed)) { cpus.push_back(cpu); }
+            }
+            if(!cpus.empty())
+            {
+                topology.node_cpus.push_back(std::move(cpus));
+                topology.node_ids.push_back(node);
+            }
+        }
+        if(topology.node_cpus.empty() && have_mask)
+        {
+            std::vector<int> cpus;
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if(CPU_ISSET(cpu, &allowed)) { cpus.push_back(cpu); }
+            }
+            topology.node_cpus.push_back(std::move(cpus));
+            topology.node_ids.push_back(0);
+        }
+#endif
+        if(topology.node_cpus.empty())
+        {
+            std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+            for(size_t i = 0; i < cpus.size(); i++) { cpus[i] = static_cast<int>(i); }
+            topology.node_cpus.push_back(std::move(cpus));
+            topology.node_ids.push_back(0);
+        }
+        return topology;
+    }
+
+
+
+    // CPU and node a worker maps to under a pinning policy
+    std::pair<int, size_t> placeWorker(size_t worker, Numa::PinPolicy policy)
+    {
+        const auto &nodes = Numa::topology().node_cpus;
+        if(policy == Numa::PinPolicy::Scatter)
+        {
+            const size_t node = worker % nodes.size();
+            const auto &cpus = nodes[node];
+            return {cpus[(worker / nodes.size()) % cpus.size()], node};
+        }
+        size_t index = worker % Numa::topology().cpuCount();
+        for(size_t node = 0; node < nodes.size(); node++)
+        {
+            if(index < nodes[node].size()) { return {nodes[node][index], node}; }
+            index -= nodes[node].size();
+        }
+        return {nodes[0][0], 0};
+    }
+}
+
+
+
+namespace Numa
+{
+
+size_t Topology::cpuCount() const noexcept
+{
+    size_t count = 0;
+    for(const auto &cpus : node_cpus) { count += cpus.size(); }
+    return count;
+}
+
+
+
+const Topology &topology()
+{
+    static const Topology detected = detectTopology();
+    return detected;
+}
+
+
+
+size_t nodeForWorker(size_t worker, PinPolicy policy)
+{
+    return (policy == PinPolicy::None) ? 0 : placeWorker(worker, policy).second;
+}
+
+
+
+size_t pinCurrentThread(size_t worker, PinPolicy policy)
+{
+    if(policy == PinPolicy::None) { return 0; }
+    const auto [cpu, node] = placeWorker(worker, policy);
+    return pinToCpu(cpu) ? node : 0;
+}
+
+
+
+bool bindToNode(void *data, size_t bytes, size_t node, bool migrate)
+{
+#ifdef __linux__
+    if(node >= topology().nodeCount()) { return false; }
+    const auto id = static_cast<size_t>(topology().node_ids[node]);
+    if(id >= kMaskWords * 64) { return false; }
+    unsigned long mask[kMaskWords] = {};
+    mask[id / 64] = 1ul << (id % 64);
+    return setPolicy(data, bytes, kMpolBind, mask, migrate ? kMpolMfMove : 0);
+#else
+    (void)data; (void)bytes; (void)node; (void)migrate;
+    return false;
+#endif
+}
+
+
+
+bool interleave(void *data, size_t bytes)
+{
+#ifdef __linux__
+    unsigned long mask[kMaskWords] = {};
+    for(const int node : topology().node_ids)
+    {
+        const auto id = static_cast<size_t>(node);
+        if(id < kMaskWords * 64) { mask[id / 64] |= 1ul << (id % 64); }
+    }
+    return setPolicy(data, bytes, kMpolInterleave, mask, kMpolMfMove);
+#else
+    (void)data; (void)bytes;
+    return false;
+#endif
+}
+
+
+
+ReplicatedTensor::ReplicatedTensor(const Tensor &source)
+{
+    const auto &nodes = topology().node_cpus;
+    copies.resize(nodes.size());
+    if(nodes.size() == 1)
+    {
+        copies[0] = source;
+        return;
+    }
+    // Allocate and copy from a thread on the target node so first touch puts
+    // the pages there; mbind makes it stick even if the pin was refused
+    std::vector<std::thread> workers;
+    for(size_t node = 0; node < nodes.size(); node++)
+    {
+        workers.emplace_back([this, &source, &nodes, node]
+        {
+            pinToCpu(nodes[node][0]);
+            Tensor copy{source.getShape()};
+            (void)bindToNode(copy.getCpuData(), copy.getSize() * sizeof(float), node, false);
+            std::copy_n(source.getCpuData(), source.getSize(), copy.getCpuData());
+            copies[node] = std::move(copy);
+        });
+    }
+    for(auto &worker : workers) { worker.join(); }
+}
+
+
+
+std::vector<std::vector<double>> measureBandwidth(size_t bytes)
+{
+    const auto &nodes = topology().node_cpus;
+    std::vector<std::vector<double>> matrix(nodes.size(), std::vector<double>(nodes.size(), 0.0));
+    const size_t count = std::max<size_t>(1, bytes / sizeof(float));
+    for(size_t from = 0; from < nodes.size(); from++)
+    {
+        for(size_t to = 0; to < nodes.size(); to++)
+        {
+            std::thread([&, from, to]
+            {
+                pinToCpu(nodes[from][0]);
+                std::unique_ptr<float[]> buffer(new float[count]);
+                (void)bindToNode(buffer.get(), count * sizeof(float), to, false);
+                std::fill_n(buffer.get(), count, 1.0f);
+
+                constexpr int kRepeats = 4;
+                float sink = 0.0f;
+                const auto start = std::chrono::steady_clock::now();
+                for(int r = 0; r < kRepeats; r++)
+                {
+                    float partial[8] = {};
+                    for(size_t i = 0; i + 8 <= count; i += 8)
+                    {
+                        for(int k = 0; k < 8; k++) { partial[k] += buffer[i + k]; }
+                    }
+                    for(float p : partial) { sink += p; }
+                }
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                matrix[from][to] = (sink > 0.0f) && (seconds > 0.0) ? static_cast<double>(count * sizeof(float)) * kRepeats / seconds / 1e9 : 0.0;
+            }).join();
+        }
+    }
+    return matrix;
+}
+
+
+
+std::string describe()
+{
+    std::ostringstream out;
+    const auto &nodes = topology().node_cpus;
+    out << "NUMA: " << nodes.size() << (nodes.size() == 1 ? " node" : " nodes");
+    for(size_t node = 0; node < nodes.size(); node++)
+    {
+        out << " | node" << topology().node_ids[node] << ": " << nodes[node].size() << " CPUs";
+    }
+    return out.str();
+}
+
+} // namespace Numa
@@ -0,0 +1,90 @@
+// =============================================================================
+// File: src/utils/Numa.h
+// =============================================================================
+//
+// Description: NUMA topology detection, thread pinning and memory placement.
+//              Topology comes from /sys/devices/system/node on Linux; other
+//              platforms, or machines without NUMA, report one node holding
+//              every CPU. Placement uses the mbind system call directly, so no
+//              libnuma dependency is needed, and every call degrades to a
+//              no-op returning false where the kernel or platform lacks
+//              support.
+//
+// =============================================================================
+
+#pragma once
+
+
+
+#include "nn/Tensor.h"
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace Numa
+{
+    struct Topology
+    {
+        // Nodes with at least one CPU this process may use. The node index
+        // used throughout this API is a position in these vectors; node_ids
+        // holds the kernel's id for it, which need not be contiguous.
+        std::vector<std::vector<int>> node_cpus; // CPUs of each node
+        std::vector<int> node_ids;
+        [[nodiscard]] size_t nodeCount() const noexcept { return node_cpus.size(); }
+        [[nodiscard]] size_t cpuCount() const noexcept;
+    };
+
+    enum class PinPolicy : std::uint8_t
+    {
+        None,    // leave placement to the OS scheduler
+        Compact, // fill the CPUs of node 0 first, then node 1, ...
+        Scatter, // round-robin workers across nodes
+    };
+
+    enum class DataPlacement : std::uint8_t
+    {
+        FirstTouch, // wherever the loading thread touched it (the default)
+        Interleave, // pages spread round-robin over all nodes
+        Replicate,  // one copy per node, each worker reads its local copy
+    };
+
+    // Detected once and cached
+    [[nodiscard]] const Topology &topology();
+
+    // Node a worker runs on under the policy (0 for PinPolicy::None)
+    [[nodiscard]] size_t nodeForWorker(size_t worker, PinPolicy policy);
+
+    // Pins the calling thread to one CPU chosen by the policy; returns the
+    // node it landed on. Returns 0 and leaves affinity untouched on failure.
+    size_t pinCurrentThread(size_t worker, PinPolicy policy);
+
+    // Memory policy for the whole pages inside [data, data + bytes). node is
+    // an index into topology(). With migrate set, pages already faulted in
+    // are moved as well.
+    bool bindToNode(void *data, size_t bytes, size_t node, bool migrate = true);
+    bool interleave(void *data, size_t bytes);
+
+    // Per-node copies of a read-only tensor, each first-touched by a thread
+    // pinned to its node. With one node this holds a single copy.
+    class ReplicatedTensor
+    {
+    public:
+        explicit ReplicatedTensor(const Tensor &source);
+        [[nodiscard]] const Tensor &local(size_t node) const { return copies[node < copies.size() ? node : 0]; }
+
+    private:
+        std::vector<Tensor> copies;
+    };
+
+    // Read bandwidth (GB/s) of a CPU on node i streaming a buffer bound to
+    // node j, for every pair
+    [[nodiscard]] std::vector<std::vector<double>> measureBandwidth(size_t bytes = 64u << 20);
+
+    [[nodiscard]] std::string describe();
+}